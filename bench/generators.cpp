@@ -0,0 +1,273 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "generators.hpp"      // Class definition
+#include "version.hpp"         // version_key of index records
+
+#include <fstream>             // Writing DB and index files
+#include <sstream>             // Building archive members
+#include <random>              // Reproducible synthetic data
+#include <algorithm>           // std::find
+#include <cstdio>              // snprintf
+#include <ctime>               // Archive entry times
+#include <archive.h>           // Writing .starpack archives
+#include <archive_entry.h>     // Archive entries
+
+namespace Starpack {
+
+    namespace {
+
+        std::mt19937 rngFor(size_t index, uint32_t seed) {
+            return std::mt19937(seed ^ static_cast<uint32_t>(index * 2654435761u));
+        }
+
+        bool addEntry(struct archive* a, const std::string& path, const std::string& data,
+                      mode_t type, mode_t perm) {
+            struct archive_entry* entry = archive_entry_new();
+            archive_entry_set_pathname(entry, path.c_str());
+            archive_entry_set_filetype(entry, type);
+            archive_entry_set_perm(entry, perm);
+            archive_entry_set_size(entry, type == AE_IFREG ? data.size() : 0);
+            archive_entry_set_mtime(entry, std::time(nullptr), 0);
+            bool ok = archive_write_header(a, entry) == ARCHIVE_OK;
+            if (ok && type == AE_IFREG && !data.empty()) {
+                ok = archive_write_data(a, data.data(), data.size()) ==
+                     static_cast<la_ssize_t>(data.size());
+            }
+            archive_entry_free(entry);
+            return ok;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::packageName / packageVersion / packageFiles
+     * ------------------------------------------------------------------------
+     */
+    std::string Generators::packageName(size_t index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "pkg%06zu", index);
+        return name;
+    }
+
+    std::string Generators::packageVersion(size_t index, uint32_t release) {
+        // Later releases raise the leading component, which every comparer honours
+        size_t bump = static_cast<size_t>(release) * 10000;
+        switch (index % 4) {
+            case 0:  return std::to_string(bump + index % 7) + "." + std::to_string(index % 13) +
+                            "." + std::to_string(index % 31);
+            case 1:  return std::to_string(bump + index % 5 + 1) + "." + std::to_string(index % 17) +
+                            "-r" + std::to_string(index % 3);
+            case 2:  return std::to_string(bump + 2020 + index % 6) + "." +
+                            std::to_string(index % 12 + 1) + "." + std::to_string(index % 28 + 1);
+            default: return std::to_string(bump + index % 3) + "." + std::to_string(index % 11) +
+                            "rc" + std::to_string(index % 4 + 1);
+        }
+    }
+
+    std::vector<std::string> Generators::packageFiles(size_t index, size_t files) {
+        std::vector<std::string> paths;
+        paths.reserve(files);
+        std::string name = packageName(index);
+        for (size_t f = 0; f < files; f++) {
+            // Spread files over a few directories like real packages do
+            const char* dir = (f % 4 == 0) ? "usr/bin/" :
+                              (f % 4 == 1) ? "usr/lib/" : "usr/share/";
+            paths.push_back(std::string(dir) + (f % 4 < 2 ? "" : name + "/") +
+                            name + "-" + std::to_string(f));
+        }
+        return paths;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::packageDependencies
+     * ------------------------------------------------------------------------
+     */
+    std::vector<std::string> Generators::packageDependencies(size_t index, const BenchScale& scale) {
+        std::vector<std::string> deps;
+        if (index == 0 || scale.dependencies == 0) {
+            return deps;
+        }
+        std::mt19937 rng = rngFor(index, scale.seed);
+        size_t count = std::min<size_t>(rng() % (scale.dependencies + 1), index);
+        for (size_t d = 0; d < count; d++) {
+            std::string dep = packageName(rng() % index);
+            if (std::find(deps.begin(), deps.end(), dep) == deps.end()) {
+                deps.push_back(dep);
+            }
+        }
+        return deps;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::writeInstalledDb
+     * ------------------------------------------------------------------------
+     */
+    bool Generators::writeInstalledDb(const std::string& path, const BenchScale& scale) {
+        std::ofstream out(path, std::ios::trunc | std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        for (size_t i = 0; i < scale.packages; i++) {
+            out << packageName(i) << " /\n"
+                << "Version: " << packageVersion(i, scale.release) << "\n"
+                << "Description: Synthetic package " << i << "\n"
+                << "Update-time: 12:00:00\n"
+                << "Files:\n";
+            for (const auto& file : packageFiles(i, scale.files)) {
+                out << "/" << file << "\n";
+            }
+            out << "Dependencies:\n";
+            for (const auto& dep : packageDependencies(i, scale)) {
+                out << dep << "\n";
+            }
+            out << "----------------------------------------\n";
+        }
+        return static_cast<bool>(out.flush());
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::writeRepoIndex
+     *
+     * Same layout as the YAML::Emitter output of Repository::createRepoIndex.
+     * ------------------------------------------------------------------------
+     */
+    bool Generators::writeRepoIndex(const std::string& path, const BenchScale& scale) {
+        std::ofstream out(path, std::ios::trunc | std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        out << "packages:\n";
+        for (size_t i = 0; i < scale.packages; i++) {
+            std::string name = packageName(i);
+            std::string version = packageVersion(i, scale.release);
+            out << "  - name: " << name << "\n"
+                << "    version: " << version << "\n"
+                << "    version_key: " << Version::indexKey(version) << "\n"
+                << "    description: Synthetic package " << i << "\n"
+                << "    file_name: " << name << "-" << version << ".starpack\n";
+            std::vector<std::string> deps = packageDependencies(i, scale);
+            if (deps.empty()) {
+                out << "    dependencies: []\n";
+            } else {
+                out << "    dependencies:\n";
+                for (const auto& dep : deps) {
+                    out << "      - " << dep << "\n";
+                }
+            }
+            out << "    strip_components: 0\n";
+            out << "    files:\n";
+            for (const auto& file : packageFiles(i, scale.files)) {
+                out << "      - " << file << "\n";
+            }
+            out << "    update_time: 12:00:00\n";
+        }
+        return static_cast<bool>(out.flush());
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::writeArchive
+     * ------------------------------------------------------------------------
+     */
+    bool Generators::writeArchive(const std::string& path, size_t index, size_t files,
+                                  const BenchScale& scale) {
+        struct archive* a = archive_write_new();
+        archive_write_add_filter_gzip(a);
+        archive_write_set_format_pax_restricted(a);
+        if (archive_write_open_filename(a, path.c_str()) != ARCHIVE_OK) {
+            archive_write_free(a);
+            return false;
+        }
+
+        std::ostringstream metadata;
+        metadata << "name: " << packageName(index) << "\n"
+                 << "version: " << packageVersion(index, scale.release) << "\n"
+                 << "description: Synthetic package " << index << "\n"
+                 << "dependencies:\n";
+        for (const auto& dep : packageDependencies(index, scale)) {
+            metadata << "  - " << dep << "\n";
+        }
+        metadata << "files:\n";
+        for (const auto& file : packageFiles(index, files)) {
+            metadata << "  - /" << file << "\n";
+        }
+
+        bool ok = addEntry(a, "metadata.yaml", metadata.str(), AE_IFREG, 0644) &&
+                  addEntry(a, "files/", "", AE_IFDIR, 0755);
+
+        std::vector<std::string> dirs;
+        std::mt19937 rng = rngFor(index, scale.seed);
+        for (const auto& file : packageFiles(index, files)) {
+            // Parent directories first, once each
+            for (size_t slash = file.find('/'); ok && slash != std::string::npos;
+                 slash = file.find('/', slash + 1)) {
+                std::string dir = file.substr(0, slash + 1);
+                if (std::find(dirs.begin(), dirs.end(), dir) == dirs.end()) {
+                    dirs.push_back(dir);
+                    ok = addEntry(a, "files/" + dir, "", AE_IFDIR, 0755);
+                }
+            }
+            // Small, mildly compressible contents (64 B - 4 KiB)
+            std::string data(64 + rng() % 4033, 'x');
+            for (size_t c = 0; c < data.size(); c += 7) {
+                data[c] = static_cast<char>('a' + rng() % 26);
+            }
+            ok = ok && addEntry(a, "files/" + file, data, AE_IFREG, 0644);
+        }
+
+        // One package hook, as most real packages ship
+        std::string hook = "[Hook]\nName = " + packageName(index) + "\n\n"
+                           "[When]\nPhase = PostInstall\nOperation = Install\n"
+                           "Paths = usr/share/" + packageName(index) + "/*\n\n"
+                           "[Exec]\nCommand = /bin/true\n";
+        ok = ok && addEntry(a, "hooks/", "", AE_IFDIR, 0755) &&
+             addEntry(a, "hooks/" + packageName(index) + ".hook", hook, AE_IFREG, 0644);
+
+        ok = archive_write_close(a) == ARCHIVE_OK && ok;
+        archive_write_free(a);
+        return ok;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Generators::versionPairs
+     * ------------------------------------------------------------------------
+     */
+    std::vector<std::pair<std::string, std::string>> Generators::versionPairs(size_t count,
+                                                                              uint32_t seed) {
+        std::mt19937 rng(seed);
+        auto randomVersion = [&]() {
+            std::string version = std::to_string(rng() % 20);
+            size_t parts = 1 + rng() % 4;
+            for (size_t p = 0; p < parts; p++) {
+                version += "." + std::to_string(rng() % 100);
+            }
+            switch (rng() % 5) {
+                case 0:  version += "-r" + std::to_string(rng() % 10); break;
+                case 1:  version += "rc" + std::to_string(rng() % 5);  break;
+                case 2:  version += "a";                               break;
+                default: break;
+            }
+            return version;
+        };
+
+        std::vector<std::pair<std::string, std::string>> pairs;
+        pairs.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            std::string left = randomVersion();
+            switch (i % 4) {
+                case 0:  pairs.emplace_back(left, left);                     break;
+                case 1:  pairs.emplace_back(left, left + ".1");              break;
+                default: pairs.emplace_back(std::move(left), randomVersion()); break;
+            }
+        }
+        return pairs;
+    }
+
+} // namespace Starpack
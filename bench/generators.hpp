@@ -0,0 +1,75 @@
+#ifndef BENCH_GENERATORS_HPP
+#define BENCH_GENERATORS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @struct BenchScale
+ * @brief Size of the synthetic data a benchmark run works on.
+ */
+struct BenchScale
+{
+    size_t   packages     = 1000;  ///< Packages in the installed DB and repository index.
+    size_t   files        = 10;    ///< Files per package.
+    size_t   dependencies = 3;     ///< Maximum direct dependencies per package.
+    uint32_t seed         = 42;    ///< Seed of every random choice, for reproducible data.
+    uint32_t release      = 0;     ///< Raises every version, so release n+1 upgrades release n.
+};
+
+/**
+ * @class Generators
+ * @brief Writes synthetic installed.db files, repo.db.yaml indices and
+ *        .starpack archives in the formats Starpack itself produces.
+ *
+ * Package i is named "pkg<i>" (zero padded) and depends only on packages
+ * with a lower index, so every generated repository resolves.
+ */
+class Generators
+{
+public:
+    /// Name of package index i.
+    static std::string packageName(size_t index);
+
+    /// Version of package index i in the given release (a mix of dotted and suffixed forms).
+    static std::string packageVersion(size_t index, uint32_t release = 0);
+
+    /// The files shipped by package index i (relative, without leading slash).
+    static std::vector<std::string> packageFiles(size_t index, size_t files);
+
+    /// Direct dependencies of package index i.
+    static std::vector<std::string> packageDependencies(size_t index, const BenchScale& scale);
+
+    /**
+     * @brief Writes an installed.db with scale.packages blocks of
+     *        scale.files files each.
+     */
+    static bool writeInstalledDb(const std::string& path, const BenchScale& scale);
+
+    /**
+     * @brief Writes a repo.db.yaml describing scale.packages packages.
+     */
+    static bool writeRepoIndex(const std::string& path, const BenchScale& scale);
+
+    /**
+     * @brief Writes a gzip-compressed .starpack archive (metadata.yaml,
+     *        files/ and one hook) for package index i with the given number
+     *        of files.
+     */
+    static bool writeArchive(const std::string& path, size_t index, size_t files,
+                             const BenchScale& scale);
+
+    /**
+     * @brief Pairs of version strings for comparison benchmarks: random
+     *        dotted versions with suffixes, equal pairs and prefixes.
+     */
+    static std::vector<std::pair<std::string, std::string>> versionPairs(size_t count,
+                                                                         uint32_t seed);
+};
+
+} // namespace Starpack
+
+#endif // BENCH_GENERATORS_HPP
@@ -0,0 +1,418 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "loopback_server.hpp" // Class definition
+
+#include <iostream>            // Standard I/O (cerr)
+#include <filesystem>          // Served paths
+#include <chrono>              // Latency and throttling
+#include <algorithm>           // std::all_of, std::transform
+#include <cctype>              // std::isalnum, std::tolower
+#include <vector>              // Send buffer
+#include <cstdio>              // snprintf
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <fcntl.h>             // open
+#include <unistd.h>            // close, pread
+#include <sys/stat.h>          // fstat
+#include <sys/socket.h>        // socket, bind, listen, accept, send
+#include <netinet/in.h>        // sockaddr_in
+#include <arpa/inet.h>         // htonl
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        // Largest request head that is accepted
+        constexpr size_t kMaxRequestHead = 16 * 1024;
+
+        bool validName(const std::string& name) {
+            if (name.empty() || name[0] == '.' || name.size() > 255) {
+                return false;
+            }
+            return std::all_of(name.begin(), name.end(), [](unsigned char c) {
+                return std::isalnum(c) || c == '.' || c == '-' || c == '_' || c == '+';
+            });
+        }
+
+        bool sendAll(int fd, const char* data, size_t size) {
+            size_t sent = 0;
+            while (sent < size) {
+                ssize_t n = send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool sendAll(int fd, const std::string& data) {
+            return sendAll(fd, data.data(), data.size());
+        }
+
+        bool sendStatus(int fd, int code, const std::string& reason, bool keepAlive,
+                        const std::string& extraHeaders = "") {
+            std::string body = (code == 304) ? "" : std::to_string(code) + " " + reason + "\n";
+            return sendAll(fd, "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n"
+                               "Content-Type: text/plain\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                               extraHeaders +
+                               (keepAlive ? "" : "Connection: close\r\n") +
+                               "\r\n" + body);
+        }
+
+        // Value of a header in the lower-cased request head ("" if absent)
+        std::string headerValue(const std::string& lowerHead, const std::string& name) {
+            size_t pos = lowerHead.find("\r\n" + name + ":");
+            if (pos == std::string::npos) {
+                return "";
+            }
+            pos += name.size() + 3;
+            size_t end = lowerHead.find("\r\n", pos);
+            std::string value = lowerHead.substr(pos, end == std::string::npos ? end : end - pos);
+            value.erase(0, value.find_first_not_of(" \t"));
+            value.erase(value.find_last_not_of(" \t") + 1);
+            return value;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * parseRange
+         *
+         * Accepts "bytes=a-b", "bytes=a-" and "bytes=-n". Returns false for
+         * anything else, including multiple ranges; the caller then sends
+         * the whole file.
+         * -------------------------------------------------------------------
+         */
+        bool parseRange(const std::string& value, off_t size, off_t& first, off_t& last,
+                        bool& satisfiable) {
+            satisfiable = true;
+            if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos) {
+                return false;
+            }
+            std::string spec = value.substr(6);
+            size_t dash = spec.find('-');
+            if (dash == std::string::npos) {
+                return false;
+            }
+            try {
+                if (dash == 0) {
+                    off_t suffix = std::stoll(spec.substr(1));
+                    first = suffix >= size ? 0 : size - suffix;
+                    last  = size - 1;
+                    satisfiable = suffix > 0 && size > 0;
+                } else {
+                    first = std::stoll(spec.substr(0, dash));
+                    last  = dash + 1 < spec.size() ? std::stoll(spec.substr(dash + 1)) : size - 1;
+                    last  = std::min(last, size - 1);
+                    satisfiable = first < size && first <= last;
+                }
+            } catch (const std::exception&) {
+                return false;
+            }
+            return true;
+        }
+
+        // Deterministic uniform value in [0, 1) for request number n
+        double uniform(uint32_t seed, uint64_t n) {
+            uint64_t z = (n + seed) * 0x9E3779B97F4A7C15ULL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            return static_cast<double>(z >> 11) / static_cast<double>(1ULL << 53);
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * LoopbackServer::start / stop
+     * ------------------------------------------------------------------------
+     */
+    LoopbackServer::~LoopbackServer() {
+        stop();
+    }
+
+    bool LoopbackServer::start(const LoopbackOptions& options) {
+        options_ = options;
+
+        listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) {
+            std::cerr << "Error: socket() failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+        socklen_t length = sizeof(addr);
+        if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd_, 128) != 0 ||
+            getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            std::cerr << "Error: Cannot listen on 127.0.0.1: " << strerror(errno) << std::endl;
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+
+        running_ = true;
+        acceptThread_ = std::thread(&LoopbackServer::acceptLoop, this);
+        return true;
+    }
+
+    void LoopbackServer::stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        shutdown(listenFd_, SHUT_RDWR);
+        if (acceptThread_.joinable()) {
+            acceptThread_.join();
+        }
+        close(listenFd_);
+        listenFd_ = -1;
+
+        // Connection threads notice within their receive timeout
+        while (connections_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::string LoopbackServer::url() const {
+        return "http://127.0.0.1:" + std::to_string(port_) + "/";
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LoopbackServer::stats / resetStats
+     * ------------------------------------------------------------------------
+     */
+    LoopbackStats LoopbackServer::stats() const {
+        LoopbackStats stats;
+        stats.requests    = requests_;
+        stats.bytes       = bytes_;
+        stats.notModified = notModified_;
+        stats.partial     = partial_;
+        stats.notFound    = notFound_;
+        stats.injected    = injected_;
+        return stats;
+    }
+
+    void LoopbackServer::resetStats() {
+        requests_ = bytes_ = notModified_ = partial_ = notFound_ = injected_ = 0;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LoopbackServer::acceptLoop
+     * ------------------------------------------------------------------------
+     */
+    void LoopbackServer::acceptLoop() {
+        while (running_) {
+            int sock = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (sock < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                break; // shutdown() by stop()
+            }
+            connections_++;
+            std::thread([this, sock]() {
+                handleConnection(sock);
+                connections_--;
+            }).detach();
+        }
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LoopbackServer::handleConnection
+     *
+     * Serves GET and HEAD requests on one keep-alive connection.
+     * ------------------------------------------------------------------------
+     */
+    void LoopbackServer::handleConnection(int sock) {
+        struct timeval timeout{ 0, 200 * 1000 };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::string buffer;
+        char chunk[4096];
+        bool keepAlive = true;
+
+        while (keepAlive && running_) {
+            size_t headEnd;
+            bool closed = false;
+            while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                if (buffer.size() > kMaxRequestHead || !running_) {
+                    closed = true;
+                    break;
+                }
+                ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                    continue;
+                }
+                if (n <= 0) {
+                    closed = true;
+                    break;
+                }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            if (closed) {
+                break;
+            }
+            std::string head = buffer.substr(0, headEnd);
+            buffer.erase(0, headEnd + 4);
+            requests_++;
+
+            // Request line: METHOD TARGET VERSION
+            std::string requestLine = head.substr(0, head.find("\r\n"));
+            size_t sp1 = requestLine.find(' ');
+            size_t sp2 = requestLine.rfind(' ');
+            if (sp1 == std::string::npos || sp2 == sp1) {
+                sendStatus(sock, 400, "Bad Request", false);
+                break;
+            }
+            std::string method = requestLine.substr(0, sp1);
+            std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+
+            std::string lowerHead = head;
+            std::transform(lowerHead.begin(), lowerHead.end(), lowerHead.begin(),
+                           [](unsigned char c){ return std::tolower(c); });
+            keepAlive = (requestLine.substr(sp2 + 1) == "HTTP/1.1") &&
+                        headerValue(lowerHead, "connection") != "close";
+
+            if (options_.latencyMs > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(options_.latencyMs));
+            }
+
+            if (options_.errorRate > 0 &&
+                uniform(options_.seed, sequence_++) < options_.errorRate) {
+                injected_++;
+                if (options_.errorStatus == 0) {
+                    break; // Drop the connection mid-request
+                }
+                if (!sendStatus(sock, options_.errorStatus, "Injected Error", keepAlive)) {
+                    break;
+                }
+                continue;
+            }
+
+            if (method != "GET" && method != "HEAD") {
+                sendStatus(sock, 405, "Method Not Allowed", false);
+                break;
+            }
+
+            std::string name = target.substr(0, target.find('?'));
+            if (!name.empty() && name[0] == '/') {
+                name.erase(0, 1);
+            }
+            int fd = validName(name) ?
+                     open((fs::path(options_.root) / name).c_str(), O_RDONLY | O_CLOEXEC) : -1;
+            struct stat st;
+            if (fd >= 0 && (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))) {
+                close(fd);
+                fd = -1;
+            }
+            if (fd < 0) {
+                notFound_++;
+                if (!sendStatus(sock, 404, "Not Found", keepAlive)) {
+                    break;
+                }
+                continue;
+            }
+
+            // Size and modification time identify a version of the file
+            char etag[64];
+            std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"",
+                          static_cast<unsigned long long>(st.st_size),
+                          static_cast<unsigned long long>(st.st_mtim.tv_sec) * 1000000000ULL +
+                          static_cast<unsigned long long>(st.st_mtim.tv_nsec));
+            std::string etagHeader = options_.etags ? "ETag: " + std::string(etag) + "\r\n" : "";
+
+            if (options_.etags) {
+                std::string match = headerValue(lowerHead, "if-none-match");
+                if (!match.empty() && (match == "*" || match.find(etag) != std::string::npos)) {
+                    close(fd);
+                    notModified_++;
+                    if (!sendStatus(sock, 304, "Not Modified", keepAlive, etagHeader)) {
+                        break;
+                    }
+                    continue;
+                }
+            }
+
+            off_t first = 0, last = st.st_size - 1;
+            bool partial = false;
+            std::string range = options_.ranges ? headerValue(lowerHead, "range") : "";
+            bool satisfiable = true;
+            if (!range.empty() && parseRange(range, st.st_size, first, last, satisfiable)) {
+                if (!satisfiable) {
+                    close(fd);
+                    if (!sendStatus(sock, 416, "Range Not Satisfiable", keepAlive,
+                                    "Content-Range: bytes */" + std::to_string(st.st_size) + "\r\n")) {
+                        break;
+                    }
+                    continue;
+                }
+                partial = true;
+                partial_++;
+            }
+            off_t length = st.st_size > 0 ? last - first + 1 : 0;
+
+            std::string response = partial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+            response += "Content-Type: application/octet-stream\r\n"
+                        "Content-Length: " + std::to_string(length) + "\r\n";
+            if (partial) {
+                response += "Content-Range: bytes " + std::to_string(first) + "-" +
+                            std::to_string(last) + "/" + std::to_string(st.st_size) + "\r\n";
+            }
+            if (options_.ranges) {
+                response += "Accept-Ranges: bytes\r\n";
+            }
+            response += etagHeader;
+            response += keepAlive ? "" : "Connection: close\r\n";
+            response += "\r\n";
+            bool ok = sendAll(sock, response);
+
+            // Body in slices, paced to the configured rate
+            size_t slice = 64 * 1024;
+            if (options_.bytesPerSecond > 0) {
+                slice = std::clamp<size_t>(static_cast<size_t>(options_.bytesPerSecond / 20),
+                                           1024, slice);
+            }
+            std::vector<char> data(slice);
+            auto begin = std::chrono::steady_clock::now();
+            off_t sent = 0;
+            while (ok && method == "GET" && sent < length) {
+                size_t want = static_cast<size_t>(std::min<off_t>(length - sent, slice));
+                ssize_t n = pread(fd, data.data(), want, first + sent);
+                if (n <= 0) {
+                    ok = false;
+                    break;
+                }
+                ok = sendAll(sock, data.data(), static_cast<size_t>(n));
+                sent += n;
+                bytes_ += static_cast<uint64_t>(n);
+                if (options_.bytesPerSecond > 0) {
+                    auto due = begin + std::chrono::microseconds(
+                        sent * 1000000LL / options_.bytesPerSecond);
+                    std::this_thread::sleep_until(due);
+                }
+            }
+            close(fd);
+            if (!ok) {
+                break;
+            }
+        }
+        close(sock);
+    }
+
+} // namespace Starpack
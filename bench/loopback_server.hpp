@@ -0,0 +1,98 @@
+#ifndef BENCH_LOOPBACK_SERVER_HPP
+#define BENCH_LOOPBACK_SERVER_HPP
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @struct LoopbackOptions
+ * @brief How a LoopbackServer shapes its responses.
+ */
+struct LoopbackOptions
+{
+    std::string root;                 ///< Directory whose plain files are served.
+    int         latencyMs      = 0;   ///< Delay before every response.
+    long long   bytesPerSecond = 0;   ///< Send rate of each response body (0 = unlimited).
+    double      errorRate      = 0.0; ///< Fraction of requests answered with errorStatus.
+    int         errorStatus    = 503; ///< Injected status; 0 drops the connection instead.
+    bool        etags          = true;  ///< Send ETag and honour If-None-Match.
+    bool        ranges         = true;  ///< Honour single "Range: bytes=" requests.
+    uint32_t    seed           = 42;    ///< Seed of the error injection.
+};
+
+/**
+ * @struct LoopbackStats
+ * @brief What a LoopbackServer has answered so far.
+ */
+struct LoopbackStats
+{
+    uint64_t requests    = 0; ///< Requests received.
+    uint64_t bytes       = 0; ///< Body bytes sent.
+    uint64_t notModified = 0; ///< 304 responses.
+    uint64_t partial     = 0; ///< 206 responses.
+    uint64_t notFound    = 0; ///< 404 responses.
+    uint64_t injected    = 0; ///< Injected errors and dropped connections.
+};
+
+/**
+ * @class LoopbackServer
+ * @brief A minimal HTTP/1.1 server on 127.0.0.1 for end-to-end tests.
+ *
+ * Serves the files of one directory on an ephemeral port from a background
+ * thread, with keep-alive, HEAD, ETag/If-None-Match and byte ranges.
+ * Latency, a per-response bandwidth cap and random errors can be injected
+ * so download paths can be measured against a slow or flaky repository
+ * without leaving the machine.
+ */
+class LoopbackServer
+{
+public:
+    LoopbackServer() = default;
+    ~LoopbackServer();
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    /**
+     * @brief Binds an ephemeral loopback port and starts serving.
+     * @return False if the socket cannot be set up.
+     */
+    bool start(const LoopbackOptions& options);
+
+    /// Stops accepting connections and waits for the accept thread.
+    void stop();
+
+    /// Base URL of the server, ending in '/'.
+    std::string url() const;
+
+    /// Counters since start() or the last resetStats().
+    LoopbackStats stats() const;
+    void resetStats();
+
+private:
+    void acceptLoop();
+    void handleConnection(int sock);
+
+    LoopbackOptions options_;
+    int             listenFd_ = -1;
+    int             port_     = 0;
+    std::thread     acceptThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int>  connections_{0};
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> notModified_{0};
+    std::atomic<uint64_t> partial_{0};
+    std::atomic<uint64_t> notFound_{0};
+    std::atomic<uint64_t> injected_{0};
+    std::atomic<uint64_t> sequence_{0};
+};
+
+} // namespace Starpack
+
+#endif // BENCH_LOOPBACK_SERVER_HPP
@@ -0,0 +1,453 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "generators.hpp"      // Synthetic DBs, indices and archives
+#include "install.hpp"         // Installer::resolveDependencies, extractPackage
+#include "update.hpp"          // Updater::compareVersions
+#include "version.hpp"         // Version::key
+#include "sync.hpp"            // Sync::installedEntries
+#include "hook.hpp"            // Hook::runNewStyleHooks
+#include "repository.hpp"      // Repository::createRepoIndex
+#include "memory_stats.hpp"    // Peak RSS and allocations per benchmark
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // JSON results, hook files
+#include <iomanip>             // Table formatting
+#include <filesystem>          // Work directory
+#include <functional>          // Benchmark bodies
+#include <chrono>              // Timing
+#include <algorithm>           // std::min, std::max
+#include <map>                 // Memory budgets
+#include <cstdlib>             // mkdtemp
+#include <unistd.h>            // geteuid
+#include <malloc.h>            // malloc_trim
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+using namespace Starpack;
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchOptions {
+        BenchScale  scale;
+        size_t      hooks         = 50;     // .hook files for hook matching
+        size_t      indexArchives = 32;     // archives for repository indexing
+        double      minTime       = 0.5;    // seconds per benchmark
+        std::string filter;                 // run only names containing this
+        std::string jsonPath;               // machine-readable results ("-" = stdout)
+        std::string workDir;                // generated data (temporary by default)
+        bool        keep          = false;  // keep workDir afterwards
+        std::map<std::string, double>   peakBudgets;   // benchmark -> MiB
+        std::map<std::string, uint64_t> allocBudgets;  // benchmark -> allocations
+    };
+
+    struct BenchResult {
+        std::string name;
+        uint64_t    iterations = 0;
+        uint64_t    items      = 0;  // items processed per iteration
+        double      minNs      = 0;
+        double      meanNs     = 0;
+        double      maxNs      = 0;
+        uint64_t    peakBytes  = 0;  // peak RSS growth of one iteration
+        uint64_t    allocs     = 0;  // allocations of one iteration
+        uint64_t    allocBytes = 0;
+    };
+
+    /**
+     * -----------------------------------------------------------------------
+     * QuietStdout
+     *
+     * The measured code logs progress to std::cout; that output would
+     * dominate the timings, so it is discarded while a benchmark runs.
+     * -----------------------------------------------------------------------
+     */
+    class QuietStdout {
+    public:
+        QuietStdout() : saved_(std::cout.rdbuf(nullptr)) {}
+        ~QuietStdout() {
+            std::cout.rdbuf(saved_);
+            std::cout.clear();
+        }
+    private:
+        std::streambuf* saved_;
+    };
+
+    /**
+     * -----------------------------------------------------------------------
+     * measure
+     *
+     * Runs body until minTime has passed (at least 3 and at most 10000
+     * times). setup, if given, runs before every iteration and is not
+     * timed. One more, untimed iteration measures how far the body raises
+     * the peak RSS and how many allocations it makes.
+     * -----------------------------------------------------------------------
+     */
+    BenchResult measure(const std::string& name, uint64_t items, double minTime,
+                        const std::function<void()>& body,
+                        const std::function<void()>& setup = nullptr) {
+        BenchResult result;
+        result.name  = name;
+        result.items = items;
+        result.minNs = 1e300;
+
+        double totalNs = 0;
+        QuietStdout quiet;
+        while (result.iterations < 3 ||
+               (totalNs < minTime * 1e9 && result.iterations < 10000)) {
+            if (setup) {
+                setup();
+            }
+            auto start = Clock::now();
+            body();
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            totalNs += ns;
+            result.minNs = std::min(result.minNs, ns);
+            result.maxNs = std::max(result.maxNs, ns);
+            result.iterations++;
+        }
+        result.meanNs = totalNs / result.iterations;
+
+        if (setup) {
+            setup();
+        }
+        // Give freed heap back first, so reused pages do not hide the peak
+        malloc_trim(0);
+        MemoryStats::resetPeak();
+        MemoryStats::Sample before = MemoryStats::sample();
+        MemoryStats::start(true);
+        body();
+        MemoryStats::Allocations allocations = MemoryStats::allocations();
+        MemoryStats::stop();
+        MemoryStats::Sample after = MemoryStats::sample();
+        result.peakBytes  = after.hwm > before.rss ? after.hwm - before.rss : 0;
+        result.allocs     = allocations.count;
+        result.allocBytes = allocations.bytes;
+        return result;
+    }
+
+    void printResult(std::ostream& out, const BenchResult& r) {
+        double perSecond = r.meanNs > 0 ? r.items * 1e9 / r.meanNs : 0;
+        out << std::left << std::setw(24) << r.name << std::right
+            << std::setw(8) << r.iterations
+            << std::setw(14) << std::fixed << std::setprecision(3) << r.meanNs / 1e6
+            << std::setw(14) << r.minNs / 1e6
+            << std::setw(16) << std::setprecision(0) << perSecond
+            << std::setw(12) << std::setprecision(1) << r.peakBytes / (1024.0 * 1024.0)
+            << std::setw(12) << r.allocs << std::endl;
+    }
+
+    bool writeJson(const BenchOptions& options, const std::vector<BenchResult>& results) {
+        std::ofstream file;
+        std::ostream* out = &std::cout;
+        if (options.jsonPath != "-") {
+            file.open(options.jsonPath, std::ios::trunc);
+            if (!file) {
+                std::cerr << "Error: Cannot write " << options.jsonPath << std::endl;
+                return false;
+            }
+            out = &file;
+        }
+
+        *out << std::fixed << std::setprecision(0)
+             << "{\"tool\":\"starpack_bench\",\"format\":1,"
+             << "\"scale\":{\"packages\":" << options.scale.packages
+             << ",\"files\":" << options.scale.files
+             << ",\"dependencies\":" << options.scale.dependencies
+             << ",\"hooks\":" << options.hooks
+             << ",\"index_archives\":" << options.indexArchives
+             << ",\"seed\":" << options.scale.seed << "},\"results\":[";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            *out << (i ? "," : "") << "\n{\"name\":\"" << r.name << "\""
+                 << ",\"iterations\":" << r.iterations
+                 << ",\"items\":" << r.items
+                 << ",\"min_ns\":" << r.minNs
+                 << ",\"mean_ns\":" << r.meanNs
+                 << ",\"max_ns\":" << r.maxNs
+                 << ",\"items_per_second\":" << (r.meanNs > 0 ? r.items * 1e9 / r.meanNs : 0)
+                 << ",\"peak_bytes\":" << r.peakBytes
+                 << ",\"allocs\":" << r.allocs
+                 << ",\"alloc_bytes\":" << r.allocBytes
+                 << "}";
+        }
+        *out << "\n]}\n";
+        return static_cast<bool>(out->flush());
+    }
+
+    void printUsage() {
+        std::cerr << "Usage: starpack_bench [options]\n"
+                  << "  --packages <n>        Packages in the synthetic DB and index (1000)\n"
+                  << "  --files <n>           Files per package (10)\n"
+                  << "  --deps <n>            Maximum dependencies per package (3)\n"
+                  << "  --hooks <n>           Hook files for hook matching (50)\n"
+                  << "  --index-archives <n>  Archives for repository indexing (32)\n"
+                  << "  --seed <n>            Seed of the generated data (42)\n"
+                  << "  --min-time <seconds>  Minimum time per benchmark (0.5)\n"
+                  << "  --filter <text>       Run only benchmarks whose name contains text\n"
+                  << "  --json <file|->       Write machine-readable results\n"
+                  << "  --max-peak <name>=<MiB>   Fail if a benchmark raises the peak RSS more\n"
+                  << "  --max-allocs <name>=<n>   Fail if one iteration allocates more often\n"
+                  << "  --workdir <dir>       Where to generate data (temporary directory)\n"
+                  << "  --keep                Keep the generated data\n";
+    }
+
+    bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--keep") {
+                options.keep = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                if      (arg == "--packages")       options.scale.packages     = std::stoul(value);
+                else if (arg == "--files")          options.scale.files        = std::stoul(value);
+                else if (arg == "--deps")           options.scale.dependencies = std::stoul(value);
+                else if (arg == "--hooks")          options.hooks              = std::stoul(value);
+                else if (arg == "--index-archives") options.indexArchives      = std::stoul(value);
+                else if (arg == "--seed")           options.scale.seed         = std::stoul(value);
+                else if (arg == "--min-time")       options.minTime            = std::stod(value);
+                else if (arg == "--filter")         options.filter             = value;
+                else if (arg == "--json")           options.jsonPath           = value;
+                else if (arg == "--workdir")        options.workDir            = value;
+                else if (arg == "--max-peak" || arg == "--max-allocs") {
+                    size_t equals = value.find('=');
+                    if (equals == std::string::npos) {
+                        return false;
+                    }
+                    std::string name = value.substr(0, equals);
+                    if (arg == "--max-peak") {
+                        options.peakBudgets[name] = std::stod(value.substr(equals + 1));
+                    } else {
+                        options.allocBudgets[name] = std::stoull(value.substr(equals + 1));
+                    }
+                }
+                else return false;
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            }
+        }
+        return options.scale.packages > 0;
+    }
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    bool temporary = options.workDir.empty();
+    if (temporary) {
+        std::string pattern = (fs::temp_directory_path() / "starpack_bench.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            std::cerr << "Error: Cannot create a temporary directory." << std::endl;
+            return 1;
+        }
+        options.workDir = pattern;
+    }
+
+    const BenchScale& scale = options.scale;
+    fs::path work     = options.workDir;
+    fs::path root     = work / "root";
+    fs::path dbDir    = root / "var" / "lib" / "starpack";
+    fs::path dbPath   = dbDir / "installed.db";
+    fs::path indexPath = work / "repo.db.yaml";
+    fs::path repoDir  = work / "repo";
+    fs::path archive  = work / "extract.starpack";
+    fs::path hookDir  = root / "etc" / "starpack" / "hooks" / "bench";
+
+    // ------------------------------------------------------------------
+    // Generate the data set
+    // ------------------------------------------------------------------
+    std::cerr << "Generating " << scale.packages << " packages x " << scale.files
+              << " files in " << work.string() << "..." << std::endl;
+    auto genStart = Clock::now();
+    std::error_code ec;
+    fs::create_directories(dbDir / "cache", ec);
+    fs::create_directories(repoDir, ec);
+    fs::create_directories(hookDir, ec);
+
+    bool generated = Generators::writeInstalledDb(dbPath.string(), scale) &&
+                     Generators::writeRepoIndex(indexPath.string(), scale) &&
+                     Generators::writeArchive(archive.string(), 0, scale.files, scale);
+    for (size_t i = 0; generated && i < std::min(options.indexArchives, scale.packages); i++) {
+        fs::path path = repoDir / (Generators::packageName(i) + "-" +
+                                   Generators::packageVersion(i) + ".starpack");
+        generated = Generators::writeArchive(path.string(), i, scale.files, scale);
+    }
+    for (size_t h = 0; generated && h < options.hooks; h++) {
+        // None of them matches, so only parsing and matching is measured
+        std::ofstream hook(hookDir / ("bench-" + std::to_string(h) + ".hook"));
+        hook << "[Hook]\nName = bench-" << h << "\nDescription = Synthetic hook\n\n"
+             << "[When]\nPhase = PostInstall\nOperation = Install\n"
+             << "Paths = usr/lib/nomatch-" << h << "/*\n\n"
+             << "[Exec]\nCommand = /bin/true\n";
+        generated = static_cast<bool>(hook);
+    }
+    if (!generated) {
+        std::cerr << "Error: Generating the benchmark data failed." << std::endl;
+        return 1;
+    }
+    std::cerr << "Generated in " << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double>(Clock::now() - genStart).count() << " s."
+              << std::endl;
+
+    // Inputs shared by several benchmarks
+    std::vector<std::string> names;
+    for (size_t i = 0; i < scale.packages; i++) {
+        names.push_back(Generators::packageName(i));
+    }
+    PackageSourceCache sources;
+    {
+        YAML::Node index = YAML::LoadFile(indexPath.string());
+        for (const auto& node : index["packages"]) {
+            sources[node["name"].as<std::string>()] = { "file://" + repoDir.string() + "/", node };
+        }
+    }
+    std::vector<std::pair<std::string, std::string>> versions =
+        Generators::versionPairs(10000, scale.seed);
+    std::vector<std::pair<std::string, std::string>> versionKeys;   // as stored in indices
+    for (const auto& [a, b] : versions) {
+        versionKeys.emplace_back(Version::indexKey(a), Version::indexKey(b));
+    }
+    std::vector<std::string> hookPaths = Generators::packageFiles(0, scale.files);
+
+    ResolvedPackage extractTarget;
+    extractTarget.name        = Generators::packageName(0);
+    extractTarget.archivePath = archive.string();
+    extractTarget.metadata    = sources[extractTarget.name].second;
+    fs::path extractRoot      = work / "extract-root";
+
+    // ------------------------------------------------------------------
+    // Benchmarks
+    // ------------------------------------------------------------------
+    struct Benchmark {
+        std::string              name;
+        uint64_t                 items;
+        std::function<void()>    body;
+        std::function<void()>    setup;
+    };
+    volatile long sink = 0;
+    std::vector<Benchmark> benchmarks = {
+        { "version_compare", versions.size(), [&] {
+            long sum = 0;
+            for (const auto& [a, b] : versions) {
+                sum += Updater::compareVersions(a, b);
+            }
+            sink = sink + sum;
+        }, nullptr },
+        { "version_key_compare", versionKeys.size(), [&] {
+            long sum = 0;
+            for (const auto& [a, b] : versionKeys) {
+                sum += a.compare(b) > 0;
+            }
+            sink = sink + sum;
+        }, nullptr },
+        { "db_lookup_first", 1, [&] {
+            sink = sink + Installer::isPackageInstalled(names.front(), root.string());
+        }, nullptr },
+        { "db_lookup_last", 1, [&] {
+            sink = sink + Installer::isPackageInstalled(names.back(), root.string());
+        }, nullptr },
+        { "db_update_date", 1, [&] {
+            sink = sink + Installer::getInstalledPackageUpdateDate(names[names.size() / 2],
+                                                                  dbPath.string());
+        }, nullptr },
+        { "db_parse_all", scale.packages, [&] {
+            sink = sink + Sync::installedEntries(root.string()).size();
+        }, nullptr },
+        { "index_parse", scale.packages, [&] {
+            PackageSourceCache parsed;
+            YAML::Node index = YAML::LoadFile(indexPath.string());
+            for (const auto& node : index["packages"]) {
+                std::string name = node["name"].as<std::string>();
+                if (parsed.find(name) == parsed.end()) {
+                    parsed[name] = { "file:///bench/", YAML::Clone(node) };
+                }
+            }
+            sink = sink + parsed.size();
+        }, nullptr },
+        { "resolve_all", scale.packages, [&] {
+            std::vector<std::string> order;
+            Installer::resolveDependencies(names, sources,
+                                           [](const std::string&) { return false; }, order);
+            sink = sink + order.size();
+        }, nullptr },
+        { "hook_match", options.hooks, [&] {
+            sink = sink + Hook::runNewStyleHooks("PostInstall", "Install", hookPaths,
+                                                 root.string(), std::string("bench"));
+        }, nullptr },
+        { "extract_package", scale.files, [&] {
+            std::vector<StoredObject> stored;
+            sink = sink + Installer::extractPackage(extractTarget, extractRoot.string(),
+                                                    false, stored);
+        }, [&] {
+            std::error_code removeError;
+            fs::remove_all(extractRoot, removeError);
+            fs::create_directories(extractRoot / "var" / "lib" / "starpack" / "cache", removeError);
+        } },
+    };
+    // Repository::createRepoIndex unpacks into /var/lib/cache, which needs root
+    if (geteuid() == 0) {
+        benchmarks.push_back({ "repo_index", std::min(options.indexArchives, scale.packages), [&] {
+            Repository::createRepoIndex(repoDir.string());
+        }, nullptr });
+    } else {
+        std::cerr << "Skipping repo_index (needs root)." << std::endl;
+    }
+
+    // With --json -, stdout carries only the JSON document
+    std::ostream& table = options.jsonPath == "-" ? std::cerr : std::cout;
+    table << std::left << std::setw(24) << "benchmark" << std::right
+              << std::setw(8) << "iters" << std::setw(14) << "mean ms"
+              << std::setw(14) << "min ms" << std::setw(16) << "items/s"
+              << std::setw(12) << "peak MiB" << std::setw(12) << "allocs" << std::endl;
+
+    std::vector<BenchResult> results;
+    for (const auto& benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(measure(benchmark.name, benchmark.items, options.minTime,
+                                  benchmark.body, benchmark.setup));
+        printResult(table, results.back());
+    }
+
+    bool ok = options.jsonPath.empty() || writeJson(options, results);
+
+    // Memory budgets
+    for (const auto& r : results) {
+        auto peak = options.peakBudgets.find(r.name);
+        if (peak != options.peakBudgets.end() && r.peakBytes > peak->second * 1024 * 1024) {
+            std::cerr << "Budget exceeded: " << r.name << " raised the peak by "
+                      << std::setprecision(2) << r.peakBytes / (1024.0 * 1024.0)
+                      << " MiB (budget " << peak->second << " MiB)" << std::endl;
+            ok = false;
+        }
+        auto allocs = options.allocBudgets.find(r.name);
+        if (allocs != options.allocBudgets.end() && r.allocs > allocs->second) {
+            std::cerr << "Budget exceeded: " << r.name << " made " << r.allocs
+                      << " allocations (budget " << allocs->second << ")" << std::endl;
+            ok = false;
+        }
+    }
+
+    if (temporary && !options.keep) {
+        fs::remove_all(work, ec);
+    } else {
+        std::cerr << "Data kept in " << work.string() << std::endl;
+    }
+    return ok ? 0 : 1;
+}
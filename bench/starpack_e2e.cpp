@@ -0,0 +1,537 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "generators.hpp"      // Synthetic archives and indices
+#include "loopback_server.hpp" // Local HTTP repository
+#include "download.hpp"        // parseRate
+#include "sync.hpp"            // Sync::installedEntries
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // repos.conf, JSON results
+#include <iomanip>             // Table formatting
+#include <filesystem>          // Work directory
+#include <functional>          // Scenario steps
+#include <chrono>              // Timing
+#include <algorithm>           // std::min, std::max
+#include <map>                 // Expected versions, memory budgets
+#include <cstdlib>             // mkdtemp, setenv
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <fcntl.h>             // open
+#include <unistd.h>            // fork, execv, dup2, geteuid
+#include <sched.h>             // unshare
+#include <sys/mount.h>         // mount
+#include <sys/wait.h>          // wait4
+#include <sys/resource.h>      // Peak RSS of each starpack run
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+using namespace Starpack;
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct E2eOptions {
+        BenchScale      scale;
+        LoopbackOptions server;
+        std::string     starpack;          // binary under test
+        int             runs     = 3;      // timed runs per scenario
+        std::string     filter;            // run only names containing this
+        std::string     jsonPath;          // machine-readable results ("-" = stdout)
+        std::string     workDir;           // repository, roots and logs
+        bool            keep     = false;  // keep workDir afterwards
+        std::map<std::string, double> rssBudgets;  // scenario -> MiB
+    };
+
+    struct E2eResult {
+        std::string   name;
+        int           runs     = 0;
+        int           failures = 0;
+        double        minMs    = 0;
+        double        meanMs   = 0;
+        double        maxMs    = 0;
+        uint64_t      peakRss  = 0;       // largest starpack RSS of a timed run
+        LoopbackStats traffic;            // summed over all timed runs
+    };
+
+    /**
+     * -----------------------------------------------------------------------
+     * Harness
+     *
+     * Paths of one run and the helpers that drive the starpack binary. The
+     * binary reads /etc/starpack/repos.conf, so every invocation runs in a
+     * private mount namespace with etcDir bound over /etc/starpack; the
+     * host configuration is never touched.
+     * -----------------------------------------------------------------------
+     */
+    struct Harness {
+        E2eOptions options;
+        fs::path   work, etcDir, gnupgDir, publicKey, served, root, logDir;
+        std::vector<std::string> names;
+        int        invocation = 0;
+        uint64_t   peakRss    = 0;      // largest ru_maxrss since it was last reset
+
+        bool shell(const std::string& command) const {
+            return std::system(command.c_str()) == 0;
+        }
+
+        // Runs starpack with args against root; output goes to a log file
+        bool starpack(const std::vector<std::string>& args, const std::string& label) {
+            std::string logPath = (logDir / (std::to_string(invocation++) + "-" + label + ".log"))
+                                      .string();
+            pid_t pid = fork();
+            if (pid < 0) {
+                std::cerr << "Error: fork() failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            if (pid == 0) {
+                int log = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                // Every prompt is answered with the default (yes)
+                int input = open("/dev/null", O_RDONLY);
+                if (log < 0 || input < 0 || dup2(log, 1) < 0 || dup2(log, 2) < 0 ||
+                    dup2(input, 0) < 0) {
+                    _exit(126);
+                }
+                if (unshare(CLONE_NEWNS) != 0 ||
+                    mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) != 0 ||
+                    mount(etcDir.c_str(), "/etc/starpack", nullptr, MS_BIND, nullptr) != 0) {
+                    std::fprintf(stderr, "starpack_e2e: mount namespace: %s\n", strerror(errno));
+                    _exit(126);
+                }
+                std::vector<char*> argv;
+                argv.push_back(const_cast<char*>(options.starpack.c_str()));
+                for (const auto& arg : args) {
+                    argv.push_back(const_cast<char*>(arg.c_str()));
+                }
+                argv.push_back(nullptr);
+                execv(argv[0], argv.data());
+                std::fprintf(stderr, "starpack_e2e: exec %s: %s\n", argv[0], strerror(errno));
+                _exit(127);
+            }
+            int status = 0;
+            struct rusage usage{};
+            while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+            }
+            peakRss = std::max(peakRss, static_cast<uint64_t>(usage.ru_maxrss) * 1024);
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if (!ok) {
+                std::cerr << "Warning: starpack " << label << " failed, see " << logPath << std::endl;
+            }
+            return ok;
+        }
+
+        // An empty root that trusts the repository key
+        bool freshRoot() {
+            std::error_code ec;
+            fs::remove_all(root, ec);
+            fs::create_directories(root / "etc" / "starpack" / "keys", ec);
+            fs::create_directories(root / "var" / "lib" / "starpack", ec);
+            return shell("gpg --batch --quiet --no-default-keyring --keyring '" +
+                         (root / "etc" / "starpack" / "keys" / "starpack.gpg").string() +
+                         "' --import '" + publicKey.string() + "' 2>/dev/null");
+        }
+
+        // Points the server at the given release of the repository
+        bool serve(uint32_t release) {
+            std::error_code ec;
+            fs::remove(served, ec);
+            fs::create_directory_symlink(work / ("repo-" + std::to_string(release)), served, ec);
+            return !ec;
+        }
+
+        bool installAll(const std::string& label) {
+            std::vector<std::string> args = { "install", "--installdir", root.string() };
+            args.insert(args.end(), names.begin(), names.end());
+            return starpack(args, label);
+        }
+
+        // Whether the root holds exactly the given release of every package
+        bool installedRelease(uint32_t release) const {
+            std::map<std::string, std::string> versions;
+            for (const auto& entry : Sync::installedEntries(root.string())) {
+                versions[entry.name] = entry.version;
+            }
+            if (versions.size() != names.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < names.size(); i++) {
+                if (versions[names[i]] != Generators::packageVersion(i, release)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /**
+     * -----------------------------------------------------------------------
+     * generateRepository
+     *
+     * Writes and signs one release of the repository into repo-<release>.
+     * -----------------------------------------------------------------------
+     */
+    bool generateRepository(Harness& h, uint32_t release) {
+        BenchScale scale = h.options.scale;
+        scale.release = release;
+        fs::path dir = h.work / ("repo-" + std::to_string(release));
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+
+        if (!Generators::writeRepoIndex((dir / "repo.db.yaml").string(), scale)) {
+            return false;
+        }
+        std::string sign = "GNUPGHOME='" + h.gnupgDir.string() +
+                           "' gpg --batch --yes --quiet --detach-sign '";
+        for (size_t i = 0; i < scale.packages; i++) {
+            fs::path archive = dir / (Generators::packageName(i) + "-" +
+                                      Generators::packageVersion(i, release) + ".starpack");
+            if (!Generators::writeArchive(archive.string(), i, scale.files, scale)) {
+                return false;
+            }
+            if (!h.shell(sign + archive.string() + "' 2>/dev/null")) {
+                std::cerr << "Error: Signing " << archive.string() << " failed." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * -----------------------------------------------------------------------
+     * runScenario
+     *
+     * setup (untimed) then step (timed) per run; check verifies the root
+     * afterwards. Server traffic is counted for the timed part only.
+     * -----------------------------------------------------------------------
+     */
+    E2eResult runScenario(Harness& h, LoopbackServer& server, const std::string& name,
+                          const std::function<bool()>& setup,
+                          const std::function<bool()>& step,
+                          const std::function<bool()>& check) {
+        E2eResult result;
+        result.name  = name;
+        result.minMs = 1e300;
+        double totalMs = 0;
+
+        for (int run = 0; run < h.options.runs; run++) {
+            if (setup && !setup()) {
+                std::cerr << "Error: Setup of " << name << " failed." << std::endl;
+                result.failures++;
+                continue;
+            }
+            server.resetStats();
+            h.peakRss = 0;
+            auto start = Clock::now();
+            bool ok = step();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            LoopbackStats traffic = server.stats();
+            ok = ok && (!check || check());
+
+            result.runs++;
+            result.failures += ok ? 0 : 1;
+            totalMs += ms;
+            result.minMs = std::min(result.minMs, ms);
+            result.maxMs = std::max(result.maxMs, ms);
+            result.peakRss = std::max(result.peakRss, h.peakRss);
+            result.traffic.requests    += traffic.requests;
+            result.traffic.bytes       += traffic.bytes;
+            result.traffic.notModified += traffic.notModified;
+            result.traffic.partial     += traffic.partial;
+            result.traffic.notFound    += traffic.notFound;
+            result.traffic.injected    += traffic.injected;
+        }
+        if (result.runs == 0) {
+            result.minMs = 0;
+        } else {
+            result.meanMs = totalMs / result.runs;
+        }
+        return result;
+    }
+
+    void printResult(std::ostream& out, const E2eResult& r) {
+        int runs = std::max(r.runs, 1);
+        out << std::left << std::setw(12) << r.name << std::right
+            << std::setw(6) << r.runs
+            << std::setw(6) << r.failures
+            << std::setw(12) << std::fixed << std::setprecision(1) << r.meanMs
+            << std::setw(12) << r.minMs
+            << std::setw(10) << r.traffic.requests / runs
+            << std::setw(12) << std::setprecision(0) << r.traffic.bytes / runs / 1024.0
+            << std::setw(6) << r.traffic.injected / runs
+            << std::setw(10) << std::setprecision(1) << r.peakRss / (1024.0 * 1024.0) << std::endl;
+    }
+
+    bool writeJson(const E2eOptions& options, const std::vector<E2eResult>& results) {
+        std::ofstream file;
+        std::ostream* out = &std::cout;
+        if (options.jsonPath != "-") {
+            file.open(options.jsonPath, std::ios::trunc);
+            if (!file) {
+                std::cerr << "Error: Cannot write " << options.jsonPath << std::endl;
+                return false;
+            }
+            out = &file;
+        }
+
+        const LoopbackOptions& s = options.server;
+        *out << std::fixed << std::setprecision(3)
+             << "{\"tool\":\"starpack_e2e\",\"format\":1,"
+             << "\"scale\":{\"packages\":" << options.scale.packages
+             << ",\"files\":" << options.scale.files
+             << ",\"dependencies\":" << options.scale.dependencies
+             << ",\"seed\":" << options.scale.seed << "},"
+             << "\"server\":{\"latency_ms\":" << s.latencyMs
+             << ",\"bytes_per_second\":" << s.bytesPerSecond
+             << ",\"error_rate\":" << s.errorRate
+             << ",\"error_status\":" << s.errorStatus
+             << ",\"etags\":" << (s.etags ? "true" : "false")
+             << ",\"ranges\":" << (s.ranges ? "true" : "false") << "},\"results\":[";
+        for (size_t i = 0; i < results.size(); i++) {
+            const E2eResult& r = results[i];
+            *out << (i ? "," : "") << "\n{\"name\":\"" << r.name << "\""
+                 << ",\"runs\":" << r.runs
+                 << ",\"failures\":" << r.failures
+                 << ",\"min_ms\":" << r.minMs
+                 << ",\"mean_ms\":" << r.meanMs
+                 << ",\"max_ms\":" << r.maxMs
+                 << ",\"requests\":" << r.traffic.requests
+                 << ",\"bytes\":" << r.traffic.bytes
+                 << ",\"not_modified\":" << r.traffic.notModified
+                 << ",\"partial\":" << r.traffic.partial
+                 << ",\"not_found\":" << r.traffic.notFound
+                 << ",\"injected\":" << r.traffic.injected
+                 << ",\"peak_rss_bytes\":" << r.peakRss << "}";
+        }
+        *out << "\n]}\n";
+        return static_cast<bool>(out->flush());
+    }
+
+    void printUsage() {
+        std::cerr << "Usage: starpack_e2e [options]   (run as root)\n"
+                  << "  --starpack <path>     Binary under test (starpack next to this tool)\n"
+                  << "  --packages <n>        Packages in the repository (20)\n"
+                  << "  --files <n>           Files per package (10)\n"
+                  << "  --deps <n>            Maximum dependencies per package (3)\n"
+                  << "  --seed <n>            Seed of the data and of error injection (42)\n"
+                  << "  --runs <n>            Timed runs per scenario (3)\n"
+                  << "  --latency <ms>        Server delay before every response (0)\n"
+                  << "  --rate <rate>         Server send rate per response, e.g. 2M (unlimited)\n"
+                  << "  --error-rate <f>      Fraction of requests that fail (0)\n"
+                  << "  --error-status <n>    Status of injected errors, 0 = drop connection (503)\n"
+                  << "  --no-etag             Do not send ETags or answer If-None-Match\n"
+                  << "  --no-range            Ignore Range requests\n"
+                  << "  --filter <text>       Run only scenarios whose name contains text\n"
+                  << "  --json <file|->       Write machine-readable results\n"
+                  << "  --max-rss <name>=<MiB>  Fail if starpack's peak RSS in a scenario is higher\n"
+                  << "  --workdir <dir>       Repository, roots and logs (temporary directory)\n"
+                  << "  --keep                Keep the work directory\n";
+    }
+
+    bool parseOptions(int argc, char* argv[], E2eOptions& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--keep" || arg == "--no-etag" || arg == "--no-range") {
+                options.keep          |= (arg == "--keep");
+                options.server.etags  &= (arg != "--no-etag");
+                options.server.ranges &= (arg != "--no-range");
+                continue;
+            }
+            if (i + 1 >= argc) {
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                if      (arg == "--starpack")     options.starpack            = value;
+                else if (arg == "--packages")     options.scale.packages      = std::stoul(value);
+                else if (arg == "--files")        options.scale.files         = std::stoul(value);
+                else if (arg == "--deps")         options.scale.dependencies  = std::stoul(value);
+                else if (arg == "--seed")         options.scale.seed          = std::stoul(value);
+                else if (arg == "--runs")         options.runs                = std::stoi(value);
+                else if (arg == "--latency")      options.server.latencyMs    = std::stoi(value);
+                else if (arg == "--error-rate")   options.server.errorRate    = std::stod(value);
+                else if (arg == "--error-status") options.server.errorStatus  = std::stoi(value);
+                else if (arg == "--filter")       options.filter              = value;
+                else if (arg == "--json")         options.jsonPath            = value;
+                else if (arg == "--workdir")      options.workDir             = value;
+                else if (arg == "--max-rss") {
+                    size_t equals = value.find('=');
+                    if (equals == std::string::npos) {
+                        return false;
+                    }
+                    options.rssBudgets[value.substr(0, equals)] = std::stod(value.substr(equals + 1));
+                }
+                else if (arg == "--rate") {
+                    if (!parseRate(value, options.server.bytesPerSecond)) {
+                        std::cerr << "Error: Invalid rate: " << value << std::endl;
+                        return false;
+                    }
+                }
+                else return false;
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            }
+        }
+        options.server.seed = options.scale.seed;
+        return options.scale.packages > 0 && options.runs > 0;
+    }
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    E2eOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    if (geteuid() != 0) {
+        std::cerr << "Error: starpack_e2e must run as root (it installs into temporary roots "
+                  << "and binds its own /etc/starpack)." << std::endl;
+        return 1;
+    }
+    if (options.starpack.empty()) {
+        std::error_code ec;
+        options.starpack = (fs::canonical("/proc/self/exe", ec).parent_path() / "starpack").string();
+    }
+    if (access(options.starpack.c_str(), X_OK) != 0) {
+        std::cerr << "Error: " << options.starpack << " is not executable (use --starpack)."
+                  << std::endl;
+        return 1;
+    }
+
+    bool temporary = options.workDir.empty();
+    if (temporary) {
+        std::string pattern = (fs::temp_directory_path() / "starpack_e2e.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            std::cerr << "Error: Cannot create a temporary directory." << std::endl;
+            return 1;
+        }
+        options.workDir = pattern;
+    }
+
+    Harness h;
+    h.options   = options;
+    h.work      = fs::absolute(options.workDir);
+    h.etcDir    = h.work / "etc";
+    h.gnupgDir  = h.work / "gnupg";
+    h.publicKey = h.work / "repo.pub";
+    h.served    = h.work / "served";
+    h.root      = h.work / "root";
+    h.logDir    = h.work / "logs";
+    for (size_t i = 0; i < options.scale.packages; i++) {
+        h.names.push_back(Generators::packageName(i));
+    }
+
+    std::error_code ec;
+    fs::create_directories(h.etcDir, ec);
+    fs::create_directories(h.logDir, ec);
+    fs::create_directories(h.gnupgDir, ec);
+    fs::permissions(h.gnupgDir, fs::perms::owner_all, ec);
+    // The bind mount needs a mount point
+    fs::create_directories("/etc/starpack", ec);
+
+    // ------------------------------------------------------------------
+    // Signing key and two releases of the repository
+    // ------------------------------------------------------------------
+    std::cerr << "Generating " << options.scale.packages << " packages x "
+              << options.scale.files << " files in " << h.work.string() << "..." << std::endl;
+    auto genStart = Clock::now();
+    std::string gpg = "GNUPGHOME='" + h.gnupgDir.string() + "' gpg --batch --quiet";
+    bool generated =
+        h.shell(gpg + " --passphrase '' --quick-gen-key 'starpack e2e <e2e@localhost>' "
+                      "ed25519 sign never 2>/dev/null") &&
+        h.shell(gpg + " --export > '" + h.publicKey.string() + "'") &&
+        generateRepository(h, 0) && generateRepository(h, 1) && h.serve(0);
+    if (!generated) {
+        std::cerr << "Error: Generating the test repository failed (is gpg installed?)." << std::endl;
+        return 1;
+    }
+    std::cerr << "Generated in " << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double>(Clock::now() - genStart).count() << " s."
+              << std::endl;
+
+    LoopbackServer server;
+    options.server.root = h.served.string();
+    if (!server.start(options.server)) {
+        return 1;
+    }
+    {
+        std::ofstream repos(h.etcDir / "repos.conf", std::ios::trunc);
+        repos << server.url() << "\n";
+    }
+    std::cerr << "Serving on " << server.url() << std::endl;
+
+    // ------------------------------------------------------------------
+    // Scenarios
+    // ------------------------------------------------------------------
+    struct Scenario {
+        std::string           name;
+        std::function<bool()> setup;
+        std::function<bool()> step;
+        std::function<bool()> check;
+    };
+    std::vector<Scenario> scenarios = {
+        { "search", nullptr, [&] {
+            return h.starpack({ "search", h.names.back() }, "search");
+        }, nullptr },
+        { "install", [&] {
+            return h.serve(0) && h.freshRoot();
+        }, [&] {
+            return h.installAll("install");
+        }, [&] { return h.installedRelease(0); } },
+        { "update", [&] {
+            return h.serve(0) && h.freshRoot() && h.installAll("update-setup") && h.serve(1);
+        }, [&] {
+            return h.starpack({ "update", "--installdir", h.root.string() }, "update");
+        }, [&] { return h.installedRelease(1); } },
+        { "remove", [&] {
+            return h.serve(0) && h.freshRoot() && h.installAll("remove-setup");
+        }, [&] {
+            std::vector<std::string> args = { "remove", "--installdir", h.root.string() };
+            args.insert(args.end(), h.names.rbegin(), h.names.rend());
+            return h.starpack(args, "remove");
+        }, [&] { return Sync::installedEntries(h.root.string()).empty(); } },
+    };
+
+    // With --json -, stdout carries only the JSON document
+    std::ostream& table = options.jsonPath == "-" ? std::cerr : std::cout;
+    table << std::left << std::setw(12) << "scenario" << std::right
+          << std::setw(6) << "runs" << std::setw(6) << "fail"
+          << std::setw(12) << "mean ms" << std::setw(12) << "min ms"
+          << std::setw(10) << "requests" << std::setw(12) << "KiB" << std::setw(6) << "err"
+          << std::setw(10) << "peak MiB" << std::endl;
+
+    std::vector<E2eResult> results;
+    for (const auto& scenario : scenarios) {
+        if (!options.filter.empty() && scenario.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(runScenario(h, server, scenario.name, scenario.setup,
+                                      scenario.step, scenario.check));
+        printResult(table, results.back());
+    }
+    server.stop();
+
+    bool ok = options.jsonPath.empty() || writeJson(options, results);
+    for (const auto& result : results) {
+        ok = ok && result.failures == 0;
+        auto budget = options.rssBudgets.find(result.name);
+        if (budget != options.rssBudgets.end() && result.peakRss > budget->second * 1024 * 1024) {
+            std::cerr << "Budget exceeded: " << result.name << " peaked at "
+                      << std::setprecision(2) << result.peakRss / (1024.0 * 1024.0)
+                      << " MiB (budget " << budget->second << " MiB)" << std::endl;
+            ok = false;
+        }
+    }
+
+    if (temporary && !options.keep) {
+        fs::remove_all(h.work, ec);
+    } else {
+        std::cerr << "Work directory kept in " << h.work.string() << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#ifndef BENCH_ENV_HPP
+#define BENCH_ENV_HPP
+
+#include <string>
+#include <vector>
+
+namespace Starpack {
+
+/**
+ * @struct BenchEnvOptions
+ * @brief Settings of a `starpack bench-env` run.
+ */
+struct BenchEnvOptions
+{
+    std::string              installDir = "/"; ///< Root whose disk is measured (temp dir under its cache).
+    std::vector<std::string> mirrors;          ///< Mirrors to probe (repos.conf if empty).
+    int                      archiveMiB = 64;  ///< Uncompressed size of the generated archive.
+};
+
+/**
+ * @class BenchEnv
+ * @brief Self-diagnostic that tells whether the disk, the CPU or the mirror
+ *        limits a transaction on this machine.
+ *
+ * Generates a package-like archive in a temporary directory under the
+ * root's package cache and measures, one stage at a time: synced disk
+ * writes, decompression, extraction, SHA-256 hashing, the fixed cost of a
+ * gpg signature check, and the latency and throughput of every mirror (a
+ * file:// stand-in for the generated archive when none is configured).
+ * Ends with the settings these numbers suggest. Nothing outside the
+ * temporary directory is modified.
+ */
+class BenchEnv
+{
+public:
+    /**
+     * @brief Runs every measurement and prints the report to standard output.
+     *
+     * @param options Root, mirrors and archive size to use.
+     * @return False if the temporary directory or the archive cannot be created.
+     */
+    static bool run(const BenchEnvOptions& options);
+};
+
+} // namespace Starpack
+
+#endif // BENCH_ENV_HPP
@@ -14,6 +14,46 @@ public:
      */
     static void clean();
 
+    /**
+     * @brief Applies CacheMaxAge and CacheMaxSize to the package archives
+     *        (and their signatures) in a cache directory.
+     *
+     * Archives older than CacheMaxAge days are removed first, then the
+     * least recently written ones until the rest fits in CacheMaxSize.
+     * Repository indices are left alone. Does nothing when neither is set.
+     *
+     * @param cacheDir The cache directory of a root.
+     */
+    static void enforceLimits(const std::string& cacheDir);
+
+    /// Suffix of the file next to a cached archive that records its SHA-256.
+    static constexpr const char* digestSuffix = ".sha256";
+
+    /**
+     * @brief Removes a cached archive (and its signature) whose SHA-256 is
+     *        not the one recorded in the repository index, so that a rebuild
+     *        published under the same file name is downloaded again.
+     *
+     * The archive's digest is taken from its digestSuffix file while that
+     * still matches the archive's size and mtime; only an archive without
+     * one (or one that changed since) is hashed, and the result recorded.
+     *
+     * @param archivePath    The archive in the cache.
+     * @param expectedSha256 The index's sha256; nothing is checked if empty.
+     * @return True if the archive was removed.
+     */
+    static bool discardIfStale(const std::string& archivePath, const std::string& expectedSha256);
+
+    /**
+     * @brief Records the SHA-256 of a cached archive, keyed by its size and
+     *        mtime, unless an up-to-date record exists. Called for archives
+     *        that passed signature verification, while they are still hot
+     *        in the page cache.
+     *
+     * @param archivePath The archive in the cache.
+     */
+    static void recordDigest(const std::string& archivePath);
+
 private:
     /**
      * @brief Helper function to delete files in a specified directory
@@ -0,0 +1,75 @@
+#ifndef CLONE_HPP
+#define CLONE_HPP
+
+#include <string>
+#include <vector>
+
+namespace Starpack {
+
+/**
+ * @brief How the files of a template root are shared with a clone.
+ */
+enum class CloneMode
+{
+    Reflink,   ///< Copy-on-write clones (FICLONE), plain copies where unsupported.
+    Hardlink,  ///< Hardlink read-only trees (usr/, package cache); reflink/copy the rest.
+    Overlay    ///< Mount an overlayfs with the template as the lower layer.
+};
+
+/**
+ * @class Clone
+ * @brief Provisions new roots from an already installed template root.
+ */
+class Clone
+{
+public:
+    /**
+     * @brief Duplicates a template root (including its installed.db) and then
+     *        installs or removes only the packages that should differ.
+     *
+     * With CloneMode::Overlay, `to` receives upper/, work/ and merged/
+     * directories and the overlay is mounted on merged/, which becomes the
+     * new root. Other mountpoints inside the template (proc, sys, ...) are
+     * recreated as empty directories.
+     *
+     * Hardlinked files are shared with the template: package installs and
+     * updates replace them, but editing them in place affects both roots.
+     *
+     * @param fromRoot   The installed template root.
+     * @param toRoot     The new root; must not exist or be empty.
+     * @param mode       How files are shared with the template.
+     * @param toInstall  Packages to add on top of the template.
+     * @param toRemove   Template packages to drop from the clone.
+     * @param confirm    If true, package installation asks for confirmation.
+     * @return True if the clone was created (package changes report their
+     *         own errors).
+     */
+    static bool cloneRoot(const std::string& fromRoot,
+                          const std::string& toRoot,
+                          CloneMode mode,
+                          const std::vector<std::string>& toInstall,
+                          const std::vector<std::string>& toRemove,
+                          bool confirm = true);
+
+    /**
+     * @brief Parses a clone mode name ("reflink", "hardlink" or "overlay").
+     *
+     * @param name The mode name.
+     * @param mode Receives the parsed mode.
+     * @return False if the name is unknown.
+     */
+    static bool parseMode(const std::string& name, CloneMode& mode);
+
+private:
+    /**
+     * @brief Mounts an overlay of fromRoot below toRoot/merged.
+     *
+     * @return The merged directory on success, an empty string on failure.
+     */
+    static std::string mountOverlay(const std::string& fromRoot,
+                                    const std::string& toRoot);
+};
+
+} // namespace Starpack
+
+#endif // CLONE_HPP
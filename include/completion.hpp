@@ -0,0 +1,76 @@
+#ifndef COMPLETION_HPP
+#define COMPLETION_HPP
+
+#include <string>
+#include <vector>
+
+namespace Starpack {
+
+/**
+ * @class Completion
+ * @brief Shell completion backed by compact package name lists.
+ *
+ * A name list is a small binary sidecar: the sorted, de-duplicated names
+ * (newline separated), an offset per name and a table with the first name
+ * for every possible leading byte. Prefix lookups mmap() the file, jump to
+ * the leading byte's range and binary-search within it, so completing never
+ * parses a repository index or the installed DB.
+ *
+ * Two lists are kept per root:
+ *  - cache/names.idx, rewritten by Installer::loadRepositoryIndex() whenever
+ *    a cached repository index is newer than it;
+ *  - installed.names next to installed.db, regenerated on the first
+ *    completion after installed.db changes (from an mmap() scan of the DB).
+ */
+class Completion
+{
+public:
+    /// File name of the repository name list inside the cache directory.
+    static constexpr const char* repoNamesFile = "names.idx";
+
+    /// File name of the installed name list next to installed.db.
+    static constexpr const char* installedNamesFile = "installed.names";
+
+    /**
+     * @brief Writes a name list atomically (temporary file + rename).
+     *
+     * @param path  Destination file.
+     * @param names Names in any order; duplicates and empty names are dropped.
+     * @return False if the file could not be written.
+     */
+    static bool writeNameIndex(const std::string& path, std::vector<std::string> names);
+
+    /**
+     * @brief True if the name list at path is missing or older than any of
+     *        the files it was built from.
+     */
+    static bool isStale(const std::string& path, const std::vector<std::string>& sources);
+
+    /**
+     * @brief Names in the list at path that start with prefix, in order.
+     *
+     * @param matches Receives the names (none if the list is unusable).
+     * @return False if the list is missing or malformed (its offsets or
+     *         leading-byte table point outside the file) and must be
+     *         rebuilt.
+     */
+    static bool lookup(const std::string& path, const std::string& prefix,
+                       std::vector<std::string>& matches);
+
+    /**
+     * @brief Implements the hidden `starpack __complete <words...>` command.
+     *
+     * words are the command-line words after "starpack", the last one being
+     * the word under the cursor (possibly empty). Candidates are printed one
+     * per line: command names for the first word, repository packages after
+     * install/info, installed packages after remove/update. `--installdir
+     * <dir>` among the words selects the root whose lists are used.
+     *
+     * @return Process exit code.
+     */
+    static int run(const std::vector<std::string>& words);
+};
+
+} // namespace Starpack
+
+#endif // COMPLETION_HPP
@@ -3,24 +3,154 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 
 namespace Starpack {
 
+/**
+ * @brief One repository of repos.conf.
+ *
+ * A line holds the repository URL, optionally followed by whitespace
+ * separated "key=value" fields:
+ *
+ *     https://repo.example.org/core/  priority=10  ttl=3600  mirror=https://mirror.example.net/core/
+ *
+ * '#' at the start of a line or of a field starts a comment.
+ */
+struct RepositoryConfig
+{
+    std::string              url;           ///< Base URL, always ending in '/'.
+    int                      priority = 0;  ///< priority: higher is consulted first; ties keep file order.
+    std::vector<std::string> mirrors;       ///< mirror (repeatable): bases serving the same files, tried in order.
+    int                      indexTtl = -1; ///< ttl: seconds a cached index is reused (-1 = until refreshed).
+
+    /// The URL followed by the mirrors.
+    std::vector<std::string> bases() const;
+};
+
+/**
+ * @brief How hard a transaction pushes its writes to stable storage.
+ */
+enum class Durability
+{
+    None,      ///< Leave write-back to the kernel (fastest).
+    Database,  ///< fsync installed.db after every change to it.
+    Full       ///< Also sync the root's file system before recording a package.
+};
+
+/**
+ * @brief Global options read from /etc/starpack/starpack.conf.
+ *
+ * The file holds "Key = Value" lines; '#' starts a comment. Unknown keys
+ * are reported and ignored, and a missing file leaves all defaults.
+ */
+struct Settings
+{
+    /// Location of the settings file.
+    static constexpr const char* defaultPath = "/etc/starpack/starpack.conf";
+
+    bool      lowImpact             = false;             ///< LowImpact
+    long long lowImpactDownloadRate = 4LL * 1024 * 1024;  ///< LowImpactDownloadRate (bytes/s)
+    long long lowImpactWriteRate    = 16LL * 1024 * 1024; ///< LowImpactWriteRate (bytes/s)
+    int       downloadConcurrencyMin = 1;                 ///< DownloadConcurrencyMin (per host)
+    int       downloadConcurrencyMax = 16;                ///< DownloadConcurrencyMax (per host)
+    int       jobs                  = 0;                  ///< Jobs (verification and root workers, 0 = one per CPU)
+    Durability durability           = Durability::None;   ///< Durability (none, db, full)
+    long long cacheMaxSize          = 0;                  ///< CacheMaxSize (bytes of archives, 0 = unlimited)
+    int       cacheMaxAge           = 0;                  ///< CacheMaxAge (days, 0 = unlimited)
+    std::vector<std::string> noExtract;                   ///< NoExtract (repeatable glob patterns)
+    std::string metricsTextfile;                          ///< MetricsTextfile (Prometheus, empty = off)
+    std::string metricsJson;                              ///< MetricsJson (empty = off)
+
+    /**
+     * @brief Number of workers for count independent items: Jobs if set,
+     *        otherwise one per item (parallelFor() caps it by the CPUs).
+     */
+    size_t workersFor(size_t count) const;
+
+    /**
+     * @brief True if a NoExtract pattern matches a path relative to the root
+     *        (e.g. "usr/share/doc/foo/README").
+     */
+    bool excludedFromExtraction(const std::string& relativePath) const;
+
+    /**
+     * @brief Loads the settings file.
+     * @param path Path to the settings file.
+     * @return The settings, with defaults for everything not set.
+     */
+    static Settings loadFromFile(const std::string& path = defaultPath);
+};
+
+/**
+ * @class Config
+ * @brief The parsed configuration: repos.conf and starpack.conf.
+ *
+ * Every subsystem reads the process-wide instance returned by current(),
+ * which is parsed once; the CLI replaces it with setCurrent() after
+ * applying its command-line overrides.
+ */
 class Config
 {
 public:
+    /// Location of the repository list.
+    static constexpr const char* defaultPath = "/etc/starpack/repos.conf";
+
     /**
-     * @brief A list of repository URLs.
+     * @brief The repositories in file order.
      */
-    std::vector<std::string> repositories;
+    std::vector<RepositoryConfig> repositories;
 
     /**
-     * @brief Loads configuration from a file on disk.
+     * @brief Global settings.
+     */
+    Settings settings;
+
+    /**
+     * @brief Loads the repository list from a file on disk.
      * @param path Path to the configuration file.
-     * @return A fully populated Config instance.
+     * @return A Config with the repositories and default settings.
      */
     static Config loadFromFile(const std::string& path);
 
+    /**
+     * @brief Loads both files; a missing repository list is not an error here.
+     * @param reposPath    Path to repos.conf.
+     * @param settingsPath Path to starpack.conf.
+     */
+    static Config load(const std::string& reposPath = defaultPath,
+                       const std::string& settingsPath = Settings::defaultPath);
+
+    /**
+     * @brief The process-wide configuration, loaded from the default paths
+     *        on first use.
+     */
+    static const Config& current();
+
+    /**
+     * @brief Replaces the process-wide configuration. Call before starting
+     *        any work that reads it.
+     */
+    static void setCurrent(const Config& config);
+
+    /**
+     * @brief The repository list at path: the process-wide one for the
+     *        default path, otherwise that file parsed the same way.
+     */
+    static Config forReposFile(const std::string& path);
+
+    /**
+     * @brief The repositories ordered by priority (stable).
+     */
+    std::vector<RepositoryConfig> byPriority() const;
+
+    /**
+     * @brief The same file at every mirror of the repository url belongs to.
+     * @param url URL of a file below a configured repository.
+     * @return The alternative URLs in mirror order; empty if there are none.
+     */
+    std::vector<std::string> mirrorUrlsFor(const std::string& url) const;
+
     /**
      * @brief Saves the current configuration to a file.
      * @param path Path to the file where configuration should be saved.
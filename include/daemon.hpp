@@ -0,0 +1,60 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <string>
+#include <vector>
+
+namespace Starpack {
+
+/**
+ * @struct DaemonOptions
+ * @brief Settings of a starpackd instance.
+ */
+struct DaemonOptions
+{
+    std::string socketPath;              ///< Unix socket to listen on (Daemon::defaultSocketPath if empty).
+    std::string installDir      = "/";   ///< Root whose installed.db is served.
+    int         refreshInterval = 300;   ///< Seconds between re-downloads of the repository indices.
+};
+
+/**
+ * @class Daemon
+ * @brief starpackd: keeps the merged repository view, the installed DB and
+ *        the search indices in memory and answers read-only queries over a
+ *        Unix socket.
+ *
+ * inotify watches repos.conf, installed.db and the cached repository
+ * indices, so the view is rebuilt as soon as an install, removal or
+ * `repo` change lands; the remote indices are additionally re-downloaded
+ * every refreshInterval seconds. `info`, `list` and `search` act as thin
+ * clients while the daemon is reachable and produce the same output as the
+ * standalone commands.
+ */
+class Daemon
+{
+public:
+    /// Socket used by clients and by default by the daemon.
+    static constexpr const char* defaultSocketPath = "/run/starpack/starpackd.sock";
+
+    /**
+     * @brief Loads the indices and serves queries until terminated.
+     *
+     * @param options Socket, root and refresh interval.
+     * @return False if the daemon cannot start.
+     */
+    static bool run(const DaemonOptions& options);
+
+    /**
+     * @brief Forwards a command to a running daemon and prints its answer.
+     *
+     * @param args     The command and its arguments (e.g. {"info", "bash"}).
+     * @param exitCode Receives the command's exit status.
+     * @return False if no daemon answered; the caller then runs the command
+     *         itself. Nothing has been printed in that case.
+     */
+    static bool query(const std::vector<std::string>& args, int& exitCode);
+};
+
+} // namespace Starpack
+
+#endif // DAEMON_HPP
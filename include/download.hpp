@@ -0,0 +1,81 @@
+#ifndef DOWNLOAD_HPP
+#define DOWNLOAD_HPP
+
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+#include <utility>  // For std::pair
+
+namespace Starpack {
+
+/**
+ * @brief Downloads a single file using a synchronous libcurl transfer.
+ *
+ * @param url        The URL to download from.
+ * @param outputPath The local destination path.
+ * @return True if the file already exists or was downloaded successfully,
+ *         false otherwise.
+ */
+bool downloadSingleFileSync(const std::string& url, const std::string& outputPath);
+
+/**
+ * @brief Downloads several files concurrently using the libcurl multi interface.
+ *
+ * Files that already exist at their destination are skipped. Data is
+ * written to "<path>.part" and renamed into place once complete. The number
+ * of parallel transfers per host adapts to the measured throughput (see
+ * setDownloadConcurrency()).
+ *
+ * @param filesToDownload A list of (URL, local destination path) pairs.
+ * @return True if every file is present after the call, false otherwise.
+ */
+bool downloadMultipleFilesMulti(const std::vector<std::pair<std::string, std::string>>& filesToDownload);
+
+/**
+ * @brief Like downloadMultipleFilesMulti(), then fetches every file that is
+ *        still missing from the mirrors of its repository (see
+ *        Config::mirrorUrlsFor()), trying them in order.
+ *
+ * @param filesToDownload A list of (URL, local destination path) pairs.
+ * @return True if every file is present after the call, false otherwise.
+ */
+bool downloadWithMirrors(const std::vector<std::pair<std::string, std::string>>& filesToDownload);
+
+/**
+ * @brief Caps the total receive rate of all downloads in this process.
+ *
+ * Concurrent transfers share the cap. Transfer timeouts are lifted while
+ * a cap is active.
+ *
+ * @param bytesPerSecond The cap in bytes per second (0 = unlimited).
+ */
+void setDownloadRateLimit(long long bytesPerSecond);
+
+/**
+ * @brief The current download cap in bytes per second (0 = unlimited).
+ */
+long long downloadRateLimit();
+
+/**
+ * @brief Sets the bounds for the number of parallel transfers per host.
+ *
+ * downloadMultipleFilesMulti() starts each host at 4 transfers (clamped to
+ * the bounds), adds one per second while that raises throughput and halves
+ * the count when a transfer stalls or fails.
+ *
+ * @param minTransfers Lower bound (at least 1).
+ * @param maxTransfers Upper bound (at least minTransfers).
+ */
+void setDownloadConcurrency(int minTransfers, int maxTransfers);
+
+/**
+ * @brief Parses a rate such as "512K", "2M" or "1048576".
+ *
+ * @param text           The rate; K, M and G suffixes are powers of 1024.
+ * @param bytesPerSecond Receives the rate in bytes per second.
+ * @return False if the text is not a valid rate.
+ */
+bool parseRate(const std::string& text, long long& bytesPerSecond);
+
+} // namespace Starpack
+
+#endif // DOWNLOAD_HPP
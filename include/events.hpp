@@ -0,0 +1,106 @@
+#ifndef EVENTS_HPP
+#define EVENTS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @struct Event
+ * @brief A step or progress report of a running operation.
+ */
+struct Event
+{
+    enum class Type {
+        Phase,    ///< A new phase started ("resolve", "download", "remove", "extract", "commit", "hooks").
+        Progress, ///< Progress within the current phase (done/total).
+        Error     ///< The operation failed; subject holds the message.
+    };
+
+    Type        type = Type::Phase;
+    std::string phase;     ///< Phase the event belongs to.
+    std::string subject;   ///< Package name, URL or message, depending on the event.
+    uint64_t    done  = 0; ///< Items or bytes completed (Progress).
+    uint64_t    total = 0; ///< Items or bytes expected, 0 if unknown (Progress).
+};
+
+/**
+ * @class EventHandler
+ * @brief Receives events and answers confirmation requests on behalf of a
+ *        library consumer. Override what you need.
+ *
+ * Calls are serialized, but may come from worker threads.
+ */
+class EventHandler
+{
+public:
+    virtual ~EventHandler() = default;
+
+    /**
+     * @brief Called for every event.
+     */
+    virtual void onEvent(const Event& event) { (void)event; }
+
+    /**
+     * @brief Called instead of the interactive [Y/n] prompt.
+     *
+     * @param action   What is about to happen ("install", "update", "sync", "apply").
+     * @param packages The packages affected.
+     * @return True to proceed.
+     */
+    virtual bool confirm(const std::string& action, const std::vector<std::string>& packages) {
+        (void)action;
+        (void)packages;
+        return true;
+    }
+};
+
+/**
+ * @class Events
+ * @brief Process-wide dispatch to the installed EventHandler.
+ *
+ * Without a handler every call is a no-op and the command-line behaviour
+ * (progress bars, stdin prompts) is unchanged. With one, download progress
+ * bars are replaced by Progress events and prompts by confirm().
+ */
+class Events
+{
+public:
+    /**
+     * @brief Installs a handler (nullptr removes it). The handler must
+     *        outlive every operation started while it is installed.
+     */
+    static void setHandler(EventHandler* handler);
+
+    /**
+     * @brief True if a handler is installed.
+     */
+    static bool active();
+
+    /**
+     * @brief Reports the start of a phase.
+     */
+    static void phase(const std::string& phase, const std::string& subject = "");
+
+    /**
+     * @brief Reports progress within a phase.
+     */
+    static void progress(const std::string& phase, const std::string& subject,
+                         uint64_t done, uint64_t total);
+
+    /**
+     * @brief Reports a failure.
+     */
+    static void error(const std::string& phase, const std::string& message);
+
+    /**
+     * @brief Asks the handler for confirmation; true if there is none.
+     */
+    static bool confirm(const std::string& action, const std::vector<std::string>& packages);
+};
+
+} // namespace Starpack
+
+#endif // EVENTS_HPP
@@ -0,0 +1,51 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <string>
+#include <vector>
+
+namespace Starpack {
+
+/**
+ * @class Image
+ * @brief Builds root filesystem images (e.g. for containers) directly from
+ *        package archives, without installing into a directory first.
+ */
+class Image
+{
+public:
+    /**
+     * @brief Resolves the dependency closure of the given packages and streams
+     *        their files into a single output archive.
+     *
+     * Entries are copied header-for-header from each package, so ownership and
+     * modes come from the package archives rather than from the filesystem;
+     * no root privileges are needed. Package hooks are placed under
+     * etc/starpack/hooks/<package>/ and a generated var/lib/starpack/installed.db
+     * is appended. Install hooks are not run.
+     *
+     * The output format is a pax tar archive; the compression filter is chosen
+     * from the file extension (.zst, .gz, .xz, .bz2, .lz4). An output of "-"
+     * writes an uncompressed tar to stdout (refused if stdout is a terminal);
+     * status output then goes to stderr.
+     *
+     * @param packageNames Packages requested by the user.
+     * @param outputPath   Path of the archive to create.
+     * @param keyringRoot  Root whose keyring is used to verify packages.
+     * @return True if the image was written completely.
+     */
+    static bool exportImage(const std::vector<std::string>& packageNames,
+                            const std::string& outputPath,
+                            const std::string& keyringRoot = "/");
+
+private:
+    /**
+     * @brief Returns the package cache directory used for image builds:
+     *        the system cache when running as root, a per-user cache otherwise.
+     */
+    static std::string imageCacheDir();
+};
+
+} // namespace Starpack
+
+#endif // IMAGE_HPP
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <iostream>
 
 /**
  * @class PackageInfo
@@ -55,9 +56,11 @@ public:
 
     /**
      * @brief Prints the package's metadata (name, version, description,
-     *        dependencies, and files) to standard output.
+     *        dependencies, and files).
+     *
+     * @param out Stream to print to (standard output by default).
      */
-    void display() const;
+    void display(std::ostream& out = std::cout) const;
 
 private:
     std::string name;
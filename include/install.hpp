@@ -6,9 +6,31 @@
 #include <ctime>             // For std::time_t (date/time)
 #include <yaml-cpp/yaml.h>   // For YAML::Node
 #include <unordered_map>     // For std::unordered_map, if needed
+#include <utility>           // For std::pair
+#include <functional>        // For std::function
+#include "object_store.hpp"  // For StoredObject
 
 namespace Starpack {
 
+/**
+ * @brief Merged view of all repository DBs: package name -> (repository URL,
+ *        package YAML node). The first repository providing a name wins.
+ */
+using PackageSourceCache = std::unordered_map<std::string, std::pair<std::string, YAML::Node>>;
+
+/**
+ * @struct ResolvedPackage
+ * @brief A package selected by dependency resolution, together with the
+ *        repository it comes from and its location in the local cache.
+ */
+struct ResolvedPackage
+{
+    std::string name;        ///< Package name.
+    std::string repoUrl;     ///< Repository URL (with trailing slash).
+    std::string archivePath; ///< Path of the .starpack archive in the cache.
+    YAML::Node  metadata;    ///< Repository metadata for the package.
+};
+
 /**
  * @class Installer
  * @brief Provides static methods for package installation processes, including
@@ -34,6 +56,110 @@ public:
                                const std::string& installDir = "/",
                                bool confirm = true);
 
+    /**
+     * @brief Installs the specified packages into several roots at once.
+     *
+     * Repositories are loaded, dependencies resolved, and archives downloaded
+     * and signature-checked only once, using the cache and keyring of the
+     * first root. Extraction and DB commits then run in parallel, one worker
+     * per root, each installing only what that root is missing.
+     *
+     * @param initialPackageNames A list of package names requested by the user.
+     * @param installDirs The root directories to install into.
+     * @param confirm If true, user confirmation is required before proceeding.
+     */
+    static void installPackage(const std::vector<std::string>& initialPackageNames,
+                               const std::vector<std::string>& installDirs,
+                               bool confirm);
+
+    /**
+     * @brief Reads repos.conf, downloads each repository DB into cacheDir and
+     *        merges all of them into a single package lookup table.
+     *
+     * @param cacheDir           Directory where repository DBs are cached.
+     * @param packageSourceCache Receives the merged package table.
+     * @param refresh            If true, cached repository DBs are downloaded again.
+     * @return True if at least one package definition was loaded.
+     */
+    static bool loadRepositoryIndex(const std::string& cacheDir,
+                                    PackageSourceCache& packageSourceCache,
+                                    bool refresh = false);
+
+    /**
+     * @brief Computes the dependency closure of the requested packages in
+     *        installation order (dependencies first).
+     *
+     * @param initialPackageNames Packages requested by the user.
+     * @param packageSourceCache  Merged repository table.
+     * @param isProvided          Called for names missing from the repositories;
+     *                            returns true if the package is already present.
+     * @param installOrder        Receives the ordered package names.
+     * @return True on success, false if a dependency cannot be satisfied.
+     */
+    static bool resolveDependencies(const std::vector<std::string>& initialPackageNames,
+                                    const PackageSourceCache& packageSourceCache,
+                                    const std::function<bool(const std::string&)>& isProvided,
+                                    std::vector<std::string>& installOrder);
+
+    /**
+     * @brief Downloads missing archives/signatures of the given packages into
+     *        the cache and verifies every signature.
+     *
+     * @param packages    Packages to fetch (archivePath must be set).
+     * @param keyringRoot Root directory whose keyring is used for verification.
+     * @return True if every package is cached and verified.
+     */
+    static bool fetchPackages(const std::vector<ResolvedPackage>& packages,
+                              const std::string& keyringRoot);
+
+    /**
+     * @brief Extracts one fetched and verified package into a root: files,
+     *        /etc/skel propagation and the package's .hook files.
+     *
+     * Does not run hooks or touch the DB.
+     *
+     * @param package        The package to extract.
+     * @param installDir     The target root directory.
+     * @param useObjectStore If true, regular files are linked from the object store.
+     * @param storedObjects  Receives the files linked from the object store.
+     * @return True on success.
+     */
+    static bool extractPackage(const ResolvedPackage& package,
+                               const std::string& installDir,
+                               bool useObjectStore,
+                               std::vector<StoredObject>& storedObjects);
+
+    /**
+     * @brief Lists the files of a package relative to the root (no leading '/').
+     *
+     * @param packageNode Repository metadata of the package.
+     * @return The file paths, as passed to hooks.
+     */
+    static std::vector<std::string> packageFilePaths(const YAML::Node& packageNode);
+
+    /**
+     * @brief Builds the node recorded in the DB for an extracted package.
+     *
+     * @param packageNode   Repository metadata of the package.
+     * @param storedObjects Files linked from the object store, if any.
+     * @return packageNode itself, or a copy carrying the object store fields.
+     */
+    static YAML::Node databaseNode(const YAML::Node& packageNode,
+                                   const std::vector<StoredObject>& storedObjects);
+
+    /**
+     * @brief Installs already fetched and verified packages into one root.
+     *
+     * Runs PreInstall hooks, extracts files, installs package hooks, records
+     * the DB entries and runs PostInstall hooks, in the given order.
+     *
+     * @param packages   Packages in installation order.
+     * @param installDir The target root directory.
+     * @return True if every package was installed successfully.
+     */
+    static bool installIntoRoot(const std::vector<ResolvedPackage>& packages,
+                                const std::string& installDir);
+
     /**
      * @brief Checks the local installation database to see if a package
      *        is recorded as installed.
@@ -55,6 +181,16 @@ public:
      */
     static bool getConfirmation(const std::vector<std::string>& packages);
 
+    /**
+     * @brief Renders the installed.db block for a package.
+     *
+     * @param packageName The name of the package.
+     * @param packageNode YAML data holding version, files, dependencies, etc.
+     * @return The DB block, terminated by the separator line.
+     */
+    static std::string formatDatabaseEntry(const std::string& packageName,
+                                           const YAML::Node& packageNode);
+
     /**
      * @brief Records metadata for an installed package into the local DB.
      *
@@ -0,0 +1,41 @@
+#ifndef LAZY_CURL_HPP
+#define LAZY_CURL_HPP
+
+namespace Starpack {
+
+/**
+ * @class LazyCurl
+ * @brief Loads libcurl (and with it TLS, HTTP/2, IDN, LDAP, ...) with
+ *        dlopen() on the first network call instead of at process start.
+ *
+ * When built with STARPACK_LAZY_CURL (the default), lazy_curl.cpp provides
+ * the curl_easy_* / curl_multi_* / curl_global_* functions Starpack uses as
+ * forwarding stubs, so callers keep using the libcurl API unchanged and
+ * local-only commands (list, info on an installed package, completion)
+ * never map the network stack. The stubs have hidden visibility and cannot
+ * interpose on a libcurl that the embedding program links itself.
+ *
+ * The library is looked up as $STARPACK_LIBCURL, libcurl.so.4,
+ * libcurl-gnutls.so.4 and libcurl.so, in that order.
+ */
+class LazyCurl
+{
+public:
+    /**
+     * @brief Loads libcurl if that has not happened yet. Thread-safe; a
+     *        failure is reported once on stderr.
+     *
+     * @return True if the curl functions are usable.
+     */
+    static bool load();
+
+    /**
+     * @brief True once libcurl has been loaded (always true when Starpack is
+     *        linked against libcurl directly).
+     */
+    static bool loaded();
+};
+
+} // namespace Starpack
+
+#endif // LAZY_CURL_HPP
@@ -0,0 +1,79 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @class Log
+ * @brief Leveled, asynchronous console output.
+ *
+ * start() installs a line-buffering stream buffer on std::cout and
+ * std::cerr: text is collected per thread, and every complete line becomes
+ * a record in a bounded lock-free ring. A background thread drains the ring
+ * and writes the records in batches, so neither `std::endl` nor a hot loop
+ * waits for the terminal. Explicit flushes (prompts, progress bars) still
+ * reach the terminal promptly, and output of concurrent threads is never
+ * interleaved within a line.
+ *
+ * Lines written to std::cout are Info records, lines written to std::cerr
+ * are Warn records if they start with "Warning" and Error records
+ * otherwise. In Json format every record is one JSON object per line on
+ * standard output, with ANSI colors stripped and progress redraws omitted.
+ *
+ * Before start() and after stop(), and in a forked child, all output is
+ * written synchronously.
+ */
+class Log
+{
+public:
+    enum class Level { Debug, Info, Warn, Error };
+    enum class Format { Text, Json };
+
+    /**
+     * @brief Routes std::cout and std::cerr through the logger and starts
+     *        the flusher thread.
+     *
+     * @param threshold Records below this level are discarded.
+     * @param format    Plain text or one JSON object per line.
+     */
+    static void start(Level threshold, Format format);
+
+    /**
+     * @brief Writes everything queued, stops the flusher and restores the
+     *        original stream buffers. Does nothing if not started.
+     */
+    static void stop();
+
+    /**
+     * @brief Blocks until everything queued so far has been written (e.g.
+     *        before running a child process that shares the terminal).
+     */
+    static void flush();
+
+    /// True if records of this level are kept; guards costly messages.
+    static bool enabled(Level level) {
+        return static_cast<int>(level) >= s_threshold.load(std::memory_order_relaxed);
+    }
+
+    /// Queues one message, tagged with its level in text format.
+    static void write(Level level, const std::string& message);
+
+    static void debug(const std::string& message) { if (enabled(Level::Debug)) write(Level::Debug, message); }
+    static void info(const std::string& message)  { if (enabled(Level::Info))  write(Level::Info, message); }
+    static void warn(const std::string& message)  { if (enabled(Level::Warn))  write(Level::Warn, message); }
+    static void error(const std::string& message) { write(Level::Error, message); }
+
+    /// Debug records dropped because the ring was full.
+    static uint64_t dropped();
+
+private:
+    static inline std::atomic<int> s_threshold{static_cast<int>(Level::Info)};
+};
+
+} // namespace Starpack
+
+#endif // LOG_HPP
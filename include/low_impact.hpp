@@ -0,0 +1,66 @@
+#ifndef LOW_IMPACT_HPP
+#define LOW_IMPACT_HPP
+
+#include <string>
+#include <cstddef>
+
+namespace Starpack {
+
+/**
+ * @class LowImpact
+ * @brief Keeps Starpack from competing with the workload of the host it
+ *        runs on: lower CPU and I/O priority, paced disk writes and no
+ *        lasting page-cache footprint.
+ */
+class LowImpact
+{
+public:
+    /**
+     * @brief Enables low-impact mode for this process.
+     *
+     * Sets nice 19 and the lowest best-effort I/O priority, paces file
+     * writes to writeBytesPerSecond and makes dropFromCache() effective.
+     * Must be called before worker threads are started.
+     *
+     * @param writeBytesPerSecond Extraction write cap (0 = unlimited).
+     */
+    static void enable(long long writeBytesPerSecond);
+
+    /**
+     * @brief True once enable() has been called.
+     */
+    static bool active();
+
+    /**
+     * @brief Accounts for `bytes` about to be written and sleeps as long as
+     *        needed to stay under the write cap. No-op unless active.
+     *
+     * Thread-safe; all writers of the process share one budget.
+     */
+    static void throttleWrite(size_t bytes);
+
+    /**
+     * @brief Drops a file's pages from the page cache (posix_fadvise
+     *        DONTNEED) once Starpack is done with it. No-op unless active.
+     *
+     * @param path    The file.
+     * @param written True if the file was just written; its dirty pages
+     *                are written back first so they can be dropped.
+     */
+    static void dropFromCache(const std::string& path, bool written);
+
+    /**
+     * @brief Moves the process into the idle I/O class (ioprio_set) and the
+     *        SCHED_IDLE CPU policy.
+     *
+     * Must be called before any worker threads are started; threads created
+     * afterwards inherit both settings. Failures are reported as warnings.
+     *
+     * @return True if both settings were applied.
+     */
+    static bool enterIdlePriority();
+};
+
+} // namespace Starpack
+
+#endif // LOW_IMPACT_HPP
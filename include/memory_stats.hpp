@@ -0,0 +1,92 @@
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace Starpack {
+
+/**
+ * @class MemoryStats
+ * @brief Memory use per phase for `--stats` and `--trace`.
+ *
+ * The outermost Trace::Span of each category samples the resident set
+ * size and its high-water mark when it opens and closes, so every phase
+ * reports how far it raised the peak. With allocation counting on (and
+ * the executable linked with alloc_hooks.cpp, see STARPACK_ALLOC_STATS),
+ * the replaced global operator new also counts allocations and requested
+ * bytes for the innermost phase open on the allocating thread. libstarpack
+ * itself never replaces the allocator. While disabled, the only
+ * cost is a relaxed atomic load per span and per allocation.
+ */
+class MemoryStats
+{
+public:
+    /// Resident set size and its high-water mark, in bytes.
+    struct Sample {
+        uint64_t rss = 0;
+        uint64_t hwm = 0;
+    };
+
+    /// Allocation totals (all phases, or one phase).
+    struct Allocations {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    /// Reads VmRSS and VmHWM of this process (/proc/self/status).
+    static Sample sample();
+
+    /**
+     * @brief Resets the high-water mark to the current RSS, so the next
+     *        sample reports the peak of what follows. Returns false if the
+     *        kernel does not support it.
+     */
+    static bool resetPeak();
+
+    /**
+     * @brief Starts per-phase accounting.
+     *
+     * @param countAllocations Also count allocations per phase.
+     */
+    static void start(bool countAllocations);
+
+    /// Prints the per-phase table to out and stops accounting.
+    static void report(std::ostream& out);
+
+    /// Stops accounting without a report.
+    static void stop();
+
+    /// True between start() and report().
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /// True while allocations are counted.
+    static bool countingAllocations() { return s_counting.load(std::memory_order_relaxed); }
+
+    /// Allocations counted so far, over all phases.
+    static Allocations allocations();
+
+    /// Called by Trace::Span when an outermost span of a phase opens; returns a token for phaseEnd.
+    static int phaseBegin(const char* phase);
+
+    /// Called when that span closes, with its duration and both samples.
+    static void phaseEnd(int token, uint64_t microseconds, const Sample& atStart, const Sample& atEnd);
+
+    /// Counts one allocation for the phase open on this thread (operator new).
+    static void countAllocation(size_t bytes);
+
+    /// Called during static initialization by the replaced operator new.
+    static void setAllocationHooksLinked() { s_hooked.store(true, std::memory_order_relaxed); }
+
+private:
+    static inline std::atomic<bool> s_enabled{false};
+    static inline std::atomic<bool> s_counting{false};
+    static inline std::atomic<bool> s_hooked{false};
+};
+
+} // namespace Starpack
+
+#endif // MEMORY_STATS_HPP
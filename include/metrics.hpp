@@ -0,0 +1,75 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @class Metrics
+ * @brief Summary of one transaction for monitoring, written after the run
+ *        as a Prometheus textfile-collector file and/or a JSON document.
+ *
+ * Enabled by MetricsTextfile / MetricsJson in starpack.conf. Collects
+ * downloaded bytes, cache hits and misses, the time spent per
+ * phase (the categories of Trace spans), changed packages, every hook run
+ * with its duration (summed per hook in the textfile), failures and the
+ * peak RSS. Both files are replaced
+ * atomically (temporary file, fsync, rename), so a collector never reads
+ * a partial summary. While disabled, every recording call tests one
+ * relaxed atomic flag and returns.
+ */
+class Metrics
+{
+public:
+    /**
+     * @brief Starts collecting for a transaction.
+     *
+     * @param command      The starpack command ("install", "update", ...).
+     * @param textfilePath Prometheus output (empty = none); should end in ".prom".
+     * @param jsonPath     JSON output (empty = none).
+     */
+    static void start(const std::string& command, const std::string& textfilePath,
+                      const std::string& jsonPath);
+
+    /**
+     * @brief Writes the summary and stops collecting. Does nothing if
+     *        collection was not started.
+     *
+     * @param exitCode The command's exit status. A non-zero status marks
+     *                 the transaction as failed (failure kind "exit") even
+     *                 if nothing else recorded a failure.
+     * @return False if an output file could not be written.
+     */
+    static bool finish(int exitCode);
+
+    /// True between start() and finish().
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /// Adds the time of an outermost span of a phase (Trace category).
+    static void addPhase(const char* phase, uint64_t microseconds);
+
+    /// Counts bytes received from a repository.
+    static void addDownload(uint64_t bytes);
+
+    /// Counts a repository file that was already cached (hit) or fetched (miss).
+    static void addCacheLookup(bool hit);
+
+    /// Counts a changed package ("install", "upgrade", "remove").
+    static void addPackageChange(const char* operation);
+
+    /// Records one hook run.
+    static void addHook(const std::string& name, uint64_t microseconds, bool ok);
+
+    /// Counts a failure of the given kind ("download", "verify", "extract", ...).
+    static void addFailure(const char* kind);
+
+private:
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+} // namespace Starpack
+
+#endif // METRICS_HPP
@@ -0,0 +1,114 @@
+#ifndef OBJECT_STORE_HPP
+#define OBJECT_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+struct archive;
+struct archive_entry;
+
+namespace Starpack {
+
+/**
+ * @struct StoredObject
+ * @brief A regular file of an installed package that is a hardlink into the
+ *        object store.
+ */
+struct StoredObject
+{
+    std::string id;   ///< Object ID ("<sha256>-<mode>-<uid>-<gid>").
+    std::string path; ///< Installed path, relative to the root (leading '/').
+};
+
+/**
+ * @class ObjectStore
+ * @brief Content-addressed store for installed files.
+ *
+ * When enabled, regular files are extracted once into the store, named by
+ * the SHA-256 of their content plus mode and owner (hardlinks share all
+ * three), and hardlinked into every root that installs them. Identical
+ * files across packages and roots then occupy a single inode. The store
+ * must live on the same filesystem as the roots; other roots fall back to
+ * plain extraction.
+ *
+ * Objects are shared: editing an installed file in place changes it for
+ * every root. Package installs and updates always replace files instead,
+ * and files meant to be edited (etc/, and whatever lies outside a
+ * package's update_dirs) get private copies. An object found with a
+ * different size than its content is replaced in the store.
+ */
+class ObjectStore
+{
+public:
+    /// Store location used when --dedup is given without --store.
+    static constexpr const char* defaultStoreDir = "/var/lib/starpack/objects";
+
+    /**
+     * @brief Enables the store at dir for this process (empty disables it).
+     */
+    static void setStoreDir(const std::string& dir);
+
+    /**
+     * @brief The configured store directory, or an empty string if disabled.
+     */
+    static const std::string& storeDir();
+
+    /**
+     * @brief Checks whether files for installDir can be hardlinked from the
+     *        store (store exists or can be created on the same filesystem).
+     */
+    static bool usableFor(const std::string& installDir);
+
+    /**
+     * @brief Consumes the data of the current regular-file entry of `a`,
+     *        adds it to the store if it is new and hardlinks it to destPath.
+     *
+     * @param a        Archive positioned at the entry's data.
+     * @param entry    The entry header (mode, owner, mtime are used).
+     * @param destPath Final path of the file inside the root.
+     * @param objectId Receives the object ID.
+     * @return True on success.
+     */
+    static bool linkEntry(struct archive* a, struct archive_entry* entry,
+                          const std::string& destPath, std::string& objectId);
+
+    /**
+     * @brief Reads the store directory and objects recorded for a package in
+     *        the installed DB.
+     *
+     * @param packageName The package name.
+     * @param dbPath      Path to installed.db.
+     * @param storeDir    Receives the "Object-store:" value (empty if none).
+     * @return The recorded objects (empty if the package was not deduplicated).
+     */
+    static std::vector<StoredObject> readPackageObjects(const std::string& packageName,
+                                                        const std::string& dbPath,
+                                                        std::string& storeDir);
+
+    /**
+     * @brief Deletes the given objects if no root links to them any more.
+     *
+     * @return The number of objects deleted.
+     */
+    static size_t releaseObjects(const std::string& storeDir,
+                                 const std::vector<StoredObject>& objects);
+
+    /**
+     * @brief Sweeps the whole store and deletes every unreferenced object
+     *        and stale temporary file.
+     *
+     * @return The number of objects deleted.
+     */
+    static size_t collectGarbage(const std::string& storeDir);
+
+private:
+    /**
+     * @brief Path of an object inside the store ("<store>/<id[0..1]>/<id>").
+     */
+    static std::string objectPath(const std::string& storeDir, const std::string& id);
+};
+
+} // namespace Starpack
+
+#endif // OBJECT_STORE_HPP
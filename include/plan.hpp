@@ -0,0 +1,67 @@
+#ifndef PLAN_HPP
+#define PLAN_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include "sync.hpp"   // For ManifestEntry, SyncPlan
+
+namespace Starpack {
+
+/**
+ * @class PlanFile
+ * @brief Splits a transaction into a networked "plan" step and an offline
+ *        "apply" step.
+ *
+ * `plan` resolves the transaction, downloads and verifies every archive
+ * into the root's cache and records the result: install order, package
+ * metadata and SHA-256 of each cached archive, the installed.db generation
+ * (its SHA-256) and the hook set that will run. `apply` replays exactly
+ * that transaction without network access and refuses to run if the
+ * cache, the DB or the hooks changed in between.
+ */
+class PlanFile
+{
+public:
+    /// Version of the plan file layout.
+    static constexpr int formatVersion = 1;
+
+    /**
+     * @brief Resolves, downloads and verifies a transaction and writes it to
+     *        outputPath.
+     *
+     * @param entries    Desired packages (see Sync::computePlan()).
+     * @param installDir The root directory the plan is for.
+     * @param outputPath Where to write the plan.
+     * @return True if the plan was written.
+     */
+    static bool create(const std::vector<ManifestEntry>& entries,
+                       const std::string& installDir,
+                       const std::string& outputPath);
+
+    /**
+     * @brief Checks a plan against the current state of its root and
+     *        executes it.
+     *
+     * @param planPath Path of a file written by create().
+     * @param confirm  If true, asks before changing anything.
+     * @return True if the plan was applied completely.
+     */
+    static bool apply(const std::string& planPath, bool confirm = true);
+
+private:
+    /**
+     * @brief Current generation of a root's installed.db (SHA-256 of its
+     *        contents, "empty" if there is none yet).
+     */
+    static std::string databaseGeneration(const std::string& installDir);
+
+    /**
+     * @brief Hook files that can run for a root, mapped to their SHA-256.
+     */
+    static std::map<std::string, std::string> hookSet(const std::string& installDir);
+};
+
+} // namespace Starpack
+
+#endif // PLAN_HPP
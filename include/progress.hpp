@@ -0,0 +1,77 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <string>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @class Progress
+ * @brief Consolidated progress display for concurrent work.
+ *
+ * An Activity is one line of the view ("Downloading", "Installing"); the
+ * Tasks of an activity (e.g. parallel transfers) only update atomic
+ * counters. A single renderer thread draws all running activities on one
+ * line about ten times per second while standard output is a terminal,
+ * and otherwise prints a plain status line every few seconds. Nothing is
+ * shown while library consumers receive events instead.
+ */
+class Progress
+{
+public:
+    enum class Unit { Bytes, Items };
+
+    struct State;
+    class Task;
+
+    /**
+     * @class Activity
+     * @brief Scoped activity; shown while it exists.
+     */
+    class Activity
+    {
+    public:
+        /**
+         * @param label         Shown at the start of the line.
+         * @param unit          What tasks count (bytes of transfers, or nothing).
+         * @param expectedTasks Number of tasks or steps expected (0 = unknown).
+         */
+        Activity(const std::string& label, Unit unit, uint64_t expectedTasks = 0);
+        ~Activity();
+        Activity(const Activity&) = delete;
+        Activity& operator=(const Activity&) = delete;
+
+        /// Counts steps finished without a Task (a cached file, an installed package).
+        void advance(uint64_t steps = 1);
+
+    private:
+        friend class Task;
+        State* state_;
+    };
+
+    /**
+     * @class Task
+     * @brief One unit of work of an activity, updated by a single thread.
+     */
+    class Task
+    {
+    public:
+        explicit Task(Activity& activity, uint64_t total = 0);
+        ~Task();
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        /// Sets the amount done and the total (0 = unknown).
+        void update(uint64_t done, uint64_t total);
+
+    private:
+        State*   state_;
+        uint64_t done_  = 0;
+        uint64_t total_ = 0;
+    };
+};
+
+} // namespace Starpack
+
+#endif // PROGRESS_HPP
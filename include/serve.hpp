@@ -0,0 +1,47 @@
+#ifndef SERVE_HPP
+#define SERVE_HPP
+
+#include <string>
+
+namespace Starpack {
+
+/**
+ * @struct ServeOptions
+ * @brief Settings of a `starpack serve` instance.
+ */
+struct ServeOptions
+{
+    int         port        = 8080;      ///< TCP port to listen on.
+    std::string bindAddress = "0.0.0.0"; ///< IPv4 address to listen on.
+    std::string upstream;                ///< Repository to fill misses from (highest-priority one of repos.conf if empty).
+    std::string installDir  = "/";       ///< Root whose package cache is served.
+    int         indexTtl    = 60;        ///< Seconds a cached repo.db.yaml is served before it is refetched.
+};
+
+/**
+ * @class CacheServer
+ * @brief A small HTTP server that lets a LAN fleet share one package cache.
+ *
+ * Serves the package cache of a root (archives, signatures and the
+ * repository index) so other nodes can list it as their first repository.
+ * A miss is fetched from the upstream repository once: concurrent requests
+ * for the same file wait for that single download instead of starting their
+ * own. Hits are sent with sendfile(). Archives and signatures are immutable
+ * and cached for good; repo.db.yaml is refetched after indexTtl seconds (a
+ * stale copy is served if the upstream is unreachable).
+ */
+class CacheServer
+{
+public:
+    /**
+     * @brief Listens and serves requests until the process is terminated.
+     *
+     * @param options Port, upstream and cache to use.
+     * @return False if the server cannot start.
+     */
+    static bool run(const ServeOptions& options);
+};
+
+} // namespace Starpack
+
+#endif // SERVE_HPP
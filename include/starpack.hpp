@@ -0,0 +1,119 @@
+#ifndef STARPACK_HPP
+#define STARPACK_HPP
+
+#include <string>
+#include <vector>
+#include "events.hpp"   // For Event, EventHandler
+#include "sync.hpp"     // For ManifestEntry, SyncPlan
+
+namespace Starpack {
+
+/**
+ * @struct PackageSummary
+ * @brief Repository metadata of one package.
+ */
+struct PackageSummary
+{
+    std::string              name;         ///< Package name.
+    std::string              version;      ///< Version in the repository.
+    std::string              description;  ///< One-line description.
+    std::string              repository;   ///< Repository URL (with trailing slash).
+    std::vector<std::string> dependencies; ///< Direct dependencies.
+};
+
+/**
+ * @class Library
+ * @brief Entry point of libstarpack for programs that link Starpack instead
+ *        of running the CLI.
+ *
+ * Operations are grouped as queries (read-only), planning (compute a
+ * SyncPlan without changing anything) and transactions (apply a plan).
+ * Progress and confirmations go through the EventHandler passed to
+ * setEventHandler(); without one, apply() proceeds without asking. The
+ * operations still log to stdout/stderr like the CLI does.
+ *
+ * All functions take the root to operate on; "/" is the running system.
+ * Changing a root requires the privileges the CLI needs for it.
+ */
+class Library
+{
+public:
+    /// Incremented whenever a signature in this header changes incompatibly.
+    static constexpr int apiVersion = 1;
+
+    /**
+     * @brief Installs the handler that receives events and confirmations
+     *        (nullptr removes it). See Events::setHandler().
+     */
+    static void setEventHandler(EventHandler* handler);
+
+    //------------------------------------------------------------------------
+    // Queries
+    //------------------------------------------------------------------------
+
+    /**
+     * @brief Packages installed in a root, with their versions.
+     */
+    static std::vector<ManifestEntry> installedPackages(const std::string& installDir = "/");
+
+    /**
+     * @brief Looks a package up in the configured repositories.
+     *
+     * Uses the root's cached repository indices, downloading missing ones.
+     *
+     * @param name       Package name.
+     * @param package    Receives the metadata.
+     * @param installDir Root whose cache is used.
+     * @return False if no repository provides the package.
+     */
+    static bool findPackage(const std::string& name, PackageSummary& package,
+                            const std::string& installDir = "/");
+
+    /**
+     * @brief Repository packages whose name, version or description contains
+     *        text, sorted by name.
+     */
+    static std::vector<PackageSummary> searchPackages(const std::string& text,
+                                                      const std::string& installDir = "/");
+
+    //------------------------------------------------------------------------
+    // Planning
+    //------------------------------------------------------------------------
+
+    /**
+     * @brief Plans converging a root to a set of desired packages (see
+     *        Sync::computePlan()).
+     */
+    static bool planSync(const std::vector<ManifestEntry>& entries,
+                         const std::string& installDir, SyncPlan& plan);
+
+    /**
+     * @brief Plans installing packages (and their dependencies) while
+     *        leaving everything installed untouched.
+     */
+    static bool planInstall(const std::vector<std::string>& names,
+                            const std::string& installDir, SyncPlan& plan);
+
+    /**
+     * @brief Plans removing packages. Fails if another installed package
+     *        still depends on one of them.
+     */
+    static bool planRemove(const std::vector<std::string>& names,
+                           const std::string& installDir, SyncPlan& plan);
+
+    //------------------------------------------------------------------------
+    // Transactions
+    //------------------------------------------------------------------------
+
+    /**
+     * @brief Asks the event handler to confirm a plan, then applies it as
+     *        one transaction (see Sync::applyPlan()).
+     *
+     * @return True if every change was applied.
+     */
+    static bool apply(const SyncPlan& plan, const std::string& installDir);
+};
+
+} // namespace Starpack
+
+#endif // STARPACK_HPP
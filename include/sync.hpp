@@ -0,0 +1,125 @@
+#ifndef SYNC_HPP
+#define SYNC_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "install.hpp"   // For ResolvedPackage
+
+namespace Starpack {
+
+/**
+ * @struct ManifestEntry
+ * @brief One desired package from a sync manifest.
+ */
+struct ManifestEntry
+{
+    std::string name;    ///< Package name.
+    std::string version; ///< Required version, or empty for the repository version.
+};
+
+/**
+ * @struct SyncStep
+ * @brief A package that has to be installed or replaced by a sync.
+ */
+struct SyncStep
+{
+    ResolvedPackage package;          ///< The repository package to put in place.
+    std::string     installedVersion; ///< Currently installed version (empty for new installs).
+};
+
+/**
+ * @struct SyncPlan
+ * @brief Everything a sync changes in one root, computed in a single
+ *        resolver run.
+ */
+struct SyncPlan
+{
+    std::vector<SyncStep>    steps;     ///< Installs and upgrades, dependencies first.
+    std::vector<std::string> removals;  ///< Installed packages outside the desired set.
+    size_t                   unchanged = 0; ///< Desired packages already up to date.
+    bool                     prefetched = false; ///< Archives are cached and already verified.
+
+    /// True if applying the plan would not change anything.
+    bool empty() const { return steps.empty() && removals.empty(); }
+};
+
+/**
+ * @class Sync
+ * @brief Converges a root to a declarative package manifest.
+ *
+ * The manifest lists the desired packages (one per line, optionally
+ * "name = version"; '#' starts a comment). Their dependency closure is
+ * what the root should contain: missing packages are installed, outdated
+ * ones upgraded and everything else removed. The whole change is fetched
+ * in one download phase and recorded with one rewrite of installed.db.
+ */
+class Sync
+{
+public:
+    /**
+     * @brief Reads a manifest file.
+     *
+     * @param manifestPath Path of the manifest.
+     * @param entries      Receives the desired packages.
+     * @return False if the file cannot be read or is malformed.
+     */
+    static bool readManifest(const std::string& manifestPath,
+                             std::vector<ManifestEntry>& entries);
+
+    /**
+     * @brief Lists the packages installed in a root, pinned to their
+     *        installed versions.
+     *
+     * Planning these plus extra names yields a plain install that leaves
+     * everything else untouched.
+     *
+     * @param installDir The root directory.
+     * @return One entry per installed package.
+     */
+    static std::vector<ManifestEntry> installedEntries(const std::string& installDir);
+
+    /**
+     * @brief Diffs the manifest against the installed DB of a root.
+     *
+     * @param entries    The desired packages.
+     * @param installDir The root directory.
+     * @param plan       Receives the changes.
+     * @return False if the manifest cannot be satisfied by the repositories.
+     */
+    static bool computePlan(const std::vector<ManifestEntry>& entries,
+                            const std::string& installDir,
+                            SyncPlan& plan);
+
+    /**
+     * @brief Prints the changes of a plan.
+     */
+    static void printPlan(const SyncPlan& plan);
+
+    /**
+     * @brief Executes a plan as one batched transaction: download and verify
+     *        everything (unless plan.prefetched), remove, extract, commit
+     *        installed.db once, then run the Post* hooks.
+     *
+     * @param plan       The plan from computePlan().
+     * @param installDir The root directory.
+     * @return True if every change was applied.
+     */
+    static bool applyPlan(const SyncPlan& plan, const std::string& installDir);
+
+    /**
+     * @brief Reads a manifest, plans and (after confirmation) applies it.
+     *
+     * @param manifestPath Path of the manifest.
+     * @param installDir   The root directory.
+     * @param confirm      If true, asks before changing anything.
+     * @return True if the root matches the manifest afterwards.
+     */
+    static bool syncRoot(const std::string& manifestPath,
+                         const std::string& installDir,
+                         bool confirm = true);
+};
+
+} // namespace Starpack
+
+#endif // SYNC_HPP
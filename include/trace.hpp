@@ -0,0 +1,113 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace Starpack {
+
+/**
+ * @class Trace
+ * @brief Phase tracing for `--trace <file>`, written in the Chrome
+ *        trace-event format (chrome://tracing, Perfetto, speedscope).
+ *
+ * Code marks a phase with a scoped Trace::Span; finished spans are kept in
+ * memory and written as "complete" (ph "X") events by finish(). While no
+ * trace was started, a Span only tests one relaxed atomic flag, so
+ * instrumentation can stay in hot paths; anything that is costly to build
+ * (names, arguments) should be guarded by Trace::enabled().
+ */
+class Trace
+{
+public:
+    /**
+     * @brief Starts recording; the trace is written to path by finish().
+     */
+    static void start(const std::string& path);
+
+    /**
+     * @brief Writes the recorded spans and stops recording. Does nothing if
+     *        no trace was started.
+     *
+     * @return False if the trace file could not be written.
+     */
+    static bool finish();
+
+    /// True between start() and finish().
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /// Microseconds since start() on a monotonic clock.
+    static uint64_t now();
+
+    /**
+     * @brief Records a span whose timing was measured elsewhere (e.g. a
+     *        transfer timed by libcurl).
+     *
+     * @param category Trace category ("download", "extract", ...).
+     * @param name     Span name shown in the viewer.
+     * @param start    Start time from now().
+     * @param end      End time from now().
+     * @param args     Pre-rendered JSON values keyed by argument name.
+     */
+    static void complete(const char* category, const std::string& name,
+                         uint64_t start, uint64_t end,
+                         const std::vector<std::pair<std::string, std::string>>& args = {});
+
+    /**
+     * @brief Renders a string argument as a quoted JSON value.
+     */
+    static std::string quote(const std::string& value);
+
+    /**
+     * @class Span
+     * @brief Records the time between construction and destruction.
+     *
+     * While Metrics are collected, the outermost span of each category on
+     * a thread also adds its duration to that phase's total. Outermost
+     * spans also sample RSS and its high-water mark for MemoryStats and, in
+     * a trace, as span arguments and a "memory" counter track.
+     */
+    class Span
+    {
+    public:
+        /**
+         * @param category Trace category.
+         * @param name     Phase name.
+         * @param subject  Optional subject (package, repository, hook),
+         *                 appended to the name as "name: subject".
+         */
+        Span(const char* category, const char* name, const std::string& subject = std::string());
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        /// Attaches a numeric argument (ignored while tracing is off).
+        void arg(const char* key, uint64_t value);
+
+        /// Attaches a string argument (ignored while tracing is off).
+        void arg(const char* key, const std::string& value);
+
+    private:
+        bool        active_;
+        bool        tracing_;
+        bool        outermost_ = false;
+        bool        sampled_   = false;
+        int         memoryToken_ = -1;
+        uint64_t    rssStart_  = 0;
+        uint64_t    hwmStart_  = 0;
+        const char* category_;
+        std::string name_;
+        uint64_t    start_ = 0;
+        std::vector<std::pair<std::string, std::string>> args_;
+    };
+
+private:
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+} // namespace Starpack
+
+#endif // TRACE_HPP
@@ -7,6 +7,8 @@
 #include <filesystem>
 #include <chrono>
 #include <ctime>
+#include <cstdint>
+#include "object_store.hpp"
 
 namespace fs = std::filesystem;
 
@@ -50,7 +52,80 @@ namespace Starpack {
         static void updatePackage(const std::vector<std::string>& packageNames,
                                   const std::string& installDir = "/");
 
+        /**
+         * @brief Updates the specified packages in several roots at once.
+         *
+         * Repository indices are fetched once, and every update is downloaded,
+         * verified and unpacked once (using the cache and keyring of the first
+         * root). Each root then receives only the updates it needs, with roots
+         * processed in parallel.
+         *
+         * With downloadOnly, pending updates are only downloaded and verified
+         * into the cache, without prompting; a later update then finds every
+         * archive cached and only extracts.
+         *
+         * @param packageNames A list of package names to update.
+         * @param installDirs  The installation root directories.
+         * @param downloadOnly If true, stop after downloading and verifying.
+         */
+        static void updatePackage(const std::vector<std::string>& packageNames,
+                                  const std::vector<std::string>& installDirs,
+                                  bool downloadOnly = false);
+
+        /**
+         * @brief Compares two version strings (see Version for the ordering).
+         *
+         * @param v1 The first version string.
+         * @param v2 The second version string.
+         * @return 1 if v1 is newer than v2, 0 if equal, -1 if v1 is older than v2.
+         */
+        static int compareVersions(const std::string& v1, const std::string& v2);
+
+        /**
+         * @brief Tells whether a repository package is a rebuild of the
+         *        installed version that should replace it.
+         *
+         * True only if both sides carry a build epoch, the repository's is
+         * larger and the archive hashes differ. Packages indexed or installed
+         * before build identifiers were recorded are never treated as newer.
+         *
+         * @param repoPackage      The package's record in the repository index.
+         * @param installedEpoch   "Build-epoch" of the installed package (0 if absent).
+         * @param installedSha256  "Sha256" of the installed package (empty if absent).
+         */
+        static bool isNewerBuild(const YAML::Node& repoPackage, int64_t installedEpoch,
+                                 const std::string& installedSha256);
+
     private:
+        /**
+         * @struct UpdateCandidate
+         * @brief The newest repository version of a package and the roots that need it.
+         */
+        struct UpdateCandidate {
+            std::string packageName;
+            std::string candidateVersion;
+            std::string candidateVersionKey; ///< Version::indexKey() of candidateVersion.
+            std::string candidateUpdateTime; ///< Index update_time, copied to the DB.
+            int64_t     candidateBuildEpoch = 0; ///< Index build_epoch (0 if absent).
+            std::string candidateSha256;     ///< Index sha256 of the archive.
+            std::string packageFileUrl;
+            std::string archivePath;         ///< Location in the shared package cache.
+            YAML::Node  metadata;
+            std::vector<size_t> roots;       ///< Indices of roots that need this update.
+        };
+
+        /**
+         * @brief Applies one downloaded and verified update to a single root.
+         *
+         * @param cand            The update candidate.
+         * @param packageMetadata Metadata of the new package version.
+         * @param installDir      The installation root directory.
+         * @return True if the files were applied and the DB was updated.
+         */
+        static bool applyUpdate(const UpdateCandidate& cand,
+                                const YAML::Node& packageMetadata,
+                                const std::string& installDir);
+
         /**
          * @brief Determines if a given file path should be updated based on update_dirs.
          *
@@ -97,53 +172,41 @@ namespace Starpack {
         static bool downloadFile(const std::string& url, const std::string& destPath);
 
         /**
-         * @brief Compares two version strings numerically.
-         *
-         * @param v1 The first version string.
-         * @param v2 The second version string.
-         * @return 1 if v1 is newer than v2, 0 if equal, -1 if v1 is older than v2.
-         */
-        static int compareVersions(const std::string& v1, const std::string& v2);
-
-        /**
-         * @brief Compares two date strings in dd/mm/yy format.
-         *
-         * @param d1 The first date string.
-         * @param d2 The second date string.
-         * @return 1 if d1 is later than d2, 0 if equal, -1 if d1 is earlier than d2.
-         */
-        static int compareDates(const std::string& d1, const std::string& d2);
-
-        /**
-         * @brief Retrieves the installed version of a package from the installation DB.
-         *
-         * @param packageName The name of the package.
-         * @param dbPath      The path to the installed database.
-         * @return A string representing the installed version, or an empty string on error.
+         * @struct InstalledBuild
+         * @brief What installed.db records about the installed build of a package.
          */
-        static std::string getInstalledVersion(const std::string& packageName, const std::string& dbPath);
+        struct InstalledBuild {
+            std::string version;        ///< Empty if the package is not installed.
+            int64_t     buildEpoch = 0; ///< "Build-epoch", 0 for older entries.
+            std::string sha256;         ///< "Sha256", empty for older entries.
+        };
 
         /**
-         * @brief Retrieves the last update timestamp for a package from the installed DB.
+         * @brief Reads the version and build identifiers of a package from the
+         *        installed DB in one pass.
          *
          * @param packageName The name of the package.
          * @param dbPath      The path to the installed database.
-         * @return A date string representing the last update, or an empty string on error.
+         * @return The recorded build; an empty version if the package is not found.
          */
-        static std::string getInstalledUpdateDate(const std::string& packageName, const std::string& dbPath);
+        static InstalledBuild getInstalledBuild(const std::string& packageName, const std::string& dbPath);
 
         /**
-         * @brief Updates the version and update time for a package in the installed DB.
+         * @brief Records the new build of a package in the installed DB.
          *
-         * Replaces the lines starting with "Version:" and "Update-time:" for the specified package.
+         * Replaces the "Version:" and "Update-time:" lines of the package,
+         * writes its "Build-epoch:" and "Sha256:" lines after the version and
+         * replaces its "Object-store:" and "Objects:" lines.
          *
-         * @param packageName    The package to update.
-         * @param dbPath         The path to the installed database.
-         * @param newVersion     The new version string.
-         * @param newUpdateTime  The new update time string.
+         * @param packageName   The package to update.
+         * @param dbPath        The path to the installed database.
+         * @param cand          The applied update candidate.
+         * @param storedObjects Files of the new version linked from the object store.
+         * @return True if the DB was rewritten.
          */
-        static void updateDatabaseVersion(const std::string& packageName, const std::string& dbPath,
-                                          const std::string& newVersion, const std::string& newUpdateTime);
+        static bool updateDatabaseVersion(const std::string& packageName, const std::string& dbPath,
+                                          const UpdateCandidate& cand,
+                                          const std::vector<StoredObject>& storedObjects);
 
         /**
          * @brief Prompts the user for confirmation before updating packages.
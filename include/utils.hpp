@@ -4,6 +4,10 @@
 #include <string>
 #include <ostream>
 #include <iostream>
+#include <cstddef>
+#include <functional>
+
+#include "log.hpp"
 
 // ANSI color codes for console output.
 #define COLOR_RESET "\033[0m"
@@ -14,33 +18,33 @@
 namespace Starpack {
 
 /**
- * @brief Logs an informational message to standard error with green coloring.
+ * @brief Logs an informational message (standard error, green tag) through Log.
  *
  * @param message The message to log.
  */
 inline void log_message(const std::string &message)
 {
-    std::cerr << COLOR_INFO << "[INFO] " << COLOR_RESET << message << std::endl;
+    Log::info(message);
 }
 
 /**
- * @brief Logs a warning message to standard error with yellow coloring.
+ * @brief Logs a warning message (standard error, yellow tag) through Log.
  *
  * @param message The warning message to log.
  */
 inline void log_warning(const std::string &message)
 {
-    std::cerr << COLOR_WARN << "[WARN] " << COLOR_RESET << message << std::endl;
+    Log::warn(message);
 }
 
 /**
- * @brief Logs an error message to standard error with red coloring.
+ * @brief Logs an error message (standard error, red tag) through Log.
  *
  * @param message The error message to log.
  */
 inline void log_error(const std::string &message)
 {
-    std::cerr << COLOR_ERROR << "[ERROR] " << COLOR_RESET << message << std::endl;
+    Log::error(message);
 }
 
 // ---------------------------------------------------------------------------
@@ -81,6 +85,48 @@ std::string fetchRepoData(const std::string& url);
  */
 std::string removeSlashAndAfter(const std::string& input);
 
+/**
+ * @brief Runs fn(i) for every index in [0, count) on a small pool of threads.
+ *
+ * Used to fan work out across several installation roots. With a single
+ * item (or a single worker) fn runs on the calling thread.
+ *
+ * An exception thrown by fn is reported on stderr and abandons that item
+ * only; the remaining items still run. Callers should therefore record an
+ * item's success as its last step.
+ *
+ * @param count      Number of work items.
+ * @param maxWorkers Upper bound for the number of threads; it is further
+ *                   capped by the hardware concurrency.
+ * @param fn         Work function receiving the item index.
+ * @return The number of items abandoned because fn threw.
+ */
+size_t parallelFor(size_t count, size_t maxWorkers, const std::function<void(size_t)>& fn);
+
+/**
+ * @brief Computes the SHA-256 of a file.
+ *
+ * @param path The file to hash.
+ * @return The lowercase hex digest, or an empty string if the file cannot be read.
+ */
+std::string sha256File(const std::string& path);
+
+/**
+ * @brief Flushes a file's data and metadata to stable storage.
+ *
+ * @param path The file to flush.
+ * @return False if the file cannot be opened or flushed.
+ */
+bool syncFile(const std::string& path);
+
+/**
+ * @brief Flushes every pending write of the file system that holds path.
+ *
+ * @param path Any file or directory on that file system (e.g. a root).
+ * @return False if the path cannot be opened or the flush fails.
+ */
+bool syncFileSystem(const std::string& path);
+
 } // namespace Starpack
 
 #endif // UTILS_HPP
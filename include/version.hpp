@@ -0,0 +1,78 @@
+#ifndef VERSION_HPP
+#define VERSION_HPP
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace Starpack {
+
+/**
+ * @class Version
+ * @brief The one version ordering used by install, update, sync and the
+ *        repository indices.
+ *
+ * A version is `[epoch:]upstream[-release]`. The epoch (digits, default 0)
+ * outranks everything else; the release (after the last '-') only breaks
+ * ties between equal upstream versions, and a version without one sorts
+ * first. Upstream and release are split into runs of digits and runs of
+ * letters; every other character separates runs. Digit runs compare
+ * numerically, letter runs bytewise. A letter run glued to the preceding
+ * run marks a pre-release, so
+ *
+ *     1.0a < 1.0rc1 < 1.0 < 1.0.a < 1.0.1 < 1:0.1
+ *
+ * key() turns a version into a byte string whose plain lexicographic order
+ * (memcmp, shorter prefix first) is that ordering, so comparing parsed
+ * versions costs a memcmp. Repository indices store the hex form of the
+ * key (`version_key`), which keeps the same order as text.
+ */
+class Version
+{
+public:
+    /// First byte of every key; bumped whenever the encoding changes.
+    static constexpr unsigned char keyFormat = 1;
+
+    /**
+     * @brief Sort key of a version: compare keys with memcmp or
+     *        std::string::compare.
+     */
+    static std::string key(std::string_view version);
+
+    /**
+     * @brief Lowercase hex of key(), as stored in repository indices.
+     *        Two index keys compare like the keys they encode.
+     */
+    static std::string indexKey(std::string_view version);
+
+    /**
+     * @brief True if text is an index key of the current keyFormat (a key
+     *        written by an older Starpack must be recomputed).
+     */
+    static bool isIndexKey(std::string_view text);
+
+    /**
+     * @brief Compares two versions without allocating (for versions up to
+     *        a few hundred bytes).
+     *
+     * @return 1 if a is newer than b, 0 if they are equal, -1 if a is older.
+     */
+    static int compare(std::string_view a, std::string_view b);
+
+    /**
+     * @brief Checks `available <op> required` for a dependency constraint.
+     *
+     * @param op One of >, >=, <, <=, ==, = and !=; anything else is
+     *           reported and fails.
+     */
+    static bool satisfies(std::string_view available, std::string_view op,
+                          std::string_view required);
+
+private:
+    /// Writes up to capacity bytes of the key to out; returns its full length.
+    static size_t encode(std::string_view version, unsigned char* out, size_t capacity);
+};
+
+} // namespace Starpack
+
+#endif // VERSION_HPP
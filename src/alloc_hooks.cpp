@@ -0,0 +1,101 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "memory_stats.hpp"    // Allocation counting
+
+#include <cstdlib>             // malloc, free, posix_memalign
+#include <algorithm>           // std::max
+#include <new>                 // Replaced operator new/delete
+
+// Linked only into the starpack, starpack_bench and starpack_e2e executables
+// (STARPACK_ALLOC_STATS), never into libstarpack: a program that embeds the
+// library keeps its own allocator.
+
+//============================================================================
+// Replaced global allocation functions
+//============================================================================
+//
+// Plain malloc/free plus one relaxed load while counting is off. Every
+// form is replaced so that memory never crosses allocators.
+
+namespace {
+
+    // Tells MemoryStats::start() that allocations can be counted
+    [[maybe_unused]] const bool g_hooksLinked = (Starpack::MemoryStats::setAllocationHooksLinked(), true);
+
+    void* allocate(std::size_t size) {
+        if (Starpack::MemoryStats::countingAllocations()) {
+            Starpack::MemoryStats::countAllocation(size);
+        }
+        if (size == 0) {
+            size = 1;
+        }
+        for (;;) {
+            if (void* p = std::malloc(size)) {
+                return p;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+        if (Starpack::MemoryStats::countingAllocations()) {
+            Starpack::MemoryStats::countAllocation(size);
+        }
+        std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+        if (size == 0) {
+            size = 1;
+        }
+        for (;;) {
+            void* p = nullptr;
+            if (posix_memalign(&p, align, size) == 0) {
+                return p;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+} // end anonymous namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,554 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "bench_env.hpp"       // Class definition
+#include "config.hpp"          // Repositories and mirrors, current settings
+#include "utils.hpp"           // sha256File
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // The signed test file
+#include <sstream>             // Rate formatting
+#include <iomanip>             // Table formatting
+#include <filesystem>          // Temporary directory
+#include <random>              // Incompressible archive content
+#include <chrono>              // Timing every stage
+#include <thread>              // Hardware concurrency
+#include <algorithm>           // std::clamp, std::sort
+#include <cmath>               // std::ceil
+#include <cstdio>              // popen, pclose, fgets
+#include <cstdlib>             // std::system, mkdtemp
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <ctime>               // Archive entry times
+#include <fcntl.h>             // open
+#include <unistd.h>            // write, fsync, close
+#include <archive.h>           // Writing and reading the test archive
+#include <archive_entry.h>     // Archive entries
+#include <curl/curl.h>         // Mirror probes
+#include <yaml-cpp/yaml.h>     // Package list of a mirror
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+using Clock = std::chrono::steady_clock;
+
+namespace Starpack {
+
+    namespace {
+
+        constexpr size_t   kMiB          = 1024 * 1024;
+        constexpr size_t   kEntrySize    = 256 * 1024;     // size of each archive member
+        constexpr double   kMinHashTime  = 0.5;            // hash the archive until this long
+        constexpr int      kVerifyRuns   = 8;
+        constexpr int      kLatencyRuns  = 3;
+        constexpr size_t   kMirrorFiles  = 4;              // packages fetched per mirror
+        constexpr uint64_t kMirrorCap    = 32 * kMiB;      // bytes fetched per mirror at most
+        constexpr double   kDefaultPackage = 4.0 * kMiB;   // typical archive size without a sample
+
+        double secondsSince(Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        std::string mibPerSecond(double bytesPerSecond) {
+            std::ostringstream out;
+            if (bytesPerSecond < 0) {
+                out << "-";
+            } else {
+                out << std::fixed << std::setprecision(1) << bytesPerSecond / kMiB << " MiB/s";
+            }
+            return out.str();
+        }
+
+        std::string milliseconds(double seconds) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(seconds < 0.01 ? 2 : 1) << seconds * 1000 << " ms";
+            return out.str();
+        }
+
+        void printRow(const std::string& stage, const std::string& value, const std::string& note = "") {
+            std::cout << "  " << std::left << std::setw(22) << stage << std::right
+                      << std::setw(14) << value << (note.empty() ? "" : "  " + note) << "\n";
+        }
+
+        /**
+         * Package-like content: a third incompressible (binaries, images),
+         * the rest repetitive text, so the compression ratio and the
+         * decompression cost resemble real archives.
+         */
+        std::string entryData(size_t index, std::mt19937& rng) {
+            std::string data(kEntrySize, '\0');
+            if (index % 3 == 0) {
+                for (size_t i = 0; i + 4 <= data.size(); i += 4) {
+                    uint32_t word = rng();
+                    std::memcpy(&data[i], &word, 4);
+                }
+            } else {
+                static const std::string line =
+                    "usr/share/doc/starpack: configuration option value description 0123456789\n";
+                for (size_t i = 0; i < data.size(); i++) {
+                    data[i] = line[(i + index * 7) % line.size()];
+                }
+            }
+            return data;
+        }
+
+        /** Writes a gzip/pax archive of about totalBytes; returns false on error. */
+        bool writeArchive(const std::string& path, size_t totalBytes, uint64_t& uncompressed) {
+            struct archive* a = archive_write_new();
+            archive_write_add_filter_gzip(a);
+            archive_write_set_format_pax_restricted(a);
+            if (archive_write_open_filename(a, path.c_str()) != ARCHIVE_OK) {
+                std::cerr << "Error: Cannot create " << path << ": " << archive_error_string(a) << "\n";
+                archive_write_free(a);
+                return false;
+            }
+
+            std::mt19937 rng(12345);
+            bool ok = true;
+            size_t entries = std::max<size_t>(1, totalBytes / kEntrySize);
+            uncompressed = 0;
+            for (size_t i = 0; i < entries && ok; i++) {
+                std::string data = entryData(i, rng);
+                struct archive_entry* entry = archive_entry_new();
+                std::string name = "usr/share/bench-env/" + std::to_string(i % 16) + "/file-" + std::to_string(i);
+                archive_entry_set_pathname(entry, name.c_str());
+                archive_entry_set_filetype(entry, AE_IFREG);
+                archive_entry_set_perm(entry, 0644);
+                archive_entry_set_size(entry, data.size());
+                archive_entry_set_mtime(entry, std::time(nullptr), 0);
+                ok = archive_write_header(a, entry) == ARCHIVE_OK &&
+                     archive_write_data(a, data.data(), data.size()) == static_cast<la_ssize_t>(data.size());
+                archive_entry_free(entry);
+                uncompressed += data.size();
+            }
+            if (!ok) {
+                std::cerr << "Error: Writing " << path << " failed: " << archive_error_string(a) << "\n";
+            }
+            ok = archive_write_close(a) == ARCHIVE_OK && ok;
+            archive_write_free(a);
+            return ok;
+        }
+
+        /** Synced sequential write of bytes into dir; bytes per second, or -1. */
+        double measureDiskWrite(const fs::path& dir, size_t bytes) {
+            fs::path file = dir / "disk-write";
+            int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::cerr << "Error: Cannot create " << file << ": " << std::strerror(errno) << "\n";
+                return -1;
+            }
+            std::mt19937 rng(1);
+            std::string block = entryData(0, rng);   // incompressible, for filesystems that compress
+
+            auto start = Clock::now();
+            bool ok = true;
+            for (size_t written = 0; written < bytes && ok; written += block.size()) {
+                ok = write(fd, block.data(), block.size()) == static_cast<ssize_t>(block.size());
+            }
+            ok = ok && fsync(fd) == 0;
+            double elapsed = secondsSince(start);
+            close(fd);
+            std::error_code ec;
+            fs::remove(file, ec);
+            return ok ? static_cast<double>(bytes) / elapsed : -1;
+        }
+
+        /**
+         * Reads the archive through libarchive. With a target directory the
+         * entries are extracted there the way the installer does it (without
+         * ownership); otherwise the data is only decompressed. Returns the
+         * elapsed seconds, or -1.
+         */
+        double readArchive(const std::string& path, const fs::path& target) {
+            struct archive* a   = archive_read_new();
+            struct archive* ext = target.empty() ? nullptr : archive_write_disk_new();
+            archive_read_support_filter_all(a);
+            archive_read_support_format_all(a);
+            if (ext) {
+                archive_write_disk_set_options(ext, ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM |
+                                                    ARCHIVE_EXTRACT_SECURE_NODOTDOT);
+                archive_write_disk_set_standard_lookup(ext);
+            }
+
+            auto start = Clock::now();
+            bool ok = archive_read_open_filename(a, path.c_str(), 32768) == ARCHIVE_OK;
+            struct archive_entry* entry;
+            while (ok && archive_read_next_header(a, &entry) == ARCHIVE_OK) {
+                if (ext) {
+                    std::string destination = (target / archive_entry_pathname(entry)).string();
+                    archive_entry_set_pathname(entry, destination.c_str());
+                    ok = archive_write_header(ext, entry) == ARCHIVE_OK;
+                }
+                const void* buffer;
+                size_t size;
+                la_int64_t offset;
+                int r = ARCHIVE_OK;
+                while (ok && (r = archive_read_data_block(a, &buffer, &size, &offset)) == ARCHIVE_OK) {
+                    if (ext) {
+                        ok = archive_write_data_block(ext, buffer, size, offset) == ARCHIVE_OK;
+                    }
+                }
+                ok = ok && r == ARCHIVE_EOF;
+                if (ok && ext) {
+                    ok = archive_write_finish_entry(ext) == ARCHIVE_OK;
+                }
+            }
+            if (!ok) {
+                std::cerr << "Error: Reading " << path << " failed: "
+                          << (archive_error_string(a) ? archive_error_string(a) : "extraction error") << "\n";
+            }
+            archive_read_free(a);
+            if (ext) {
+                archive_write_close(ext);
+                archive_write_free(ext);
+            }
+            double elapsed = secondsSince(start);
+            return ok ? elapsed : -1;
+        }
+
+        /** SHA-256 over the file until kMinHashTime has passed; bytes per second, or -1. */
+        double measureHash(const std::string& path, uint64_t size) {
+            auto start = Clock::now();
+            uint64_t hashed = 0;
+            do {
+                if (sha256File(path).empty()) {
+                    return -1;
+                }
+                hashed += size;
+            } while (secondsSince(start) < kMinHashTime);
+            return static_cast<double>(hashed) / secondsSince(start);
+        }
+
+        /**
+         * Fixed cost of one signature check: the installer's gpg command on
+         * a tiny signed file, with a throwaway key in its own home directory.
+         * Returns seconds per verification, or -1 if gpg is not usable.
+         */
+        double measureVerify(const fs::path& dir) {
+            fs::path home = dir / "gnupg";
+            fs::path file = dir / "signed";
+            fs::path sig  = dir / "signed.sig";
+            std::error_code ec;
+            fs::create_directory(home, ec);
+            fs::permissions(home, fs::perms::owner_all, ec);
+            {
+                std::ofstream out(file);
+                out << "starpack bench-env\n";
+            }
+
+            std::string gpg = "gpg --batch --no-tty --homedir \"" + home.string() + "\" ";
+            bool ready =
+                std::system((gpg + "--passphrase '' --quick-gen-key 'starpack bench-env' "
+                                   "ed25519 sign never >/dev/null 2>&1").c_str()) == 0 &&
+                std::system((gpg + "--detach-sign --output \"" + sig.string() + "\" \"" +
+                             file.string() + "\" >/dev/null 2>&1").c_str()) == 0;
+
+            double perVerify = -1;
+            if (ready) {
+                std::string command = gpg + "--status-fd 1 --no-default-keyring --keyring \"" +
+                                      (home / "pubring.kbx").string() + "\" --verify \"" +
+                                      sig.string() + "\" \"" + file.string() + "\" 2>/dev/null";
+                auto start = Clock::now();
+                int good = 0;
+                for (int i = 0; i < kVerifyRuns; i++) {
+                    FILE* pipe = popen(command.c_str(), "r");
+                    if (!pipe) {
+                        break;
+                    }
+                    char buffer[256];
+                    while (fgets(buffer, sizeof(buffer), pipe)) {
+                        if (std::string(buffer).rfind("[GNUPG:] GOODSIG", 0) == 0) {
+                            good++;
+                        }
+                    }
+                    pclose(pipe);
+                }
+                if (good == kVerifyRuns) {
+                    perVerify = secondsSince(start) / kVerifyRuns;
+                }
+            }
+            // Stop the agent the key generation started in that home directory
+            std::system(("gpgconf --homedir \"" + home.string() + "\" --kill all >/dev/null 2>&1").c_str());
+            return perVerify;
+        }
+
+        struct MirrorResult {
+            std::string url;
+            double      latency    = -1;   // seconds to the first byte of the index
+            double      throughput = -1;   // bytes per second over the fetched files
+            double      averageFile = 0;   // mean size of the fetched files
+            std::string error;
+        };
+
+        struct Fetch {
+            std::string* body  = nullptr;  // kept for the index only
+            uint64_t     bytes = 0;
+        };
+
+        size_t fetchWrite(char* data, size_t size, size_t nmemb, void* userdata) {
+            Fetch* fetch = static_cast<Fetch*>(userdata);
+            size_t total = size * nmemb;
+            if (fetch->body) {
+                fetch->body->append(data, total);
+            }
+            fetch->bytes += total;
+            return fetch->bytes > kMirrorCap ? 0 : total;
+        }
+
+        /** One GET; fills the time to the first byte and the total time. */
+        bool fetch(CURL* curl, const std::string& url, Fetch& sink, double& firstByte, double& total,
+                   std::string& error) {
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, fetchWrite);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+            CURLcode res = curl_easy_perform(curl);
+            if (res != CURLE_OK && !(res == CURLE_WRITE_ERROR && sink.bytes > kMirrorCap)) {
+                error = curl_easy_strerror(res);
+                return false;
+            }
+            curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &firstByte);
+            curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total);
+            return true;
+        }
+
+        /**
+         * Latency: median time to the first byte of the index over a few
+         * requests on one connection. Throughput: the first packages the
+         * index lists (the files themselves for a stand-in), fetched one
+         * after the other.
+         */
+        MirrorResult probeMirror(const std::string& base, const std::string& index,
+                                 std::vector<std::string> files) {
+            MirrorResult result;
+            result.url = base;
+            CURL* curl = curl_easy_init();
+            if (!curl) {
+                result.error = "curl_easy_init failed";
+                return result;
+            }
+
+            std::vector<double> firstBytes;
+            std::string indexBody;
+            for (int i = 0; i < kLatencyRuns; i++) {
+                indexBody.clear();
+                Fetch sink{&indexBody};
+                double firstByte = 0, total = 0;
+                if (!fetch(curl, base + index, sink, firstByte, total, result.error)) {
+                    curl_easy_cleanup(curl);
+                    return result;
+                }
+                firstBytes.push_back(firstByte);
+            }
+            std::sort(firstBytes.begin(), firstBytes.end());
+            result.latency = firstBytes[firstBytes.size() / 2];
+
+            if (files.empty()) {
+                try {
+                    YAML::Node repo = YAML::Load(indexBody);
+                    for (const auto& package : repo["packages"]) {
+                        if (package["file_name"] && files.size() < kMirrorFiles) {
+                            files.push_back(package["file_name"].as<std::string>());
+                        }
+                    }
+                } catch (const std::exception&) {
+                    // Not a package index; measure with the index itself
+                }
+            }
+            if (files.empty()) {
+                files.push_back(index);
+            }
+
+            uint64_t bytes = 0;
+            double   seconds = 0;
+            size_t   fetched = 0;
+            for (const auto& file : files) {
+                Fetch sink;
+                double firstByte = 0, total = 0;
+                if (!fetch(curl, base + file, sink, firstByte, total, result.error)) {
+                    break;
+                }
+                bytes   += sink.bytes;
+                seconds += total;
+                fetched++;
+                if (bytes > kMirrorCap) {
+                    break;
+                }
+            }
+            curl_easy_cleanup(curl);
+            if (fetched > 0) {
+                result.error.clear();
+                result.throughput  = seconds > 0 ? static_cast<double>(bytes) / seconds : -1;
+                result.averageFile = static_cast<double>(bytes) / fetched;
+            }
+            return result;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * BenchEnv::run
+     * ------------------------------------------------------------------------
+     */
+    bool BenchEnv::run(const BenchEnvOptions& options) {
+        fs::path cacheDir = fs::path(options.installDir) / "var/lib/starpack/cache";
+        std::error_code ec;
+        fs::create_directories(cacheDir, ec);
+        std::string pattern = (cacheDir / "bench-env.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            std::cerr << "Error: Cannot create a temporary directory in " << cacheDir
+                      << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        fs::path workDir = pattern;
+        fs::path archivePath = workDir / "bench-env.starpack";
+
+        std::cout << "Measuring on " << fs::absolute(cacheDir).string() << " ("
+                  << options.archiveMiB << " MiB test archive, "
+                  << std::thread::hardware_concurrency() << " CPUs)\n\n";
+
+        uint64_t uncompressed = 0;
+        if (!writeArchive(archivePath.string(), static_cast<size_t>(options.archiveMiB) * kMiB,
+                          uncompressed)) {
+            fs::remove_all(workDir, ec);
+            return false;
+        }
+        uint64_t compressed = fs::file_size(archivePath, ec);
+        double ratio = compressed > 0 ? static_cast<double>(uncompressed) / compressed : 1.0;
+
+        // Local stages, one at a time
+        std::cout << "Local stages (one worker):\n";
+        double diskWrite = measureDiskWrite(workDir, uncompressed);
+        printRow("disk write (synced)", mibPerSecond(diskWrite));
+
+        double decompressTime = readArchive(archivePath.string(), fs::path());
+        double decompress = decompressTime > 0 ? uncompressed / decompressTime : -1;
+        printRow("decompression", mibPerSecond(decompress), "uncompressed bytes");
+
+        double extractTime = readArchive(archivePath.string(), workDir / "root");
+        double extract = extractTime > 0 ? uncompressed / extractTime : -1;
+        printRow("extraction", mibPerSecond(extract), "decompress + write files, not synced");
+        fs::remove_all(workDir / "root", ec);
+
+        double hash = measureHash(archivePath.string(), compressed);
+        printRow("SHA-256", mibPerSecond(hash), "archive bytes");
+
+        double verify = measureVerify(workDir);
+        if (verify > 0) {
+            std::ostringstream rate;
+            rate << std::fixed << std::setprecision(1) << 1.0 / verify << "/s";
+            printRow("gpg verification", rate.str(), milliseconds(verify) + " fixed cost per signature");
+        } else {
+            printRow("gpg verification", "-", "gpg not usable here");
+        }
+
+        // Mirrors, or the generated archive behind a file:// URL
+        std::vector<std::string> mirrors = options.mirrors;
+        if (mirrors.empty()) {
+            for (const auto& repo : Config::current().byPriority()) {
+                for (const auto& base : repo.bases()) {
+                    mirrors.push_back(base);
+                }
+            }
+        }
+        std::vector<MirrorResult> results;
+        std::cout << "\nMirrors:\n";
+        if (mirrors.empty()) {
+            results.push_back(probeMirror("file://" + fs::absolute(workDir).string() + "/",
+                                          archivePath.filename().string(),
+                                          { archivePath.filename().string() }));
+            results.back().url = "file:// stand-in (no mirrors configured)";
+        } else {
+            for (std::string mirror : mirrors) {
+                if (!mirror.empty() && mirror.back() != '/') {
+                    mirror += '/';
+                }
+                results.push_back(probeMirror(mirror, "repo.db.yaml", {}));
+            }
+        }
+        for (const auto& result : results) {
+            if (!result.error.empty() && result.throughput < 0) {
+                std::cout << "  " << result.url << "\n      unreachable: " << result.error << "\n";
+                continue;
+            }
+            std::cout << "  " << result.url << "\n      latency " << milliseconds(result.latency)
+                      << ", throughput " << mibPerSecond(result.throughput)
+                      << " (one connection)\n";
+        }
+        fs::remove_all(workDir, ec);
+
+        // Recommendations
+        //
+        // A package costs (per uncompressed byte) the extraction, the hash of
+        // its compressed bytes and a share of the fixed gpg cost. Jobs adds
+        // workers until they would write faster than the disk takes it.
+        double package = kDefaultPackage;
+        const MirrorResult* slowest = nullptr;
+        for (const auto& result : results) {
+            if (result.throughput > 0) {
+                package = result.averageFile > 0 ? result.averageFile : package;
+                if (!slowest || result.throughput < slowest->throughput) {
+                    slowest = &result;
+                }
+            }
+        }
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        double perWorker = -1;
+        if (extract > 0 && hash > 0) {
+            double perByte = 1.0 / extract + 1.0 / (hash * ratio) +
+                             (verify > 0 ? verify / (package * ratio) : 0);
+            perWorker = 1.0 / perByte;
+        }
+        int jobs = 1;
+        if (perWorker > 0 && diskWrite > 0) {
+            jobs = std::clamp(static_cast<int>(std::ceil(diskWrite / perWorker)), 1, static_cast<int>(cpus));
+        }
+
+        // Parallel transfers hide the request latency: with latency L, one
+        // connection at rate T and packages of size S, a host keeps the link
+        // busy with about 1 + L*T/S transfers in flight
+        int concurrency = 4;
+        if (slowest && slowest->latency >= 0) {
+            concurrency = static_cast<int>(std::ceil(1.0 + slowest->latency * slowest->throughput / package));
+        }
+        int concurrencyMax = std::clamp(concurrency * 2, 4, 32);
+        int concurrencyMin = std::clamp(concurrency / 2, 1, concurrencyMax);
+        if (!slowest) {
+            // Nothing measured; keep what is configured
+            const Settings& settings = Config::current().settings;
+            concurrencyMin = settings.downloadConcurrencyMin;
+            concurrencyMax = settings.downloadConcurrencyMax;
+        }
+
+        // Compare the stages in uncompressed bytes per second
+        double installRate = perWorker > 0 ? perWorker * jobs : -1;
+        if (diskWrite > 0 && (installRate < 0 || diskWrite < installRate)) {
+            installRate = diskWrite;
+        }
+        double networkRate = slowest ? slowest->throughput * std::min(concurrency, concurrencyMax) * ratio : -1;
+        std::string limit;
+        if (networkRate > 0 && (installRate < 0 || networkRate < installRate)) {
+            limit = "the mirror (" + slowest->url + ")";
+        } else if (installRate > 0 && diskWrite > 0 && installRate >= diskWrite) {
+            limit = "the disk";
+        } else if (installRate > 0) {
+            limit = "decompression and verification (CPU)";
+        }
+
+        std::cout << "\nRecommended settings (" << Settings::defaultPath << "):\n"
+                  << "  Jobs = " << jobs << "\n"
+                  << "  DownloadConcurrencyMin = " << concurrencyMin << "\n"
+                  << "  DownloadConcurrencyMax = " << concurrencyMax
+                  << (slowest ? "" : "  (unchanged: no mirror answered)") << "\n";
+        if (!limit.empty()) {
+            std::cout << "Expected limit: " << limit << "\n";
+        }
+        return true;
+    }
+
+} // namespace Starpack
@@ -1,12 +1,68 @@
 #include "cache.hpp"
+#include "object_store.hpp"
+#include "config.hpp"
+#include "utils.hpp"
 #include <iostream>
+#include <iomanip>
 #include <filesystem>
 #include <regex>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 
 namespace Starpack {
 
+    namespace {
+
+        // Size and mtime identify the archive a digest file was written for
+        std::string digestKey(const std::string& archivePath) {
+            struct stat st;
+            if (stat(archivePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                return "";
+            }
+            return std::to_string(st.st_size) + " " + std::to_string(st.st_mtim.tv_sec) + "." +
+                   std::to_string(st.st_mtim.tv_nsec);
+        }
+
+        // The recorded digest, or an empty string if there is none for the
+        // archive as it is now
+        std::string recordedDigest(const std::string& archivePath, const std::string& key) {
+            std::ifstream in(archivePath + Cache::digestSuffix);
+            std::string digest, recordedKey;
+            if (key.empty() || !(in >> digest) || !std::getline(in >> std::ws, recordedKey) ||
+                recordedKey != key) {
+                return "";
+            }
+            return digest;
+        }
+
+        void writeDigest(const std::string& archivePath, const std::string& key,
+                         const std::string& digest) {
+            if (key.empty() || digest.empty()) {
+                return;
+            }
+            std::string path = archivePath + Cache::digestSuffix;
+            std::string tmpPath = path + ".tmp";
+            {
+                std::ofstream out(tmpPath, std::ios::trunc);
+                out << digest << " " << key << "\n";
+                if (!out) {
+                    return;
+                }
+            }
+            std::error_code ec;
+            fs::rename(tmpPath, path, ec);
+            if (ec) {
+                fs::remove(tmpPath, ec);
+            }
+        }
+
+    } // end anonymous namespace
+
     void Cache::clean() {
         std::cout << "Cleaning up Starpack cache..." << std::endl;
 
@@ -23,9 +79,98 @@ namespace Starpack {
             removeFiles(directory, pattern);
         }
 
+        // Objects no root links to any more
+        size_t released = ObjectStore::collectGarbage(ObjectStore::defaultStoreDir);
+        if (released > 0) {
+            std::cout << "Removed " << released << " unreferenced object(s) from "
+                      << ObjectStore::defaultStoreDir << std::endl;
+        }
+
         std::cout << "Cache cleanup completed." << std::endl;
     }
 
+    bool Cache::discardIfStale(const std::string& archivePath, const std::string& expectedSha256) {
+        std::error_code ec;
+        if (expectedSha256.empty() || !fs::exists(archivePath, ec)) {
+            return false;
+        }
+        std::string key = digestKey(archivePath);
+        std::string digest = recordedDigest(archivePath, key);
+        if (digest.empty()) {
+            digest = sha256File(archivePath);
+            writeDigest(archivePath, key, digest);
+        }
+        if (digest == expectedSha256) {
+            return false;
+        }
+        Log::info("Cached " + fs::path(archivePath).filename().string() +
+                  " differs from the repository build; downloading it again.");
+        fs::remove(archivePath, ec);
+        fs::remove(archivePath + ".sig", ec);
+        fs::remove(archivePath + digestSuffix, ec);
+        return true;
+    }
+
+    void Cache::recordDigest(const std::string& archivePath) {
+        std::string key = digestKey(archivePath);
+        if (!key.empty() && recordedDigest(archivePath, key).empty()) {
+            writeDigest(archivePath, key, sha256File(archivePath));
+        }
+    }
+
+    void Cache::enforceLimits(const std::string& cacheDir) {
+        const Settings& settings = Config::current().settings;
+        if (settings.cacheMaxSize <= 0 && settings.cacheMaxAge <= 0) {
+            return;
+        }
+
+        struct Archive {
+            fs::path            path;
+            uintmax_t           size;   // archive plus signature
+            fs::file_time_type  written;
+        };
+        std::vector<Archive> archives;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(cacheDir, ec)) {
+            if (!entry.is_regular_file(ec) || entry.path().extension() != ".starpack") {
+                continue;
+            }
+            uintmax_t size = entry.file_size(ec);
+            uintmax_t sigSize = fs::file_size(entry.path().string() + ".sig", ec);
+            archives.push_back({ entry.path(), size + (ec ? 0 : sigSize), entry.last_write_time(ec) });
+        }
+        std::sort(archives.begin(), archives.end(),
+                  [](const Archive& a, const Archive& b) { return a.written < b.written; });
+
+        uintmax_t total = 0;
+        for (const auto& archive : archives) {
+            total += archive.size;
+        }
+        auto cutoff = fs::file_time_type::clock::now() - std::chrono::hours(24) * settings.cacheMaxAge;
+
+        size_t removed = 0;
+        uintmax_t freed = 0;
+        for (const auto& archive : archives) {
+            bool tooOld   = settings.cacheMaxAge > 0 && archive.written < cutoff;
+            bool overSize = settings.cacheMaxSize > 0 &&
+                            total > static_cast<uintmax_t>(settings.cacheMaxSize);
+            if (!tooOld && !overSize) {
+                continue;
+            }
+            fs::remove(archive.path, ec);
+            fs::remove(archive.path.string() + ".sig", ec);
+            fs::remove(archive.path.string() + digestSuffix, ec);
+            total -= archive.size;
+            freed += archive.size;
+            removed++;
+        }
+        if (removed > 0) {
+            std::cout << "Cache limits: removed " << removed << " archive(s) from " << cacheDir
+                      << ", freed " << std::fixed << std::setprecision(1)
+                      << freed / (1024.0 * 1024.0) << " MiB." << std::endl;
+        }
+    }
+
     void Cache::removeFiles(const std::string& directory, const std::string& pattern) {
         try {
             if (!fs::exists(directory)) {
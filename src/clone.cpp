@@ -0,0 +1,463 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "clone.hpp"           // Class definition
+#include "install.hpp"         // Installer::installPackage
+#include "remove.hpp"          // removePackages
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <filesystem>          // Path handling
+#include <map>                 // Hardlink bookkeeping
+#include <vector>              // Buffers
+#include <utility>             // std::pair
+#include <chrono>              // Timing the clone phase
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <fcntl.h>             // open, O_* flags, AT_* flags
+#include <unistd.h>            // close, read, write, link, symlink, readlink
+#include <dirent.h>            // opendir, readdir
+#include <sys/stat.h>          // lstat, mkdir, mknod, fchmod, utimensat
+#include <sys/xattr.h>         // llistxattr, lgetxattr, lsetxattr
+#include <sys/ioctl.h>         // ioctl
+#include <sys/mount.h>         // mount
+#include <linux/fs.h>          // FICLONE
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        /**
+         * -------------------------------------------------------------------
+         * CloneContext
+         *
+         * State shared by the recursive tree copy.
+         * -------------------------------------------------------------------
+         */
+        struct CloneContext {
+            CloneMode mode = CloneMode::Reflink;
+            dev_t rootDevice = 0;
+            std::map<std::pair<dev_t, ino_t>, std::string> seenInodes; // Hardlinks inside the template
+            size_t reflinked = 0;
+            size_t copied = 0;
+            size_t linked = 0;
+            size_t others = 0;
+            size_t skippedMounts = 0;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * isSharedTree
+         *
+         * Trees whose files are only ever replaced (never edited in place)
+         * by starpack, and can therefore be hardlinked into a clone.
+         * -------------------------------------------------------------------
+         */
+        bool isSharedTree(const std::string& relPath) {
+            static const char* const sharedTrees[] = {
+                "usr",
+                "var/lib/starpack/cache"
+            };
+            for (const char* tree : sharedTrees) {
+                std::string prefix(tree);
+                if (relPath == prefix || relPath.rfind(prefix + "/", 0) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * copyXattrs
+         *
+         * Copies every extended attribute of src onto dst: file capabilities,
+         * POSIX ACLs, SELinux labels and user attributes. Attributes the
+         * target filesystem or policy refuses are reported and skipped.
+         * -------------------------------------------------------------------
+         */
+        void copyXattrs(const std::string& src, const std::string& dst) {
+            ssize_t listSize = llistxattr(src.c_str(), nullptr, 0);
+            if (listSize <= 0) {
+                return; // None, or attributes unsupported by the template's filesystem
+            }
+            std::vector<char> names(static_cast<size_t>(listSize));
+            listSize = llistxattr(src.c_str(), names.data(), names.size());
+            if (listSize < 0) {
+                return;
+            }
+
+            std::vector<char> value;
+            for (const char* name = names.data(); name < names.data() + listSize;
+                 name += std::strlen(name) + 1) {
+                ssize_t valueSize = lgetxattr(src.c_str(), name, nullptr, 0);
+                if (valueSize < 0) {
+                    continue;
+                }
+                value.resize(static_cast<size_t>(valueSize));
+                valueSize = lgetxattr(src.c_str(), name, value.data(), value.size());
+                if (valueSize < 0 ||
+                    lsetxattr(dst.c_str(), name, value.data(), static_cast<size_t>(valueSize), 0) != 0) {
+                    std::cerr << "Warning: Cannot copy attribute " << name << " to " << dst
+                              << ": " << strerror(errno) << std::endl;
+                }
+            }
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * applyMetadata
+         *
+         * Copies owner, xattrs, mode and timestamps of src (`st`) onto `path`.
+         * Ownership first, since chown clears set-id bits and capabilities.
+         * -------------------------------------------------------------------
+         */
+        void applyMetadata(const std::string& src, const std::string& path, const struct stat& st) {
+            if (lchown(path.c_str(), st.st_uid, st.st_gid) != 0) {
+                std::cerr << "Warning: lchown failed for " << path << ": "
+                          << strerror(errno) << std::endl;
+            }
+            copyXattrs(src, path);
+            if (!S_ISLNK(st.st_mode) && chmod(path.c_str(), st.st_mode & 07777) != 0) {
+                std::cerr << "Warning: chmod failed for " << path << ": "
+                          << strerror(errno) << std::endl;
+            }
+            struct timespec times[2] = { st.st_atim, st.st_mtim };
+            utimensat(AT_FDCWD, path.c_str(), times, AT_SYMLINK_NOFOLLOW);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * cloneRegularFile
+         *
+         * Creates dst as a reflink of src, falling back to copy_file_range
+         * and finally to read/write when the filesystem cannot share blocks.
+         * -------------------------------------------------------------------
+         */
+        bool cloneRegularFile(const std::string& src, const std::string& dst,
+                              const struct stat& st, CloneContext& ctx) {
+            int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in < 0) {
+                std::cerr << "Error: Cannot open " << src << ": " << strerror(errno) << std::endl;
+                return false;
+            }
+            int out = open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            if (out < 0) {
+                std::cerr << "Error: Cannot create " << dst << ": " << strerror(errno) << std::endl;
+                close(in);
+                return false;
+            }
+
+            bool ok = true;
+            if (ioctl(out, FICLONE, in) == 0) {
+                ctx.reflinked++;
+            } else {
+                off_t remaining = st.st_size;
+                bool useCopyRange = true;
+                std::vector<char> buffer;
+                while (ok && remaining > 0) {
+                    ssize_t n = -1;
+                    if (useCopyRange) {
+                        n = copy_file_range(in, nullptr, out, nullptr,
+                                            static_cast<size_t>(remaining), 0);
+                        if (n < 0 && (errno == EXDEV || errno == ENOSYS ||
+                                      errno == EINVAL || errno == EOPNOTSUPP)) {
+                            useCopyRange = false;
+                            buffer.resize(1 << 16);
+                            continue;
+                        }
+                    } else {
+                        n = read(in, buffer.data(), buffer.size());
+                        if (n > 0 && write(out, buffer.data(), static_cast<size_t>(n)) != n) {
+                            n = -1;
+                        }
+                    }
+                    if (n < 0) {
+                        std::cerr << "Error: Copying " << src << " failed: "
+                                  << strerror(errno) << std::endl;
+                        ok = false;
+                    } else if (n == 0) {
+                        break; // File shrank underneath us
+                    } else {
+                        remaining -= n;
+                    }
+                }
+                ctx.copied++;
+            }
+
+            close(in);
+            if (close(out) != 0) {
+                ok = false;
+            }
+            if (ok) {
+                applyMetadata(src, dst, st);
+            }
+            return ok;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * cloneTree
+         *
+         * Recursively recreates src at dst. relPath is the path relative to
+         * the template root and decides whether hardlinks may be used.
+         * -------------------------------------------------------------------
+         */
+        bool cloneTree(const std::string& src, const std::string& dst,
+                       const std::string& relPath, CloneContext& ctx) {
+            DIR* dir = opendir(src.c_str());
+            if (!dir) {
+                std::cerr << "Error: Cannot read directory " << src << ": "
+                          << strerror(errno) << std::endl;
+                return false;
+            }
+
+            bool ok = true;
+            while (struct dirent* de = readdir(dir)) {
+                std::string name = de->d_name;
+                if (name == "." || name == "..") {
+                    continue;
+                }
+
+                std::string srcPath = src + "/" + name;
+                std::string dstPath = dst + "/" + name;
+                std::string childRel = relPath.empty() ? name : relPath + "/" + name;
+
+                struct stat st;
+                if (lstat(srcPath.c_str(), &st) != 0) {
+                    std::cerr << "Error: Cannot stat " << srcPath << ": "
+                              << strerror(errno) << std::endl;
+                    ok = false;
+                    continue;
+                }
+
+                if (S_ISDIR(st.st_mode)) {
+                    if (mkdir(dstPath.c_str(), 0700) != 0) {
+                        std::cerr << "Error: Cannot create " << dstPath << ": "
+                                  << strerror(errno) << std::endl;
+                        ok = false;
+                        continue;
+                    }
+                    if (st.st_dev != ctx.rootDevice) {
+                        // Another filesystem (proc, sys, a bind mount, ...): keep the mountpoint only
+                        ctx.skippedMounts++;
+                    } else if (!cloneTree(srcPath, dstPath, childRel, ctx)) {
+                        ok = false;
+                    }
+                    applyMetadata(srcPath, dstPath, st); // After children, so mtimes survive
+                    continue;
+                }
+
+                // Preserve hardlinks that already exist inside the template
+                if (S_ISREG(st.st_mode) && st.st_nlink > 1) {
+                    auto key = std::make_pair(st.st_dev, st.st_ino);
+                    auto it = ctx.seenInodes.find(key);
+                    if (it != ctx.seenInodes.end()) {
+                        if (link(it->second.c_str(), dstPath.c_str()) == 0) {
+                            ctx.linked++;
+                            continue;
+                        }
+                    } else {
+                        ctx.seenInodes[key] = dstPath;
+                    }
+                }
+
+                if (S_ISREG(st.st_mode)) {
+                    if (ctx.mode == CloneMode::Hardlink && isSharedTree(childRel) &&
+                        link(srcPath.c_str(), dstPath.c_str()) == 0) {
+                        ctx.linked++;
+                    } else if (!cloneRegularFile(srcPath, dstPath, st, ctx)) {
+                        ok = false;
+                    }
+                } else if (S_ISLNK(st.st_mode)) {
+                    std::vector<char> target(static_cast<size_t>(st.st_size) + 1);
+                    ssize_t len = readlink(srcPath.c_str(), target.data(), target.size());
+                    if (len < 0 || symlink(std::string(target.data(), static_cast<size_t>(len)).c_str(),
+                                           dstPath.c_str()) != 0) {
+                        std::cerr << "Error: Cannot copy symlink " << srcPath << ": "
+                                  << strerror(errno) << std::endl;
+                        ok = false;
+                        continue;
+                    }
+                    applyMetadata(srcPath, dstPath, st);
+                    ctx.others++;
+                } else if (S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode) || S_ISFIFO(st.st_mode)) {
+                    if (mknod(dstPath.c_str(), st.st_mode, st.st_rdev) != 0) {
+                        std::cerr << "Error: Cannot create node " << dstPath << ": "
+                                  << strerror(errno) << std::endl;
+                        ok = false;
+                        continue;
+                    }
+                    applyMetadata(srcPath, dstPath, st);
+                    ctx.others++;
+                }
+                // Sockets are runtime state and are not cloned
+            }
+
+            closedir(dir);
+            return ok;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Clone::parseMode
+     * ------------------------------------------------------------------------
+     */
+    bool Clone::parseMode(const std::string& name, CloneMode& mode) {
+        if (name == "reflink") {
+            mode = CloneMode::Reflink;
+        } else if (name == "hardlink") {
+            mode = CloneMode::Hardlink;
+        } else if (name == "overlay") {
+            mode = CloneMode::Overlay;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Clone::mountOverlay
+     * ------------------------------------------------------------------------
+     */
+    std::string Clone::mountOverlay(const std::string& fromRoot,
+                                    const std::string& toRoot) {
+        fs::path upper  = fs::path(toRoot) / "upper";
+        fs::path work   = fs::path(toRoot) / "work";
+        fs::path merged = fs::path(toRoot) / "merged";
+
+        std::error_code ec;
+        for (const auto& dir : { upper, work, merged }) {
+            fs::create_directories(dir, ec);
+            if (ec) {
+                std::cerr << "Error: Cannot create " << dir.string() << ": "
+                          << ec.message() << std::endl;
+                return "";
+            }
+        }
+
+        std::string options = "lowerdir=" + fs::absolute(fromRoot).string() +
+                              ",upperdir=" + fs::absolute(upper).string() +
+                              ",workdir="  + fs::absolute(work).string();
+        if (mount("overlay", merged.c_str(), "overlay", 0, options.c_str()) != 0) {
+            std::cerr << "Error: Mounting overlay on " << merged.string() << " failed: "
+                      << strerror(errno) << std::endl;
+            return "";
+        }
+
+        std::cout << "Overlay mounted on " << merged.string() << ". To remount later:\n"
+                  << "  mount -t overlay overlay -o " << options << " "
+                  << fs::absolute(merged).string() << std::endl;
+        return merged.string();
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Clone::cloneRoot
+     *
+     * Copies (or overlays) the template, then applies the package delta
+     * with the regular remove/install code paths.
+     * ------------------------------------------------------------------------
+     */
+    bool Clone::cloneRoot(const std::string& fromRoot,
+                          const std::string& toRoot,
+                          CloneMode mode,
+                          const std::vector<std::string>& toInstall,
+                          const std::vector<std::string>& toRemove,
+                          bool confirm) {
+
+        std::cout << "--- Starpack Clone ---" << std::endl;
+        std::cout << "Template: " << fromRoot << "\nTarget:   " << toRoot << std::endl;
+
+        std::error_code ec;
+        fs::path templateDb = fs::path(fromRoot) / "var" / "lib" / "starpack" / "installed.db";
+        if (!fs::exists(templateDb, ec)) {
+            std::cerr << "Error: " << fromRoot << " is not an installed root (missing "
+                      << templateDb.string() << ")." << std::endl;
+            return false;
+        }
+        if (fs::exists(toRoot, ec) && !fs::is_empty(toRoot, ec)) {
+            std::cerr << "Error: Target " << toRoot << " exists and is not empty." << std::endl;
+            return false;
+        }
+
+        // A target inside the template would be cloned into itself (and an
+        // overlay upper dir may not live inside its lower dir either)
+        fs::path canonicalFrom = fs::weakly_canonical(fromRoot, ec);
+        fs::path canonicalTo = ec ? fs::path() : fs::weakly_canonical(toRoot, ec);
+        if (ec) {
+            std::cerr << "Error: Cannot resolve " << fromRoot << " or " << toRoot << ": "
+                      << ec.message() << std::endl;
+            return false;
+        }
+        auto rel = canonicalTo.lexically_relative(canonicalFrom);
+        if (!rel.empty() && *rel.begin() != "..") {
+            std::cerr << "Error: Target " << toRoot << " is inside the template "
+                      << fromRoot << "." << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string newRoot = toRoot;
+
+        if (mode == CloneMode::Overlay) {
+            newRoot = mountOverlay(fromRoot, toRoot);
+            if (newRoot.empty()) {
+                return false;
+            }
+        } else {
+            struct stat rootStat;
+            if (lstat(fromRoot.c_str(), &rootStat) != 0 || !S_ISDIR(rootStat.st_mode)) {
+                std::cerr << "Error: Cannot stat template " << fromRoot << std::endl;
+                return false;
+            }
+            fs::create_directories(toRoot, ec);
+            if (ec) {
+                std::cerr << "Error: Cannot create " << toRoot << ": " << ec.message() << std::endl;
+                return false;
+            }
+
+            CloneContext ctx;
+            ctx.mode = mode;
+            ctx.rootDevice = rootStat.st_dev;
+            bool ok = cloneTree(fromRoot, toRoot, "", ctx);
+            applyMetadata(fromRoot, toRoot, rootStat);
+
+            std::cout << "Files: " << ctx.reflinked << " reflinked, "
+                      << ctx.linked << " hardlinked, " << ctx.copied << " copied, "
+                      << ctx.others << " other";
+            if (ctx.skippedMounts > 0) {
+                std::cout << "; " << ctx.skippedMounts << " mountpoint(s) left empty";
+            }
+            std::cout << std::endl;
+
+            if (!ok) {
+                std::cerr << "Error: Clone of " << fromRoot << " is incomplete." << std::endl;
+                return false;
+            }
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << "Root cloned in " << elapsed.count() << " ms." << std::endl;
+
+        // Package delta against the template
+        if (!toRemove.empty()) {
+            std::string dbPath = newRoot + "/var/lib/starpack/installed.db";
+            removePackages(toRemove, dbPath, false, newRoot);
+        }
+        if (!toInstall.empty()) {
+            Installer::installPackage(toInstall, newRoot, confirm);
+        }
+
+        std::cout << "--- Clone ready: " << newRoot << " ---" << std::endl;
+        return true;
+    }
+
+} // namespace Starpack
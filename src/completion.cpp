@@ -0,0 +1,385 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "completion.hpp"      // Class definition
+
+#include <iostream>            // Standard I/O (cout)
+#include <fstream>             // Writing name lists
+#include <filesystem>          // Paths, rename
+#include <algorithm>           // std::sort, std::unique, std::lower_bound
+#include <string_view>         // Names inside the mapping
+#include <cstring>             // memcmp, memchr, memmem
+#include <cstdint>             // Fixed-width header fields
+#include <fcntl.h>             // open
+#include <sys/mman.h>          // mmap
+#include <sys/stat.h>          // stat
+#include <unistd.h>            // close, getpid
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        /**
+         * -------------------------------------------------------------------
+         * Name list layout (native byte order, all offsets in bytes)
+         *
+         *   NameIndexHeader
+         *   uint32_t offsets[count + 1]   start of each name in the blob;
+         *                                 offsets[count] == blobSize
+         *   char     blob[blobSize]       names, each followed by '\n'
+         *
+         * buckets[b] is the index of the first name whose leading byte is
+         * >= b (buckets[256] == count).
+         * -------------------------------------------------------------------
+         */
+        constexpr char kMagic[8] = { 'S', 'P', 'N', 'A', 'M', 'E', 'S', '1' };
+
+        struct NameIndexHeader {
+            char     magic[8];
+            uint32_t count;
+            uint32_t blobSize;
+            uint32_t buckets[257];
+        };
+
+        const char* const kBlockEnd = "\n----------------------------------------\n";
+
+        const char* const kCommands[] = {
+            "apply", "bench-env", "clean", "clone", "daemon", "image", "info", "install",
+            "list", "plan", "remove", "repo", "search", "serve", "sync", "update"
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * MappedFile
+         *
+         * Read-only mmap() of a whole file; empty if it cannot be mapped.
+         * -------------------------------------------------------------------
+         */
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path) {
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+                struct stat st;
+                if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (map != MAP_FAILED) {
+                        data_ = static_cast<const char*>(map);
+                        size_ = st.st_size;
+                    }
+                }
+                ::close(fd);
+            }
+            ~MappedFile() {
+                if (data_) {
+                    munmap(const_cast<char*>(data_), size_);
+                }
+            }
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const char* data() const { return data_; }
+            size_t      size() const { return size_; }
+
+        private:
+            const char* data_ = nullptr;
+            size_t      size_ = 0;
+        };
+
+        bool modifiedTime(const std::string& path, struct timespec& mtime) {
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0) {
+                return false;
+            }
+            mtime = st.st_mtim;
+            return true;
+        }
+
+        bool olderThan(const struct timespec& a, const struct timespec& b) {
+            return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * scanInstalledNames
+         *
+         * Package names of an installed.db: the first word of the first line
+         * of every block ("<name> /").
+         * -------------------------------------------------------------------
+         */
+        std::vector<std::string> scanInstalledNames(const std::string& dbPath) {
+            std::vector<std::string> names;
+            MappedFile db(dbPath);
+            const char* pos = db.data();
+            const char* end = db.data() + db.size();
+            size_t blockEndLength = std::strlen(kBlockEnd);
+
+            while (pos && pos < end) {
+                const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+                if (!lineEnd) {
+                    lineEnd = end;
+                }
+                const char* nameEnd = static_cast<const char*>(std::memchr(pos, ' ', lineEnd - pos));
+                if (nameEnd && nameEnd > pos) {
+                    names.emplace_back(pos, nameEnd);
+                }
+                const char* next = static_cast<const char*>(
+                    memmem(lineEnd, end - lineEnd, kBlockEnd, blockEndLength));
+                pos = next ? next + blockEndLength : nullptr;
+            }
+            return names;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * installedNames
+         *
+         * Looks prefix up in the root's installed name list, rebuilding the
+         * list first if installed.db changed since it was written (silently
+         * using the scan alone when the list cannot be written).
+         * -------------------------------------------------------------------
+         */
+        std::vector<std::string> installedNames(const fs::path& root, const std::string& prefix) {
+            fs::path dbDir = root / "var" / "lib" / "starpack";
+            std::string dbPath = (dbDir / "installed.db").string();
+            std::string listPath = (dbDir / Completion::installedNamesFile).string();
+
+            std::vector<std::string> matches;
+            if (!Completion::isStale(listPath, { dbPath }) &&
+                Completion::lookup(listPath, prefix, matches)) {
+                return matches;
+            }
+
+            std::vector<std::string> names = scanInstalledNames(dbPath);
+            Completion::writeNameIndex(listPath, names);
+
+            for (auto& name : names) {
+                if (name.compare(0, prefix.size(), prefix) == 0) {
+                    matches.push_back(std::move(name));
+                }
+            }
+            std::sort(matches.begin(), matches.end());
+            matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+            return matches;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Completion::writeNameIndex
+     * ------------------------------------------------------------------------
+     */
+    bool Completion::writeNameIndex(const std::string& path, std::vector<std::string> names) {
+        names.erase(std::remove(names.begin(), names.end(), std::string()), names.end());
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+
+        NameIndexHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.count = static_cast<uint32_t>(names.size());
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(names.size() + 1);
+        std::string blob;
+        size_t bucket = 0;
+        for (size_t i = 0; i < names.size(); i++) {
+            unsigned char lead = static_cast<unsigned char>(names[i][0]);
+            while (bucket <= lead) {
+                header.buckets[bucket++] = static_cast<uint32_t>(i);
+            }
+            offsets.push_back(static_cast<uint32_t>(blob.size()));
+            blob += names[i];
+            blob += '\n';
+        }
+        while (bucket <= 256) {
+            header.buckets[bucket++] = header.count;
+        }
+        offsets.push_back(static_cast<uint32_t>(blob.size()));
+        header.blobSize = static_cast<uint32_t>(blob.size());
+
+        std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+            if (!out) {
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(offsets.data()),
+                      offsets.size() * sizeof(uint32_t));
+            out.write(blob.data(), blob.size());
+            out.flush();
+            if (!out) {
+                std::error_code ec;
+                fs::remove(tmpPath, ec);
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmpPath, path, ec);
+        if (ec) {
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Completion::isStale
+     * ------------------------------------------------------------------------
+     */
+    bool Completion::isStale(const std::string& path, const std::vector<std::string>& sources) {
+        struct timespec listTime;
+        if (!modifiedTime(path, listTime)) {
+            return true;
+        }
+        for (const auto& source : sources) {
+            struct timespec sourceTime;
+            if (modifiedTime(source, sourceTime) && olderThan(listTime, sourceTime)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Completion::lookup
+     * ------------------------------------------------------------------------
+     */
+    bool Completion::lookup(const std::string& path, const std::string& prefix,
+                            std::vector<std::string>& matches) {
+        matches.clear();
+        MappedFile file(path);
+        if (file.size() < sizeof(NameIndexHeader)) {
+            return false;
+        }
+
+        NameIndexHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        size_t tableSize = (static_cast<size_t>(header.count) + 1) * sizeof(uint32_t);
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+            file.size() != sizeof(header) + tableSize + header.blobSize) {
+            return false;
+        }
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(file.data() + sizeof(header));
+        const char* blob = file.data() + sizeof(header) + tableSize;
+
+        // Every range read below must lie inside the file: buckets ascend up
+        // to count, and each name is at least its '\n' and ends by blobSize
+        if (header.buckets[0] != 0 || header.buckets[256] != header.count) {
+            return false;
+        }
+        for (size_t b = 0; b < 256; b++) {
+            if (header.buckets[b] > header.buckets[b + 1]) {
+                return false;
+            }
+        }
+        if (offsets[0] != 0 || offsets[header.count] != header.blobSize) {
+            return false;
+        }
+        for (uint32_t i = 0; i < header.count; i++) {
+            if (offsets[i] >= offsets[i + 1]) {
+                return false;
+            }
+        }
+
+        auto nameAt = [&](uint32_t i) {
+            return std::string_view(blob + offsets[i], offsets[i + 1] - offsets[i] - 1);
+        };
+
+        uint32_t first = 0;
+        uint32_t last  = header.count;
+        if (!prefix.empty()) {
+            unsigned char lead = static_cast<unsigned char>(prefix[0]);
+            first = header.buckets[lead];
+            last  = header.buckets[lead + 1];
+        }
+
+        // Binary search for the first name >= prefix within the bucket
+        uint32_t lo = first;
+        uint32_t hi = last;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (nameAt(mid) < prefix) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (uint32_t i = lo; i < last; i++) {
+            std::string_view name = nameAt(i);
+            if (name.substr(0, prefix.size()) != prefix) {
+                break;
+            }
+            matches.emplace_back(name);
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Completion::run
+     * ------------------------------------------------------------------------
+     */
+    int Completion::run(const std::vector<std::string>& words) {
+        if (words.empty()) {
+            return 0;
+        }
+        const std::string& current = words.back();
+
+        // Completing the command itself
+        if (words.size() == 1) {
+            for (const char* command : kCommands) {
+                if (std::string_view(command).substr(0, current.size()) == current) {
+                    std::cout << command << '\n';
+                }
+            }
+            return 0;
+        }
+
+        // Option values and options are left to the shell
+        const std::string& previous = words[words.size() - 2];
+        if ((!previous.empty() && previous[0] == '-') || (!current.empty() && current[0] == '-')) {
+            return 0;
+        }
+
+        fs::path root = "/";
+        for (size_t i = 1; i + 1 < words.size(); i++) {
+            if (words[i] == "--installdir" && i + 2 < words.size()) {
+                root = words[i + 1];
+            }
+        }
+
+        const std::string& command = words[0];
+        std::vector<std::string> candidates;
+        if (command == "install" || command == "info") {
+            fs::path cacheDir = root / "var" / "lib" / "starpack" / "cache";
+            std::string namesPath = (cacheDir / repoNamesFile).string();
+            if (!lookup(namesPath, current, candidates)) {
+                // Rewritten by the next command that loads the indices
+                std::error_code ec;
+                fs::remove(namesPath, ec);
+            }
+        }
+        if (command == "remove" || command == "update" || command == "info") {
+            std::vector<std::string> installed = installedNames(root, current);
+            candidates.insert(candidates.end(), installed.begin(), installed.end());
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+
+        for (const auto& candidate : candidates) {
+            std::cout << candidate << '\n';
+        }
+        return 0;
+    }
+
+} // namespace Starpack
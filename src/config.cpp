@@ -1,14 +1,154 @@
 #include "config.hpp"
+#include "download.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <fnmatch.h>
 
 namespace fs = std::filesystem;
 
 namespace Starpack {
 
+    namespace {
+
+        std::string trimmed(const std::string& s) {
+            size_t start = s.find_first_not_of(" \t\r");
+            if (start == std::string::npos) {
+                return "";
+            }
+            return s.substr(start, s.find_last_not_of(" \t\r") - start + 1);
+        }
+
+        std::string withSlash(std::string url) {
+            if (!url.empty() && url.back() != '/') {
+                url += '/';
+            }
+            return url;
+        }
+
+        bool parseBool(const std::string& value, bool& out) {
+            std::string v = value;
+            std::transform(v.begin(), v.end(), v.begin(),
+                           [](unsigned char c){ return std::tolower(c); });
+            if (v == "yes" || v == "true" || v == "on" || v == "1") {
+                out = true;
+            } else if (v == "no" || v == "false" || v == "off" || v == "0") {
+                out = false;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        bool parseInteger(const std::string& value, int& out, int minimum) {
+            try {
+                size_t used = 0;
+                int n = std::stoi(value, &used);
+                if (used != value.size() || n < minimum) {
+                    return false;
+                }
+                out = n;
+                return true;
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+
+        bool parseCount(const std::string& value, int& out) {
+            return parseInteger(value, out, 1);
+        }
+
+        bool parseDurability(const std::string& value, Durability& out) {
+            std::string v = value;
+            std::transform(v.begin(), v.end(), v.begin(),
+                           [](unsigned char c){ return std::tolower(c); });
+            if (v == "none") {
+                out = Durability::None;
+            } else if (v == "db") {
+                out = Durability::Database;
+            } else if (v == "full") {
+                out = Durability::Full;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Parses repos.conf into repositories (first occurrence of a URL
+         * wins). Returns false if the file cannot be opened.
+         */
+        bool parseRepositories(const std::string& path, std::vector<RepositoryConfig>& repositories) {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            std::string line;
+            size_t lineNumber = 0;
+            while (std::getline(file, line)) {
+                lineNumber++;
+                std::istringstream fields(line);
+                std::string field;
+                RepositoryConfig repo;
+                while (fields >> field) {
+                    if (field[0] == '#') {
+                        break;
+                    }
+                    if (repo.url.empty()) {
+                        repo.url = withSlash(field);
+                        continue;
+                    }
+
+                    size_t eq = field.find('=');
+                    std::string key   = field.substr(0, eq);
+                    std::string value = eq == std::string::npos ? "" : field.substr(eq + 1);
+                    bool ok = true;
+                    if (key == "priority") {
+                        ok = parseInteger(value, repo.priority, -1000000);
+                    } else if (key == "ttl") {
+                        ok = parseInteger(value, repo.indexTtl, 0);
+                    } else if (key == "mirror" && !value.empty()) {
+                        repo.mirrors.push_back(withSlash(value));
+                    } else {
+                        std::cerr << "Warning: " << path << ":" << lineNumber
+                                  << ": unknown repository option '" << field << "'." << std::endl;
+                        continue;
+                    }
+                    if (!ok) {
+                        std::cerr << "Warning: " << path << ":" << lineNumber
+                                  << ": invalid value for " << key << ": '" << value << "'." << std::endl;
+                    }
+                }
+
+                if (repo.url.empty()) {
+                    continue;
+                }
+                bool known = std::any_of(repositories.begin(), repositories.end(),
+                                         [&](const RepositoryConfig& r) { return r.url == repo.url; });
+                if (!known) {
+                    repositories.push_back(repo);
+                }
+            }
+            return true;
+        }
+
+        std::mutex              g_currentMutex;
+        std::unique_ptr<Config> g_current;
+
+    } // end anonymous namespace
+
+    std::vector<std::string> RepositoryConfig::bases() const {
+        std::vector<std::string> all{ url };
+        all.insert(all.end(), mirrors.begin(), mirrors.end());
+        return all;
+    }
+
     Config Config::loadFromFile(const std::string& path) {
         Config config;
 
@@ -16,26 +156,65 @@ namespace Starpack {
             std::cerr << "Error: Configuration file not found: " << path << std::endl;
             return config;
         }
-
-        std::ifstream file(path);
-        if (!file.is_open()) {
+        if (!parseRepositories(path, config.repositories)) {
             std::cerr << "Error: Unable to open configuration file: " << path << std::endl;
-            return config;
         }
+        return config;
+    }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            // Skips comments or empty lines
-            if (line.empty() || line[0] == '#') {
-                continue;
-            }
-            config.repositories.push_back(line);
+    Config Config::load(const std::string& reposPath, const std::string& settingsPath) {
+        Config config;
+        parseRepositories(reposPath, config.repositories);
+        config.settings = Settings::loadFromFile(settingsPath);
+        return config;
+    }
+
+    const Config& Config::current() {
+        std::lock_guard<std::mutex> lock(g_currentMutex);
+        if (!g_current) {
+            g_current = std::make_unique<Config>(load());
         }
+        return *g_current;
+    }
 
-        file.close();
+    void Config::setCurrent(const Config& config) {
+        std::lock_guard<std::mutex> lock(g_currentMutex);
+        g_current = std::make_unique<Config>(config);
+    }
+
+    Config Config::forReposFile(const std::string& path) {
+        if (path == defaultPath) {
+            return current();
+        }
+        Config config;
+        parseRepositories(path, config.repositories);
+        config.settings = current().settings;
         return config;
     }
 
+    std::vector<RepositoryConfig> Config::byPriority() const {
+        std::vector<RepositoryConfig> ordered = repositories;
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [](const RepositoryConfig& a, const RepositoryConfig& b) {
+                             return a.priority > b.priority;
+                         });
+        return ordered;
+    }
+
+    std::vector<std::string> Config::mirrorUrlsFor(const std::string& url) const {
+        std::vector<std::string> urls;
+        for (const auto& repo : repositories) {
+            if (url.rfind(repo.url, 0) == 0) {
+                std::string file = url.substr(repo.url.size());
+                for (const auto& mirror : repo.mirrors) {
+                    urls.push_back(mirror + file);
+                }
+                break;
+            }
+        }
+        return urls;
+    }
+
     void Config::saveToFile(const std::string& path) const {
         std::ofstream file(path, std::ios::trunc); // Truncate file to overwrite
         if (!file.is_open()) {
@@ -45,11 +224,22 @@ namespace Starpack {
 
         // Adds a comment header
         file << "# Starpack Repository Configuration\n";
-        file << "# Define repositories for Starpack to fetch packages from.\n\n";
+        file << "# Define repositories for Starpack to fetch packages from.\n";
+        file << "# <url> [priority=<n>] [ttl=<seconds>] [mirror=<url> ...]\n\n";
 
         // Writes repositories to file
         for (const auto& repo : repositories) {
-            file << repo << "\n";
+            file << repo.url;
+            if (repo.priority != 0) {
+                file << " priority=" << repo.priority;
+            }
+            if (repo.indexTtl >= 0) {
+                file << " ttl=" << repo.indexTtl;
+            }
+            for (const auto& mirror : repo.mirrors) {
+                file << " mirror=" << mirror;
+            }
+            file << "\n";
         }
 
         file.close();
@@ -57,30 +247,128 @@ namespace Starpack {
 
     void Config::print() const {
         std::cout << "Configured Repositories:" << std::endl;
-        for (const auto& repo : repositories) {
-            std::cout << "  - " << repo << std::endl;
+        for (const auto& repo : byPriority()) {
+            std::cout << "  - " << repo.url;
+            if (repo.priority != 0) {
+                std::cout << " (priority " << repo.priority << ")";
+            }
+            if (repo.indexTtl >= 0) {
+                std::cout << " (index TTL " << repo.indexTtl << "s)";
+            }
+            std::cout << std::endl;
+            for (const auto& mirror : repo.mirrors) {
+                std::cout << "      mirror " << mirror << std::endl;
+            }
         }
     }
 
     void Config::addRepository(const std::string& repo) {
         // Ensures that the repository does not already exist
-        if (std::find(repositories.begin(), repositories.end(), repo) != repositories.end()) {
+        std::string url = withSlash(repo);
+        auto it = std::find_if(repositories.begin(), repositories.end(),
+                               [&](const RepositoryConfig& r) { return r.url == url; });
+        if (it != repositories.end()) {
             std::cerr << "Error: Repository already exists: " << repo << std::endl;
             return;
         }
-    
-        repositories.push_back(repo);
+
+        RepositoryConfig entry;
+        entry.url = url;
+        repositories.push_back(entry);
         std::cout << "Added repository: " << repo << std::endl;
-    }        
+    }
 
     void Config::removeRepository(const std::string& repo) {
         // Find and remove the repository
-        auto it = std::find(repositories.begin(), repositories.end(), repo);
+        std::string url = withSlash(repo);
+        auto it = std::find_if(repositories.begin(), repositories.end(),
+                               [&](const RepositoryConfig& r) { return r.url == url; });
         if (it != repositories.end()) {
             repositories.erase(it);
             std::cout << "Removed repository: " << repo << std::endl;
         } else {
             std::cerr << "Error: Repository not found: " << repo << std::endl;
         }
-    }    
+    }
+
+    size_t Settings::workersFor(size_t count) const {
+        return jobs > 0 ? static_cast<size_t>(jobs) : std::max<size_t>(1, count);
+    }
+
+    bool Settings::excludedFromExtraction(const std::string& relativePath) const {
+        for (const auto& pattern : noExtract) {
+            if (fnmatch(pattern.c_str(), relativePath.c_str(), 0) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Settings Settings::loadFromFile(const std::string& path) {
+        Settings settings;
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return settings;
+        }
+
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            line = trimmed(line);
+            if (line.empty()) {
+                continue;
+            }
+
+            size_t eq = line.find('=');
+            std::string key   = trimmed(line.substr(0, eq));
+            std::string value = eq == std::string::npos ? "" : trimmed(line.substr(eq + 1));
+
+            bool ok = true;
+            if (key == "LowImpact") {
+                ok = parseBool(value, settings.lowImpact);
+            } else if (key == "LowImpactDownloadRate") {
+                ok = parseRate(value, settings.lowImpactDownloadRate);
+            } else if (key == "LowImpactWriteRate") {
+                ok = parseRate(value, settings.lowImpactWriteRate);
+            } else if (key == "DownloadConcurrencyMin") {
+                ok = parseCount(value, settings.downloadConcurrencyMin);
+            } else if (key == "DownloadConcurrencyMax") {
+                ok = parseCount(value, settings.downloadConcurrencyMax);
+            } else if (key == "Jobs") {
+                ok = parseInteger(value, settings.jobs, 0);
+            } else if (key == "Durability") {
+                ok = parseDurability(value, settings.durability);
+            } else if (key == "CacheMaxSize") {
+                ok = parseRate(value, settings.cacheMaxSize);   // same K/M/G suffixes
+            } else if (key == "CacheMaxAge") {
+                ok = parseInteger(value, settings.cacheMaxAge, 0);
+            } else if (key == "NoExtract") {
+                // Patterns are relative to the root; a leading '/' is optional
+                std::istringstream patterns(value);
+                std::string pattern;
+                while (patterns >> pattern) {
+                    settings.noExtract.push_back(pattern[0] == '/' ? pattern.substr(1) : pattern);
+                }
+            } else if (key == "MetricsTextfile") {
+                settings.metricsTextfile = value;
+            } else if (key == "MetricsJson") {
+                settings.metricsJson = value;
+            } else {
+                std::cerr << "Warning: " << path << ":" << lineNumber
+                          << ": unknown setting '" << key << "'." << std::endl;
+                continue;
+            }
+            if (!ok) {
+                std::cerr << "Warning: " << path << ":" << lineNumber
+                          << ": invalid value for " << key << ": '" << value << "'." << std::endl;
+            }
+        }
+        return settings;
+    }
 }
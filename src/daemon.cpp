@@ -0,0 +1,709 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "daemon.hpp"          // Class definition
+#include "config.hpp"          // repos.conf
+#include "info.hpp"            // PackageInfo (same output as `starpack info`)
+#include "utils.hpp"           // fetchRepoData
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // Reading installed.db and cached indices
+#include <sstream>             // Building answers
+#include <filesystem>          // Paths
+#include <unordered_map>       // Name and file-name indices
+#include <map>                 // PackageInfo file lists
+#include <set>                 // Changed cache files
+#include <memory>              // std::shared_ptr
+#include <mutex>               // Guarding the current view
+#include <thread>              // Query thread
+#include <chrono>              // Refresh scheduling
+#include <atomic>              // Stop flag
+#include <csignal>             // SIGTERM / SIGINT
+#include <cstdint>             // SIZE_MAX
+#include <algorithm>           // std::replace
+#include <cstring>             // strerror, memcpy
+#include <cerrno>              // errno
+#include <yaml-cpp/yaml.h>     // Repository indices
+#include <poll.h>              // poll
+#include <pthread.h>           // pthread_sigmask
+#include <unistd.h>            // read, write, close, unlink
+#include <sys/inotify.h>       // Change notifications
+#include <sys/socket.h>        // socket, bind, listen, accept
+#include <sys/stat.h>          // chmod
+#include <sys/un.h>            // sockaddr_un
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+using namespace std::chrono;
+
+namespace Starpack {
+
+    namespace {
+
+        const std::string kConfigDir = "/etc/starpack";
+        const std::string kReposConf = "/etc/starpack/repos.conf";
+
+        // Events that mean a watched file was replaced or rewritten
+        constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+
+        // Further events within this window are folded into one reload
+        constexpr int kDebounceMs = 50;
+
+        struct RepoPackage {
+            std::string              name;
+            std::string              version;
+            std::string              description;
+            std::vector<std::string> dependencies;
+            std::vector<std::string> files;        // As listed in the index
+        };
+
+        struct RepoIndex {
+            std::string              url;          // With trailing slash
+            std::string              cacheFile;    // Name of the installer's cached copy
+            std::vector<RepoPackage> packages;
+        };
+
+        struct FileHit {
+            size_t      repo;
+            size_t      package;
+            std::string path;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * RepoView
+         *
+         * Immutable snapshot of all repositories plus lookup indices. The
+         * first repository that carries a name wins, as in the installer.
+         * -------------------------------------------------------------------
+         */
+        struct RepoView {
+            std::vector<RepoIndex>                                repos;
+            std::unordered_map<std::string, std::pair<size_t, size_t>> byName;
+            std::unordered_map<std::string, std::vector<FileHit>> byFileName;
+        };
+
+        struct InstalledPackage {
+            std::string              header;       // "name /" line, shown as the name
+            std::string              version;      // Raw text after "Version:"
+            std::vector<std::string> files;
+        };
+
+        struct InstalledView {
+            bool                                    exists = false;
+            std::vector<InstalledPackage>           packages;
+            std::unordered_map<std::string, size_t> byName;
+        };
+
+        std::mutex                           g_viewMutex;
+        std::shared_ptr<const RepoView>      g_repoView;
+        std::shared_ptr<const InstalledView> g_installedView;
+
+        std::atomic<bool> g_stop{false};
+
+        void onSignal(int) {
+            g_stop = true;
+        }
+
+        std::string cacheFileName(const std::string& url) {
+            std::string name = url;
+            std::replace(name.begin(), name.end(), '/', '_');
+            std::replace(name.begin(), name.end(), ':', '_');
+            return name + "repo.db.yaml";
+        }
+
+        std::string scalar(const YAML::Node& node) {
+            return (node && node.IsScalar()) ? node.as<std::string>() : "";
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * parseRepoIndex
+         * -------------------------------------------------------------------
+         */
+        bool parseRepoIndex(const std::string& text, RepoIndex& index) {
+            YAML::Node repo;
+            try {
+                repo = YAML::Load(text);
+            } catch (const YAML::Exception& e) {
+                std::cerr << "[starpackd] Invalid index for " << index.url << ": "
+                          << e.what() << std::endl;
+                return false;
+            }
+            if (!repo["packages"] || !repo["packages"].IsSequence()) {
+                std::cerr << "[starpackd] Invalid repository data at " << index.url << std::endl;
+                return false;
+            }
+
+            index.packages.clear();
+            for (const auto& node : repo["packages"]) {
+                RepoPackage package;
+                package.name        = scalar(node["name"]);
+                package.version     = scalar(node["version"]);
+                package.description = scalar(node["description"]);
+                if (package.name.empty()) {
+                    continue;
+                }
+                if (node["dependencies"] && node["dependencies"].IsSequence()) {
+                    for (const auto& dep : node["dependencies"]) {
+                        package.dependencies.push_back(dep.as<std::string>());
+                    }
+                }
+                if (node["files"] && node["files"].IsSequence()) {
+                    for (const auto& file : node["files"]) {
+                        package.files.push_back(file.as<std::string>());
+                    }
+                }
+                index.packages.push_back(std::move(package));
+            }
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * loadRepoIndex
+         *
+         * Remote first (what the standalone commands see), the installer's
+         * cached copy as fallback; or only the cached copy when it is the
+         * file that just changed.
+         * -------------------------------------------------------------------
+         */
+        void loadRepoIndex(RepoIndex& index, const fs::path& cacheDir, bool fromCache) {
+            if (!fromCache) {
+                try {
+                    if (parseRepoIndex(fetchRepoData(index.url + "repo.db.yaml"), index)) {
+                        return;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "[starpackd] " << index.url << ": " << e.what()
+                              << "; using the cached index." << std::endl;
+                }
+            }
+            std::ifstream file(cacheDir / index.cacheFile);
+            if (file.is_open()) {
+                std::stringstream text;
+                text << file.rdbuf();
+                parseRepoIndex(text.str(), index);
+            }
+        }
+
+        std::shared_ptr<const RepoView> buildRepoView(std::vector<RepoIndex> repos) {
+            auto view = std::make_shared<RepoView>();
+            view->repos = std::move(repos);
+            for (size_t r = 0; r < view->repos.size(); ++r) {
+                const auto& packages = view->repos[r].packages;
+                for (size_t p = 0; p < packages.size(); ++p) {
+                    view->byName.emplace(packages[p].name, std::make_pair(r, p));
+                    for (auto path : packages[p].files) {
+                        if (!path.empty() && path.front() != '/') {
+                            path = "/" + path;
+                        }
+                        view->byFileName[fs::path(path).filename().string()]
+                            .push_back({ r, p, path });
+                    }
+                }
+            }
+            return view;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * loadInstalledView
+         *
+         * Parses installed.db the way fetchPackageInfoFromLocal() reads it.
+         * -------------------------------------------------------------------
+         */
+        std::shared_ptr<const InstalledView> loadInstalledView(const fs::path& dbPath) {
+            auto view = std::make_shared<InstalledView>();
+            std::ifstream db(dbPath);
+            if (!db.is_open()) {
+                return view;
+            }
+            view->exists = true;
+
+            std::string line;
+            InstalledPackage* current = nullptr;
+            bool inFiles = false;
+            while (std::getline(db, line)) {
+                if (line.size() > 2 && line.compare(line.size() - 2, 2, " /") == 0 &&
+                    line.find(' ') == line.size() - 2) {
+                    view->byName[line.substr(0, line.size() - 2)] = view->packages.size();
+                    view->packages.push_back({ line, "", {} });
+                    current = &view->packages.back();
+                    inFiles = false;
+                } else if (!current) {
+                    continue;
+                } else if (inFiles && !line.empty() && line[0] == '/') {
+                    current->files.push_back(line);
+                } else if (line.rfind("Version:", 0) == 0 && current->version.empty()) {
+                    current->version = line.substr(8);
+                } else if (line.rfind("Files:", 0) == 0) {
+                    inFiles = true;
+                } else {
+                    inFiles = false;
+                }
+            }
+            return view;
+        }
+
+        //====================================================================
+        // Queries
+        //====================================================================
+
+        int answerList(const InstalledView& installed, const fs::path& dbPath,
+                       std::ostream& out, std::ostream& err) {
+            if (!installed.exists) {
+                err << "Error: Could not open the installed database file: "
+                    << dbPath.string() << "\n";
+                return 0;
+            }
+            out << "Installed Packages:\n";
+            out << "-------------------\n";
+            for (const auto& package : installed.packages) {
+                out << package.header.substr(0, package.header.size() - 2) << "\n";
+            }
+            if (installed.packages.empty()) {
+                out << "No packages are installed (what?)\n";
+            }
+            return 0;
+        }
+
+        int answerInfo(const RepoView& repos, const InstalledView& installed,
+                       const fs::path& dbPath, const std::string& name,
+                       std::ostream& out, std::ostream& err) {
+            if (!installed.exists) {
+                err << "Error: Local database not found at " << dbPath.string() << "\n";
+            } else {
+                auto it = installed.byName.find(name);
+                if (it != installed.byName.end()) {
+                    const auto& package = installed.packages[it->second];
+                    std::map<std::string, std::string> files;
+                    for (const auto& file : package.files) {
+                        files[file] = "Installed file";
+                    }
+                    PackageInfo(package.header, package.version, "Installed package", {}, files)
+                        .display(out);
+                    return 0;
+                }
+                err << "Error: Package " << name << " not found in the local database.\n";
+            }
+
+            auto it = repos.byName.find(name);
+            if (it != repos.byName.end()) {
+                const auto& package = repos.repos[it->second.first].packages[it->second.second];
+                std::map<std::string, std::string> files;
+                for (const auto& file : package.files) {
+                    files[file] = "File included";
+                }
+                PackageInfo(package.name, package.version, package.description,
+                            package.dependencies, files).display(out);
+                return 0;
+            }
+            err << "Error: Package " << name << " not found in repositories.\n";
+            err << "Error: Package " << name << " not found locally or in repositories.\n";
+            return 0;
+        }
+
+        int answerSearch(const RepoView& repos, const std::string& query,
+                         std::ostream& out) {
+            bool found = false;
+            for (const auto& repo : repos.repos) {
+                out << "Searching in repository: " << repo.url << "repo.db.yaml\n";
+                for (const auto& package : repo.packages) {
+                    if (package.name.find(query)        != std::string::npos ||
+                        package.version.find(query)     != std::string::npos ||
+                        package.description.find(query) != std::string::npos) {
+                        out << "Package: " << package.name
+                            << " (Version: " << package.version << ")\n";
+                        out << "Description: " << package.description << "\n\n";
+                        found = true;
+                    }
+                }
+            }
+            if (!found) {
+                out << "No packages found matching: " << query << "\n";
+            }
+            return 0;
+        }
+
+        int answerSearchFile(const RepoView& repos, const std::string& filePath,
+                             std::ostream& out) {
+            std::string fileName = fs::path(filePath).filename().string();
+            auto hits = repos.byFileName.find(fileName);
+
+            bool found = false;
+            size_t next = 0;
+            for (size_t r = 0; r < repos.repos.size(); ++r) {
+                out << "Searching in repository: " << repos.repos[r].url << "repo.db.yaml\n";
+                if (hits == repos.byFileName.end()) {
+                    continue;
+                }
+                // Hits are ordered by repository, package and file; one per package
+                const auto& list = hits->second;
+                size_t lastPackage = SIZE_MAX;
+                for (; next < list.size() && list[next].repo == r; ++next) {
+                    if (list[next].package == lastPackage) {
+                        continue;
+                    }
+                    lastPackage = list[next].package;
+                    const auto& package = repos.repos[r].packages[list[next].package];
+                    out << "Package: " << package.name
+                        << " (Version: " << package.version << ")\n";
+                    out << "Description: " << package.description << "\n";
+                    out << "Matched File: \033[31m" << list[next].path << "\033[0m\n\n";
+                    found = true;
+                }
+            }
+            if (!found) {
+                out << "No packages found containing file: " << filePath << "\n";
+            }
+            return 0;
+        }
+
+        int answer(const std::vector<std::string>& args, const fs::path& dbPath,
+                   std::ostream& out, std::ostream& err) {
+            std::shared_ptr<const RepoView>      repos;
+            std::shared_ptr<const InstalledView> installed;
+            {
+                std::lock_guard<std::mutex> lock(g_viewMutex);
+                repos     = g_repoView;
+                installed = g_installedView;
+            }
+
+            const std::string command = args.empty() ? "" : args[0];
+            if (command == "ping" && args.size() == 1) {
+                out << "pong\n";
+                return 0;
+            }
+            if (command == "list" && args.size() == 1) {
+                return answerList(*installed, dbPath, out, err);
+            }
+            if (command == "info" && args.size() == 2) {
+                return answerInfo(*repos, *installed, dbPath, args[1], out, err);
+            }
+            if (command == "search" && args.size() == 2) {
+                return answerSearch(*repos, args[1], out);
+            }
+            if (command == "search" && args.size() == 3 && args[1] == "--file") {
+                return answerSearchFile(*repos, args[2], out);
+            }
+            err << "starpackd: unsupported query '" << command << "'\n";
+            return 2;
+        }
+
+        //====================================================================
+        // Socket I/O
+        //====================================================================
+
+        bool writeAll(int fd, const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * serveQueries
+         *
+         * One request per connection: a line of tab-separated arguments. The
+         * answer is "<exit> <stdout bytes> <stderr bytes>\n" and both texts.
+         * -------------------------------------------------------------------
+         */
+        void serveQueries(int listenFd, fs::path dbPath) {
+            while (!g_stop) {
+                int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+                    std::cerr << "[starpackd] accept() failed: " << strerror(errno) << std::endl;
+                    std::this_thread::sleep_for(milliseconds(100));
+                    continue;
+                }
+                struct timeval timeout{ 2, 0 };
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+                std::string request;
+                char buffer[4096];
+                while (request.find('\n') == std::string::npos && request.size() < 65536) {
+                    ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+                    if (n <= 0) {
+                        break;
+                    }
+                    request.append(buffer, static_cast<size_t>(n));
+                }
+                size_t end = request.find('\n');
+                if (end == std::string::npos) {
+                    close(client);
+                    continue;
+                }
+
+                std::vector<std::string> args;
+                std::stringstream fields(request.substr(0, end));
+                std::string field;
+                while (std::getline(fields, field, '\t')) {
+                    args.push_back(field);
+                }
+
+                std::ostringstream out, err;
+                int code = answer(args, dbPath, out, err);
+                std::string o = out.str(), e = err.str();
+                writeAll(client, std::to_string(code) + " " + std::to_string(o.size()) + " " +
+                                 std::to_string(e.size()) + "\n" + o + e);
+                close(client);
+            }
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Daemon::run
+     * ------------------------------------------------------------------------
+     */
+    bool Daemon::run(const DaemonOptions& options) {
+        const std::string socketPath = options.socketPath.empty()
+            ? defaultSocketPath : options.socketPath;
+        const fs::path dbDir    = fs::path(options.installDir) / "var" / "lib" / "starpack";
+        const fs::path dbPath   = dbDir / "installed.db";
+        const fs::path cacheDir = dbDir / "cache";
+
+        std::error_code ec;
+        fs::create_directories(cacheDir, ec);
+        fs::create_directories(kConfigDir, ec);
+        fs::create_directories(fs::path(socketPath).parent_path(), ec);
+
+        // Watch before the first load so no change can slip in between
+        int inotifyFd = inotify_init1(IN_CLOEXEC);
+        if (inotifyFd < 0) {
+            std::cerr << "Error: inotify_init1 failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        int configWatch = inotify_add_watch(inotifyFd, kConfigDir.c_str(), kWatchMask);
+        int dbWatch     = inotify_add_watch(inotifyFd, dbDir.c_str(), kWatchMask);
+        int cacheWatch  = inotify_add_watch(inotifyFd, cacheDir.c_str(), kWatchMask);
+        if (configWatch < 0 || dbWatch < 0 || cacheWatch < 0) {
+            std::cerr << "Error: Cannot watch " << kConfigDir << ", " << dbDir.string()
+                      << " or " << cacheDir.string() << ": " << strerror(errno) << std::endl;
+            close(inotifyFd);
+            return false;
+        }
+
+        std::vector<RepoIndex> repos;
+        auto loadAllRepos = [&]() {
+            auto started = steady_clock::now();
+            repos.clear();
+            // Re-read on every reload: repos.conf is watched for changes
+            for (const auto& repo : Config::loadFromFile(kReposConf).byPriority()) {
+                const std::string& url = repo.url;
+                RepoIndex index;
+                index.url       = url;
+                index.cacheFile = cacheFileName(url);
+                loadRepoIndex(index, cacheDir, false);
+                repos.push_back(std::move(index));
+            }
+            auto view = buildRepoView(repos);
+            size_t count = 0;
+            for (const auto& repo : view->repos) {
+                count += repo.packages.size();
+            }
+            {
+                std::lock_guard<std::mutex> lock(g_viewMutex);
+                g_repoView = view;
+            }
+            std::cout << "[starpackd] Loaded " << count << " package(s) from "
+                      << view->repos.size() << " repositor" << (view->repos.size() == 1 ? "y" : "ies")
+                      << " in " << duration_cast<milliseconds>(steady_clock::now() - started).count()
+                      << " ms" << std::endl;
+        };
+        auto loadInstalled = [&]() {
+            auto view = loadInstalledView(dbPath);
+            {
+                std::lock_guard<std::mutex> lock(g_viewMutex);
+                g_installedView = view;
+            }
+            std::cout << "[starpackd] Loaded " << view->packages.size()
+                      << " installed package(s) from " << dbPath.string() << std::endl;
+        };
+
+        loadAllRepos();
+        loadInstalled();
+
+        // Socket: replace a stale one, readable by everyone (queries are read-only)
+        int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (listenFd < 0 || socketPath.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: Cannot create socket " << socketPath << std::endl;
+            close(inotifyFd);
+            return false;
+        }
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        unlink(socketPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 128) != 0) {
+            std::cerr << "Error: Cannot listen on " << socketPath << ": "
+                      << strerror(errno) << std::endl;
+            close(listenFd);
+            close(inotifyFd);
+            return false;
+        }
+        chmod(socketPath.c_str(), 0666);
+
+        std::signal(SIGPIPE, SIG_IGN);
+        std::signal(SIGTERM, onSignal);
+        std::signal(SIGINT, onSignal);
+
+        // SIGTERM/SIGINT must reach the main loop, not the query thread
+        sigset_t stopSignals, previous;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGTERM);
+        sigaddset(&stopSignals, SIGINT);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+        std::thread(serveQueries, listenFd, dbPath).detach();
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        std::cout << "[starpackd] Serving " << options.installDir << " on " << socketPath
+                  << std::endl;
+
+        auto nextRefresh = steady_clock::now() + seconds(options.refreshInterval);
+        alignas(struct inotify_event) char events[16 * 1024];
+
+        while (!g_stop) {
+            int waitMs = options.refreshInterval > 0
+                ? static_cast<int>(std::max<long long>(0,
+                      duration_cast<milliseconds>(nextRefresh - steady_clock::now()).count()))
+                : -1;
+            struct pollfd pfd{ inotifyFd, POLLIN, 0 };
+            int rc = poll(&pfd, 1, waitMs);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[starpackd] poll failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            if (rc == 0) {
+                loadAllRepos();
+                nextRefresh = steady_clock::now() + seconds(options.refreshInterval);
+                continue;
+            }
+
+            // Collect everything that changed, including events that follow closely
+            bool reposChanged = false, installedChanged = false;
+            std::set<std::string> changedIndices;
+            do {
+                ssize_t len = read(inotifyFd, events, sizeof(events));
+                for (ssize_t offset = 0; offset < len; ) {
+                    auto* event = reinterpret_cast<struct inotify_event*>(events + offset);
+                    std::string name = event->len ? event->name : "";
+                    if (event->wd == configWatch && name == "repos.conf") {
+                        reposChanged = true;
+                    } else if (event->wd == dbWatch && name == "installed.db") {
+                        installedChanged = true;
+                    } else if (event->wd == cacheWatch && name.size() > 12 &&
+                               name.compare(name.size() - 12, 12, "repo.db.yaml") == 0) {
+                        changedIndices.insert(name);
+                    }
+                    offset += sizeof(struct inotify_event) + event->len;
+                }
+            } while (poll(&pfd, 1, kDebounceMs) > 0);
+
+            if (installedChanged) {
+                loadInstalled();
+            }
+            if (reposChanged) {
+                loadAllRepos();
+            } else if (!changedIndices.empty()) {
+                // An install or update refreshed its cached copy; that is the newest data
+                bool any = false;
+                for (auto& index : repos) {
+                    if (changedIndices.count(index.cacheFile)) {
+                        loadRepoIndex(index, cacheDir, true);
+                        any = true;
+                    }
+                }
+                if (any) {
+                    auto view = buildRepoView(repos);
+                    std::lock_guard<std::mutex> lock(g_viewMutex);
+                    g_repoView = view;
+                    std::cout << "[starpackd] Reloaded " << changedIndices.size()
+                              << " cached repository index(es)" << std::endl;
+                }
+            }
+        }
+
+        unlink(socketPath.c_str());
+        close(inotifyFd);
+        std::cout << "[starpackd] Stopped." << std::endl;
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Daemon::query
+     * ------------------------------------------------------------------------
+     */
+    bool Daemon::query(const std::vector<std::string>& args, int& exitCode) {
+        std::string request;
+        for (const auto& arg : args) {
+            if (arg.find_first_of("\t\n") != std::string::npos) {
+                return false;
+            }
+            request += (request.empty() ? "" : "\t") + arg;
+        }
+        request += "\n";
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, defaultSocketPath, sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return false;
+        }
+        struct timeval timeout{ 5, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::string response;
+        if (writeAll(fd, request)) {
+            char buffer[65536];
+            ssize_t n;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                response.append(buffer, static_cast<size_t>(n));
+            }
+        }
+        close(fd);
+
+        // Only print a complete answer; otherwise the caller runs the command itself
+        size_t headerEnd = response.find('\n');
+        if (headerEnd == std::string::npos) {
+            return false;
+        }
+        int code = 0;
+        size_t outSize = 0, errSize = 0;
+        std::istringstream header(response.substr(0, headerEnd));
+        if (!(header >> code >> outSize >> errSize) ||
+            response.size() != headerEnd + 1 + outSize + errSize || code == 2) {
+            return false;
+        }
+        std::cout << response.substr(headerEnd + 1, outSize) << std::flush;
+        std::cerr << response.substr(headerEnd + 1 + outSize, errSize) << std::flush;
+        exitCode = code;
+        return true;
+    }
+
+} // namespace Starpack
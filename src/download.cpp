@@ -0,0 +1,834 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "download.hpp"        // Public download entry points
+#include "low_impact.hpp"      // Page-cache hygiene for finished downloads
+#include "events.hpp"          // Progress events for library consumers
+#include "trace.hpp"           // --trace transfer spans
+#include "metrics.hpp"         // Transferred bytes, cache hits, failures
+#include "progress.hpp"        // Consolidated transfer progress
+#include "config.hpp"          // Repository mirrors
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // File streams (ofstream)
+#include <filesystem>          // Modern C++ filesystem operations
+#include <curl/curl.h>         // Libcurl for downloading
+#include <map>                 // Ordered maps (job table)
+#include <iomanip>             // Output formatting (setprecision)
+#include <chrono>              // Time points and durations
+#include <thread>              // std::this_thread::sleep_for
+#include <atomic>              // std::atomic_* types
+#include <cstdio>              // std::perror
+#include <algorithm>           // std::max, std::clamp
+#include <list>                // Queue of pending transfers
+#include <memory>              // Per-transfer progress tasks
+#include <sys/select.h>        // select, fd_set
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+using namespace std::chrono;
+
+namespace Starpack {
+
+    namespace {
+
+        // Process-wide receive cap in bytes per second (0 = unlimited)
+        std::atomic<long long> g_rateLimit{0};
+
+        // Bounds for the number of parallel transfers per host
+        std::atomic<int> g_minConcurrency{1};
+        std::atomic<int> g_maxConcurrency{16};
+
+        // Window a host starts with before any throughput has been measured
+        constexpr int kInitialWindow = 4;
+
+        // A transfer that received nothing for this long counts as stalled
+        constexpr auto kStallTime = seconds(3);
+
+        // How often the window of a host is re-evaluated
+        constexpr auto kAdjustInterval = milliseconds(1000);
+
+        /**
+         * -------------------------------------------------------------------
+         * WriteCallback
+         *
+         * cURL write callback for receiving data and writing directly to
+         * an output file stream.
+         * -------------------------------------------------------------------
+         */
+        size_t WriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata) {
+            std::ofstream* outFile = static_cast<std::ofstream*>(userdata);
+            size_t totalSize = size * nmemb;
+
+            if (outFile && outFile->is_open()) {
+                outFile->write(static_cast<char*>(ptr), totalSize);
+                if (!outFile->good()) {
+                    std::cerr << "Error writing to download file stream!" << std::endl;
+                    return 0; // Signal error to cURL
+                }
+            } else {
+                // If the file stream is invalid but not null, we signal an error
+                if (userdata != nullptr) {
+                    std::cerr << "Error: Invalid file stream in WriteCallback!" << std::endl;
+                    return 0; // Signal error to cURL
+                }
+            }
+            return totalSize;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * reportTransfer
+         *
+         * Progress of one transfer: an event for library consumers, otherwise
+         * the counters of its progress task, drawn by the Progress renderer.
+         * -------------------------------------------------------------------
+         */
+        int reportTransfer(const std::string* url, Progress::Task* task,
+                           curl_off_t totalToDownload, curl_off_t nowDownloaded) {
+            uint64_t done  = static_cast<uint64_t>(std::max<curl_off_t>(0, nowDownloaded));
+            uint64_t total = static_cast<uint64_t>(std::max<curl_off_t>(0, totalToDownload));
+
+            if (Events::active()) {
+                Events::progress("download", url ? *url : "", done, total);
+                return 0;
+            }
+            if (task) {
+                task->update(done, total);
+            }
+            return 0; // Return 0 to indicate success to cURL
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * SingleTransfer / XferInfoCallback
+         *
+         * cURL transfer info callback of synchronous downloads.
+         * -------------------------------------------------------------------
+         */
+        struct SingleTransfer {
+            const std::string* url;
+            Progress::Task*    task;
+        };
+
+        int XferInfoCallback(void* ptr,
+                             curl_off_t totalToDownload,
+                             curl_off_t nowDownloaded,
+                             curl_off_t /*totalToUpload*/,
+                             curl_off_t /*nowUploaded*/) {
+            SingleTransfer* transfer = static_cast<SingleTransfer*>(ptr);
+            return reportTransfer(transfer ? transfer->url : nullptr,
+                                  transfer ? transfer->task : nullptr,
+                                  totalToDownload, nowDownloaded);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * HostWindow
+         *
+         * AIMD state of one host: the number of in-flight transfers grows by
+         * one per interval while that keeps raising aggregate throughput,
+         * and is halved when a transfer stalls or fails.
+         * -------------------------------------------------------------------
+         */
+        struct HostWindow {
+            int        limit      = kInitialWindow;
+            int        inFlight   = 0;
+            bool       congested  = false;   // a transfer failed since the last adjustment
+            curl_off_t bytes      = 0;       // received since the last adjustment
+            double     throughput = 0;       // smoothed bytes per second
+            steady_clock::time_point lastAdjust = steady_clock::now();
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * DownloadJob
+         *
+         * Structure that holds information about a download job for the
+         * multi-file asynchronous download mechanism.
+         * -------------------------------------------------------------------
+         */
+        struct DownloadJob {
+            std::ofstream fileStream;
+            CURL*         easyHandle = nullptr;
+            std::string   url;
+            std::string   outputPath;
+            bool          success = false;
+            HostWindow*   window   = nullptr;
+            curl_off_t    received = 0;
+            steady_clock::time_point lastProgress = steady_clock::now();
+            std::unique_ptr<Progress::Task> progress;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * MultiXferInfoCallback
+         *
+         * Progress callback of multi transfers: feeds the byte counts into
+         * the host's window and the transfer's progress task.
+         * -------------------------------------------------------------------
+         */
+        int MultiXferInfoCallback(void* clientp,
+                                  curl_off_t totalToDownload,
+                                  curl_off_t nowDownloaded,
+                                  curl_off_t /*totalToUpload*/,
+                                  curl_off_t /*nowUploaded*/) {
+            DownloadJob* job = static_cast<DownloadJob*>(clientp);
+            if (job && nowDownloaded > job->received) {
+                if (job->window) {
+                    job->window->bytes += nowDownloaded - job->received;
+                }
+                job->received     = nowDownloaded;
+                job->lastProgress = steady_clock::now();
+            }
+            return reportTransfer(job ? &job->url : nullptr, job ? job->progress.get() : nullptr,
+                                  totalToDownload, nowDownloaded);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * hostOf
+         *
+         * The "host[:port]" part of a URL; file:// URLs share one window.
+         * -------------------------------------------------------------------
+         */
+        std::string hostOf(const std::string& url) {
+            size_t start = url.find("://");
+            start = (start == std::string::npos) ? 0 : start + 3;
+            size_t end = url.find('/', start);
+            return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * adjustWindow
+         *
+         * One controller step for a host. A stall or failure halves the
+         * window; a full window with queued work grows by one as long as the
+         * measured throughput did not drop with the last increase.
+         * -------------------------------------------------------------------
+         */
+        void adjustWindow(HostWindow& window, bool stalled, bool backlog,
+                          steady_clock::time_point now) {
+            double elapsed = duration<double>(now - window.lastAdjust).count();
+            if (elapsed <= 0) {
+                return;
+            }
+            const int minLimit = g_minConcurrency.load();
+            const int maxLimit = g_maxConcurrency.load();
+            double sample = static_cast<double>(window.bytes) / elapsed;
+
+            if (stalled || window.congested) {
+                window.limit = std::max(minLimit, window.limit / 2);
+            } else if (backlog && window.inFlight >= window.limit) {
+                if (window.throughput <= 0 || sample >= 0.9 * window.throughput) {
+                    window.limit = std::min(maxLimit, window.limit + 1);
+                } else if (sample < 0.75 * window.throughput) {
+                    // More parallelism made things slower: back off gently
+                    window.limit = std::max(minLimit, window.limit - 1);
+                }
+            }
+            window.limit = std::clamp(window.limit, minLimit, maxLimit);
+
+            window.throughput = (window.throughput <= 0)
+                ? sample : 0.7 * window.throughput + 0.3 * sample;
+            window.bytes      = 0;
+            window.congested  = false;
+            window.lastAdjust = now;
+        }
+
+    } // end anonymous namespace
+
+    //========================================================================
+    // Download Functions
+    //========================================================================
+
+    /**
+     * ------------------------------------------------------------------------
+     * downloadSingleFileSync
+     *
+     * Downloads a single file using a synchronous cURL invocation. Returns
+     * true if the file either already exists or downloads successfully.
+     * ------------------------------------------------------------------------
+     */
+    bool downloadSingleFileSync(const std::string& url, const std::string& outputPath) {
+        if (fs::exists(outputPath)) {
+            // Already present, consider it "good"
+            Metrics::addCacheLookup(true);
+            return true;
+        }
+
+        std::cout << "[Sync] Downloading: " << url << " -> " << outputPath << std::endl;
+
+        fs::path outPathFs(outputPath);
+        fs::path parentDir = outPathFs.parent_path();
+        if (!parentDir.empty() && !fs::exists(parentDir)) {
+            try {
+                fs::create_directories(parentDir);
+            } catch (const std::exception& e) {
+                std::cerr << "[Sync] Error creating directory "
+                          << parentDir.string() << ": " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            std::cerr << "[Sync] Error: Failed to initialize curl." << std::endl;
+            return false;
+        }
+
+        // Data goes to a .part file that only replaces outputPath once complete
+        std::string partPath = outputPath + ".part";
+        std::ofstream outFile(partPath, std::ios::binary | std::ios::trunc);
+        if (!outFile) {
+            std::cerr << "[Sync] Error: Failed to open file for writing: "
+                      << partPath << std::endl;
+            curl_easy_cleanup(curl);
+            return false;
+        }
+
+        Progress::Activity activity("Downloading " + fs::path(url).filename().string(),
+                                    Progress::Unit::Bytes);
+        Progress::Task task(activity);
+        SingleTransfer transfer{ &url, &task };
+
+        // Configure cURL
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &outFile);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, XferInfoCallback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);
+        if (g_rateLimit > 0) {
+            curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE,
+                             static_cast<curl_off_t>(g_rateLimit.load()));
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 0L); // slow by design
+        }
+
+        Trace::Span span("download", "fetch", fs::path(url).filename().string());
+        CURLcode res = curl_easy_perform(curl);
+        long response_code = 0;
+        if (res == CURLE_OK) {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        }
+        curl_off_t bytes = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+        Metrics::addDownload(static_cast<uint64_t>(bytes));
+        if (Trace::enabled()) {
+            span.arg("url", url);
+            span.arg("bytes", static_cast<uint64_t>(bytes));
+            span.arg("status", static_cast<uint64_t>(response_code));
+        }
+
+        curl_easy_cleanup(curl);
+        outFile.close();
+
+        if (res != CURLE_OK) {
+            std::cerr << "[Sync] Error downloading " << url << ": "
+                      << curl_easy_strerror(res) << std::endl;
+            Metrics::addFailure("download");
+            fs::remove(partPath);
+            return false;
+        }
+
+        if (response_code >= 400) {
+            std::cerr << "[Sync] Error downloading " << url << ": Server responded with code "
+                      << response_code << std::endl;
+            Metrics::addFailure("download");
+            fs::remove(partPath);
+            return false;
+        }
+        Metrics::addCacheLookup(false);
+
+        std::error_code ec;
+        fs::rename(partPath, outputPath, ec);
+        if (ec) {
+            std::cerr << "[Sync] Error: Cannot move " << partPath << " into place: "
+                      << ec.message() << std::endl;
+            fs::remove(partPath, ec);
+            return false;
+        }
+        LowImpact::dropFromCache(outputPath, true);
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * downloadMultipleFilesMulti
+     *
+     * Downloads multiple files asynchronously using cURL multi-interface.
+     * Returns true if all files download successfully, false otherwise.
+     * ------------------------------------------------------------------------
+     */
+    bool downloadMultipleFilesMulti(const std::vector<std::pair<std::string, std::string>>& filesToDownload) {
+        if (filesToDownload.empty()) {
+            return true;
+        }
+
+        CURLM* multiHandle = curl_multi_init();
+        if (!multiHandle) {
+            std::cerr << "[Multi Error] curl_multi_init failed!\n";
+            return false;
+        }
+
+        // One view for the whole batch; each transfer is a task of it
+        Progress::Activity activity("Downloading", Progress::Unit::Bytes, filesToDownload.size());
+        std::map<CURL*, DownloadJob> jobs;
+        std::atomic<bool>   overallSuccess = {true};
+        std::atomic<size_t> completedCount = {0};
+        size_t totalJobsAttempted         = 0;
+
+        // Files not started yet; each host admits as many as its window allows
+        std::list<size_t> pending;
+        for (size_t i = 0; i < filesToDownload.size(); ++i) {
+            pending.push_back(i);
+        }
+        std::map<std::string, HostWindow> windows;
+        int currentDownloads    = 0;
+        int stillRunning        = 0;
+
+        // Main event loop
+        do {
+            // Start queued transfers on every host that has room in its window
+            for (auto pendingIt = pending.begin(); pendingIt != pending.end(); ) {
+                const auto& url  = filesToDownload[*pendingIt].first;
+                const auto& path = filesToDownload[*pendingIt].second;
+                auto [windowIt, newHost] = windows.try_emplace(hostOf(url));
+                HostWindow& window = windowIt->second;
+                if (newHost) {
+                    window.limit = std::clamp(kInitialWindow, g_minConcurrency.load(),
+                                              g_maxConcurrency.load());
+                }
+                if (window.inFlight >= window.limit) {
+                    ++pendingIt;
+                    continue;
+                }
+                pendingIt = pending.erase(pendingIt);
+                totalJobsAttempted++;
+
+                // If file already exists, skip
+                if (fs::exists(path)) {
+                    Metrics::addCacheLookup(true);
+                    activity.advance();
+                    completedCount++;
+                    continue;
+                }
+
+                // Make sure destination directory exists
+                fs::path outPathFs(path);
+                fs::path parentPath = outPathFs.parent_path();
+                if (!parentPath.empty() && !fs::exists(parentPath)) {
+                    try {
+                        fs::create_directories(parentPath);
+                    } catch (const std::exception& e) {
+                        std::cerr << "[Multi Error] Creating directory "
+                                  << parentPath.string() << " failed: "
+                                  << e.what() << ". Skipping URL: " << url << std::endl;
+                        overallSuccess = false;
+                        activity.advance();
+                        completedCount++;
+                        continue;
+                    }
+                }
+
+                CURL* easyHandle = curl_easy_init();
+                if (!easyHandle) {
+                    std::cerr << "[Multi Error] curl_easy_init failed for URL: "
+                              << url << ". Skipping." << std::endl;
+                    overallSuccess = false;
+                    activity.advance();
+                    completedCount++;
+                    continue;
+                }
+
+                // Emplace a blank job first
+                auto [it, success_emplace] =
+                     jobs.emplace(easyHandle, DownloadJob{});
+                if (!success_emplace) {
+                    std::cerr << "[Multi Internal Error] Failed to emplace job for handle. "
+                              << "Skipping URL: " << url << std::endl;
+                    curl_easy_cleanup(easyHandle);
+                    overallSuccess = false;
+                    activity.advance();
+                    completedCount++;
+                    continue;
+                }
+
+                // Reference the job stored in the map
+                DownloadJob& job_in_map  = it->second;
+                job_in_map.url           = url;
+                job_in_map.outputPath    = path;
+                job_in_map.easyHandle    = easyHandle;
+                job_in_map.window        = &window;
+                job_in_map.progress      = std::make_unique<Progress::Task>(activity);
+                job_in_map.fileStream.open(path + ".part", std::ios::binary | std::ios::trunc);
+
+                if (!job_in_map.fileStream) {
+                    std::cerr << "[Multi Error] Failed to open file for writing: '"
+                              << path << ".part'. Skipping URL: " << url << std::endl;
+                    curl_easy_cleanup(easyHandle);
+                    jobs.erase(it);
+                    overallSuccess = false;
+                    completedCount++;
+                    continue;
+                }
+
+                // Set cURL options
+                curl_easy_setopt(easyHandle, CURLOPT_URL, url.c_str());
+                curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+                curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &job_in_map.fileStream);
+                curl_easy_setopt(easyHandle, CURLOPT_FOLLOWLOCATION, 1L);
+                curl_easy_setopt(easyHandle, CURLOPT_FAILONERROR, 1L);
+                curl_easy_setopt(easyHandle, CURLOPT_PRIVATE, easyHandle);
+                curl_easy_setopt(easyHandle, CURLOPT_NOPROGRESS, 0L);
+                curl_easy_setopt(easyHandle, CURLOPT_XFERINFOFUNCTION, MultiXferInfoCallback);
+                curl_easy_setopt(easyHandle, CURLOPT_XFERINFODATA, &job_in_map);
+                curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT, 15L);
+                curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT, 300L);
+                curl_easy_setopt(easyHandle, CURLOPT_USERAGENT, "Starpack/1.0");
+                if (g_rateLimit > 0) {
+                    // Split the cap between the transfers the windows allow
+                    int slots = 0;
+                    for (const auto& entry : windows) {
+                        slots += entry.second.limit;
+                    }
+                    curl_off_t perTransfer = std::max<curl_off_t>(
+                        1024, g_rateLimit.load() / std::max(1, slots));
+                    curl_easy_setopt(easyHandle, CURLOPT_MAX_RECV_SPEED_LARGE, perTransfer);
+                    curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT, 0L);
+                }
+
+                // Add handle to the multi stack
+                CURLMcode mc = curl_multi_add_handle(multiHandle, easyHandle);
+                if (mc != CURLM_OK) {
+                    std::cerr << "[Multi Error] curl_multi_add_handle failed (" << mc
+                              << "): " << curl_multi_strerror(mc)
+                              << " for URL: " << url << ". Skipping." << std::endl;
+
+                    if (job_in_map.fileStream.is_open()) {
+                        job_in_map.fileStream.close();
+                    }
+                    fs::remove(path + ".part");
+                    curl_easy_cleanup(easyHandle);
+                    jobs.erase(it);
+                    overallSuccess = false;
+                    completedCount++;
+                    continue;
+                }
+
+                // We have one more transfer in progress
+                currentDownloads++;
+                window.inFlight++;
+            }
+
+            // Perform the transfers
+            CURLMcode mc_perf = curl_multi_perform(multiHandle, &stillRunning);
+            if (mc_perf != CURLM_OK && mc_perf != CURLM_CALL_MULTI_PERFORM) {
+                std::cerr << "[Multi Error] curl_multi_perform failed (" << mc_perf
+                          << "): " << curl_multi_strerror(mc_perf) << std::endl;
+            }
+
+            // Check for completed transfers
+            int msgsInQueue = 0;
+            CURLMsg* msg;
+
+            while ((msg = curl_multi_info_read(multiHandle, &msgsInQueue))) {
+                if (msg->msg == CURLMSG_DONE) {
+                    CURL* easyHandle = msg->easy_handle;
+                    CURLcode result  = msg->data.result;
+                    long response_code = 0;
+                    double total_time  = 0;
+
+                    auto it = jobs.find(easyHandle);
+                    if (it != jobs.end()) {
+                        DownloadJob& completedJob = it->second;
+                        if (completedJob.window) {
+                            completedJob.window->inFlight--;
+                            // Connection-level failures are a congestion signal
+                            if (result != CURLE_OK && result != CURLE_HTTP_RETURNED_ERROR) {
+                                completedJob.window->congested = true;
+                            }
+                        }
+
+                        if (completedJob.fileStream.is_open()) {
+                            completedJob.fileStream.close();
+                        }
+
+                        curl_easy_getinfo(easyHandle, CURLINFO_RESPONSE_CODE, &response_code);
+                        curl_easy_getinfo(easyHandle, CURLINFO_TOTAL_TIME, &total_time);
+
+                        curl_off_t bytes = 0;
+                        curl_easy_getinfo(easyHandle, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+                        Metrics::addDownload(static_cast<uint64_t>(bytes));
+
+                        // libcurl timed the transfer; the span ends now
+                        if (Trace::enabled()) {
+                            uint64_t end = Trace::now();
+                            uint64_t elapsed = static_cast<uint64_t>(total_time * 1e6);
+                            Trace::complete("download",
+                                            "fetch: " + fs::path(completedJob.url).filename().string(),
+                                            end > elapsed ? end - elapsed : 0, end,
+                                            { { "url",    Trace::quote(completedJob.url) },
+                                              { "bytes",  std::to_string(bytes) },
+                                              { "status", std::to_string(response_code) },
+                                              { "host",   Trace::quote(hostOf(completedJob.url)) } });
+                        }
+
+                        std::error_code ec;
+                        if (result == CURLE_OK && response_code < 400) {
+                            fs::rename(completedJob.outputPath + ".part",
+                                       completedJob.outputPath, ec);
+                            completedJob.success = !ec;
+                            if (!ec) {
+                                LowImpact::dropFromCache(completedJob.outputPath, true);
+                                Metrics::addCacheLookup(false);
+                            } else {
+                                Metrics::addFailure("download");
+                                std::cerr << "[Multi Error] Cannot move "
+                                          << completedJob.outputPath << ".part into place: "
+                                          << ec.message() << std::endl;
+                                overallSuccess = false;
+                                fs::remove(completedJob.outputPath + ".part", ec);
+                            }
+                        } else {
+                            std::cerr << "[Multi Error] Failed download:\n"
+                                      << "  URL : " << completedJob.url << "\n"
+                                      << "  Path: " << completedJob.outputPath << std::endl;
+
+                            if (result != CURLE_OK) {
+                                std::cerr << "  Curl Error: "
+                                          << curl_easy_strerror(result)
+                                          << " (Code: " << result << ")\n";
+                            }
+
+                            if (response_code >= 400) {
+                                std::cerr << "  HTTP Status: " << response_code << "\n";
+                            }
+                            std::cerr << "  Time: "
+                                      << std::fixed << std::setprecision(2)
+                                      << total_time << "s\n";
+
+                            overallSuccess = false;
+                            Metrics::addFailure("download");
+                            fs::remove(completedJob.outputPath + ".part", ec);
+                        }
+
+                        curl_multi_remove_handle(multiHandle, easyHandle);
+                        curl_easy_cleanup(easyHandle);
+                        jobs.erase(it);
+                        currentDownloads--;
+                        completedCount++;
+                    } else {
+                        // We didn't find the handle in our map
+                        std::cerr << "[Multi Internal Error] Completed handle not found in map!"
+                                  << std::endl;
+                        curl_multi_remove_handle(multiHandle, easyHandle);
+                        curl_easy_cleanup(easyHandle);
+                        currentDownloads--;
+                        completedCount++;
+                    }
+                }
+            }
+
+            // Re-evaluate the window of each host once per interval
+            auto now = steady_clock::now();
+            for (auto& [host, window] : windows) {
+                if (now - window.lastAdjust < kAdjustInterval) {
+                    continue;
+                }
+                bool stalled = false;
+                for (const auto& entry : jobs) {
+                    if (entry.second.window == &window &&
+                        now - entry.second.lastProgress > kStallTime) {
+                        stalled = true;
+                        break;
+                    }
+                }
+                bool backlog = std::any_of(pending.begin(), pending.end(), [&](size_t i) {
+                    return hostOf(filesToDownload[i].first) == host;
+                });
+                adjustWindow(window, stalled, backlog, now);
+                if (stalled) {
+                    // Give the slow transfers a fresh grace period before the next cut
+                    for (auto& entry : jobs) {
+                        if (entry.second.window == &window) {
+                            entry.second.lastProgress = now;
+                        }
+                    }
+                }
+            }
+
+            // If still running, or there's more to queue, wait for activity
+            if (stillRunning > 0) {
+                struct timeval timeout;
+                fd_set fdread, fdwrite, fdexcep;
+                int maxfd = -1;
+
+                FD_ZERO(&fdread);
+                FD_ZERO(&fdwrite);
+                FD_ZERO(&fdexcep);
+
+                timeout.tv_sec  = 0;
+                timeout.tv_usec = 100 * 1000; // 100ms
+
+                CURLMcode mc_fdset = curl_multi_fdset(multiHandle,
+                                                      &fdread, &fdwrite, &fdexcep,
+                                                      &maxfd);
+
+                if (mc_fdset != CURLM_OK) {
+                    std::cerr << "[Multi Error] curl_multi_fdset: "
+                              << curl_multi_strerror(mc_fdset) << std::endl;
+                }
+
+                if (maxfd == -1) {
+                    std::this_thread::sleep_for(milliseconds(100));
+                } else {
+                    int rc = select(maxfd + 1,
+                                    &fdread, &fdwrite, &fdexcep, &timeout);
+                    if (rc == -1) {
+                        std::perror("[Multi Error] select failed");
+                        overallSuccess = false;
+                    }
+                }
+            } else if (!pending.empty()) {
+                // If there's more to do but none are running, short sleep
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+
+        } while (stillRunning > 0 || completedCount < totalJobsAttempted || !pending.empty());
+
+        // Final cleanup check
+        int msgsInQueue = 0;
+        CURLMsg* msg;
+        while ((msg = curl_multi_info_read(multiHandle, &msgsInQueue))) {
+            if (msg->msg == CURLMSG_DONE) {
+                CURL* easyHandle = msg->easy_handle;
+                auto it = jobs.find(easyHandle);
+
+                if (it != jobs.end()) {
+                    DownloadJob& completedJob = it->second;
+                    if (completedJob.fileStream.is_open()) {
+                        completedJob.fileStream.close();
+                    }
+                    if (!completedJob.success) {
+                        overallSuccess = false;
+                        std::error_code ec;
+                        fs::remove(completedJob.outputPath + ".part", ec);
+                    }
+                    curl_multi_remove_handle(multiHandle, easyHandle);
+                    curl_easy_cleanup(easyHandle);
+                    jobs.erase(it);
+                } else {
+                    curl_multi_remove_handle(multiHandle, easyHandle);
+                    curl_easy_cleanup(easyHandle);
+                }
+            }
+        }
+
+        curl_multi_cleanup(multiHandle);
+        std::cout << "[Multi] Download processing finished." << std::endl;
+        return overallSuccess;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * downloadWithMirrors
+     *
+     * The mirrors are only contacted for files the primary URLs did not
+     * deliver, one file and one mirror at a time.
+     * ------------------------------------------------------------------------
+     */
+    bool downloadWithMirrors(const std::vector<std::pair<std::string, std::string>>& filesToDownload) {
+        if (downloadMultipleFilesMulti(filesToDownload)) {
+            return true;
+        }
+        const Config& config = Config::current();
+        bool complete = true;
+        for (const auto& [url, path] : filesToDownload) {
+            if (fs::exists(path)) {
+                continue;
+            }
+            bool fetched = false;
+            for (const auto& mirrorUrl : config.mirrorUrlsFor(url)) {
+                std::cerr << "Retrying from mirror: " << mirrorUrl << std::endl;
+                if (downloadSingleFileSync(mirrorUrl, path)) {
+                    fetched = true;
+                    break;
+                }
+            }
+            complete = complete && fetched;
+        }
+        return complete;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * setDownloadRateLimit / downloadRateLimit
+     * ------------------------------------------------------------------------
+     */
+    void setDownloadRateLimit(long long bytesPerSecond) {
+        g_rateLimit = std::max(0LL, bytesPerSecond);
+    }
+
+    long long downloadRateLimit() {
+        return g_rateLimit;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * setDownloadConcurrency
+     * ------------------------------------------------------------------------
+     */
+    void setDownloadConcurrency(int minTransfers, int maxTransfers) {
+        minTransfers = std::max(1, minTransfers);
+        g_minConcurrency = minTransfers;
+        g_maxConcurrency = std::max(minTransfers, maxTransfers);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * parseRate
+     *
+     * Accepts plain byte counts and K/M/G suffixes (powers of 1024).
+     * ------------------------------------------------------------------------
+     */
+    bool parseRate(const std::string& text, long long& bytesPerSecond) {
+        if (text.empty()) {
+            return false;
+        }
+        size_t consumed = 0;
+        double value = 0;
+        try {
+            value = std::stod(text, &consumed);
+        } catch (...) {
+            return false;
+        }
+        std::string suffix = text.substr(consumed);
+        if (!suffix.empty() && (suffix.back() == 'B' || suffix.back() == 'b')) {
+            suffix.pop_back();
+        }
+        double scale = 1;
+        if (suffix == "K" || suffix == "k") {
+            scale = 1024.0;
+        } else if (suffix == "M" || suffix == "m") {
+            scale = 1024.0 * 1024;
+        } else if (suffix == "G" || suffix == "g") {
+            scale = 1024.0 * 1024 * 1024;
+        } else if (!suffix.empty()) {
+            return false;
+        }
+        if (value < 0) {
+            return false;
+        }
+        bytesPerSecond = static_cast<long long>(value * scale);
+        return true;
+    }
+
+} // namespace Starpack
@@ -0,0 +1,88 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "events.hpp"          // Class definition
+
+#include <atomic>              // Current handler
+#include <mutex>               // Serializing handler calls
+
+namespace Starpack {
+
+    namespace {
+
+        std::atomic<EventHandler*> g_handler{nullptr};
+        std::mutex                 g_handlerMutex;
+
+        void dispatch(const Event& event) {
+            EventHandler* handler = g_handler.load();
+            if (!handler) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(g_handlerMutex);
+            handler->onEvent(event);
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Events::setHandler / active
+     * ------------------------------------------------------------------------
+     */
+    void Events::setHandler(EventHandler* handler) {
+        std::lock_guard<std::mutex> lock(g_handlerMutex);
+        g_handler = handler;
+    }
+
+    bool Events::active() {
+        return g_handler.load() != nullptr;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Events::phase / progress / error
+     * ------------------------------------------------------------------------
+     */
+    void Events::phase(const std::string& phase, const std::string& subject) {
+        Event event;
+        event.type    = Event::Type::Phase;
+        event.phase   = phase;
+        event.subject = subject;
+        dispatch(event);
+    }
+
+    void Events::progress(const std::string& phase, const std::string& subject,
+                          uint64_t done, uint64_t total) {
+        Event event;
+        event.type    = Event::Type::Progress;
+        event.phase   = phase;
+        event.subject = subject;
+        event.done    = done;
+        event.total   = total;
+        dispatch(event);
+    }
+
+    void Events::error(const std::string& phase, const std::string& message) {
+        Event event;
+        event.type    = Event::Type::Error;
+        event.phase   = phase;
+        event.subject = message;
+        dispatch(event);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Events::confirm
+     * ------------------------------------------------------------------------
+     */
+    bool Events::confirm(const std::string& action, const std::vector<std::string>& packages) {
+        EventHandler* handler = g_handler.load();
+        if (!handler) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(g_handlerMutex);
+        return handler->confirm(action, packages);
+    }
+
+} // namespace Starpack
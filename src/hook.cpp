@@ -8,6 +8,9 @@
 
 #include "hook.hpp"
 #include "chroot_util.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
 
 #include <fstream> // For reading hook files
 #include <sstream> // Potentially useful for string manipulation
@@ -26,6 +29,7 @@
 #include <unordered_set> // For efficient duplicate checking (e.g., filenames)
 #include <future>        // Available for async operations
 #include <cctype>        // For ::tolower
+#include <chrono>        // Hook run durations for the metrics
 
 namespace fs = std::filesystem;
 
@@ -45,6 +49,28 @@ void Hook::trim(std::string &s)
 
 namespace
 {
+    /**
+     * ----------------------------------------------------------------------
+     * HookRunRecorder
+     *
+     * Reports one hook run to the transaction metrics on every way out of
+     * the run, including the early returns on failure.
+     * ----------------------------------------------------------------------
+     */
+    struct HookRunRecorder
+    {
+        std::string name;
+        bool ok = false;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        ~HookRunRecorder()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            Starpack::Metrics::addHook(name,
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), ok);
+        }
+    };
+
     /**
      * ----------------------------------------------------------------------
      * NewHookInfo
@@ -595,6 +621,8 @@ size_t Hook::runNewStyleHooks(const std::string &phase,
     for (const auto &hook : matchingHooks)
     {
         executed_count++;
+        Starpack::Trace::Span hookSpan("hook", "hook", fs::path(hook.sourceFilePath).filename().string());
+        hookSpan.arg("phase", phase);
         std::cout << "  -> Executing hook (" << executed_count
                   << "/" << matchingHooks.size() << "): "
                   << fs::path(hook.sourceFilePath).filename().string();
@@ -614,6 +642,7 @@ size_t Hook::runNewStyleHooks(const std::string &phase,
                       << ". Skipping." << std::endl;
             continue;
         }
+        HookRunRecorder hookRun{ fs::path(hook.sourceFilePath).filename().string() };
 
         // If it needs paths, we haven't implemented passing them in
         if (hook.exec.needsPaths)
@@ -670,6 +699,8 @@ size_t Hook::runNewStyleHooks(const std::string &phase,
             std::cout << "     Running command (direct on host): "
                       << hook.exec.command << std::endl;
 
+            // The hook writes to the same terminal; show our lines first
+            Starpack::Log::flush();
             int result = std::system(hook.exec.command.c_str());
 
             if (result == -1)
@@ -717,6 +748,7 @@ size_t Hook::runNewStyleHooks(const std::string &phase,
                 return 0;
             }
         }
+        hookRun.ok = true;
     }
 
     // If we got here, all matching hooks executed successfully
@@ -0,0 +1,523 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "image.hpp"           // Class definition
+#include "install.hpp"         // Repository loading, resolution, fetch, DB entries
+#include "log.hpp"             // Log::flush before moving stdout
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <filesystem>          // Path handling
+#include <unordered_set>       // Directories already written to the image
+#include <unordered_map>       // Hardlink target remapping
+#include <cstdlib>             // std::getenv
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <ctime>               // std::time
+#include <unistd.h>            // geteuid, dup, dup2, isatty
+#include <archive.h>           // Libarchive read/write
+#include <archive_entry.h>     // Libarchive entry handling
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        /**
+         * -------------------------------------------------------------------
+         * ImageStream
+         *
+         * Output archive plus the set of directories already emitted, so
+         * directories shared by several packages appear only once.
+         * -------------------------------------------------------------------
+         */
+        struct ImageStream {
+            struct archive* out = nullptr;
+            std::unordered_set<std::string> dirs;
+            std::time_t now = 0;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * StdoutRedirect
+         *
+         * While an image is streamed to standard output, fd 1 points at
+         * standard error, so that status lines (of the logger, downloads
+         * and every other component) cannot end up inside the archive. The
+         * archive is written to a duplicate of the original stdout, which
+         * is restored on destruction.
+         * -------------------------------------------------------------------
+         */
+        struct StdoutRedirect {
+            int archiveFd = -1;
+
+            bool begin() {
+                Log::flush();
+                archiveFd = dup(STDOUT_FILENO);
+                if (archiveFd < 0) {
+                    return false;
+                }
+                if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+                    close(archiveFd);
+                    archiveFd = -1;
+                    return false;
+                }
+                return true;
+            }
+
+            ~StdoutRedirect() {
+                if (archiveFd >= 0) {
+                    Log::flush();
+                    dup2(archiveFd, STDOUT_FILENO);
+                    close(archiveFd);
+                }
+            }
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * hasSuffix
+         * -------------------------------------------------------------------
+         */
+        bool hasSuffix(const std::string& s, const std::string& suffix) {
+            return s.size() >= suffix.size() &&
+                   s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * addCompressionFilter
+         *
+         * Chooses the output compression from the file extension.
+         * -------------------------------------------------------------------
+         */
+        bool addCompressionFilter(struct archive* out, const std::string& outputPath) {
+            int r = ARCHIVE_OK;
+            if (hasSuffix(outputPath, ".zst") || hasSuffix(outputPath, ".tzst")) {
+                r = archive_write_add_filter_zstd(out);
+            } else if (hasSuffix(outputPath, ".gz") || hasSuffix(outputPath, ".tgz")) {
+                r = archive_write_add_filter_gzip(out);
+            } else if (hasSuffix(outputPath, ".xz") || hasSuffix(outputPath, ".txz")) {
+                r = archive_write_add_filter_xz(out);
+            } else if (hasSuffix(outputPath, ".bz2")) {
+                r = archive_write_add_filter_bzip2(out);
+            } else if (hasSuffix(outputPath, ".lz4")) {
+                r = archive_write_add_filter_lz4(out);
+            }
+            if (r < ARCHIVE_WARN) {
+                std::cerr << "Error: Unsupported compression for " << outputPath
+                          << ": " << archive_error_string(out) << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * mapSectionPath
+         *
+         * Turns an archive entry name inside `sectionPrefix` into a path
+         * relative to the image root, dropping stripComponents leading
+         * components. Returns an empty string for entries outside the
+         * section or that strip to nothing.
+         * -------------------------------------------------------------------
+         */
+        std::string mapSectionPath(std::string entryName,
+                                   const std::string& sectionPrefix,
+                                   int stripComponents) {
+            if (entryName.rfind("./", 0) == 0) {
+                entryName.erase(0, 2);
+            }
+            if (entryName.rfind(sectionPrefix, 0) != 0) {
+                return "";
+            }
+
+            fs::path finalRelativePath;
+            int currStrip = 0;
+            for (const auto& part : fs::path(entryName.substr(sectionPrefix.size()))) {
+                if (part.empty() || part == ".") {
+                    continue;
+                }
+                if (part == "..") {
+                    return ""; // Never let a package escape the image root
+                }
+                if (currStrip < stripComponents) {
+                    currStrip++;
+                    continue;
+                }
+                finalRelativePath /= part;
+            }
+            return finalRelativePath.string();
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * writeDirectory
+         *
+         * Emits a root-owned 0755 directory entry (and its parents) unless
+         * the directory is already part of the image.
+         * -------------------------------------------------------------------
+         */
+        bool writeDirectory(ImageStream& img, const fs::path& dir) {
+            if (dir.empty() || img.dirs.count(dir.string())) {
+                return true;
+            }
+            if (!writeDirectory(img, dir.parent_path())) {
+                return false;
+            }
+
+            struct archive_entry* entry = archive_entry_new();
+            archive_entry_set_pathname(entry, dir.string().c_str());
+            archive_entry_set_filetype(entry, AE_IFDIR);
+            archive_entry_set_perm(entry, 0755);
+            archive_entry_set_uid(entry, 0);
+            archive_entry_set_gid(entry, 0);
+            archive_entry_set_uname(entry, "root");
+            archive_entry_set_gname(entry, "root");
+            archive_entry_set_mtime(entry, img.now, 0);
+            int r = archive_write_header(img.out, entry);
+            archive_entry_free(entry);
+
+            if (r < ARCHIVE_WARN) {
+                std::cerr << "Error: Failed writing directory " << dir.string()
+                          << ": " << archive_error_string(img.out) << std::endl;
+                return false;
+            }
+            img.dirs.insert(dir.string());
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * writeRegularFile
+         *
+         * Emits a root-owned regular file with the given contents.
+         * -------------------------------------------------------------------
+         */
+        bool writeRegularFile(ImageStream& img, const fs::path& path,
+                              const std::string& content, int perm) {
+            if (!writeDirectory(img, path.parent_path())) {
+                return false;
+            }
+
+            struct archive_entry* entry = archive_entry_new();
+            archive_entry_set_pathname(entry, path.string().c_str());
+            archive_entry_set_filetype(entry, AE_IFREG);
+            archive_entry_set_perm(entry, perm);
+            archive_entry_set_uid(entry, 0);
+            archive_entry_set_gid(entry, 0);
+            archive_entry_set_uname(entry, "root");
+            archive_entry_set_gname(entry, "root");
+            archive_entry_set_mtime(entry, img.now, 0);
+            archive_entry_set_size(entry, static_cast<la_int64_t>(content.size()));
+
+            bool ok = archive_write_header(img.out, entry) >= ARCHIVE_WARN &&
+                      archive_write_data(img.out, content.data(), content.size()) ==
+                          static_cast<la_ssize_t>(content.size());
+            archive_entry_free(entry);
+
+            if (!ok) {
+                std::cerr << "Error: Failed writing " << path.string()
+                          << ": " << archive_error_string(img.out) << std::endl;
+            }
+            return ok;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * streamPackage
+         *
+         * Copies the files/ section of a package archive into the image and
+         * places top-level .hook files from hooks/ under
+         * etc/starpack/hooks/<package>/. Entry headers (owner, mode, mtime,
+         * links, xattrs) are passed through unchanged; only paths are
+         * rewritten.
+         * -------------------------------------------------------------------
+         */
+        bool streamPackage(ImageStream& img,
+                           const std::string& packageName,
+                           const std::string& archivePath,
+                           int stripComponents) {
+
+            struct archive* in = archive_read_new();
+            if (!in) {
+                std::cerr << "Error: archive_read_new() failed." << std::endl;
+                return false;
+            }
+            archive_read_support_filter_all(in);
+            archive_read_support_format_all(in);
+
+            if (archive_read_open_filename(in, archivePath.c_str(), 65536) != ARCHIVE_OK) {
+                std::cerr << "Error: Could not open archive " << archivePath
+                          << ": " << archive_error_string(in) << std::endl;
+                archive_read_free(in);
+                return false;
+            }
+
+            fs::path hooksDir = fs::path("etc") / "starpack" / "hooks" / packageName;
+            std::vector<char> buffer(65536);
+            bool ok = true;
+            struct archive_entry* entry;
+            int r;
+
+            while (ok && (r = archive_read_next_header(in, &entry)) == ARCHIVE_OK) {
+                std::string entryName = archive_entry_pathname(entry);
+                fs::path outPath;
+
+                std::string rel = mapSectionPath(entryName, "files/", stripComponents);
+                if (!rel.empty()) {
+                    outPath = rel;
+                } else {
+                    rel = mapSectionPath(entryName, "hooks/", stripComponents);
+                    fs::path hookRel(rel);
+                    if (rel.empty() ||
+                        archive_entry_filetype(entry) != AE_IFREG ||
+                        hookRel.has_parent_path() ||
+                        hookRel.extension() != ".hook") {
+                        archive_read_data_skip(in);
+                        continue;
+                    }
+                    outPath = hooksDir / hookRel;
+                }
+
+                if (archive_entry_filetype(entry) == AE_IFDIR) {
+                    if (img.dirs.count(outPath.string())) {
+                        archive_read_data_skip(in);
+                        continue;
+                    }
+                    ok = writeDirectory(img, outPath.parent_path());
+                    img.dirs.insert(outPath.string());
+                } else {
+                    ok = writeDirectory(img, outPath.parent_path());
+                }
+                if (!ok) {
+                    break;
+                }
+
+                archive_entry_set_pathname(entry, outPath.string().c_str());
+                if (const char* link = archive_entry_hardlink(entry)) {
+                    std::string target = mapSectionPath(link, "files/", stripComponents);
+                    if (target.empty()) {
+                        std::cerr << "Warning: Skipping hardlink " << entryName
+                                  << " with target outside files/ in " << packageName
+                                  << std::endl;
+                        archive_read_data_skip(in);
+                        continue;
+                    }
+                    archive_entry_set_hardlink(entry, target.c_str());
+                }
+
+                if (archive_write_header(img.out, entry) < ARCHIVE_WARN) {
+                    std::cerr << "Error: Failed writing header for " << outPath.string()
+                              << ": " << archive_error_string(img.out) << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                la_ssize_t n;
+                while ((n = archive_read_data(in, buffer.data(), buffer.size())) > 0) {
+                    if (archive_write_data(img.out, buffer.data(), static_cast<size_t>(n)) != n) {
+                        std::cerr << "Error: Failed writing data for " << outPath.string()
+                                  << ": " << archive_error_string(img.out) << std::endl;
+                        ok = false;
+                        break;
+                    }
+                }
+                if (n < 0) {
+                    std::cerr << "Error: Failed reading " << entryName << " from "
+                              << archivePath << ": " << archive_error_string(in) << std::endl;
+                    ok = false;
+                }
+            }
+
+            if (ok && r != ARCHIVE_EOF) {
+                std::cerr << "Error reading archive headers of " << archivePath
+                          << ": " << archive_error_string(in) << std::endl;
+                ok = false;
+            }
+
+            archive_read_close(in);
+            archive_read_free(in);
+            return ok;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Image::imageCacheDir
+     * ------------------------------------------------------------------------
+     */
+    std::string Image::imageCacheDir() {
+        if (geteuid() == 0) {
+            return "/var/lib/starpack/cache";
+        }
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            return std::string(xdg) + "/starpack";
+        }
+        if (const char* home = std::getenv("HOME"); home && *home) {
+            return std::string(home) + "/.cache/starpack";
+        }
+        return "/tmp/starpack-cache-" + std::to_string(geteuid());
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Image::exportImage
+     *
+     * Resolves the closure like `install` does, then streams every package
+     * into one archive. The archive is written to "<output>.part" and renamed
+     * into place once complete; "-" streams it to stdout and sends every
+     * status line to stderr instead.
+     * ------------------------------------------------------------------------
+     */
+    bool Image::exportImage(const std::vector<std::string>& packageNames,
+                            const std::string& outputPath,
+                            const std::string& keyringRoot) {
+
+        bool toStdout = outputPath == "-";
+        StdoutRedirect redirect;
+        if (toStdout) {
+            if (isatty(STDOUT_FILENO)) {
+                std::cerr << "Error: Refusing to write an image archive to a terminal." << std::endl;
+                return false;
+            }
+            if (!redirect.begin()) {
+                std::cerr << "Error: Could not redirect standard output: "
+                          << std::strerror(errno) << std::endl;
+                return false;
+            }
+        }
+
+        std::cout << "--- Starpack Image Export ---" << std::endl;
+        std::cout << "Output: " << outputPath << std::endl;
+
+        std::string cacheDir = imageCacheDir();
+
+        // Steps 1-3: repositories
+        PackageSourceCache packageSourceCache;
+        if (!Installer::loadRepositoryIndex(cacheDir, packageSourceCache)) {
+            return false;
+        }
+
+        // Step 4: resolve the full closure; nothing is pre-installed in an image
+        std::cout << "[4/8] Resolving dependencies..." << std::endl;
+        std::vector<std::string> order;
+        if (!Installer::resolveDependencies(packageNames, packageSourceCache,
+                                            [](const std::string&) { return false; },
+                                            order)) {
+            return false;
+        }
+
+        std::vector<ResolvedPackage> packages;
+        for (const auto& name : order) {
+            const auto& source = packageSourceCache.at(name);
+            if (!source.second["file_name"] || !source.second["file_name"].IsScalar()) {
+                std::cerr << "Error: Missing 'file_name' in metadata for package '"
+                          << name << "'. Aborting." << std::endl;
+                return false;
+            }
+            ResolvedPackage pkg;
+            pkg.name        = name;
+            pkg.repoUrl     = source.first;
+            pkg.metadata    = source.second;
+            pkg.archivePath = (fs::path(cacheDir) /
+                               source.second["file_name"].as<std::string>()).string();
+            packages.push_back(pkg);
+        }
+
+        // Steps 5-6: download and verify
+        if (!Installer::fetchPackages(packages, keyringRoot)) {
+            return false;
+        }
+
+        // Step 7: stream everything into the output archive
+        std::cout << "[7/8] Writing " << packages.size() << " package(s) to image..."
+                  << std::endl;
+        std::string partPath = toStdout ? "standard output" : outputPath + ".part";
+
+        ImageStream img;
+        img.now = std::time(nullptr);
+        img.out = archive_write_new();
+        if (!img.out) {
+            std::cerr << "Error: archive_write_new() failed." << std::endl;
+            return false;
+        }
+        archive_write_set_format_pax_restricted(img.out);
+        // Standard output gets an uncompressed tar ("-" has no extension)
+        if (!addCompressionFilter(img.out, outputPath) ||
+            (toStdout ? archive_write_open_fd(img.out, redirect.archiveFd)
+                      : archive_write_open_filename(img.out, partPath.c_str())) != ARCHIVE_OK) {
+            std::cerr << "Error: Could not open " << partPath << ": "
+                      << archive_error_string(img.out) << std::endl;
+            archive_write_free(img.out);
+            return false;
+        }
+
+        bool ok = true;
+        std::string database;
+        for (size_t i = 0; ok && i < packages.size(); ++i) {
+            const auto& pkg = packages[i];
+            std::cout << " -> (" << (i + 1) << "/" << packages.size() << ") "
+                      << pkg.name << std::endl;
+
+            int stripComponents = 0;
+            if (pkg.metadata["strip_components"] && pkg.metadata["strip_components"].IsScalar()) {
+                try {
+                    stripComponents = std::max(0, pkg.metadata["strip_components"].as<int>());
+                } catch (...) {
+                }
+            }
+
+            ok = streamPackage(img, pkg.name, pkg.archivePath, stripComponents);
+            try {
+                database += Installer::formatDatabaseEntry(pkg.name, pkg.metadata);
+            } catch (const YAML::Exception& e) {
+                std::cerr << "YAML Error processing package node for "
+                          << pkg.name << ": " << e.what() << std::endl;
+                ok = false;
+            }
+        }
+
+        // The generated DB makes the image manageable by starpack afterwards
+        if (ok) {
+            ok = writeRegularFile(img, fs::path("var") / "lib" / "starpack" / "installed.db",
+                                  database, 0644);
+        }
+
+        if (archive_write_close(img.out) != ARCHIVE_OK) {
+            std::cerr << "Error: Failed finishing " << partPath << ": "
+                      << archive_error_string(img.out) << std::endl;
+            ok = false;
+        }
+        archive_write_free(img.out);
+
+        std::error_code ec;
+        if (!ok) {
+            if (!toStdout) {
+                fs::remove(partPath, ec);
+            }
+            std::cerr << "--- Image export failed ---" << std::endl;
+            return false;
+        }
+        if (toStdout) {
+            std::cout << "[8/8] Image written to standard output"
+                      << " (install hooks were not run)" << std::endl;
+            return true;
+        }
+        fs::rename(partPath, outputPath, ec);
+        if (ec) {
+            std::cerr << "Error: Could not move " << partPath << " to " << outputPath
+                      << ": " << ec.message() << std::endl;
+            fs::remove(partPath, ec);
+            return false;
+        }
+
+        std::cout << "[8/8] Image written: " << outputPath
+                  << " (install hooks were not run)" << std::endl;
+        return true;
+    }
+
+} // namespace Starpack
@@ -1,4 +1,5 @@
 #include "info.hpp"
+#include "config.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -65,19 +66,19 @@ std::map<std::string, std::string> PackageInfo::getFiles() const
 // ============================================================================
 // Display package information
 // ============================================================================
-void PackageInfo::display() const
+void PackageInfo::display(std::ostream& out) const
 {
-    std::cout << "Package Name: " << name << "\n";
-    std::cout << "Version: " << version << "\n";
-    std::cout << "Description: " << description << "\n";
+    out << "Package Name: " << name << "\n";
+    out << "Version: " << version << "\n";
+    out << "Description: " << description << "\n";
 
-    std::cout << "Dependencies: ";
+    out << "Dependencies: ";
     for (const auto& dep : dependencies) {
-        std::cout << dep << " ";
+        out << dep << " ";
     }
-    std::cout << "\nFiles:\n";
+    out << "\nFiles:\n";
     for (const auto& [path, details] : files) {
-        std::cout << "  " << path << " (" << details << ")\n";
+        out << "  " << path << " (" << details << ")\n";
     }
 }
 
@@ -99,7 +100,7 @@ bool fetchPackageInfoFromLocal(const std::string& packageName,
     std::string line;
 
     while (std::getline(dbFile, line)) {
-        if (line.find(packageName) == 0) {
+        if (line == packageName + " /") {
             // Parse the package information
             std::string name     = line;
             std::string version;
@@ -141,19 +142,9 @@ bool fetchPackageInfoFromRepos(const std::string& packageName,
         return false;
     }
 
-    std::ifstream confFile(reposConfPath);
-    std::string repoUrl;
-
-    // Iterate through repos.conf file, line by line
-    while (std::getline(confFile, repoUrl)) {
-        if (repoUrl.empty() || repoUrl[0] == '#') {
-            continue;
-        }
-
-        // Ensure repoUrl ends with a slash
-        if (repoUrl.back() != '/') {
-            repoUrl += '/';
-        }
+    // Iterate through the repositories, highest priority first
+    for (const auto& repository : Starpack::Config::forReposFile(reposConfPath).byPriority()) {
+        const std::string& repoUrl = repository.url;
 
         // Construct the .yaml URL for this repo
         std::string repoDbUrl     = repoUrl + "repo.db.yaml";
@@ -6,6 +6,17 @@
 #include "chroot_util.hpp"     // For chroot operations, hooks use it)
 #include "hook.hpp"            // For calling Pre/Post install hooks
 #include "utils.hpp"           // utility functions like logging might are here
+#include "download.hpp"        // Package and repository DB downloads
+#include "object_store.hpp"    // Content-addressed file deduplication
+#include "low_impact.hpp"      // Write pacing and page-cache hygiene
+#include "events.hpp"          // Confirmation by library consumers
+#include "completion.hpp"      // Package name list for shell completion
+#include "trace.hpp"           // --trace phase spans
+#include "metrics.hpp"         // Transaction metrics
+#include "progress.hpp"        // Installation progress view
+#include "config.hpp"          // Repositories, Jobs, Durability, NoExtract
+#include "cache.hpp"           // Cache limits, stale cached archives
+#include "version.hpp"         // Dependency version constraints
 
 #include <iostream>            // Standard I/O (cout, cerr)
 #include <fstream>             // File streams (ifstream, ofstream)
@@ -13,7 +24,6 @@
 #include <filesystem>          // Modern C++ filesystem operations
 #include <yaml-cpp/yaml.h>     // YAML parsing library
 #include <cstdlib>             // std::system, EXIT_SUCCESS/FAILURE
-#include <curl/curl.h>         // Libcurl for downloading
 #include <unistd.h>            // geteuid (POSIX-specific)
 #include <unordered_set>       // Efficient hash sets
 #include <unordered_map>       // Efficient hash maps
@@ -22,6 +32,7 @@
 #include <vector>              // Dynamic arrays
 #include <deque>               // Double-ended queue (for dependency stack)
 #include <utility>             // std::pair
+#include <optional>            // Progress view ends before the hooks run
 #include <regex>               // Regular expressions (for version parsing)
 #include <iomanip>             // Output formatting (setprecision, setw, etc.)
 #include <chrono>              // Time points and durations
@@ -41,6 +52,7 @@
 #include <atomic>              // std::atomic_* types
 #include <queue>               // std::queue
 #include <functional>          // std::function
+#include <mutex>               // One key import at a time
 
 // Alias for easier filesystem usage
 namespace fs = std::filesystem;
@@ -70,6 +82,9 @@ namespace Starpack {
         // Keeps track of each repository URL and its associated local DB path.
         std::unordered_map<std::string, std::string> repoUrlToDbPath;
 
+        // Serializes fetching and importing a missing signing key
+        std::mutex g_keyImportMutex;
+
         /**
          * -------------------------------------------------------------------
          * generateTempFilename
@@ -136,6 +151,7 @@ namespace Starpack {
                 }
 
                 // Write the retrieved block
+                LowImpact::throttleWrite(size);
                 if (archive_write_data_block(aw, buff, size, offset) < ARCHIVE_OK) {
                     std::cerr << "archive_write_data_block error: "
                               << archive_error_string(aw) << "\n";
@@ -221,6 +237,38 @@ namespace Starpack {
             }
         }
 
+        /**
+         * -------------------------------------------------------------------
+         * keepsPrivateCopy
+         *
+         * Files that are edited in place stay out of the object store, since
+         * such an edit would reach every root sharing the object: anything
+         * under etc/ and, for packages declaring update_dirs, everything
+         * outside those directories.
+         * -------------------------------------------------------------------
+         */
+        bool keepsPrivateCopy(const std::string& relativePath,
+                              const std::vector<std::string>& updateDirs) {
+            if (relativePath.rfind("etc/", 0) == 0) {
+                return true;
+            }
+            if (updateDirs.empty()) {
+                return false;
+            }
+            for (std::string prefix : updateDirs) {
+                while (!prefix.empty() && prefix.front() == '/') {
+                    prefix.erase(0, 1);
+                }
+                if (!prefix.empty() && prefix.back() != '/') {
+                    prefix.push_back('/');
+                }
+                if (relativePath.rfind(prefix, 0) == 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         /**
          * -------------------------------------------------------------------
          * extract_archive_section
@@ -232,7 +280,13 @@ namespace Starpack {
         int extract_archive_section(const std::string& archivePath,
                                     const std::string& sectionPrefix,
                                     const std::string& destDir,
-                                    int stripComponents) {
+                                    int stripComponents,
+                                    std::vector<StoredObject>* storedObjects = nullptr,
+                                    const std::vector<std::string>& updateDirs = {}) {
+
+            Trace::Span span("extract", "section", sectionPrefix);
+            uint64_t extractedEntries = 0;
+            uint64_t extractedBytes   = 0;
 
             struct archive* a   = archive_read_new();        // for reading
             struct archive* ext = archive_write_disk_new();  // for writing to disk
@@ -307,8 +361,20 @@ namespace Starpack {
                     continue;
                 }
 
+                // NoExtract only applies to the files installed into the root
+                if (sectionPrefix == "files/" &&
+                    Config::current().settings.excludedFromExtraction(strippedRelativePath)) {
+                    Log::debug("Skipped (NoExtract): /" + strippedRelativePath);
+                    archive_read_data_skip(a);
+                    continue;
+                }
+
                 // Build the destination path
                 fs::path fullDestPath = fs::path(destDir) / strippedRelativePath;
+                extractedEntries++;
+                if (archive_entry_filetype(entry) == AE_IFREG) {
+                    extractedBytes += std::max<la_int64_t>(0, archive_entry_size(entry));
+                }
 
                 // Ensure the parent directory exists
                 fs::path parent = fullDestPath.parent_path();
@@ -354,6 +420,20 @@ namespace Starpack {
                               << ec_stat_before.message() << std::endl;
                 }
 
+                // Regular files go through the object store when deduplicating
+                if (storedObjects &&
+                    archive_entry_filetype(entry) == AE_IFREG &&
+                    !archive_entry_hardlink(entry) &&
+                    !keepsPrivateCopy(strippedRelativePath, updateDirs)) {
+                    std::string objectId;
+                    if (ObjectStore::linkEntry(a, entry, fullDestPath.string(), objectId)) {
+                        storedObjects->push_back({ objectId, "/" + strippedRelativePath });
+                    } else {
+                        result = -1;
+                    }
+                    continue;
+                }
+
                 // Overwrite the archive entry's pathname with our new extracted path
                 archive_entry_set_pathname(entry, fullDestPath.string().c_str());
 
@@ -425,6 +505,8 @@ namespace Starpack {
                     if (r < ARCHIVE_WARN) {
                         result = -1;
                     }
+                } else if (archive_entry_filetype(entry) == AE_IFREG) {
+                    LowImpact::dropFromCache(fullDestPath.string(), true);
                 }
             }
 
@@ -441,164 +523,12 @@ namespace Starpack {
             archive_write_close(ext);
             archive_write_free(ext);
 
+            span.arg("archive", archivePath);
+            span.arg("entries", extractedEntries);
+            span.arg("bytes", extractedBytes);
             return result;
         }
 
-        /**
-         * -------------------------------------------------------------------
-         * WriteCallback
-         *
-         * cURL write callback for receiving data and writing directly to
-         * an output file stream.
-         * -------------------------------------------------------------------
-         */
-        size_t WriteCallback(void* ptr, size_t size, size_t nmemb, void* userdata) {
-            std::ofstream* outFile = static_cast<std::ofstream*>(userdata);
-            size_t totalSize = size * nmemb;
-
-            if (outFile && outFile->is_open()) {
-                outFile->write(static_cast<char*>(ptr), totalSize);
-                if (!outFile->good()) {
-                    std::cerr << "Error writing to download file stream!" << std::endl;
-                    return 0; // Signal error to cURL
-                }
-            } else {
-                // If the file stream is invalid but not null, we signal an error
-                if (userdata != nullptr) {
-                    std::cerr << "Error: Invalid file stream in WriteCallback!" << std::endl;
-                    return 0; // Signal error to cURL
-                }
-            }
-            return totalSize;
-        }
-
-        /**
-         * -------------------------------------------------------------------
-         * XferInfoCallback
-         *
-         * cURL transfer info callback for progress reporting (download
-         * progress bar or numeric indicators).
-         * -------------------------------------------------------------------
-         */
-        int XferInfoCallback(void* /*ptr*/,
-                             curl_off_t totalToDownload,
-                             curl_off_t nowDownloaded,
-                             curl_off_t /*totalToUpload*/,
-                             curl_off_t /*nowUploaded*/) {
-
-            if (totalToDownload <= 0) {
-                // Unknown or zero total size
-                if (nowDownloaded > 0) {
-                    double megaBytes = static_cast<double>(nowDownloaded) / (1024 * 1024);
-                    std::cout << "\rDownloading... "
-                              << std::fixed << std::setprecision(1)
-                              << megaBytes << " MiB" << std::flush;
-                } else {
-                    std::cout << "\rDownloading... (size unknown)" << std::flush;
-                }
-                return 0;
-            }
-
-            // Build a simple text progress bar
-            const int barWidth = 50;
-            double progress = static_cast<double>(nowDownloaded)
-                              / static_cast<double>(totalToDownload);
-            if (progress > 1.0) {
-                progress = 1.0; // Clamp to 100%
-            }
-            int pos = static_cast<int>(barWidth * progress);
-
-            std::cout << "\r[";
-            for (int i = 0; i < barWidth; ++i) {
-                if (i < pos) {
-                    std::cout << "=";
-                } else if (i == pos) {
-                    std::cout << ">";
-                } else {
-                    std::cout << " ";
-                }
-            }
-            std::cout << "] "
-                      << std::fixed << std::setprecision(1)
-                      << (progress * 100.0) << "%"
-                      << std::flush;
-
-            return 0; // Return 0 to indicate success to cURL
-        }
-
-        /**
-         * -------------------------------------------------------------------
-         * parseVersion
-         *
-         * Splits a version string (e.g. "1.2.3") into numeric components
-         * for simpler lexical comparisons.
-         * -------------------------------------------------------------------
-         */
-        static std::vector<int> parseVersion(const std::string& ver) {
-            std::vector<int> parts;
-            std::stringstream ss(ver);
-            std::string token;
-
-            while (std::getline(ss, token, '.')) {
-                try {
-                    parts.push_back(std::stoi(token));
-                } catch (...) {
-                    // If parsing fails, default to 0
-                    parts.push_back(0);
-                }
-            }
-            return parts;
-        }
-
-        /**
-         * -------------------------------------------------------------------
-         * compareVersionSemantics
-         *
-         * Compare two dotted version strings numerically (like X.Y.Z).
-         * Return -1 if v1 < v2, 0 if equal, 1 if v1 > v2.
-         * -------------------------------------------------------------------
-         */
-        static int compareVersionSemantics(const std::string& v1, const std::string& v2) {
-            auto p1 = parseVersion(v1);
-            auto p2 = parseVersion(v2);
-            size_t n = std::max(p1.size(), p2.size());
-
-            for (size_t i = 0; i < n; ++i) {
-                int c1 = (i < p1.size()) ? p1[i] : 0;
-                int c2 = (i < p2.size()) ? p2[i] : 0;
-
-                if (c1 < c2) return -1;
-                if (c1 > c2) return 1;
-            }
-            return 0;
-        }
-
-        /**
-         * -------------------------------------------------------------------
-         * compareVersions
-         *
-         * Uses compareVersionSemantics() internally to compare two versions
-         * according to a given operator (>, >=, <, <=, ==, !=).
-         * -------------------------------------------------------------------
-         */
-        bool compareVersions(const std::string& version1,
-                             const std::string& version2,
-                             const std::string& operatorSymbol) {
-
-            int res = compareVersionSemantics(version1, version2);
-
-            if      (operatorSymbol == ">")   return (res > 0);
-            else if (operatorSymbol == ">=")  return (res >= 0);
-            else if (operatorSymbol == "<")   return (res < 0);
-            else if (operatorSymbol == "<=")  return (res <= 0);
-            else if (operatorSymbol == "==" || operatorSymbol == "=") return (res == 0);
-            else if (operatorSymbol == "!=")  return (res != 0);
-
-            std::cerr << "Warning: Unknown version comparison operator: '"
-                      << operatorSymbol << "'\n";
-            return false;
-        }
-
         /**
          * -------------------------------------------------------------------
          * validateDependency
@@ -612,7 +542,7 @@ namespace Starpack {
                                 const YAML::Node& availablePackageNode) {
 
             // Regex to parse operators and version: >, >=, <, <=, ==, etc.
-            std::regex constraintRegex(R"(([><=]=?)\s*([\w\.\-\+~]+))");
+            std::regex constraintRegex(R"(([><=]=?)\s*([\w\.\-\+~:]+))");
             std::smatch match;
             std::string operatorSymbol = "=="; // Default: exact match
             std::string constraintVersion = versionConstraint;
@@ -649,44 +579,7 @@ namespace Starpack {
             }
             std::string availableVersion = availablePackageNode["version"].as<std::string>();
 
-            // Compare using compareVersions
-            return compareVersions(availableVersion, constraintVersion, operatorSymbol);
-        }
-
-        /**
-         * -------------------------------------------------------------------
-         * printProgressBar
-         *
-         * A simple ASCII progress bar. The total helps gauge the fraction.
-         * -------------------------------------------------------------------
-         */
-        void printProgressBar(size_t current, size_t total) {
-            if (total == 0) return;
-
-            float percent = static_cast<float>(current) / static_cast<float>(total);
-            percent = std::min(percent, 1.0f);
-            const int barWidth = 50;
-            int pos = static_cast<int>(barWidth * percent);
-
-            std::cout << "\rProgress: [";
-            for (int i = 0; i < barWidth; i++) {
-                if (i < pos) {
-                    std::cout << "=";
-                } else if (i == pos) {
-                    std::cout << ">";
-                } else {
-                    std::cout << " ";
-                }
-            }
-            std::cout << "] "
-                      << std::fixed << std::setprecision(0)
-                      << (percent * 100.0f) << "% ("
-                      << current << "/" << total << ")"
-                      << std::flush;
-
-            if (current == total) {
-                std::cout << std::endl;
-            }
+            return Version::satisfies(availableVersion, operatorSymbol, constraintVersion);
         }
 
         /**
@@ -720,388 +613,8 @@ namespace Starpack {
             }
         }
 
-        /**
-         * -------------------------------------------------------------------
-         * DownloadJob
-         *
-         * Structure that holds information about a download job for the
-         * multi-file asynchronous download mechanism.
-         * -------------------------------------------------------------------
-         */
-        struct DownloadJob {
-            std::ofstream fileStream;
-            CURL*         easyHandle = nullptr;
-            std::string   url;
-            std::string   outputPath;
-            bool          success = false;
-        };
-
     } // end anonymous namespace
 
-    //========================================================================
-    // Download Functions (Starpack namespace)
-    //========================================================================
-
-    /**
-     * ------------------------------------------------------------------------
-     * downloadSingleFileSync
-     *
-     * Downloads a single file using a synchronous cURL invocation. Returns
-     * true if the file either already exists or downloads successfully.
-     * ------------------------------------------------------------------------
-     */
-    bool downloadSingleFileSync(const std::string& url, const std::string& outputPath) {
-        if (fs::exists(outputPath)) {
-            // Already present, consider it "good"
-            return true;
-        }
-
-        std::cout << "[Sync] Downloading: " << url << " -> " << outputPath << std::endl;
-
-        fs::path outPathFs(outputPath);
-        fs::path parentDir = outPathFs.parent_path();
-        if (!parentDir.empty() && !fs::exists(parentDir)) {
-            try {
-                fs::create_directories(parentDir);
-            } catch (const std::exception& e) {
-                std::cerr << "[Sync] Error creating directory "
-                          << parentDir.string() << ": " << e.what() << std::endl;
-                return false;
-            }
-        }
-
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-            std::cerr << "[Sync] Error: Failed to initialize curl." << std::endl;
-            return false;
-        }
-
-        std::ofstream outFile(outputPath, std::ios::binary | std::ios::trunc);
-        if (!outFile) {
-            std::cerr << "[Sync] Error: Failed to open file for writing: "
-                      << outputPath << std::endl;
-            curl_easy_cleanup(curl);
-            return false;
-        }
-
-        // Configure cURL
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &outFile);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, XferInfoCallback);
-        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, nullptr);
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);
-
-        CURLcode res = curl_easy_perform(curl);
-        long response_code = 0;
-        if (res == CURLE_OK) {
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-        }
-
-        curl_easy_cleanup(curl);
-        outFile.close();
-        std::cout << std::endl; // progress bar newline
-
-        if (res != CURLE_OK) {
-            std::cerr << "[Sync] Error downloading " << url << ": "
-                      << curl_easy_strerror(res) << std::endl;
-            fs::remove(outputPath);
-            return false;
-        }
-
-        if (response_code >= 400) {
-            std::cerr << "[Sync] Error downloading " << url << ": Server responded with code "
-                      << response_code << std::endl;
-            fs::remove(outputPath);
-            return false;
-        }
-
-        return true;
-    }
-
-    /**
-     * ------------------------------------------------------------------------
-     * downloadMultipleFilesMulti
-     *
-     * Downloads multiple files asynchronously using cURL multi-interface.
-     * Returns true if all files download successfully, false otherwise.
-     * ------------------------------------------------------------------------
-     */
-    bool downloadMultipleFilesMulti(const std::vector<std::pair<std::string, std::string>>& filesToDownload) {
-        if (filesToDownload.empty()) {
-            return true;
-        }
-
-        CURLM* multiHandle = curl_multi_init();
-        if (!multiHandle) {
-            std::cerr << "[Multi Error] curl_multi_init failed!\n";
-            return false;
-        }
-
-        std::map<CURL*, DownloadJob> jobs;
-        std::atomic<bool> overallSuccess = {true};
-        std::atomic<int>  completedCount = {0};
-        size_t totalJobsAttempted       = 0;
-
-        // Let’s limit concurrency to 10 or the number of files, whichever is smaller
-        const int maxConcurrent = std::max(1, std::min((int)filesToDownload.size(), 10));
-        int currentDownloads    = 0;
-        size_t fileIndex        = 0;
-        int stillRunning        = 0;
-
-        // Main event loop
-        do {
-            // Add new transfers as long as we have capacity and unprocessed files
-            while (currentDownloads < maxConcurrent && fileIndex < filesToDownload.size()) {
-                const auto& url  = filesToDownload[fileIndex].first;
-                const auto& path = filesToDownload[fileIndex].second;
-                fileIndex++;
-                totalJobsAttempted++;
-
-                // If file already exists, skip
-                if (fs::exists(path)) {
-                    completedCount++;
-                    continue;
-                }
-
-                // Make sure destination directory exists
-                fs::path outPathFs(path);
-                fs::path parentPath = outPathFs.parent_path();
-                if (!parentPath.empty() && !fs::exists(parentPath)) {
-                    try {
-                        fs::create_directories(parentPath);
-                    } catch (const std::exception& e) {
-                        std::cerr << "[Multi Error] Creating directory "
-                                  << parentPath.string() << " failed: "
-                                  << e.what() << ". Skipping URL: " << url << std::endl;
-                        overallSuccess = false;
-                        completedCount++;
-                        continue;
-                    }
-                }
-
-                CURL* easyHandle = curl_easy_init();
-                if (!easyHandle) {
-                    std::cerr << "[Multi Error] curl_easy_init failed for URL: "
-                              << url << ". Skipping." << std::endl;
-                    overallSuccess = false;
-                    completedCount++;
-                    continue;
-                }
-
-                // Emplace a blank job first
-                auto [it, success_emplace] =
-                     jobs.emplace(easyHandle, DownloadJob{});
-                if (!success_emplace) {
-                    std::cerr << "[Multi Internal Error] Failed to emplace job for handle. "
-                              << "Skipping URL: " << url << std::endl;
-                    curl_easy_cleanup(easyHandle);
-                    overallSuccess = false;
-                    completedCount++;
-                    continue;
-                }
-
-                // Reference the job stored in the map
-                DownloadJob& job_in_map  = it->second;
-                job_in_map.url           = url;
-                job_in_map.outputPath    = path;
-                job_in_map.easyHandle    = easyHandle;
-                job_in_map.fileStream.open(path, std::ios::binary | std::ios::trunc);
-
-                if (!job_in_map.fileStream) {
-                    std::cerr << "[Multi Error] Failed to open file for writing: '"
-                              << path << "'. Skipping URL: " << url << std::endl;
-                    curl_easy_cleanup(easyHandle);
-                    jobs.erase(it);
-                    overallSuccess = false;
-                    completedCount++;
-                    continue;
-                }
-
-                // Set cURL options
-                curl_easy_setopt(easyHandle, CURLOPT_URL, url.c_str());
-                curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
-                curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &job_in_map.fileStream);
-                curl_easy_setopt(easyHandle, CURLOPT_FOLLOWLOCATION, 1L);
-                curl_easy_setopt(easyHandle, CURLOPT_FAILONERROR, 1L);
-                curl_easy_setopt(easyHandle, CURLOPT_PRIVATE, easyHandle);
-                curl_easy_setopt(easyHandle, CURLOPT_NOPROGRESS, 0L);
-                curl_easy_setopt(easyHandle, CURLOPT_XFERINFOFUNCTION, XferInfoCallback);
-                curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT, 15L);
-                curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT, 300L);
-                curl_easy_setopt(easyHandle, CURLOPT_USERAGENT, "Starpack/1.0");
-
-                // Add handle to the multi stack
-                CURLMcode mc = curl_multi_add_handle(multiHandle, easyHandle);
-                if (mc != CURLM_OK) {
-                    std::cerr << "[Multi Error] curl_multi_add_handle failed (" << mc
-                              << "): " << curl_multi_strerror(mc)
-                              << " for URL: " << url << ". Skipping." << std::endl;
-
-                    if (job_in_map.fileStream.is_open()) {
-                        job_in_map.fileStream.close();
-                    }
-                    fs::remove(path);
-                    curl_easy_cleanup(easyHandle);
-                    jobs.erase(it);
-                    overallSuccess = false;
-                    completedCount++;
-                    continue;
-                }
-
-                // We have one more transfer in progress
-                currentDownloads++;
-            }
-
-            // Perform the transfers
-            CURLMcode mc_perf = curl_multi_perform(multiHandle, &stillRunning);
-            if (mc_perf != CURLM_OK && mc_perf != CURLM_CALL_MULTI_PERFORM) {
-                std::cerr << "[Multi Error] curl_multi_perform failed (" << mc_perf
-                          << "): " << curl_multi_strerror(mc_perf) << std::endl;
-            }
-
-            // Check for completed transfers
-            int msgsInQueue = 0;
-            CURLMsg* msg;
-
-            while ((msg = curl_multi_info_read(multiHandle, &msgsInQueue))) {
-                if (msg->msg == CURLMSG_DONE) {
-                    CURL* easyHandle = msg->easy_handle;
-                    CURLcode result  = msg->data.result;
-                    long response_code = 0;
-                    double total_time  = 0;
-
-                    auto it = jobs.find(easyHandle);
-                    if (it != jobs.end()) {
-                        DownloadJob& completedJob = it->second;
-
-                        if (completedJob.fileStream.is_open()) {
-                            completedJob.fileStream.close();
-                        }
-
-                        curl_easy_getinfo(easyHandle, CURLINFO_RESPONSE_CODE, &response_code);
-                        curl_easy_getinfo(easyHandle, CURLINFO_TOTAL_TIME, &total_time);
-
-                        if (result == CURLE_OK && response_code < 400) {
-                            completedJob.success = true;
-                        } else {
-                            std::cout << std::endl; // new line for clarity
-                            std::cerr << "[Multi Error] Failed download:\n"
-                                      << "  URL : " << completedJob.url << "\n"
-                                      << "  Path: " << completedJob.outputPath << std::endl;
-
-                            if (result != CURLE_OK) {
-                                std::cerr << "  Curl Error: "
-                                          << curl_easy_strerror(result)
-                                          << " (Code: " << result << ")\n";
-                            }
-
-                            if (response_code >= 400) {
-                                std::cerr << "  HTTP Status: " << response_code << "\n";
-                            }
-                            std::cerr << "  Time: "
-                                      << std::fixed << std::setprecision(2)
-                                      << total_time << "s\n";
-
-                            overallSuccess = false;
-                            fs::remove(completedJob.outputPath);
-                        }
-
-                        curl_multi_remove_handle(multiHandle, easyHandle);
-                        curl_easy_cleanup(easyHandle);
-                        jobs.erase(it);
-                        currentDownloads--;
-                        completedCount++;
-                    } else {
-                        // We didn't find the handle in our map
-                        std::cerr << "[Multi Internal Error] Completed handle not found in map!"
-                                  << std::endl;
-                        curl_multi_remove_handle(multiHandle, easyHandle);
-                        curl_easy_cleanup(easyHandle);
-                        currentDownloads--;
-                        completedCount++;
-                    }
-                    // Clear progress line
-                    std::cout << "\r" << std::string(80, ' ') << "\r" << std::flush;
-                }
-            }
-
-            // If still running, or there's more to queue, wait for activity
-            if (stillRunning > 0) {
-                struct timeval timeout;
-                fd_set fdread, fdwrite, fdexcep;
-                int maxfd = -1;
-
-                FD_ZERO(&fdread);
-                FD_ZERO(&fdwrite);
-                FD_ZERO(&fdexcep);
-
-                timeout.tv_sec  = 0;
-                timeout.tv_usec = 100 * 1000; // 100ms
-
-                CURLMcode mc_fdset = curl_multi_fdset(multiHandle,
-                                                      &fdread, &fdwrite, &fdexcep,
-                                                      &maxfd);
-
-                if (mc_fdset != CURLM_OK) {
-                    std::cerr << "[Multi Error] curl_multi_fdset: "
-                              << curl_multi_strerror(mc_fdset) << std::endl;
-                }
-
-                if (maxfd == -1) {
-                    std::this_thread::sleep_for(milliseconds(100));
-                } else {
-                    int rc = select(maxfd + 1,
-                                    &fdread, &fdwrite, &fdexcep, &timeout);
-                    if (rc == -1) {
-                        std::perror("[Multi Error] select failed");
-                        overallSuccess = false;
-                    }
-                }
-            } else if (fileIndex < filesToDownload.size()) {
-                // If there's more to do but none are running, short sleep
-                std::this_thread::sleep_for(milliseconds(10));
-            }
-
-        } while (stillRunning > 0 || completedCount < totalJobsAttempted);
-
-        // Final cleanup check
-        int msgsInQueue = 0;
-        CURLMsg* msg;
-        while ((msg = curl_multi_info_read(multiHandle, &msgsInQueue))) {
-            if (msg->msg == CURLMSG_DONE) {
-                CURL* easyHandle = msg->easy_handle;
-                auto it = jobs.find(easyHandle);
-
-                if (it != jobs.end()) {
-                    DownloadJob& completedJob = it->second;
-                    if (completedJob.fileStream.is_open()) {
-                        completedJob.fileStream.close();
-                    }
-                    if (!completedJob.success) {
-                        overallSuccess = false;
-                        fs::remove(completedJob.outputPath);
-                    }
-                    curl_multi_remove_handle(multiHandle, easyHandle);
-                    curl_easy_cleanup(easyHandle);
-                    jobs.erase(it);
-                } else {
-                    curl_multi_remove_handle(multiHandle, easyHandle);
-                    curl_easy_cleanup(easyHandle);
-                }
-            }
-        }
-
-        curl_multi_cleanup(multiHandle);
-        std::cout << "\r" << std::string(80, ' ') << "\r";
-        std::cout << "[Multi] Download processing finished." << std::endl;
-        return overallSuccess;
-    }
-
     //========================================================================
     // Installer Class Methods
     //========================================================================
@@ -1250,6 +763,9 @@ namespace Starpack {
      * ------------------------------------------------------------------------
      */
     bool Installer::getConfirmation(const std::vector<std::string>& packages) {
+        if (Events::active()) {
+            return Events::confirm("install", packages);
+        }
         if (packages.empty()) {
             std::cout << "Internal Info: No packages identified for installation action."
                       << std::endl;
@@ -1288,6 +804,98 @@ namespace Starpack {
         }
     }
 
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::formatDatabaseEntry
+     *
+     * Renders the installed.db block for one package.
+     * ------------------------------------------------------------------------
+     */
+    std::string Installer::formatDatabaseEntry(const std::string& packageName,
+                                               const YAML::Node& packageNode) {
+
+        std::ostringstream entry;
+
+        // Package block header
+        entry << packageName << " /\n";
+
+        // Lambda for writing a key/value if present
+        auto write_scalar = [&](const std::string& key,
+                                const std::string& dbKey) {
+            if (packageNode[key] && packageNode[key].IsScalar()) {
+                entry << dbKey << ": "
+                      << packageNode[key].as<std::string>() << "\n";
+            }
+        };
+
+        // Write fields if they exist
+        write_scalar("version",     "Version");
+        write_scalar("build_epoch", "Build-epoch");
+        write_scalar("sha256",      "Sha256");
+        write_scalar("description", "Description");
+        write_scalar("size",       "Size");
+        write_scalar("arch",       "Architecture");
+
+        // For date, prefer 'update_time', fallback to 'build_date'
+        if (packageNode["update_time"] &&
+            packageNode["update_time"].IsScalar()) {
+            write_scalar("update_time", "Update-time");
+        } else {
+            write_scalar("build_date",  "Build-date");
+        }
+        write_scalar("object_store", "Object-store");
+
+        // Files list
+        if (packageNode["files"] &&
+            packageNode["files"].IsSequence()) {
+            entry << "Files:\n";
+            for (const auto& fileNode : packageNode["files"]) {
+                if (fileNode.IsScalar()) {
+                    std::string filePath = fileNode.as<std::string>();
+                    if (filePath.empty()) {
+                        continue;
+                    }
+                    if (filePath[0] != '/') {
+                        filePath = "/" + filePath;
+                    }
+                    entry << filePath << "\n";
+                }
+            }
+        } else {
+            std::cerr << "Warning: Missing 'files' list for package "
+                      << packageName << " in DB entry.\n";
+        }
+
+        // Object store IDs of deduplicated files ("<id> <path>")
+        if (packageNode["objects"] &&
+            packageNode["objects"].IsSequence()) {
+            entry << "Objects:\n";
+            for (const auto& objectNode : packageNode["objects"]) {
+                if (objectNode.IsScalar()) {
+                    entry << objectNode.as<std::string>() << "\n";
+                }
+            }
+        }
+
+        // Dependencies list
+        if (packageNode["dependencies"] &&
+            packageNode["dependencies"].IsSequence()) {
+            entry << "Dependencies:\n";
+            for (const auto& depNode : packageNode["dependencies"]) {
+                if (depNode.IsScalar()) {
+                    std::string depStr = depNode.as<std::string>();
+                    if (!depStr.empty()) {
+                        entry << depStr << "\n";
+                    }
+                }
+            }
+        }
+
+        // End block
+        entry << "----------------------------------------\n";
+        return entry.str();
+    }
+
     /**
      * ------------------------------------------------------------------------
      * Installer::createDatabaseEntry
@@ -1300,6 +908,7 @@ namespace Starpack {
                                         const std::string& installDir,
                                         const YAML::Node& packageNode) {
 
+        Trace::Span span("db", "write entry", packageName);
         fs::path dbDir  = fs::path(installDir) / "var" / "lib" / "starpack";
         fs::path dbPath = dbDir / "installed.db";
 
@@ -1308,79 +917,21 @@ namespace Starpack {
                 fs::create_directories(dbDir);
             }
 
+            std::string entry = formatDatabaseEntry(packageName, packageNode);
+
             std::ofstream dbFile(dbPath, std::ios::app | std::ios::binary);
             if (!dbFile) {
                 throw std::runtime_error("Unable to open database file for writing: "
                                          + dbPath.string());
             }
-
-            // Package block header
-            dbFile << packageName << " /\n";
-
-            // Lambda for writing a key/value if present
-            auto write_scalar = [&](const std::string& key,
-                                    const std::string& dbKey) {
-                if (packageNode[key] && packageNode[key].IsScalar()) {
-                    dbFile << dbKey << ": "
-                           << packageNode[key].as<std::string>() << "\n";
-                }
-            };
-
-            // Write fields if they exist
-            write_scalar("version",     "Version");
-            write_scalar("description", "Description");
-            write_scalar("size",       "Size");
-            write_scalar("arch",       "Architecture");
-
-            // For date, prefer 'update_time', fallback to 'build_date'
-            if (packageNode["update_time"] &&
-                packageNode["update_time"].IsScalar()) {
-                write_scalar("update_time", "Update-time");
-            } else {
-                write_scalar("build_date",  "Build-date");
+            dbFile << entry;
+            dbFile.flush();
+            dbFile.close();
+            if (Config::current().settings.durability != Durability::None &&
+                !syncFile(dbPath.string())) {
+                std::cerr << "Warning: Could not sync " << dbPath.string() << std::endl;
             }
 
-            // Files list
-            if (packageNode["files"] &&
-                packageNode["files"].IsSequence()) {
-                dbFile << "Files:\n";
-                for (const auto& fileNode : packageNode["files"]) {
-                    if (fileNode.IsScalar()) {
-                        std::string filePath = fileNode.as<std::string>();
-                        if (filePath.empty()) {
-                            continue;
-                        }
-                        if (filePath[0] != '/') {
-                            filePath = "/" + filePath;
-                        }
-                        dbFile << filePath << "\n";
-                    }
-                }
-            } else {
-                std::cerr << "Warning: Missing 'files' list for package "
-                          << packageName << " in DB entry.\n";
-            }
-
-            // Dependencies list
-            if (packageNode["dependencies"] &&
-                packageNode["dependencies"].IsSequence()) {
-                dbFile << "Dependencies:\n";
-                bool hasDeps = false;
-                for (const auto& depNode : packageNode["dependencies"]) {
-                    if (depNode.IsScalar()) {
-                        std::string depStr = depNode.as<std::string>();
-                        if (!depStr.empty()) {
-                            dbFile << depStr << "\n";
-                            hasDeps = true;
-                        }
-                    }
-                }
-            }
-
-            // End block
-            dbFile << "----------------------------------------\n";
-            dbFile.flush();
-
         } catch (const YAML::Exception& e) {
             std::cerr << "YAML Error processing package node for "
                       << packageName << ": " << e.what() << std::endl;
@@ -1504,22 +1055,15 @@ namespace Starpack {
             std::cerr << "GPG Verification failed: Missing public key: "
                       << missingKey << std::endl;
 
-            // Attempt to read /etc/starpack/repos.conf to get repository URLs
-            std::ifstream confFile("/etc/starpack/repos.conf");
-            std::vector<std::string> repoUrls;
-            std::string repoLine;
+            // Concurrent verifications import one key at a time
+            std::lock_guard<std::mutex> importLock(g_keyImportMutex);
 
-            while (std::getline(confFile, repoLine)) {
-                repoLine.erase(0, repoLine.find_first_not_of(" \t\n\r"));
-                repoLine.erase(repoLine.find_last_not_of(" \t\n\r") + 1);
-
-                if (repoLine.empty() || repoLine[0] == '#') {
-                    continue;
-                }
-                if (repoLine.back() != '/') {
-                    repoLine += '/';
+            // Every repository and mirror may carry the key
+            std::vector<std::string> repoUrls;
+            for (const auto& repo : Config::current().byPriority()) {
+                for (const auto& base : repo.bases()) {
+                    repoUrls.push_back(base);
                 }
-                repoUrls.push_back(repoLine);
             }
 
             if (repoUrls.empty()) {
@@ -1614,7 +1158,7 @@ namespace Starpack {
         return false;
     }
 
-    // An alias for the dependency graph: package -> its dependencies
+    // An alias for the dependency graph: package -> packages that depend on it
     using DependencyGraph = std::unordered_map<std::string, std::vector<std::string>>;
 
     /**
@@ -1668,18 +1212,14 @@ namespace Starpack {
             installOrder.push_back(currentPkg);
 
             // Decrease in-degree for items that depend on currentPkg
-            for (const auto &pair : graph) {
-                const std::string& potentialDependent = pair.first;
-                const auto& dependencies = pair.second;
-
-                // If this dependent actually depends on currentPkg
-                if (std::find(dependencies.begin(), dependencies.end(), currentPkg)
-                    != dependencies.end()) {
-                    if (inDegree.count(potentialDependent)) {
-                        if (--inDegree[potentialDependent] == 0) {
-                            zeroInDegreeQueue.push(potentialDependent);
-                        }
-                    }
+            // (graph edges point from a package to its dependents)
+            auto dependents = graph.find(currentPkg);
+            if (dependents == graph.end()) {
+                continue;
+            }
+            for (const auto &dependent : dependents->second) {
+                if (--inDegree[dependent] == 0) {
+                    zeroInDegreeQueue.push(dependent);
                 }
             }
         }
@@ -1707,70 +1247,127 @@ namespace Starpack {
 
     /**
      * ------------------------------------------------------------------------
-     * Installer::installPackage
+     * Installer::resolveDependencies
      *
-     * The main method that orchestrates package installation, including
-     * repository lookup, dependency resolution, file downloading, signature
-     * verification, extraction, and hooking into Pre/Post install steps.
+     * Collects the dependency closure of the requested packages from the
+     * merged repository table and returns it in installation order.
+     * Packages missing from the repositories are accepted only if
+     * isProvided() reports them as already present.
      * ------------------------------------------------------------------------
      */
-    void Installer::installPackage(const std::vector<std::string>& initialPackageNames,
-                                   const std::string& installDir,
-                                   bool confirm) {
-
-        std::cout << "--- Starpack Installation ---" << std::endl;
-        std::cout << "Target directory: " << installDir << std::endl;
+    bool Installer::resolveDependencies(const std::vector<std::string>& initialPackageNames,
+                                        const PackageSourceCache& packageSourceCache,
+                                        const std::function<bool(const std::string&)>& isProvided,
+                                        std::vector<std::string>& installOrder) {
 
-        // Ensure our local DB is set up
-        initializeDatabase(installDir);
+        Trace::Span span("resolve", "resolve dependencies");
+        std::unordered_set<std::string> requiredPackages;
+        std::unordered_set<std::string> visitedForDeps;
 
-        // Data structures
-        std::unordered_map<std::string, YAML::Node> repoDbCache;  // Not heavily used
-        std::unordered_map<std::string,
-                           std::pair<std::string, YAML::Node>> packageSourceCache;
-        std::unordered_set<std::string> resolvedPackages;
-        std::vector<std::string> repoUrls;
-        std::vector<std::pair<std::string, std::string>> downloadTasks;
+        // Depth-first approach with a manual stack
+        std::vector<std::string> resolutionStack = initialPackageNames;
+        while (!resolutionStack.empty()) {
+            std::string currentPkg = resolutionStack.back();
+            resolutionStack.pop_back();
 
-        // Step 1: Load repository URLs
-        std::cout << "[1/8] Loading repository configuration..." << std::endl;
-        fs::path repoConfPath = fs::path("/etc") / "starpack" / "repos.conf";
+            if (visitedForDeps.count(currentPkg)) {
+                continue;
+            }
+            visitedForDeps.insert(currentPkg);
+            requiredPackages.insert(currentPkg);
 
-        std::ifstream confFile(repoConfPath);
-        if (!confFile) {
-            std::cerr << "Error: Failed to open repository config: "
-                      << repoConfPath.string() << std::endl;
-            return;
+            auto it = packageSourceCache.find(currentPkg);
+            if (it != packageSourceCache.end()) {
+                const YAML::Node& pkgNode = it->second.second;
+                if (pkgNode["dependencies"] && pkgNode["dependencies"].IsSequence()) {
+                    for (const auto &depNode : pkgNode["dependencies"]) {
+                        if (depNode.IsScalar()) {
+                            std::string depName = depNode.as<std::string>();
+                            if (!visitedForDeps.count(depName)) {
+                                resolutionStack.push_back(depName);
+                            }
+                        }
+                    }
+                }
+            } else {
+                // If the package isn't in the repo, it has to be installed already
+                if (!isProvided(currentPkg)) {
+                    std::cerr << "Error: Dependency '" << currentPkg
+                              << "' not in repos and not installed." << std::endl;
+                    return false;
+                }
+            }
         }
 
-        std::string currentRepoUrl;
-        while (std::getline(confFile, currentRepoUrl)) {
-            currentRepoUrl.erase(0, currentRepoUrl.find_first_not_of(" \t\n\r"));
-            currentRepoUrl.erase(currentRepoUrl.find_last_not_of(" \t\n\r") + 1);
-            if (currentRepoUrl.empty() || currentRepoUrl[0] == '#') {
+        // Build a graph of dependencies
+        DependencyGraph depGraph;
+        for (const auto &pkgName : requiredPackages) {
+            depGraph[pkgName] = {};
+        }
+        for (const auto &pkgName : requiredPackages) {
+            auto it = packageSourceCache.find(pkgName);
+            if (it == packageSourceCache.end()) {
+                // Possibly installed already
                 continue;
             }
-            if (currentRepoUrl.back() != '/') {
-                currentRepoUrl += '/';
-            }
-            if (std::find(repoUrls.begin(), repoUrls.end(), currentRepoUrl) == repoUrls.end()) {
-                repoUrls.push_back(currentRepoUrl);
+
+            const YAML::Node& pkgNode = it->second.second;
+            if (pkgNode["dependencies"] && pkgNode["dependencies"].IsSequence()) {
+                for (const auto &depNode : pkgNode["dependencies"]) {
+                    if (depNode.IsScalar()) {
+                        std::string depName = depNode.as<std::string>();
+                        if (requiredPackages.count(depName)) {
+                            depGraph[depName].push_back(pkgName);
+                        }
+                    }
+                }
             }
         }
-        confFile.close();
+
+        try {
+            installOrder = computeInstallationOrderCycleTolerant(depGraph);
+            span.arg("packages", static_cast<uint64_t>(installOrder.size()));
+        } catch (const std::exception &e) {
+            std::cerr << "Error resolving dependencies: " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::loadRepositoryIndex
+     *
+     * Reads repos.conf, downloads every repository DB into cacheDir and
+     * merges them into packageSourceCache (first repository wins).
+     * ------------------------------------------------------------------------
+     */
+    bool Installer::loadRepositoryIndex(const std::string& cacheDir,
+                                        PackageSourceCache& packageSourceCache,
+                                        bool refresh) {
+
+        Trace::Span span("index", "load repositories");
+
+        // Step 1: Load repository URLs. Higher priorities come first, and
+        // the first repository that defines a package provides it.
+        std::cout << "[1/8] Loading repository configuration..." << std::endl;
+        std::vector<RepositoryConfig> repositories = Config::current().byPriority();
+        std::vector<std::string> repoUrls;
+        for (const auto& repo : repositories) {
+            repoUrls.push_back(repo.url);
+        }
 
         if (repoUrls.empty()) {
             std::cerr << "Error: No valid repository URLs found in "
-                      << repoConfPath.string() << "." << std::endl;
-            return;
+                      << Config::defaultPath << "." << std::endl;
+            return false;
         }
 
         std::cout << "Found " << repoUrls.size() << " repository URL(s)." << std::endl;
 
         // Step 2: Prepare and download repo DBs
         std::cout << "[2/8] Checking/Downloading repository databases..." << std::endl;
-        fs::path cacheDirPath = fs::path(installDir) /
-                                "var" / "lib" / "starpack" / "cache";
+        fs::path cacheDirPath(cacheDir);
         try {
             if (!fs::exists(cacheDirPath)) {
                 fs::create_directories(cacheDirPath);
@@ -1779,13 +1376,13 @@ namespace Starpack {
             std::cerr << "Error creating cache directory "
                       << cacheDirPath.string() << ": " << e.what()
                       << ". Aborting." << std::endl;
-            return;
+            return false;
         }
-        std::string cacheDir = cacheDirPath.string();
 
         // Make a list of DB download tasks
         std::vector<std::pair<std::string, std::string>> dbDownloadTasks;
-        for (const auto& repoUrl : repoUrls) {
+        for (const auto& repo : repositories) {
+            const std::string& repoUrl = repo.url;
             std::string repoDbUrl = repoUrl + "repo.db.yaml";
 
             std::string safeRepoName = repoUrl;
@@ -1797,12 +1394,25 @@ namespace Starpack {
             // Record it in the global map
             repoUrlToDbPath[repoUrl] = localDbPath.string();
 
+            // Cached DBs are only downloaded again once removed, or once
+            // older than the repository's TTL
+            std::error_code ec;
+            bool expired = false;
+            if (!refresh && repo.indexTtl >= 0 && fs::exists(localDbPath, ec)) {
+                auto age = fs::file_time_type::clock::now() - fs::last_write_time(localDbPath, ec);
+                expired = !ec && age > std::chrono::seconds(repo.indexTtl);
+            }
+            if (refresh || expired) {
+                fs::remove(localDbPath, ec);
+            }
+
             dbDownloadTasks.push_back({repoDbUrl, localDbPath.string()});
         }
 
         // Download them
         if (!dbDownloadTasks.empty()) {
-            if (!downloadMultipleFilesMulti(dbDownloadTasks)) {
+            Trace::Span downloadSpan("index", "download indices");
+            if (!downloadWithMirrors(dbDownloadTasks)) {
                 std::cerr << "Warning: One or more repository DB downloads failed. "
                           << "Installation may be incomplete." << std::endl;
             }
@@ -1827,6 +1437,7 @@ namespace Starpack {
             }
 
             try {
+                Trace::Span parseSpan("index", "parse", repoUrl);
                 std::cout << " -> Loading packages from " << repoUrl << "..." << std::endl;
                 YAML::Node currentDb = YAML::LoadFile(localDbPath);
 
@@ -1842,6 +1453,7 @@ namespace Starpack {
                         }
                     }
                     std::cout << "    Loaded " << count << " package definitions." << std::endl;
+                    parseSpan.arg("packages", static_cast<uint64_t>(count));
                 }
             } catch (const std::exception& e) {
                 std::cerr << "Error parsing DB " << localDbPath << ": "
@@ -1852,155 +1464,86 @@ namespace Starpack {
         if (packageSourceCache.empty()) {
             std::cerr << "Error: No packages found in any repository database."
                       << std::endl;
-            return;
-        }
-
-        // Step 4: Resolve dependencies
-        std::cout << "[4/8] Resolving dependencies..." << std::endl;
-        std::unordered_set<std::string> requiredPackages;
-        std::unordered_set<std::string> visitedForDeps;
-
-        // Depth-first approach with a manual stack
-        std::vector<std::string> resolutionStack = initialPackageNames;
-        while (!resolutionStack.empty()) {
-            std::string currentPkg = resolutionStack.back();
-            resolutionStack.pop_back();
-
-            if (visitedForDeps.count(currentPkg)) {
-                continue;
-            }
-            visitedForDeps.insert(currentPkg);
-            requiredPackages.insert(currentPkg);
-
-            auto it = packageSourceCache.find(currentPkg);
-            if (it != packageSourceCache.end()) {
-                YAML::Node pkgNode = it->second.second;
-                if (pkgNode["dependencies"] && pkgNode["dependencies"].IsSequence()) {
-                    for (const auto &depNode : pkgNode["dependencies"]) {
-                        if (depNode.IsScalar()) {
-                            std::string depName = depNode.as<std::string>();
-                            if (!visitedForDeps.count(depName)) {
-                                resolutionStack.push_back(depName);
-                            }
-                        }
-                    }
-                }
-            } else {
-                // If the package isn't in the repo, check if it's installed
-                if (!isPackageInstalled(currentPkg, installDir)) {
-                    std::cerr << "Error: Dependency '" << currentPkg
-                              << "' not in repos and not installed." << std::endl;
-                    return;
-                }
-            }
+            return false;
         }
 
-        // Build a graph of dependencies
-        DependencyGraph depGraph;
-        for (const auto &pkgName : requiredPackages) {
-            depGraph[pkgName] = {};
+        // Keep the completion name list in step with the cached indices
+        std::vector<std::string> dbPaths;
+        for (const auto& repoUrl : repoUrls) {
+            dbPaths.push_back(repoUrlToDbPath[repoUrl]);
         }
-        for (const auto &pkgName : requiredPackages) {
-            auto it = packageSourceCache.find(pkgName);
-            if (it == packageSourceCache.end()) {
-                // Possibly installed already
-                continue;
+        std::string namesPath = (cacheDirPath / Completion::repoNamesFile).string();
+        if (Completion::isStale(namesPath, dbPaths)) {
+            std::vector<std::string> names;
+            names.reserve(packageSourceCache.size());
+            for (const auto& [name, source] : packageSourceCache) {
+                names.push_back(name);
             }
-
-            YAML::Node pkgNode = it->second.second;
-            if (pkgNode["dependencies"] && pkgNode["dependencies"].IsSequence()) {
-                for (const auto &depNode : pkgNode["dependencies"]) {
-                    if (depNode.IsScalar()) {
-                        std::string depName = depNode.as<std::string>();
-                        if (requiredPackages.count(depName)) {
-                            depGraph[depName].push_back(pkgName);
-                        }
-                    }
-                }
-            }
-        }
-
-        std::vector<std::string> sortedPackages;
-        try {
-            sortedPackages = computeInstallationOrderCycleTolerant(depGraph);
-        } catch (const std::exception &e) {
-            std::cerr << "Error resolving dependencies: " << e.what() << std::endl;
-            return;
-        }
-
-        // Filter out anything already installed
-        std::vector<std::string> finalPackagesToInstall;
-        for (const auto &pkgName : sortedPackages) {
-            if (requiredPackages.count(pkgName) &&
-                !isPackageInstalled(pkgName, installDir)) {
-                finalPackagesToInstall.push_back(pkgName);
+            if (!Completion::writeNameIndex(namesPath, names)) {
+                std::cerr << "Warning: Could not write " << namesPath << std::endl;
             }
         }
+        return true;
+    }
 
-        if (finalPackagesToInstall.empty()) {
-            std::cout << "All requested packages and dependencies are already installed."
-                      << std::endl;
-            return;
-        }
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::fetchPackages
+     *
+     * Downloads every package archive and its signature into the cache
+     * (skipping files that are already cached) and verifies each signature
+     * once against the keyring of keyringRoot.
+     * ------------------------------------------------------------------------
+     */
+    bool Installer::fetchPackages(const std::vector<ResolvedPackage>& packages,
+                                  const std::string& keyringRoot) {
 
-        std::cout << "Packages requiring installation/update (in order): ";
-        for (size_t i=0; i < finalPackagesToInstall.size(); ++i) {
-            std::cout << finalPackagesToInstall[i]
-                      << (i == finalPackagesToInstall.size()-1 ? "" : ", ");
-        }
-        std::cout << std::endl;
+        Trace::Span span("download", "fetch packages");
 
-        // Step 4.5: confirmation
-        if (confirm) {
-            std::cout << "[Confirm] User confirmation required..." << std::endl;
-            if (!Installer::getConfirmation(finalPackagesToInstall)) {
-                return;
+        // A cached archive is reused only if it is the indexed build. The
+        // check reads a recorded digest; archives without one are hashed,
+        // so it runs up to Jobs at a time
+        std::vector<std::string> expectedSha256(packages.size());
+        for (size_t i = 0; i < packages.size(); ++i) {
+            const YAML::Node& sha256 = packages[i].metadata["sha256"];
+            if (sha256 && sha256.IsScalar()) {
+                expectedSha256[i] = sha256.as<std::string>();
             }
-            std::cout << "Confirmation received. Proceeding..." << std::endl;
-        } else {
-            std::cout << "[Confirm] Skipping confirmation prompt (--noconfirm used)."
-                      << std::endl;
         }
+        parallelFor(packages.size(), Config::current().settings.workersFor(packages.size()),
+                    [&](size_t i) {
+            Cache::discardIfStale(packages[i].archivePath, expectedSha256[i]);
+        });
 
         // Step 5: Prepare downloads for package archives + signatures
-        downloadTasks.clear();
-        for (const auto &pkgName : finalPackagesToInstall) {
-            auto it = packageSourceCache.find(pkgName);
-            if (it == packageSourceCache.end()) {
-                std::cerr << "Internal Error: No source info found for required package '"
-                          << pkgName << "'. Aborting." << std::endl;
-                return;
-            }
-
-            YAML::Node pkgNode = it->second.second;
-            if (!pkgNode["file_name"] || !pkgNode["file_name"].IsScalar()) {
+        std::vector<std::pair<std::string, std::string>> downloadTasks;
+        for (const auto &pkg : packages) {
+            if (!pkg.metadata["file_name"] || !pkg.metadata["file_name"].IsScalar()) {
                 std::cerr << "Error: Missing 'file_name' in metadata for package '"
-                          << pkgName << "'. Aborting." << std::endl;
-                return;
+                          << pkg.name << "'. Aborting." << std::endl;
+                return false;
             }
 
-            std::string fileName = pkgNode["file_name"].as<std::string>();
-            std::string fileUrl  = it->second.first + fileName;
-            fs::path localPath   = cacheDirPath / fileName;
-
-            if (!fs::exists(localPath)) {
-                downloadTasks.push_back({ fileUrl, localPath.string() });
+            std::string fileUrl = pkg.repoUrl + pkg.metadata["file_name"].as<std::string>();
+            if (!fs::exists(pkg.archivePath)) {
+                downloadTasks.push_back({ fileUrl, pkg.archivePath });
             }
 
             std::string sigUrl = fileUrl + ".sig";
-            std::string sigLoc = localPath.string() + ".sig";
+            std::string sigLoc = pkg.archivePath + ".sig";
             if (!fs::exists(sigLoc)) {
                 downloadTasks.push_back({ sigUrl, sigLoc });
             }
         }
 
+        span.arg("files", static_cast<uint64_t>(downloadTasks.size()));
         if (!downloadTasks.empty()) {
             std::cout << "[5/8] Downloading required package files and signatures..."
                       << std::endl;
-            if (!downloadMultipleFilesMulti(downloadTasks)) {
+            if (!downloadWithMirrors(downloadTasks)) {
                 std::cerr << "Error: One or more package/signature downloads failed. "
                           << "Aborting installation." << std::endl;
-                return;
+                return false;
             }
             std::cout << "Downloads complete." << std::endl;
         } else {
@@ -2008,243 +1551,347 @@ namespace Starpack {
                       << std::endl;
         }
 
-        // Step 6: Verify signatures
+        // Step 6: Verify signatures, up to Jobs at a time
         std::cout << "[6/8] Verifying package signatures..." << std::endl;
-        for (const auto& packageName : finalPackagesToInstall) {
-            auto sourceCacheIt = packageSourceCache.find(packageName);
-            if (sourceCacheIt == packageSourceCache.end()) {
-                std::cerr << "Internal Error: Cache missing for '"
-                          << packageName
-                          << "' during verification. Aborting." << std::endl;
-                return;
+        for (const auto& pkg : packages) {
+            if (!fs::exists(pkg.archivePath)) {
+                std::cerr << "Error: Package file missing from cache after download: "
+                          << pkg.archivePath << ". Aborting." << std::endl;
+                return false;
+            }
+            if (!fs::exists(pkg.archivePath + ".sig")) {
+                std::cerr << "Error: Signature file missing from cache after download: "
+                          << pkg.archivePath << ".sig. Aborting." << std::endl;
+                return false;
             }
+        }
 
-            YAML::Node currentPackageNode = sourceCacheIt->second.second;
-            if (!currentPackageNode["file_name"] ||
-                !currentPackageNode["file_name"].IsScalar()) {
-                std::cerr << "Internal Error: Missing 'file_name' for '"
-                          << packageName
-                          << "' during verification. Aborting."
-                          << std::endl;
+        std::atomic<size_t> failed{0};
+        failed += parallelFor(packages.size(), Config::current().settings.workersFor(packages.size()),
+                              [&](size_t i) {
+            const ResolvedPackage& pkg = packages[i];
+            Trace::Span verifySpan("verify", "verify signature", pkg.name);
+            if (!verifyGPGSignature(pkg.archivePath, pkg.archivePath + ".sig", keyringRoot)) {
+                std::cerr << "Error: Signature verification failed for: "
+                          << pkg.name << "." << std::endl;
+                Metrics::addFailure("verify");
+                failed++;
                 return;
             }
+            Cache::recordDigest(pkg.archivePath);
+            std::cout << " -> Verifying " << pkg.name << "... OK" << std::endl;
+        });
+        if (failed > 0) {
+            std::cerr << "Error: " << failed << " signature(s) failed verification. Aborting."
+                      << std::endl;
+            return false;
+        }
+        std::cout << "All package signatures verified successfully." << std::endl;
+        return true;
+    }
 
-            std::string fileName            = currentPackageNode["file_name"].as<std::string>();
-            std::string packagePathInCache  = (cacheDirPath / fileName).string();
-            std::string sigPathInCache      = packagePathInCache + ".sig";
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::extractPackage
+     *
+     * Extracts the files/ section of one fetched package into installDir,
+     * propagates /etc/skel and installs the package's .hook files. Running
+     * hooks and recording the DB entry are left to the caller.
+     * ------------------------------------------------------------------------
+     */
+    bool Installer::extractPackage(const ResolvedPackage& package,
+                                   const std::string& installDir,
+                                   bool useObjectStore,
+                                   std::vector<StoredObject>& storedObjects) {
+
+        const std::string& packageName = package.name;
+        const YAML::Node& currentPackageNode = package.metadata;
+        const std::string& packagePathInCache = package.archivePath;
+        std::string cacheDir = (fs::path(installDir) /
+                                "var" / "lib" / "starpack" / "cache").string();
+        storedObjects.clear();
+        Trace::Span span("extract", "package", packageName);
+
+        // Extraction
+        std::cout << "  [" << installDir << "] -> Extracting package files..." << std::endl;
+        int stripComponents = 0;
+        if (currentPackageNode["strip_components"] &&
+            currentPackageNode["strip_components"].IsScalar()) {
+            try {
+                stripComponents = currentPackageNode["strip_components"].as<int>();
+            } catch (...) { //blank so it doesn't complain
+            }
+        }
 
-            if (!fs::exists(packagePathInCache)) {
-                std::cerr << "Error: Package file missing from cache after download: "
-                          << packagePathInCache << ". Aborting." << std::endl;
-                return;
+        std::vector<std::string> updateDirs;
+        if (currentPackageNode["update_dirs"] && currentPackageNode["update_dirs"].IsSequence()) {
+            for (const auto& dir : currentPackageNode["update_dirs"]) {
+                if (dir.IsScalar()) {
+                    updateDirs.push_back(dir.as<std::string>());
+                }
             }
-            if (!fs::exists(sigPathInCache)) {
-                std::cerr << "Error: Signature file missing from cache after download: "
-                          << sigPathInCache << ". Aborting." << std::endl;
-                return;
+        }
+
+        if (extract_archive_section(packagePathInCache,
+                                    "files/",
+                                    installDir,
+                                    std::max(0, stripComponents),
+                                    useObjectStore ? &storedObjects : nullptr,
+                                    updateDirs) != 0) {
+            std::cerr << "Error: Failed file extraction for package: "
+                      << packageName << ". Aborting." << std::endl;
+            return false;
+        }
+
+        // /etc/skel logic
+        std::cout << "  [" << installDir << "] -> Copying /etc/skel contents if present..." << std::endl;
+        fs::path skelDir = fs::path(installDir) / "etc" / "skel";
+        if (fs::exists(skelDir) && fs::is_directory(skelDir)) {
+            Trace::Span skelSpan("extract", "copy skel", packageName);
+            fs::path rootDir = fs::path(installDir) / "root";
+            copyTreeRecursively(skelDir, rootDir);
+
+            fs::path homeDir = fs::path(installDir) / "home";
+            if (fs::exists(homeDir) && fs::is_directory(homeDir)) {
+                for (auto &userHome : fs::directory_iterator(homeDir)) {
+                    if (userHome.is_directory()) {
+                        copyTreeRecursively(skelDir, userHome.path());
+                    }
+                }
             }
+        } else {
+            std::cout << "    (/etc/skel directory not present or invalid; skipping)"
+                      << std::endl;
+        }
 
-            std::cout << " -> Verifying " << packageName << "..." << std::flush;
-            if (!verifyGPGSignature(packagePathInCache, sigPathInCache, installDir)) {
-                std::cerr << "Error: Signature verification failed for: "
-                          << packageName << ". Aborting." << std::endl;
-                return;
+        // Hooks extraction
+        std::cout << "  [" << installDir << "] -> Installing hooks..." << std::endl;
+        std::string tempHooksExtractDir = generateTempFilename(packageName + "_hooks_",
+                                                               cacheDir);
+        int extractResult = extract_archive_section(packagePathInCache,
+                                                    "hooks/",
+                                                    tempHooksExtractDir,
+                                                    std::max(0, stripComponents));
+
+        if (extractResult == 0) {
+            fs::path hooksSourceDir(tempHooksExtractDir);
+            std::error_code ec_stat;
+
+            if (fs::is_directory(hooksSourceDir, ec_stat) && !ec_stat) {
+                fs::path packageHooksDestBase = fs::path(installDir) /
+                                                "etc" / "starpack" / "hooks";
+                fs::path packageHooksDestDir  = packageHooksDestBase /
+                                                packageName;
+                bool hooksFoundInDir = false;
+
+                try {
+                    fs::create_directories(packageHooksDestDir);
+                    for (const auto& entry : fs::directory_iterator(hooksSourceDir)) {
+                        std::error_code ec_file_stat;
+                        if (entry.is_regular_file(ec_file_stat) &&
+                            !ec_file_stat &&
+                            entry.path().extension() == ".hook") {
+
+                            hooksFoundInDir = true;
+                            fs::path srcPath  = entry.path();
+                            fs::path destPath = packageHooksDestDir / srcPath.filename();
+
+                            try {
+                                fs::copy(srcPath,
+                                         destPath,
+                                         fs::copy_options::overwrite_existing);
+                                Log::debug("   - Installed hook: " +
+                                           destPath.filename().string());
+                            } catch (const std::exception& copy_e) {
+                                std::cerr << "   - Error installing hook "
+                                          << srcPath.filename().string()
+                                          << ": " << copy_e.what()
+                                          << std::endl;
+                            }
+                        } else if (ec_file_stat) {
+                            std::cerr << "   - Warning: Could not stat "
+                                      << entry.path().string() << ": "
+                                      << ec_file_stat.message() << std::endl;
+                        }
+                    }
+                    if (!hooksFoundInDir) {
+                        std::cout << "   - No .hook files found in extracted hooks directory."
+                                  << std::endl;
+                    }
+                } catch (const std::exception& dir_e) {
+                    std::cerr << "Error processing extracted hooks directory "
+                              << hooksSourceDir.string() << ": "
+                              << dir_e.what() << std::endl;
+                }
+            } else {
+                if (ec_stat) {
+                    std::cerr << "   - Warning: Could not stat extracted hooks dir "
+                              << hooksSourceDir.string() << ": "
+                              << ec_stat.message() << std::endl;
+                } else {
+                    std::cout << "   - Extracted hooks directory is empty or invalid."
+                              << std::endl;
+                }
             }
-            std::cout << " OK" << std::endl;
+        } else {
+            std::cerr << "   - Warning: Failed to extract hooks section for "
+                      << packageName
+                      << " (archive might not contain hooks)."
+                      << std::endl;
         }
-        std::cout << "All package signatures verified successfully." << std::endl;
 
+        // Clean up hooks temp dir
+        std::error_code ec_rm;
+        if (fs::exists(tempHooksExtractDir)) {
+            fs::remove_all(tempHooksExtractDir, ec_rm);
+            if(ec_rm) {
+                std::cerr << "Warning: Failed to remove temporary hook directory "
+                          << tempHooksExtractDir
+                          << ": " << ec_rm.message() << std::endl;
+            }
+        }
+
+        // The archive is not needed again soon
+        LowImpact::dropFromCache(packagePathInCache, false);
+
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::packageFilePaths
+     * ------------------------------------------------------------------------
+     */
+    std::vector<std::string> Installer::packageFilePaths(const YAML::Node& packageNode) {
+        std::vector<std::string> paths;
+        if (packageNode["files"] && packageNode["files"].IsSequence()) {
+            for (const auto &fileNode : packageNode["files"]) {
+                if (fileNode.IsScalar()) {
+                    std::string relPath = fileNode.as<std::string>();
+                    if (!relPath.empty() && relPath[0] == '/') {
+                        relPath = relPath.substr(1);
+                    }
+                    if (!relPath.empty()) {
+                        paths.push_back(relPath);
+                    }
+                }
+            }
+        }
+        return paths;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::databaseNode
+     * ------------------------------------------------------------------------
+     */
+    YAML::Node Installer::databaseNode(const YAML::Node& packageNode,
+                                       const std::vector<StoredObject>& storedObjects) {
+        if (storedObjects.empty()) {
+            return packageNode;
+        }
+        YAML::Node dbNode = YAML::Clone(packageNode);
+        dbNode["object_store"] = ObjectStore::storeDir();
+        for (const auto& object : storedObjects) {
+            dbNode["objects"].push_back(object.id + " " + object.path);
+        }
+        return dbNode;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::installIntoRoot
+     *
+     * Extracts already fetched and verified packages into installDir in the
+     * given order, installs their hooks, records them in the root's DB and
+     * finally runs the PostInstall hooks.
+     * ------------------------------------------------------------------------
+     */
+    bool Installer::installIntoRoot(const std::vector<ResolvedPackage>& packages,
+                                    const std::string& installDir) {
+
+        // Ensure the root's local DB is set up
+        initializeDatabase(installDir);
 
         // Step 7: Install packages (extract, hooks, DB update)
-        std::cout << "[7/8] Installing packages..." << std::endl;
-        size_t totalToInstall = finalPackagesToInstall.size();
+        std::cout << "[7/8] Installing packages into " << installDir << "..." << std::endl;
+        size_t totalToInstall = packages.size();
+
+        // Deduplicate regular files through the object store if enabled
+        bool useObjectStore = ObjectStore::usableFor(installDir);
+        if (useObjectStore) {
+            std::cout << "Using object store " << ObjectStore::storeDir()
+                      << " for " << installDir << std::endl;
+        }
+
+        // Roots are installed in parallel, so per-package lines name their root
+        const std::string tag = "  [" + installDir + "]";
 
         // Storage for running PostInstall hooks afterwards
         std::vector<std::pair<std::string, std::vector<std::string>>> postInstallHooksData;
 
+        std::optional<Progress::Activity> progress;
+        progress.emplace("Installing", Progress::Unit::Items, totalToInstall);
         for (size_t i = 0; i < totalToInstall; ++i) {
-            const std::string &packageName = finalPackagesToInstall[i];
-            std::cout << "\n(" << (i + 1) << "/" << totalToInstall
+            const std::string &packageName = packages[i].name;
+            std::cout << "\n" << tag << " (" << (i + 1) << "/" << totalToInstall
                       << ") Installing " << packageName << "..." << std::endl;
 
             if (isPackageInstalled(packageName, installDir)) {
-                std::cout << "   Skipping already installed package: "
+                std::cout << tag << " Skipping already installed package: "
                           << packageName << std::endl;
-                printProgressBar(i + 1, totalToInstall);
+                progress->advance();
                 continue;
             }
 
-            auto sourceCacheIt = packageSourceCache.find(packageName);
-            YAML::Node currentPackageNode = sourceCacheIt->second.second;
-            std::string fileName          = currentPackageNode["file_name"].as<std::string>();
-            std::string packagePathInCache = (cacheDirPath / fileName).string();
+            const YAML::Node& currentPackageNode = packages[i].metadata;
+            Trace::Span packageSpan("install", "install", packageName);
 
             // PreInstall hooks
-            std::cout << " -> Running PreInstall hooks..." << std::endl;
+            std::cout << tag << " -> Running PreInstall hooks..." << std::endl;
             Hook::runNewStyleHooks("PreInstall",
                                    "Install",
                                    {},
                                    installDir,
                                    packageName);
 
-            // Extraction
-            std::cout << " -> Extracting package files..." << std::endl;
-            int stripComponents = 0;
-            if (currentPackageNode["strip_components"] &&
-                currentPackageNode["strip_components"].IsScalar()) {
-                try {
-                    stripComponents = currentPackageNode["strip_components"].as<int>();
-                } catch (...) { //blank so it doesn't complain
-                }
-            }
-
-            if (extract_archive_section(packagePathInCache,
-                                        "files/",
-                                        installDir,
-                                        std::max(0, stripComponents)) != 0) {
-                std::cerr << "Error: Failed file extraction for package: "
-                          << packageName << ". Aborting." << std::endl;
-                return;
-            }
-
-            // /etc/skel logic
-            std::cout << " -> Copying /etc/skel contents if present..." << std::endl;
-            fs::path skelDir = fs::path(installDir) / "etc" / "skel";
-            if (fs::exists(skelDir) && fs::is_directory(skelDir)) {
-                fs::path rootDir = fs::path(installDir) / "root";
-                copyTreeRecursively(skelDir, rootDir);
-
-                fs::path homeDir = fs::path(installDir) / "home";
-                if (fs::exists(homeDir) && fs::is_directory(homeDir)) {
-                    for (auto &userHome : fs::directory_iterator(homeDir)) {
-                        if (userHome.is_directory()) {
-                            copyTreeRecursively(skelDir, userHome.path());
-                        }
-                    }
-                }
-            } else {
-                std::cout << "    (/etc/skel directory not present or invalid; skipping)"
-                          << std::endl;
-            }
-
-            // Hooks extraction
-            std::cout << " -> Installing hooks..." << std::endl;
-            std::string tempHooksExtractDir = generateTempFilename(packageName + "_hooks_",
-                                                                   cacheDir);
-            int extractResult = extract_archive_section(packagePathInCache,
-                                                        "hooks/",
-                                                        tempHooksExtractDir,
-                                                        std::max(0, stripComponents));
-
-            if (extractResult == 0) {
-                fs::path hooksSourceDir(tempHooksExtractDir);
-                std::error_code ec_stat;
-
-                if (fs::is_directory(hooksSourceDir, ec_stat) && !ec_stat) {
-                    fs::path packageHooksDestBase = fs::path(installDir) /
-                                                    "etc" / "starpack" / "hooks";
-                    fs::path packageHooksDestDir  = packageHooksDestBase /
-                                                    packageName;
-                    bool hooksFoundInDir = false;
-
-                    try {
-                        fs::create_directories(packageHooksDestDir);
-                        for (const auto& entry : fs::directory_iterator(hooksSourceDir)) {
-                            std::error_code ec_file_stat;
-                            if (entry.is_regular_file(ec_file_stat) &&
-                                !ec_file_stat &&
-                                entry.path().extension() == ".hook") {
-
-                                hooksFoundInDir = true;
-                                fs::path srcPath  = entry.path();
-                                fs::path destPath = packageHooksDestDir / srcPath.filename();
-
-                                try {
-                                    fs::copy(srcPath,
-                                             destPath,
-                                             fs::copy_options::overwrite_existing);
-                                    std::cout << "   - Installed hook: "
-                                              << destPath.filename().string()
-                                              << std::endl;
-                                } catch (const std::exception& copy_e) {
-                                    std::cerr << "   - Error installing hook "
-                                              << srcPath.filename().string()
-                                              << ": " << copy_e.what()
-                                              << std::endl;
-                                }
-                            } else if (ec_file_stat) {
-                                std::cerr << "   - Warning: Could not stat "
-                                          << entry.path().string() << ": "
-                                          << ec_file_stat.message() << std::endl;
-                            }
-                        }
-                        if (!hooksFoundInDir) {
-                            std::cout << "   - No .hook files found in extracted hooks directory."
-                                      << std::endl;
-                        }
-                    } catch (const std::exception& dir_e) {
-                        std::cerr << "Error processing extracted hooks directory "
-                                  << hooksSourceDir.string() << ": "
-                                  << dir_e.what() << std::endl;
-                    }
-                } else {
-                    if (ec_stat) {
-                        std::cerr << "   - Warning: Could not stat extracted hooks dir "
-                                  << hooksSourceDir.string() << ": "
-                                  << ec_stat.message() << std::endl;
-                    } else {
-                        std::cout << "   - Extracted hooks directory is empty or invalid."
-                                  << std::endl;
-                    }
-                }
-            } else {
-                std::cerr << "   - Warning: Failed to extract hooks section for "
-                          << packageName
-                          << " (archive might not contain hooks)."
-                          << std::endl;
+            // Extraction, /etc/skel and package hooks
+            std::vector<StoredObject> storedObjects;
+            if (!extractPackage(packages[i], installDir, useObjectStore, storedObjects)) {
+                Metrics::addFailure("extract");
+                return false;
             }
 
-            // Clean up hooks temp dir
-            std::error_code ec_rm;
-            if (fs::exists(tempHooksExtractDir)) {
-                fs::remove_all(tempHooksExtractDir, ec_rm);
-                if(ec_rm) {
-                    std::cerr << "Warning: Failed to remove temporary hook directory "
-                              << tempHooksExtractDir
-                              << ": " << ec_rm.message() << std::endl;
-                }
+            // With Durability = full the files reach the disk before the DB
+            // says the package is installed
+            if (Config::current().settings.durability == Durability::Full &&
+                !syncFileSystem(installDir)) {
+                std::cerr << "Warning: Could not sync " << installDir << std::endl;
             }
 
             // Collect installed file paths for PostInstall hook
-            std::vector<std::string> installedPathsForHook;
-            if (currentPackageNode["files"] && currentPackageNode["files"].IsSequence()) {
-                for (const auto &fileNode : currentPackageNode["files"]) {
-                    if (fileNode.IsScalar()) {
-                        std::string relPath = fileNode.as<std::string>();
-                        if (!relPath.empty() && relPath[0] == '/') {
-                            relPath = relPath.substr(1);
-                        }
-                        if (!relPath.empty()) {
-                            installedPathsForHook.push_back(relPath);
-                        }
-                    }
-                }
-            }
+            std::vector<std::string> installedPathsForHook = packageFilePaths(currentPackageNode);
 
             // Update the local DB
-            std::cout << " -> Updating installation database..." << std::endl;
-            createDatabaseEntry(packageName, installDir, currentPackageNode);
+            std::cout << tag << " -> Updating installation database..." << std::endl;
+            createDatabaseEntry(packageName, installDir,
+                                databaseNode(currentPackageNode, storedObjects));
 
             // Record data for post-install hooks
             postInstallHooksData.push_back({ packageName, installedPathsForHook });
 
             // Done with this package
-            std::cout << " -> Finished installing " << packageName << std::endl;
-            printProgressBar(i + 1, totalToInstall);
+            Metrics::addPackageChange("install");
+            std::cout << tag << " -> Finished installing " << packageName << std::endl;
+            progress->advance();
         }
 
+        progress.reset();
+
         // Step 7.5: PostInstall hooks
-        std::cout << "\n[7.5/8] Running PostInstall hooks for all installed packages..." << std::endl;
+        std::cout << "\n[7.5/8] Running PostInstall hooks for the packages installed into "
+                  << installDir << "..." << std::endl;
+        Trace::Span hooksSpan("hook", "PostInstall hooks");
         size_t totalHooksExecuted = 0;
 
         for (const auto& data : postInstallHooksData) {
@@ -2261,7 +1908,7 @@ namespace Starpack {
 
             // Only print a note if something actually ran
             if (hooksExecutedForPackage > 0) {
-                std::cout << " -> Finished PostInstall hooks for package: "
+                std::cout << tag << " -> Finished PostInstall hooks for package: "
                           << pkgName << " ("
                           << hooksExecutedForPackage << " hook(s) executed)"
                           << std::endl;
@@ -2269,8 +1916,189 @@ namespace Starpack {
             }
         }
 
+        std::cout << " -> " << installDir << ": " << postInstallHooksData.size()
+                  << " package(s) installed, " << totalHooksExecuted
+                  << " PostInstall hook(s) executed." << std::endl;
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::installPackage
+     *
+     * Single-root convenience wrapper around the multi-root installer.
+     * ------------------------------------------------------------------------
+     */
+    void Installer::installPackage(const std::vector<std::string>& initialPackageNames,
+                                   const std::string& installDir,
+                                   bool confirm) {
+        installPackage(initialPackageNames, std::vector<std::string>{installDir}, confirm);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Installer::installPackage (multiple roots)
+     *
+     * The main method that orchestrates package installation, including
+     * repository lookup, dependency resolution, file downloading, signature
+     * verification, extraction, and hooking into Pre/Post install steps.
+     *
+     * Repository loading, resolution, downloads and signature checks happen
+     * once for all roots; the first root's cache and keyring are shared.
+     * Extraction and DB commits then run for every root in parallel.
+     * ------------------------------------------------------------------------
+     */
+    void Installer::installPackage(const std::vector<std::string>& initialPackageNames,
+                                   const std::vector<std::string>& installDirs,
+                                   bool confirm) {
+
+        std::cout << "--- Starpack Installation ---" << std::endl;
+        if (installDirs.empty()) {
+            std::cerr << "Error: No installation directory given." << std::endl;
+            return;
+        }
+        for (const auto& installDir : installDirs) {
+            std::cout << "Target directory: " << installDir << std::endl;
+            // Ensure our local DB is set up
+            initializeDatabase(installDir);
+        }
+
+        // Downloads and keys are shared through the first root
+        const std::string& cacheRoot = installDirs.front();
+        fs::path cacheDirPath = fs::path(cacheRoot) /
+                                "var" / "lib" / "starpack" / "cache";
+
+        // Steps 1-3: repositories
+        PackageSourceCache packageSourceCache;
+        if (!loadRepositoryIndex(cacheDirPath.string(), packageSourceCache)) {
+            Metrics::addFailure("index");
+            return;
+        }
+
+        // Checks whether a package is recorded in every target root
+        auto installedEverywhere = [&](const std::string& pkgName) {
+            for (const auto& installDir : installDirs) {
+                if (!isPackageInstalled(pkgName, installDir)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Step 4: Resolve dependencies
+        std::cout << "[4/8] Resolving dependencies..." << std::endl;
+        std::vector<std::string> sortedPackages;
+        if (!resolveDependencies(initialPackageNames, packageSourceCache,
+                                 installedEverywhere, sortedPackages)) {
+            Metrics::addFailure("resolve");
+            return;
+        }
+
+        // Per-root plans: everything in order that the root does not have yet.
+        // The union of all plans is what gets downloaded and verified.
+        std::vector<std::vector<ResolvedPackage>> rootPlans(installDirs.size());
+        std::vector<ResolvedPackage> fetchPlan;
+        std::vector<std::string> finalPackagesToInstall;
+        for (const auto &pkgName : sortedPackages) {
+            auto it = packageSourceCache.find(pkgName);
+
+            bool neededSomewhere = false;
+            for (size_t r = 0; r < installDirs.size(); ++r) {
+                if (isPackageInstalled(pkgName, installDirs[r])) {
+                    continue;
+                }
+                if (it == packageSourceCache.end()) {
+                    std::cerr << "Internal Error: No source info found for required package '"
+                              << pkgName << "'. Aborting." << std::endl;
+                    return;
+                }
+                if (!it->second.second["file_name"] ||
+                    !it->second.second["file_name"].IsScalar()) {
+                    std::cerr << "Error: Missing 'file_name' in metadata for package '"
+                              << pkgName << "'. Aborting." << std::endl;
+                    return;
+                }
+                ResolvedPackage resolved;
+                resolved.name        = pkgName;
+                resolved.repoUrl     = it->second.first;
+                resolved.metadata    = it->second.second;
+                resolved.archivePath = (cacheDirPath /
+                                        it->second.second["file_name"].as<std::string>()).string();
+                rootPlans[r].push_back(resolved);
+                if (!neededSomewhere) {
+                    fetchPlan.push_back(resolved);
+                    finalPackagesToInstall.push_back(pkgName);
+                    neededSomewhere = true;
+                }
+            }
+        }
+
+        if (finalPackagesToInstall.empty()) {
+            std::cout << "All requested packages and dependencies are already installed."
+                      << std::endl;
+            return;
+        }
+
+        std::cout << "Packages requiring installation/update (in order): ";
+        for (size_t i=0; i < finalPackagesToInstall.size(); ++i) {
+            std::cout << finalPackagesToInstall[i]
+                      << (i == finalPackagesToInstall.size()-1 ? "" : ", ");
+        }
+        std::cout << std::endl;
+        if (installDirs.size() > 1) {
+            for (size_t r = 0; r < installDirs.size(); ++r) {
+                std::cout << "  " << installDirs[r] << ": "
+                          << rootPlans[r].size() << " package(s)" << std::endl;
+            }
+        }
+
+        // Step 4.5: confirmation
+        if (confirm) {
+            std::cout << "[Confirm] User confirmation required..." << std::endl;
+            if (!Installer::getConfirmation(finalPackagesToInstall)) {
+                return;
+            }
+            std::cout << "Confirmation received. Proceeding..." << std::endl;
+        } else {
+            std::cout << "[Confirm] Skipping confirmation prompt (--noconfirm used)."
+                      << std::endl;
+        }
+
+        // Steps 5-6: download and verify once for every root
+        if (!fetchPackages(fetchPlan, cacheRoot)) {
+            return;
+        }
+
+        // Step 7: fan out extraction and DB commits across the roots. A root
+        // whose install throws stays marked as failed; the others finish
+        std::vector<char> rootResults(installDirs.size(), 0);
+        parallelFor(installDirs.size(), Config::current().settings.workersFor(installDirs.size()),
+                    [&](size_t r) {
+            if (rootPlans[r].empty()) {
+                rootResults[r] = 1;
+                return;
+            }
+            rootResults[r] = installIntoRoot(rootPlans[r], installDirs[r]) ? 1 : 0;
+        });
+
+        size_t failedRoots = 0;
+        for (size_t r = 0; r < installDirs.size(); ++r) {
+            if (!rootResults[r]) {
+                std::cerr << "Error: Installation failed for root: "
+                          << installDirs[r] << std::endl;
+                failedRoots++;
+            }
+        }
+
         // Step 8: Done
         std::cout << "[8/8] Installation process finished." << std::endl;
+        Cache::enforceLimits(cacheDirPath.string());
+        if (failedRoots > 0) {
+            std::cout << "--- Installation finished with errors in "
+                      << failedRoots << " of " << installDirs.size()
+                      << " root(s) ---" << std::endl;
+            return;
+        }
         std::cout << "--- Installation Complete ---" << std::endl;
     }
 
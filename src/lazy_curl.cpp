@@ -0,0 +1,254 @@
+//============================================================================
+// Includes
+//============================================================================
+
+// The stubs below are the definitions of curl_easy_setopt & co, so the
+// type-checking macros of typecheck-gcc.h must not rename them
+#define CURL_DISABLE_TYPECHECK
+
+#include "lazy_curl.hpp"       // Class definition
+
+#include <curl/curl.h>         // Types and prototypes of the forwarded API
+
+#ifdef STARPACK_LAZY_CURL
+
+#include <iostream>            // Standard I/O (cerr)
+#include <mutex>               // std::call_once
+#include <atomic>              // Load state
+#include <cstdarg>             // va_list
+#include <cstdlib>             // std::getenv
+#include <dlfcn.h>             // dlopen, dlsym
+
+#define STARPACK_HIDDEN __attribute__((visibility("hidden")))
+
+namespace Starpack {
+
+    namespace {
+
+        /**
+         * -------------------------------------------------------------------
+         * CurlApi
+         *
+         * The libcurl entry points Starpack calls, resolved from the
+         * dlopen()ed library.
+         * -------------------------------------------------------------------
+         */
+        struct CurlApi {
+            CURLcode    (*global_init)(long);
+            void        (*global_cleanup)(void);
+            CURL*       (*easy_init)(void);
+            CURLcode    (*easy_setopt)(CURL*, CURLoption, ...);
+            CURLcode    (*easy_perform)(CURL*);
+            CURLcode    (*easy_getinfo)(CURL*, CURLINFO, ...);
+            void        (*easy_cleanup)(CURL*);
+            const char* (*easy_strerror)(CURLcode);
+            CURLM*      (*multi_init)(void);
+            CURLMcode   (*multi_add_handle)(CURLM*, CURL*);
+            CURLMcode   (*multi_remove_handle)(CURLM*, CURL*);
+            CURLMcode   (*multi_perform)(CURLM*, int*);
+            CURLMcode   (*multi_fdset)(CURLM*, fd_set*, fd_set*, fd_set*, int*);
+            CURLMsg*    (*multi_info_read)(CURLM*, int*);
+            CURLMcode   (*multi_cleanup)(CURLM*);
+            const char* (*multi_strerror)(CURLMcode);
+        };
+
+        CurlApi           g_api{};
+        std::once_flag    g_loadOnce;
+        std::atomic<bool> g_loaded{false};
+
+        const char* const kUnavailable = "libcurl could not be loaded";
+
+        template <typename Fn>
+        bool resolve(void* handle, const char* name, Fn& target) {
+            target = reinterpret_cast<Fn>(dlsym(handle, name));
+            return target != nullptr;
+        }
+
+        void loadLibrary() {
+            const char* candidates[] = {
+                std::getenv("STARPACK_LIBCURL"),
+                "libcurl.so.4", "libcurl-gnutls.so.4", "libcurl.so"
+            };
+
+            void* handle = nullptr;
+            for (const char* name : candidates) {
+                if (name && *name && (handle = dlopen(name, RTLD_NOW | RTLD_LOCAL))) {
+                    break;
+                }
+            }
+            if (!handle) {
+                std::cerr << "Error: Network support is unavailable: cannot load libcurl ("
+                          << dlerror() << ")." << std::endl;
+                return;
+            }
+
+            bool ok = resolve(handle, "curl_global_init",         g_api.global_init)
+                   && resolve(handle, "curl_global_cleanup",      g_api.global_cleanup)
+                   && resolve(handle, "curl_easy_init",           g_api.easy_init)
+                   && resolve(handle, "curl_easy_setopt",         g_api.easy_setopt)
+                   && resolve(handle, "curl_easy_perform",        g_api.easy_perform)
+                   && resolve(handle, "curl_easy_getinfo",        g_api.easy_getinfo)
+                   && resolve(handle, "curl_easy_cleanup",        g_api.easy_cleanup)
+                   && resolve(handle, "curl_easy_strerror",       g_api.easy_strerror)
+                   && resolve(handle, "curl_multi_init",          g_api.multi_init)
+                   && resolve(handle, "curl_multi_add_handle",    g_api.multi_add_handle)
+                   && resolve(handle, "curl_multi_remove_handle", g_api.multi_remove_handle)
+                   && resolve(handle, "curl_multi_perform",       g_api.multi_perform)
+                   && resolve(handle, "curl_multi_fdset",         g_api.multi_fdset)
+                   && resolve(handle, "curl_multi_info_read",     g_api.multi_info_read)
+                   && resolve(handle, "curl_multi_cleanup",       g_api.multi_cleanup)
+                   && resolve(handle, "curl_multi_strerror",      g_api.multi_strerror);
+            if (!ok) {
+                std::cerr << "Error: Network support is unavailable: incompatible libcurl ("
+                          << dlerror() << ")." << std::endl;
+                dlclose(handle);
+                return;
+            }
+
+            // Done before any thread can issue a transfer (curl_global_init is
+            // not thread-safe in older libcurl releases)
+            g_api.global_init(CURL_GLOBAL_DEFAULT);
+            g_loaded = true;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * LazyCurl::load / loaded
+     * ------------------------------------------------------------------------
+     */
+    bool LazyCurl::load() {
+        std::call_once(g_loadOnce, loadLibrary);
+        return g_loaded;
+    }
+
+    bool LazyCurl::loaded() {
+        return g_loaded;
+    }
+
+} // namespace Starpack
+
+//============================================================================
+// Forwarding stubs
+//============================================================================
+
+using Starpack::g_api;
+using Starpack::LazyCurl;
+
+extern "C" {
+
+STARPACK_HIDDEN CURLcode curl_global_init(long flags) {
+    // load() already initialises libcurl; repeated calls are reference counted
+    return LazyCurl::load() ? g_api.global_init(flags) : CURLE_FAILED_INIT;
+}
+
+STARPACK_HIDDEN void curl_global_cleanup(void) {
+    if (LazyCurl::loaded()) {
+        g_api.global_cleanup();
+    }
+}
+
+STARPACK_HIDDEN CURL* curl_easy_init(void) {
+    return LazyCurl::load() ? g_api.easy_init() : nullptr;
+}
+
+/*
+ * curl_easy_setopt is variadic; the option number encodes the type of its
+ * argument (see CURLOPTTYPE_* in curl.h), so it can be forwarded exactly.
+ */
+STARPACK_HIDDEN CURLcode curl_easy_setopt(CURL* handle, CURLoption option, ...) {
+    if (!LazyCurl::loaded()) {
+        return CURLE_FAILED_INIT;
+    }
+    va_list args;
+    va_start(args, option);
+    CURLcode result;
+    if (option < CURLOPTTYPE_OBJECTPOINT) {
+        result = g_api.easy_setopt(handle, option, va_arg(args, long));
+    } else if (option < CURLOPTTYPE_FUNCTIONPOINT) {
+        result = g_api.easy_setopt(handle, option, va_arg(args, void*));
+    } else if (option < CURLOPTTYPE_OFF_T) {
+        result = g_api.easy_setopt(handle, option, va_arg(args, void (*)(void)));
+    } else if (option < CURLOPTTYPE_BLOB) {
+        result = g_api.easy_setopt(handle, option, va_arg(args, curl_off_t));
+    } else {
+        result = g_api.easy_setopt(handle, option, va_arg(args, void*));
+    }
+    va_end(args);
+    return result;
+}
+
+STARPACK_HIDDEN CURLcode curl_easy_perform(CURL* handle) {
+    return LazyCurl::loaded() ? g_api.easy_perform(handle) : CURLE_FAILED_INIT;
+}
+
+// Every CURLINFO_* result is returned through a pointer
+STARPACK_HIDDEN CURLcode curl_easy_getinfo(CURL* handle, CURLINFO info, ...) {
+    if (!LazyCurl::loaded()) {
+        return CURLE_FAILED_INIT;
+    }
+    va_list args;
+    va_start(args, info);
+    CURLcode result = g_api.easy_getinfo(handle, info, va_arg(args, void*));
+    va_end(args);
+    return result;
+}
+
+STARPACK_HIDDEN void curl_easy_cleanup(CURL* handle) {
+    if (LazyCurl::loaded()) {
+        g_api.easy_cleanup(handle);
+    }
+}
+
+STARPACK_HIDDEN const char* curl_easy_strerror(CURLcode code) {
+    return LazyCurl::loaded() ? g_api.easy_strerror(code) : Starpack::kUnavailable;
+}
+
+STARPACK_HIDDEN CURLM* curl_multi_init(void) {
+    return LazyCurl::load() ? g_api.multi_init() : nullptr;
+}
+
+STARPACK_HIDDEN CURLMcode curl_multi_add_handle(CURLM* multi, CURL* handle) {
+    return LazyCurl::loaded() ? g_api.multi_add_handle(multi, handle) : CURLM_INTERNAL_ERROR;
+}
+
+STARPACK_HIDDEN CURLMcode curl_multi_remove_handle(CURLM* multi, CURL* handle) {
+    return LazyCurl::loaded() ? g_api.multi_remove_handle(multi, handle) : CURLM_INTERNAL_ERROR;
+}
+
+STARPACK_HIDDEN CURLMcode curl_multi_perform(CURLM* multi, int* running) {
+    return LazyCurl::loaded() ? g_api.multi_perform(multi, running) : CURLM_INTERNAL_ERROR;
+}
+
+STARPACK_HIDDEN CURLMcode curl_multi_fdset(CURLM* multi, fd_set* readFds, fd_set* writeFds,
+                                           fd_set* excFds, int* maxFd) {
+    return LazyCurl::loaded() ? g_api.multi_fdset(multi, readFds, writeFds, excFds, maxFd)
+                              : CURLM_INTERNAL_ERROR;
+}
+
+STARPACK_HIDDEN CURLMsg* curl_multi_info_read(CURLM* multi, int* queued) {
+    return LazyCurl::loaded() ? g_api.multi_info_read(multi, queued) : nullptr;
+}
+
+STARPACK_HIDDEN CURLMcode curl_multi_cleanup(CURLM* multi) {
+    return LazyCurl::loaded() ? g_api.multi_cleanup(multi) : CURLM_INTERNAL_ERROR;
+}
+
+STARPACK_HIDDEN const char* curl_multi_strerror(CURLMcode code) {
+    return LazyCurl::loaded() ? g_api.multi_strerror(code) : Starpack::kUnavailable;
+}
+
+} // extern "C"
+
+#else // !STARPACK_LAZY_CURL
+
+namespace Starpack {
+
+    // Linked against libcurl directly: nothing to load
+    bool LazyCurl::load()   { return true; }
+    bool LazyCurl::loaded() { return true; }
+
+} // namespace Starpack
+
+#endif // STARPACK_LAZY_CURL
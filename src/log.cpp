@@ -0,0 +1,501 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "log.hpp"             // Class definition
+#include "trace.hpp"           // Trace::quote for JSON strings
+#include "utils.hpp"           // Console colors
+
+#include <iostream>            // std::cout, std::cerr
+#include <streambuf>           // Line-buffering stream buffer
+#include <thread>              // Flusher thread
+#include <mutex>               // Flusher wake-up
+#include <condition_variable>  // Flusher wake-up
+#include <chrono>              // Record timestamps
+#include <memory>              // Ring storage
+#include <vector>              // Write batches
+#include <ctime>               // gmtime_r
+#include <cerrno>              // errno
+#include <unistd.h>            // write
+#include <pthread.h>           // pthread_atfork
+
+namespace Starpack {
+
+    namespace {
+
+        enum class Kind : uint8_t {
+            Line,       // complete line from a stream, including '\n'
+            Partial,    // explicitly flushed text without '\n' (prompt, progress)
+            Message     // Log::write, tagged with its level in text format
+        };
+
+        struct Record {
+            uint64_t    timeUs = 0;
+            uint32_t    thread = 0;
+            Log::Level  level  = Log::Level::Info;
+            Kind        kind   = Kind::Line;
+            int         fd     = 1;
+            std::string text;
+        };
+
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};
+            Record                record;
+        };
+
+        constexpr uint64_t kCapacity = 8192;   // power of two
+        constexpr uint64_t kMask     = kCapacity - 1;
+
+        std::unique_ptr<Slot[]> g_slots;
+        std::atomic<uint64_t>   g_tail{0};     // next position to claim (producers)
+        uint64_t                g_head = 0;    // next position to read (flusher only)
+        std::atomic<uint64_t>   g_written{0};  // records written so far
+        std::atomic<uint64_t>   g_dropped{0};
+
+        std::atomic<bool>       g_async{false};
+        std::atomic<bool>       g_stopping{false};
+        std::atomic<bool>       g_sleeping{false};
+        Log::Format             g_format = Log::Format::Text;
+        std::thread             g_flusher;
+        std::mutex              g_wakeMutex;
+        std::condition_variable g_wake;
+
+        std::streambuf*         g_originalOut = nullptr;
+        std::streambuf*         g_originalErr = nullptr;
+        bool                    g_atforkRegistered = false;
+        bool                    g_viewShown = false;   // a '\r' redraw ends the terminal output
+
+        uint32_t threadNumber() {
+            static std::atomic<uint32_t> next{0};
+            thread_local uint32_t number = ++next;
+            return number;
+        }
+
+        uint64_t wallClockMicros() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        void writeAll(int fd, const std::string& data) {
+            const char* p = data.data();
+            size_t left = data.size();
+            while (left > 0) {
+                ssize_t n = ::write(fd, p, left);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return; // Nowhere left to report a console error
+                }
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+        }
+
+        /**
+         * Text without ANSI escape sequences and, for a line redrawn with
+         * '\r', only its last state.
+         */
+        std::string plainText(const std::string& text) {
+            size_t from = text.rfind('\r');
+            from = (from == std::string::npos) ? 0 : from + 1;
+            std::string out;
+            out.reserve(text.size() - from);
+            for (size_t i = from; i < text.size(); i++) {
+                if (text[i] == '\033' && i + 1 < text.size() && text[i + 1] == '[') {
+                    i += 2;
+                    while (i < text.size() && !(text[i] >= '@' && text[i] <= '~')) i++;
+                    continue;
+                }
+                if (text[i] == '\n') continue;
+                out += text[i];
+            }
+            return out;
+        }
+
+        const char* levelName(Log::Level level) {
+            switch (level) {
+                case Log::Level::Debug: return "debug";
+                case Log::Level::Info:  return "info";
+                case Log::Level::Warn:  return "warn";
+                case Log::Level::Error: return "error";
+            }
+            return "info";
+        }
+
+        /**
+         * Appends the rendered record to out and returns the descriptor it
+         * belongs on, or -1 if the record renders to nothing.
+         */
+        int render(const Record& record, std::string& out) {
+            if (g_format == Log::Format::Json) {
+                std::string message = plainText(record.text);
+                if (message.empty() && record.kind != Kind::Message) return -1;
+
+                time_t seconds = static_cast<time_t>(record.timeUs / 1000000);
+                struct tm utc;
+                gmtime_r(&seconds, &utc);
+                char stamp[40];
+                size_t len = strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &utc);
+                snprintf(stamp + len, sizeof(stamp) - len, ".%03uZ",
+                         static_cast<unsigned>((record.timeUs / 1000) % 1000));
+
+                out += "{\"time\":\"";
+                out += stamp;
+                out += "\",\"level\":\"";
+                out += levelName(record.level);
+                out += "\",\"thread\":";
+                out += std::to_string(record.thread);
+                out += ",\"message\":";
+                out += Trace::quote(message);
+                out += "}\n";
+                return 1;
+            }
+
+            // A line printed while a progress view is drawn replaces it; the
+            // renderer draws the view again below on its next tick
+            bool redraw = record.kind == Kind::Partial &&
+                          record.text.find('\r') != std::string::npos;
+            if (redraw) {
+                g_viewShown = !plainText(record.text).empty();
+            } else if (g_viewShown) {
+                out += "\r\033[K";
+                g_viewShown = false;
+            }
+
+            if (record.kind != Kind::Message) {
+                out += record.text;
+                return record.fd;
+            }
+            switch (record.level) {
+                case Log::Level::Debug: out += "[DEBUG] "; break;
+                case Log::Level::Info:  out += COLOR_INFO  "[INFO] "  COLOR_RESET; break;
+                case Log::Level::Warn:  out += COLOR_WARN  "[WARN] "  COLOR_RESET; break;
+                case Log::Level::Error: out += COLOR_ERROR "[ERROR] " COLOR_RESET; break;
+            }
+            out += record.text;
+            out += '\n';
+            return 2;
+        }
+
+        void writeDirect(const Record& record) {
+            std::string out;
+            int fd = render(record, out);
+            if (fd >= 0) writeAll(fd, out);
+        }
+
+        void wakeFlusher() {
+            std::lock_guard<std::mutex> lock(g_wakeMutex);
+            g_wake.notify_one();
+        }
+
+        bool recordAvailable() {
+            return g_slots[g_head & kMask].sequence.load(std::memory_order_acquire) == g_head + 1;
+        }
+
+        /**
+         * Queues a record (bounded MPSC ring with per-slot sequence numbers).
+         * A full ring drops Debug records and makes other levels wait for
+         * the flusher, so memory stays bounded.
+         */
+        void push(Record&& record, bool urgent) {
+            if (!g_async.load(std::memory_order_acquire)) {
+                writeDirect(record);
+                return;
+            }
+            for (;;) {
+                uint64_t position = g_tail.load(std::memory_order_relaxed);
+                Slot& slot = g_slots[position & kMask];
+                uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+                if (difference == 0) {
+                    if (g_tail.compare_exchange_weak(position, position + 1,
+                                                     std::memory_order_relaxed)) {
+                        slot.record = std::move(record);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        break;
+                    }
+                }
+                else if (difference < 0) {
+                    if (record.level == Log::Level::Debug) {
+                        g_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    wakeFlusher();
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (urgent || g_sleeping.load(std::memory_order_relaxed)) {
+                wakeFlusher();
+            }
+        }
+
+        /**
+         * Writes everything currently in the ring, batching consecutive
+         * records for the same descriptor into one write().
+         */
+        void drain() {
+            int batchFd = -1;
+            std::string batch;
+            uint64_t taken = 0;
+            while (recordAvailable()) {
+                Slot& slot = g_slots[g_head & kMask];
+                Record record = std::move(slot.record);
+                slot.sequence.store(g_head + kCapacity, std::memory_order_release);
+                g_head++;
+                taken++;
+
+                std::string out;
+                int fd = render(record, out);
+                if (fd < 0) continue;
+                if (fd != batchFd && !batch.empty()) {
+                    writeAll(batchFd, batch);
+                    batch.clear();
+                }
+                batchFd = fd;
+                batch += out;
+                if (batch.size() >= 64 * 1024) {
+                    writeAll(batchFd, batch);
+                    batch.clear();
+                }
+            }
+            if (!batch.empty()) writeAll(batchFd, batch);
+            if (taken > 0) g_written.store(g_head, std::memory_order_release);
+        }
+
+        void flusherMain() {
+            for (;;) {
+                drain();
+                if (g_stopping.load(std::memory_order_acquire)) {
+                    drain();
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(g_wakeMutex);
+                g_sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                g_wake.wait_for(lock, std::chrono::milliseconds(100), [] {
+                    return recordAvailable() || g_stopping.load(std::memory_order_acquire);
+                });
+                g_sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        Log::Level streamLevel(int fd, const std::string& line) {
+            if (fd == 1) return Log::Level::Info;
+            std::string text = plainText(line);
+            size_t start = text.find_first_not_of(" \t");
+            if (start != std::string::npos &&
+                (text.compare(start, 7, "Warning") == 0 || text.compare(start, 6, "[WARN]") == 0)) {
+                return Log::Level::Warn;
+            }
+            return Log::Level::Error;
+        }
+
+        bool looksLikePrompt(const std::string& text) {
+            size_t end = text.find_last_not_of(" \t");
+            return end != std::string::npos && (text[end] == ':' || text[end] == '?');
+        }
+
+        void pushStreamText(int fd, std::string&& text, Kind kind) {
+            Record record;
+            record.kind = kind;
+            record.fd = fd;
+            record.level = streamLevel(fd, text);
+            if (kind == Kind::Partial) {
+                // Prompts are always shown; progress redraws only with
+                // normal verbosity on a text console
+                bool redraw = text.find('\r') != std::string::npos;
+                if (redraw && (g_format == Log::Format::Json || !Log::enabled(Log::Level::Info))) {
+                    return;
+                }
+            }
+            else if (!Log::enabled(record.level)) {
+                return;
+            }
+            record.timeUs = wallClockMicros();
+            record.thread = threadNumber();
+            record.text = std::move(text);
+            push(std::move(record), kind == Kind::Partial);
+        }
+
+        /**
+         * Text written by this thread that does not end a line yet, per
+         * descriptor; left over text is queued when the thread exits.
+         */
+        struct PendingText {
+            std::string text[3];
+            ~PendingText() {
+                for (int fd = 1; fd <= 2; fd++) {
+                    if (!text[fd].empty()) {
+                        pushStreamText(fd, std::move(text[fd]), Kind::Partial);
+                    }
+                }
+            }
+        };
+
+        std::string& pendingText(int fd) {
+            thread_local PendingText pending;
+            return pending.text[fd];
+        }
+
+        /**
+         * Stream buffer without a put area: every write is appended to the
+         * calling thread's pending text, and each completed line is queued
+         * as its own record.
+         */
+        class LineBuffer : public std::streambuf {
+        public:
+            explicit LineBuffer(int fd) : fd_(fd) {}
+
+        protected:
+            int_type overflow(int_type c) override {
+                if (traits_type::eq_int_type(c, traits_type::eof())) {
+                    return traits_type::not_eof(c);
+                }
+                char ch = traits_type::to_char_type(c);
+                append(&ch, 1);
+                return c;
+            }
+
+            std::streamsize xsputn(const char* s, std::streamsize n) override {
+                append(s, static_cast<size_t>(n));
+                return n;
+            }
+
+            int sync() override {
+                // In Json format a record is a whole line; a prompt is shown
+                // together with the rest of its line. Quiet output keeps the
+                // start of a status line until it is complete (and filtered)
+                // unless it asks a question.
+                std::string& pending = pendingText(fd_);
+                if (!pending.empty() && g_format == Log::Format::Text &&
+                    (fd_ == 2 || Log::enabled(Log::Level::Info) || looksLikePrompt(pending))) {
+                    pushStreamText(fd_, std::move(pending), Kind::Partial);
+                    pending.clear();
+                }
+                return 0;
+            }
+
+        private:
+            void append(const char* s, size_t n) {
+                std::string& pending = pendingText(fd_);
+                size_t scanFrom = pending.size();
+                pending.append(s, n);
+                size_t lineStart = 0;
+                size_t newline;
+                while ((newline = pending.find('\n', scanFrom)) != std::string::npos) {
+                    pushStreamText(fd_, pending.substr(lineStart, newline + 1 - lineStart), Kind::Line);
+                    lineStart = newline + 1;
+                    scanFrom = lineStart;
+                }
+                if (lineStart > 0) pending.erase(0, lineStart);
+            }
+
+            int fd_;
+        };
+
+        LineBuffer g_outBuffer(1);
+        LineBuffer g_errBuffer(2);
+
+        void beforeFork() {
+            if (g_async.load(std::memory_order_acquire)) Log::flush();
+        }
+
+        void inForkedChild() {
+            // The flusher does not exist in the child
+            g_async.store(false, std::memory_order_release);
+        }
+
+    } // anonymous namespace
+
+    /** ---- Log::start ---- */
+    void Log::start(Level threshold, Format format) {
+        s_threshold.store(static_cast<int>(threshold), std::memory_order_relaxed);
+        g_format = format;
+        if (g_async.load(std::memory_order_acquire)) return;
+
+        if (!g_slots) {
+            g_slots.reset(new Slot[kCapacity]);
+        }
+        for (uint64_t i = 0; i < kCapacity; i++) {
+            g_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        g_tail.store(0, std::memory_order_relaxed);
+        g_head = 0;
+        g_written.store(0, std::memory_order_relaxed);
+        g_stopping.store(false, std::memory_order_relaxed);
+        g_async.store(true, std::memory_order_release);
+        g_flusher = std::thread(flusherMain);
+
+        if (!g_atforkRegistered) {
+            pthread_atfork(beforeFork, nullptr, inForkedChild);
+            g_atforkRegistered = true;
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        g_originalOut = std::cout.rdbuf(&g_outBuffer);
+        g_originalErr = std::cerr.rdbuf(&g_errBuffer);
+        // Lines are complete records; flushing after every insertion would
+        // split them
+        std::cerr.unsetf(std::ios::unitbuf);
+    }
+
+    /** ---- Log::stop ---- */
+    void Log::stop() {
+        if (!g_async.load(std::memory_order_acquire)) return;
+
+        // Unfinished text of this thread (e.g. a message without '\n')
+        std::string& out = pendingText(1);
+        if (!out.empty()) { pushStreamText(1, std::move(out), Kind::Partial); out.clear(); }
+        std::string& err = pendingText(2);
+        if (!err.empty()) { pushStreamText(2, std::move(err), Kind::Partial); err.clear(); }
+
+        g_stopping.store(true, std::memory_order_release);
+        wakeFlusher();
+        g_flusher.join();
+        g_async.store(false, std::memory_order_release);
+
+        std::cout.rdbuf(g_originalOut);
+        std::cerr.rdbuf(g_originalErr);
+        std::cerr.setf(std::ios::unitbuf);
+
+        uint64_t lost = g_dropped.exchange(0);
+        if (lost > 0) {
+            std::cerr << "Warning: " << lost << " debug messages were dropped.\n";
+        }
+    }
+
+    /** ---- Log::flush ---- */
+    void Log::flush() {
+        std::cout.flush();
+        std::cerr.flush();
+        if (!g_async.load(std::memory_order_acquire)) return;
+
+        uint64_t target = g_tail.load(std::memory_order_acquire);
+        wakeFlusher();
+        while (g_written.load(std::memory_order_acquire) < target) {
+            if (!g_async.load(std::memory_order_acquire)) return;
+            wakeFlusher();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    /** ---- Log::write ---- */
+    void Log::write(Level level, const std::string& message) {
+        if (!enabled(level)) return;
+        Record record;
+        record.timeUs = wallClockMicros();
+        record.thread = threadNumber();
+        record.level = level;
+        record.kind = Kind::Message;
+        record.fd = 2;
+        record.text = message;
+        push(std::move(record), level >= Level::Warn);
+    }
+
+    /** ---- Log::dropped ---- */
+    uint64_t Log::dropped() {
+        return g_dropped.load(std::memory_order_relaxed);
+    }
+
+} // namespace Starpack
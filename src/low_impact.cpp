@@ -0,0 +1,142 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "low_impact.hpp"      // Class definition
+
+#include <iostream>            // Standard I/O (cerr)
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <atomic>              // Mode flag
+#include <mutex>               // Shared write budget
+#include <chrono>              // Pacing
+#include <thread>              // std::this_thread::sleep_until
+#include <sched.h>             // sched_setscheduler, SCHED_IDLE
+#include <unistd.h>            // syscall, close
+#include <fcntl.h>             // open, posix_fadvise, sync_file_range
+#include <sys/syscall.h>       // SYS_ioprio_set
+#include <sys/resource.h>      // setpriority
+
+namespace Starpack {
+
+    namespace {
+
+        // From linux/ioprio.h, which is not exported by every libc
+        constexpr int kIoprioWhoProcess = 1;
+        constexpr int kIoprioClassBE    = 2;
+        constexpr int kIoprioClassIdle  = 3;
+        constexpr int kIoprioClassShift = 13;
+
+        std::atomic<bool>      g_active{false};
+        std::atomic<long long> g_writeRate{0};
+
+        // Earliest time the next write may start (shared by all threads)
+        std::mutex g_budgetMutex;
+        std::chrono::steady_clock::time_point g_nextWrite;
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * LowImpact::enable
+     *
+     * Best-effort level 7 rather than the idle class: interactive updates
+     * still have to finish on a busy host, just behind everything else.
+     * ------------------------------------------------------------------------
+     */
+    void LowImpact::enable(long long writeBytesPerSecond) {
+        if (setpriority(PRIO_PROCESS, 0, 19) != 0) {
+            std::cerr << "Warning: Cannot lower CPU priority: "
+                      << strerror(errno) << std::endl;
+        }
+        int ioprio = (kIoprioClassBE << kIoprioClassShift) | 7;
+        if (syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, ioprio) != 0) {
+            std::cerr << "Warning: Cannot lower I/O priority: "
+                      << strerror(errno) << std::endl;
+        }
+        g_writeRate = writeBytesPerSecond > 0 ? writeBytesPerSecond : 0;
+        g_active = true;
+    }
+
+    bool LowImpact::active() {
+        return g_active;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LowImpact::throttleWrite
+     *
+     * Each call reserves a slot of bytes/rate seconds in a shared schedule
+     * and waits for its start, so concurrent writers add up to the cap.
+     * ------------------------------------------------------------------------
+     */
+    void LowImpact::throttleWrite(size_t bytes) {
+        long long rate = g_writeRate;
+        if (!g_active || rate <= 0 || bytes == 0) {
+            return;
+        }
+
+        auto cost = std::chrono::nanoseconds(
+            static_cast<long long>(static_cast<double>(bytes) * 1e9 / static_cast<double>(rate)));
+        std::chrono::steady_clock::time_point start;
+        {
+            std::lock_guard<std::mutex> lock(g_budgetMutex);
+            auto now = std::chrono::steady_clock::now();
+            if (g_nextWrite < now) {
+                g_nextWrite = now;
+            }
+            start = g_nextWrite;
+            g_nextWrite += cost;
+        }
+        std::this_thread::sleep_until(start);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LowImpact::dropFromCache
+     * ------------------------------------------------------------------------
+     */
+    void LowImpact::dropFromCache(const std::string& path, bool written) {
+        if (!g_active) {
+            return;
+        }
+        int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (written) {
+            // Dirty pages cannot be dropped; push them out first
+            sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE |
+                                      SYNC_FILE_RANGE_WRITE |
+                                      SYNC_FILE_RANGE_WAIT_AFTER);
+        }
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * LowImpact::enterIdlePriority
+     * ------------------------------------------------------------------------
+     */
+    bool LowImpact::enterIdlePriority() {
+        bool ok = true;
+
+        int ioprio = kIoprioClassIdle << kIoprioClassShift;
+        if (syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, ioprio) != 0) {
+            std::cerr << "Warning: Cannot switch to idle I/O priority: "
+                      << strerror(errno) << std::endl;
+            ok = false;
+        }
+
+        struct sched_param param {};
+        param.sched_priority = 0;
+        if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+            std::cerr << "Warning: Cannot switch to SCHED_IDLE: "
+                      << strerror(errno) << std::endl;
+            ok = false;
+        }
+        return ok;
+    }
+
+} // namespace Starpack
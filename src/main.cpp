@@ -4,6 +4,7 @@
 #include <ctime>
 #include <fstream>
 #include <unistd.h>
+#include <algorithm>
 
 #include "repository.hpp"
 #include "install.hpp"
@@ -15,6 +16,22 @@
 #include "spaceship.hpp"
 #include "list.hpp"
 #include "config.hpp"
+#include "image.hpp"
+#include "clone.hpp"
+#include "sync.hpp"
+#include "plan.hpp"
+#include "download.hpp"
+#include "low_impact.hpp"
+#include "serve.hpp"
+#include "daemon.hpp"
+#include "search.hpp"
+#include "object_store.hpp"
+#include "completion.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
+#include "memory_stats.hpp"
+#include "bench_env.hpp"
 
 // Helper function: Parse the installed database to get all installed package names.
 std::vector<std::string> getInstalledPackages(const std::string& dbPath = "/var/lib/starpack/installed.db")
@@ -35,6 +52,63 @@ std::vector<std::string> getInstalledPackages(const std::string& dbPath = "/var/
     return pkgs;
 }
 
+// Helper function: Append the root directories listed in a file (one per line,
+// '#' starts a comment) to installDirs.
+bool readInstallDirFile(const std::string& path, std::vector<std::string>& installDirs)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Unable to open install directory list " << path << ".\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#') {
+            installDirs.push_back(line);
+        }
+    }
+    return true;
+}
+
+// Helper function: Parse the daemon options starting at argv[first] and run
+// starpackd (reached as `starpack daemon` or through a starpackd symlink).
+int runDaemon(int argc, char* argv[], int first)
+{
+    Starpack::DaemonOptions options;
+
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--socket" || arg == "--installdir" || arg == "--refresh") && i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires an argument.\n";
+            return 1;
+        }
+        if (arg == "--socket") {
+            options.socketPath = argv[++i];
+        }
+        else if (arg == "--installdir") {
+            options.installDir = argv[++i];
+        }
+        else if (arg == "--refresh") {
+            try {
+                options.refreshInterval = std::stoi(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid number of seconds: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "Usage: starpackd [--socket <path>] [--installdir <dir>] "
+                      << "[--refresh <seconds>]\n";
+            return 1;
+        }
+    }
+
+    return Starpack::Daemon::run(options) ? 0 : 1;
+}
+
 void printHelp()
 {
     std::cout << "Starpack Alpha (x86_64)\n"
@@ -48,26 +122,157 @@ void printHelp()
               << "  update       - Update package list or upgrade packages\n"
               << "  list         - List installed packages\n"
               << "  info         - Show package details\n"
+              << "  search       - Search the repositories (by text, or --file <path>)\n"
               << "  repo         - Manage repositories\n"
-              << "  clean        - Clean the cache\n\n"
+              << "  clean        - Clean the cache\n"
+              << "  image        - Export packages as a root filesystem archive\n"
+              << "  clone        - Provision a new root from an installed template root\n"
+              << "  sync         - Converge a root to a package manifest\n"
+              << "  plan         - Resolve and download a transaction for a later apply\n"
+              << "  apply        - Execute a saved plan offline\n"
+              << "  serve        - Share the package cache with other nodes over HTTP\n"
+              << "  daemon       - Run starpackd, which answers info/list/search from memory\n"
+              << "  bench-env    - Measure disk, decompression, verification and mirror speed\n\n"
+              << "Options:\n"
+              << "  --low-impact - Lower CPU/I-O priority, cap bandwidth and keep the\n"
+              << "                 page cache clean (also: LowImpact = yes in starpack.conf)\n"
+              << "  --trace <file> - Record phase timings as a Chrome trace (chrome://tracing)\n"
+              << "  -v, --verbose  - Also show per-file and per-package detail\n"
+              << "  -q, --quiet    - Only show warnings, errors and prompts\n"
+              << "  --log-format text|json - json writes one JSON object per line\n"
+              << "  --stats      - Print time, memory and allocations per phase at exit\n\n"
               << "This Star Has Spaceship Powers.\n";
 }
 
+int runCommand(const std::string& command, int argc, char* argv[]);
+
 int main(int argc, char* argv[])
 {
+    std::string programName = argv[0];
+    if (programName.substr(programName.find_last_of('/') + 1) == "starpackd") {
+        return runDaemon(argc, argv, 1);
+    }
+
+    // Shell completion (hidden); answered before anything else is loaded
+    if (argc >= 2 && std::string(argv[1]) == "__complete") {
+        return Starpack::Completion::run(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
     // If no command is supplied, show the help message
     if (argc < 2) {
         printHelp();
         return 0;
     }
 
+    // Global options, accepted anywhere on the command line; they override
+    // the configuration every subsystem reads through Config::current()
+    Starpack::Config config = Starpack::Config::load();
+    Starpack::Settings& settings = config.settings;
+    std::string tracePath;
+    bool stats = false;
+    Starpack::Log::Level logLevel = Starpack::Log::Level::Info;
+    Starpack::Log::Format logFormat = Starpack::Log::Format::Text;
+    {
+        int kept = 1;
+        for (int i = 1; i < argc; i++) {
+            if (std::string(argv[i]) == "--low-impact") {
+                settings.lowImpact = true;
+            }
+            else if (std::string(argv[i]) == "--trace") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --trace requires an output file.\n";
+                    return 1;
+                }
+                tracePath = argv[++i];
+            }
+            else if (std::string(argv[i]) == "--stats") {
+                stats = true;
+            }
+            else if (std::string(argv[i]) == "-v" || std::string(argv[i]) == "--verbose") {
+                logLevel = Starpack::Log::Level::Debug;
+            }
+            else if (std::string(argv[i]) == "-q" || std::string(argv[i]) == "--quiet") {
+                logLevel = Starpack::Log::Level::Warn;
+            }
+            else if (std::string(argv[i]) == "--log-format") {
+                std::string format = (i + 1 < argc) ? argv[++i] : "";
+                if (format == "json") {
+                    logFormat = Starpack::Log::Format::Json;
+                }
+                else if (format != "text") {
+                    std::cerr << "Error: --log-format must be 'text' or 'json'.\n";
+                    return 1;
+                }
+            }
+            else {
+                argv[kept++] = argv[i];
+            }
+        }
+        argc = kept;
+        argv[argc] = nullptr;
+    }
+    if (argc < 2) {
+        printHelp();
+        return 0;
+    }
+    Starpack::Config::setCurrent(config);
+    Starpack::setDownloadConcurrency(settings.downloadConcurrencyMin,
+                                     settings.downloadConcurrencyMax);
+    if (settings.lowImpact) {
+        Starpack::LowImpact::enable(settings.lowImpactWriteRate);
+        Starpack::setDownloadRateLimit(settings.lowImpactDownloadRate);
+    }
+
     // Parse the first argument as the main command
     std::string command = argv[1];
 
+    // Console output goes through the asynchronous logger from here on
+    Starpack::Log::start(logLevel, logFormat);
+
+    // The trace and the metrics are written when main returns, after the
+    // command span closed; the logger is drained last
+    struct TraceWriter {
+        int exitCode = 1;
+        ~TraceWriter() {
+            Starpack::Trace::finish();
+            Starpack::Metrics::finish(exitCode);
+            Starpack::MemoryStats::report(std::cerr);
+            Starpack::Log::stop();
+        }
+    } traceWriter;
+    if (!tracePath.empty()) {
+        Starpack::Trace::start(tracePath);
+    }
+    if (stats) {
+        Starpack::MemoryStats::start(true);
+    }
+    if (command == "install" || command == "remove" || command == "update" ||
+        command == "sync"    || command == "apply"  || command == "clone") {
+        Starpack::Metrics::start(command, settings.metricsTextfile, settings.metricsJson);
+    }
+    Starpack::Trace::Span commandSpan("cli", "starpack", command);
+    traceWriter.exitCode = runCommand(command, argc, argv);
+    return traceWriter.exitCode;
+}
+
+// Runs one command after the global options were applied and returns the
+// process exit code.
+int runCommand(const std::string& command, int argc, char* argv[])
+{
+    // With starpackd running, read-only queries are answered from its warm indices
+    if (command == "info" || command == "list" || command == "search") {
+        int exitCode = 0;
+        if (Starpack::Daemon::query(std::vector<std::string>(argv + 1, argv + argc), exitCode)) {
+            return exitCode;
+        }
+    }
+
     // Certain commands must be run as root
     if ((command == "install" || command == "remove" ||
          command == "update"  || command == "clean"  ||
-         command == "list"    || command == "create-starpack") &&
+         command == "list"    || command == "create-starpack" ||
+         command == "clone"   || command == "sync"   ||
+         command == "plan"    || command == "apply") &&
          (geteuid() != 0))
     {
         std::cerr << "Error: The '" << command << "' command must be run as root.\n";
@@ -83,20 +288,19 @@ int main(int argc, char* argv[])
         if (argc >= 3) {
             std::string subCommand = argv[2];
             if (subCommand == "list") {
-                Starpack::Config config = Starpack::Config::loadFromFile("/etc/starpack/repos.conf");
-                config.print();
+                Starpack::Config::loadFromFile(Starpack::Config::defaultPath).print();
             }
             else if (subCommand == "add" && argc == 4) {
                 std::string newRepo = argv[3];
-                Starpack::Config config = Starpack::Config::loadFromFile("/etc/starpack/repos.conf");
-                config.addRepository(newRepo);
-                config.saveToFile("/etc/starpack/repos.conf");
+                Starpack::Config repos = Starpack::Config::loadFromFile(Starpack::Config::defaultPath);
+                repos.addRepository(newRepo);
+                repos.saveToFile(Starpack::Config::defaultPath);
             }
             else if (subCommand == "remove" && argc == 4) {
                 std::string repo = argv[3];
-                Starpack::Config config = Starpack::Config::loadFromFile("/etc/starpack/repos.conf");
-                config.removeRepository(repo);
-                config.saveToFile("/etc/starpack/repos.conf");
+                Starpack::Config repos = Starpack::Config::loadFromFile(Starpack::Config::defaultPath);
+                repos.removeRepository(repo);
+                repos.saveToFile(Starpack::Config::defaultPath);
             }
             else if (subCommand == "index" && argc == 4) {
                 std::string location = argv[3];
@@ -123,8 +327,7 @@ int main(int argc, char* argv[])
     // Install Command
     // -------------------------------------------------------------
     else if (command == "install") {
-        std::string installDir = "/";
-        bool installDirSpecified = false;
+        std::vector<std::string> installDirs;
         std::vector<std::string> packagesToInstall;
 
         // Collect arguments after "install"
@@ -132,26 +335,53 @@ int main(int argc, char* argv[])
             std::string arg = argv[i];
             if (arg == "--installdir") {
                 if (i + 1 < argc) {
-                    installDir = argv[i + 1];
+                    installDirs.push_back(argv[i + 1]);
                     i++;
-                    installDirSpecified = true;
                 }
                 else {
                     std::cerr << "Error: --installdir requires a directory argument.\n";
                     return 1;
                 }
             }
+            else if (arg == "--installdir-file") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --installdir-file requires a file argument.\n";
+                    return 1;
+                }
+                if (!readInstallDirFile(argv[++i], installDirs)) {
+                    return 1;
+                }
+            }
+            else if (arg == "--dedup") {
+                if (Starpack::ObjectStore::storeDir().empty()) {
+                    Starpack::ObjectStore::setStoreDir(Starpack::ObjectStore::defaultStoreDir);
+                }
+            }
+            else if (arg == "--store") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --store requires a directory argument.\n";
+                    return 1;
+                }
+                Starpack::ObjectStore::setStoreDir(argv[++i]);
+            }
             else {
                 packagesToInstall.push_back(arg);
             }
         }
 
         if (packagesToInstall.empty()) {
-            std::cerr << "Usage: starpack install <package_name> [package_name ...] [--installdir <dir>]\n";
+            std::cerr << "Usage: starpack install <package_name> [package_name ...] [--installdir <dir> ...] [--installdir-file <file>]\n"
+                      << "                       [--dedup] [--store <dir>]\n";
             return 1;
         }
 
-        Starpack::Installer::installPackage(packagesToInstall, installDir, true);
+        if (installDirs.size() > 1) {
+            Starpack::Installer::installPackage(packagesToInstall, installDirs, true);
+        }
+        else {
+            std::string installDir = installDirs.empty() ? "/" : installDirs.front();
+            Starpack::Installer::installPackage(packagesToInstall, installDir, true);
+        }
     }
     // -------------------------------------------------------------
     // Remove Command
@@ -187,14 +417,31 @@ int main(int argc, char* argv[])
     // Update Command
     // -------------------------------------------------------------
     else if (command == "update") {
-        std::string installDir = "/";
+        std::vector<std::string> installDirs;
         std::vector<std::string> packagesToUpdate;
+        bool downloadOnly = false;
+        bool prefetch = false;
+        long long maxRate = -1;
 
         for (int i = 2; i < argc; i++) {
             std::string arg = argv[i];
-            if (arg == "--installdir") {
+            if (arg == "--download-only") {
+                downloadOnly = true;
+            }
+            else if (arg == "--prefetch") {
+                prefetch = true;
+                downloadOnly = true;
+            }
+            else if (arg == "--max-rate") {
+                if (i + 1 >= argc || !Starpack::parseRate(argv[i + 1], maxRate)) {
+                    std::cerr << "Error: --max-rate requires a rate such as 512K or 2M.\n";
+                    return 1;
+                }
+                i++;
+            }
+            else if (arg == "--installdir") {
                 if (i + 1 < argc) {
-                    installDir = argv[i + 1];
+                    installDirs.push_back(argv[i + 1]);
                     i++;
                 }
                 else {
@@ -202,17 +449,385 @@ int main(int argc, char* argv[])
                     return 1;
                 }
             }
+            else if (arg == "--installdir-file") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --installdir-file requires a file argument.\n";
+                    return 1;
+                }
+                if (!readInstallDirFile(argv[++i], installDirs)) {
+                    return 1;
+                }
+            }
+            else if (arg == "--dedup") {
+                if (Starpack::ObjectStore::storeDir().empty()) {
+                    Starpack::ObjectStore::setStoreDir(Starpack::ObjectStore::defaultStoreDir);
+                }
+            }
+            else if (arg == "--store") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --store requires a directory argument.\n";
+                    return 1;
+                }
+                Starpack::ObjectStore::setStoreDir(argv[++i]);
+            }
             else {
                 packagesToUpdate.push_back(arg);
             }
         }
+        if (installDirs.empty()) {
+            installDirs.push_back("/");
+        }
 
-        // If no packages specified, update everything that's installed
+        // If no packages specified, update everything that's installed in any root
         if (packagesToUpdate.empty()) {
-            packagesToUpdate = getInstalledPackages(installDir + "/var/lib/starpack/installed.db");
+            for (const auto& dir : installDirs) {
+                for (const auto& pkg : getInstalledPackages(dir + "/var/lib/starpack/installed.db")) {
+                    if (std::find(packagesToUpdate.begin(), packagesToUpdate.end(), pkg) == packagesToUpdate.end()) {
+                        packagesToUpdate.push_back(pkg);
+                    }
+                }
+            }
+        }
+
+        // Timer-driven prefetch: stay out of the way of interactive work
+        if (prefetch) {
+            Starpack::LowImpact::enterIdlePriority();
+            if (maxRate < 0) {
+                maxRate = 2LL * 1024 * 1024;
+            }
+        }
+        if (maxRate > 0) {
+            Starpack::setDownloadRateLimit(maxRate);
+        }
+        if (prefetch) {
+            // Also refresh the repository DBs that install and sync read
+            Starpack::PackageSourceCache refreshed;
+            Starpack::Installer::loadRepositoryIndex(installDirs.front() + "/var/lib/starpack/cache",
+                                                     refreshed, true);
+        }
+
+        Starpack::Updater::updatePackage(packagesToUpdate, installDirs, downloadOnly);
+    }
+    // -------------------------------------------------------------
+    // Image Command
+    // -------------------------------------------------------------
+    else if (command == "image") {
+        std::string outputPath;
+        std::vector<std::string> packagesToExport;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--output" || arg == "-o") {
+                if (i + 1 < argc) {
+                    outputPath = argv[++i];
+                }
+                else {
+                    std::cerr << "Error: --output requires a file argument.\n";
+                    return 1;
+                }
+            }
+            else {
+                packagesToExport.push_back(arg);
+            }
+        }
+
+        if (outputPath.empty() || packagesToExport.empty()) {
+            std::cerr << "Usage: starpack image --output <root.tar.zst> <package_name> [package_name ...]\n";
+            return 1;
         }
 
-        Starpack::Updater::updatePackage(packagesToUpdate, installDir);
+        if (!Starpack::Image::exportImage(packagesToExport, outputPath)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Clone Command
+    // -------------------------------------------------------------
+    else if (command == "clone") {
+        std::string fromRoot;
+        std::string toRoot;
+        Starpack::CloneMode mode = Starpack::CloneMode::Reflink;
+        std::vector<std::string> packagesToInstall;
+        std::vector<std::string> packagesToRemove;
+        bool confirm = true;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            bool takesValue = (arg == "--from" || arg == "--to" || arg == "--mode" ||
+                               arg == "--install" || arg == "--remove");
+            if (takesValue && i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n";
+                return 1;
+            }
+            if (arg == "--from") {
+                fromRoot = argv[++i];
+            }
+            else if (arg == "--to") {
+                toRoot = argv[++i];
+            }
+            else if (arg == "--mode") {
+                if (!Starpack::Clone::parseMode(argv[++i], mode)) {
+                    std::cerr << "Error: Unknown clone mode '" << argv[i]
+                              << "' (expected reflink, hardlink or overlay).\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--install") {
+                packagesToInstall.push_back(argv[++i]);
+            }
+            else if (arg == "--remove") {
+                packagesToRemove.push_back(argv[++i]);
+            }
+            else if (arg == "--noconfirm") {
+                confirm = false;
+            }
+            else {
+                std::cerr << "Error: Unknown argument for clone: " << arg << "\n";
+                return 1;
+            }
+        }
+
+        if (fromRoot.empty() || toRoot.empty()) {
+            std::cerr << "Usage: starpack clone --from <template-root> --to <dir> "
+                      << "[--mode reflink|hardlink|overlay] [--install <pkg>]... "
+                      << "[--remove <pkg>]... [--noconfirm]\n";
+            return 1;
+        }
+
+        if (!Starpack::Clone::cloneRoot(fromRoot, toRoot, mode,
+                                        packagesToInstall, packagesToRemove, confirm)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Sync Command
+    // -------------------------------------------------------------
+    else if (command == "sync") {
+        std::string manifestPath;
+        std::string installDir = "/";
+        bool confirm = true;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "--manifest" || arg == "--installdir") && i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n";
+                return 1;
+            }
+            if (arg == "--manifest") {
+                manifestPath = argv[++i];
+            }
+            else if (arg == "--installdir") {
+                installDir = argv[++i];
+            }
+            else if (arg == "--noconfirm") {
+                confirm = false;
+            }
+            else {
+                std::cerr << "Error: Unknown argument for sync: " << arg << "\n";
+                return 1;
+            }
+        }
+
+        if (manifestPath.empty()) {
+            std::cerr << "Usage: starpack sync --manifest <file> [--installdir <dir>] [--noconfirm]\n";
+            return 1;
+        }
+
+        if (!Starpack::Sync::syncRoot(manifestPath, installDir, confirm)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Plan Command
+    // -------------------------------------------------------------
+    else if (command == "plan") {
+        std::string manifestPath;
+        std::string outputPath;
+        std::string installDir = "/";
+        std::vector<std::string> packageNames;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            bool takesValue = (arg == "--manifest" || arg == "--installdir" || arg == "--out");
+            if (takesValue && i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n";
+                return 1;
+            }
+            if (arg == "--manifest") {
+                manifestPath = argv[++i];
+            }
+            else if (arg == "--installdir") {
+                installDir = argv[++i];
+            }
+            else if (arg == "--out") {
+                outputPath = argv[++i];
+            }
+            else {
+                packageNames.push_back(arg);
+            }
+        }
+
+        if (outputPath.empty()) {
+            std::cerr << "Usage: starpack plan [--manifest <file>] [package_name ...] "
+                      << "[--installdir <dir>] --out <plan file>\n"
+                      << "  Without a manifest, the named packages are added to the root;\n"
+                      << "  without packages either, every installed package is upgraded.\n";
+            return 1;
+        }
+
+        // A manifest describes the whole root; otherwise keep what is installed
+        std::vector<Starpack::ManifestEntry> entries;
+        if (!manifestPath.empty()) {
+            if (!Starpack::Sync::readManifest(manifestPath, entries)) {
+                return 1;
+            }
+        }
+        else {
+            entries = Starpack::Sync::installedEntries(installDir);
+            if (packageNames.empty()) {
+                for (auto& entry : entries) {
+                    entry.version.clear();
+                }
+            }
+        }
+        for (const auto& name : packageNames) {
+            auto it = std::find_if(entries.begin(), entries.end(),
+                                   [&](const Starpack::ManifestEntry& e) { return e.name == name; });
+            if (it != entries.end()) {
+                it->version.clear();
+            }
+            else {
+                entries.push_back({ name, "" });
+            }
+        }
+        if (entries.empty()) {
+            std::cerr << "Error: Nothing to plan.\n";
+            return 1;
+        }
+
+        if (!Starpack::PlanFile::create(entries, installDir, outputPath)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Apply Command
+    // -------------------------------------------------------------
+    else if (command == "apply") {
+        std::string planPath;
+        bool confirm = true;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--noconfirm") {
+                confirm = false;
+            }
+            else if (planPath.empty()) {
+                planPath = arg;
+            }
+            else {
+                std::cerr << "Error: Unknown argument for apply: " << arg << "\n";
+                return 1;
+            }
+        }
+
+        if (planPath.empty()) {
+            std::cerr << "Usage: starpack apply <plan file> [--noconfirm]\n";
+            return 1;
+        }
+
+        if (!Starpack::PlanFile::apply(planPath, confirm)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Serve Command
+    // -------------------------------------------------------------
+    else if (command == "serve") {
+        Starpack::ServeOptions options;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "--port" || arg == "--bind" || arg == "--upstream" ||
+                 arg == "--installdir" || arg == "--index-ttl") && i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n";
+                return 1;
+            }
+            try {
+                if (arg == "--port") {
+                    options.port = std::stoi(argv[++i]);
+                }
+                else if (arg == "--bind") {
+                    options.bindAddress = argv[++i];
+                }
+                else if (arg == "--upstream") {
+                    options.upstream = argv[++i];
+                }
+                else if (arg == "--installdir") {
+                    options.installDir = argv[++i];
+                }
+                else if (arg == "--index-ttl") {
+                    options.indexTtl = std::stoi(argv[++i]);
+                }
+                else {
+                    std::cerr << "Error: Unknown argument for serve: " << arg << "\n";
+                    return 1;
+                }
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid number for " << arg << ": " << argv[i] << "\n";
+                return 1;
+            }
+        }
+
+        if (options.port <= 0 || options.port > 65535 || options.indexTtl < 0) {
+            std::cerr << "Usage: starpack serve [--port <n>] [--bind <addr>] [--upstream <url>] "
+                      << "[--installdir <dir>] [--index-ttl <seconds>]\n";
+            return 1;
+        }
+
+        if (!Starpack::CacheServer::run(options)) {
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Bench-env Command
+    // -------------------------------------------------------------
+    else if (command == "bench-env") {
+        Starpack::BenchEnvOptions options;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "--installdir" || arg == "--mirror" || arg == "--size") && i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n";
+                return 1;
+            }
+            if (arg == "--installdir") {
+                options.installDir = argv[++i];
+            }
+            else if (arg == "--mirror") {
+                options.mirrors.push_back(argv[++i]);
+            }
+            else if (arg == "--size") {
+                try {
+                    options.archiveMiB = std::stoi(argv[++i]);
+                } catch (const std::exception&) {
+                    options.archiveMiB = 0;
+                }
+            }
+            else {
+                std::cerr << "Error: Unknown argument for bench-env: " << arg << "\n";
+                return 1;
+            }
+        }
+
+        if (options.archiveMiB <= 0) {
+            std::cerr << "Usage: starpack bench-env [--installdir <dir>] [--mirror <url> ...] "
+                      << "[--size <MiB>]\n";
+            return 1;
+        }
+
+        if (!Starpack::BenchEnv::run(options)) {
+            return 1;
+        }
     }
     // -------------------------------------------------------------
     // Info Command
@@ -241,6 +856,27 @@ int main(int argc, char* argv[])
         }
     }
     // -------------------------------------------------------------
+    // Search Command
+    // -------------------------------------------------------------
+    else if (command == "search") {
+        if (argc == 3) {
+            Starpack::Search::searchPackages(argv[2]);
+        }
+        else if (argc == 4 && std::string(argv[2]) == "--file") {
+            Starpack::Search::searchByFile(argv[3]);
+        }
+        else {
+            std::cerr << "Usage: starpack search <text> | starpack search --file <path>\n";
+            return 1;
+        }
+    }
+    // -------------------------------------------------------------
+    // Daemon Command
+    // -------------------------------------------------------------
+    else if (command == "daemon") {
+        return runDaemon(argc, argv, 2);
+    }
+    // -------------------------------------------------------------
     // Clean Command
     // -------------------------------------------------------------
     else if (command == "clean") {
@@ -0,0 +1,225 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "memory_stats.hpp"    // Class definition
+
+#include <sstream>             // MiB formatting
+#include <iomanip>             // Table formatting
+#include <algorithm>           // std::max
+#include <mutex>               // Phase registration
+#include <cstring>             // strcmp, strncmp
+#include <cstdlib>             // strtoull
+#include <fcntl.h>             // open
+#include <unistd.h>            // read, write, close
+#include <sys/resource.h>      // getrusage (fallback peak)
+
+namespace Starpack {
+
+    namespace {
+
+        // Phases are Trace categories, a small fixed set; bucket 0 collects
+        // allocations made outside any phase
+        constexpr int kMaxPhases = 32;
+
+        struct PhaseTotals {
+            const char*           name = nullptr;
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> microseconds{0};
+            std::atomic<uint64_t> peakGrowth{0};     // how far the phase raised VmHWM
+            std::atomic<uint64_t> maxRssAtEnd{0};
+            std::atomic<uint64_t> allocCount{0};
+            std::atomic<uint64_t> allocBytes{0};
+        };
+
+        PhaseTotals      g_phases[kMaxPhases];
+        std::atomic<int> g_phaseCount{1};
+        std::mutex       g_registerMutex;
+
+        // Phase bucket of the innermost open phase on this thread
+        thread_local int t_phase = 0;
+
+        int bucketFor(const char* phase) {
+            int count = g_phaseCount.load(std::memory_order_acquire);
+            for (int i = 1; i < count; i++) {
+                if (g_phases[i].name == phase || std::strcmp(g_phases[i].name, phase) == 0) {
+                    return i;
+                }
+            }
+            std::lock_guard<std::mutex> lock(g_registerMutex);
+            count = g_phaseCount.load(std::memory_order_relaxed);
+            for (int i = 1; i < count; i++) {
+                if (std::strcmp(g_phases[i].name, phase) == 0) {
+                    return i;
+                }
+            }
+            if (count == kMaxPhases) {
+                return 0;
+            }
+            g_phases[count].name = phase;
+            g_phaseCount.store(count + 1, std::memory_order_release);
+            return count;
+        }
+
+        void raiseTo(std::atomic<uint64_t>& value, uint64_t candidate) {
+            uint64_t current = value.load(std::memory_order_relaxed);
+            while (candidate > current &&
+                   !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::string mib(uint64_t bytes) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1024.0 * 1024.0);
+            return out.str();
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * MemoryStats::sample / resetPeak
+     * ------------------------------------------------------------------------
+     */
+    MemoryStats::Sample MemoryStats::sample() {
+        Sample result;
+        char buffer[4096];
+        int fd = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+            close(fd);
+            if (length > 0) {
+                buffer[length] = '\0';
+                for (char* line = buffer; line && *line; ) {
+                    if (std::strncmp(line, "VmHWM:", 6) == 0) {
+                        result.hwm = std::strtoull(line + 6, nullptr, 10) * 1024;
+                    } else if (std::strncmp(line, "VmRSS:", 6) == 0) {
+                        result.rss = std::strtoull(line + 6, nullptr, 10) * 1024;
+                    }
+                    line = std::strchr(line, '\n');
+                    if (line) {
+                        line++;
+                    }
+                }
+            }
+        }
+        if (result.hwm == 0) {
+            struct rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            result.hwm = static_cast<uint64_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KiB
+        }
+        return result;
+    }
+
+    bool MemoryStats::resetPeak() {
+        int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = write(fd, "5", 1) == 1;
+        close(fd);
+        return ok;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * MemoryStats::start / report / stop / allocations
+     * ------------------------------------------------------------------------
+     */
+    void MemoryStats::start(bool countAllocations) {
+        for (int i = 0; i < kMaxPhases; i++) {
+            g_phases[i].calls        = 0;
+            g_phases[i].microseconds = 0;
+            g_phases[i].peakGrowth   = 0;
+            g_phases[i].maxRssAtEnd  = 0;
+            g_phases[i].allocCount   = 0;
+            g_phases[i].allocBytes   = 0;
+        }
+        s_enabled  = true;
+        s_counting = countAllocations && s_hooked.load();
+    }
+
+    void MemoryStats::report(std::ostream& out) {
+        if (!enabled()) {
+            return;
+        }
+        bool counted = countingAllocations();
+        stop();
+
+        out << "\nMemory by phase:\n"
+            << std::left << std::setw(10) << "phase" << std::right
+            << std::setw(8) << "calls" << std::setw(10) << "time s"
+            << std::setw(12) << "RSS MiB" << std::setw(12) << "peak +MiB";
+        if (counted) {
+            out << std::setw(12) << "allocs" << std::setw(12) << "alloc MiB";
+        }
+        out << "\n";
+
+        int count = g_phaseCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            const PhaseTotals& phase = g_phases[i];
+            uint64_t calls = phase.calls.load();
+            if (i == 0 && (!counted || phase.allocCount.load() == 0)) {
+                continue;
+            }
+            out << std::left << std::setw(10) << (i == 0 ? "(other)" : phase.name) << std::right
+                << std::setw(8) << calls
+                << std::setw(10) << std::fixed << std::setprecision(3) << phase.microseconds.load() / 1e6
+                << std::setw(12) << (i == 0 ? "-" : mib(phase.maxRssAtEnd.load()))
+                << std::setw(12) << (i == 0 ? "-" : mib(phase.peakGrowth.load()));
+            if (counted) {
+                out << std::setw(12) << phase.allocCount.load()
+                    << std::setw(12) << mib(phase.allocBytes.load());
+            }
+            out << "\n";
+        }
+        Sample now = sample();
+        out << "Peak RSS: " << mib(now.hwm) << " MiB, current RSS: " << mib(now.rss) << " MiB\n";
+    }
+
+    void MemoryStats::stop() {
+        s_counting = false;
+        s_enabled  = false;
+    }
+
+    MemoryStats::Allocations MemoryStats::allocations() {
+        Allocations total;
+        int count = g_phaseCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            total.count += g_phases[i].allocCount.load(std::memory_order_relaxed);
+            total.bytes += g_phases[i].allocBytes.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * MemoryStats::phaseBegin / phaseEnd / countAllocation
+     * ------------------------------------------------------------------------
+     */
+    int MemoryStats::phaseBegin(const char* phase) {
+        int bucket = bucketFor(phase);
+        int token = (t_phase << 8) | bucket;
+        t_phase = bucket;
+        return token;
+    }
+
+    void MemoryStats::phaseEnd(int token, uint64_t microseconds,
+                               const Sample& atStart, const Sample& atEnd) {
+        PhaseTotals& phase = g_phases[token & 0xff];
+        t_phase = token >> 8;
+        phase.calls.fetch_add(1, std::memory_order_relaxed);
+        phase.microseconds.fetch_add(microseconds, std::memory_order_relaxed);
+        if (atEnd.hwm > atStart.hwm) {
+            phase.peakGrowth.fetch_add(atEnd.hwm - atStart.hwm, std::memory_order_relaxed);
+        }
+        raiseTo(phase.maxRssAtEnd, atEnd.rss);
+    }
+
+    void MemoryStats::countAllocation(size_t bytes) {
+        PhaseTotals& phase = g_phases[t_phase];
+        phase.allocCount.fetch_add(1, std::memory_order_relaxed);
+        phase.allocBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+} // namespace Starpack
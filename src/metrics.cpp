@@ -0,0 +1,358 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "metrics.hpp"         // Class definition
+#include "trace.hpp"           // Trace::quote for JSON strings
+
+#include <iostream>            // Standard I/O (cerr)
+#include <sstream>             // Rendering both formats
+#include <iomanip>             // Fixed-point seconds
+#include <filesystem>          // Output directories
+#include <chrono>              // Transaction timing
+#include <mutex>               // Collected values
+#include <map>                 // Per-phase, per-operation, per-kind and per-hook totals
+#include <vector>              // Hook runs
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <fcntl.h>             // open
+#include <unistd.h>            // write, fsync, close, getpid
+#include <sys/resource.h>      // getrusage (peak RSS)
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        struct HookRun {
+            std::string name;
+            uint64_t    microseconds;
+            bool        ok;
+        };
+
+        struct Collected {
+            std::mutex  mutex;
+            std::string command;
+            std::string textfilePath;
+            std::string jsonPath;
+            std::chrono::steady_clock::time_point started;
+
+            std::atomic<uint64_t> downloadBytes{0};
+            std::atomic<uint64_t> cacheHits{0};
+            std::atomic<uint64_t> cacheMisses{0};
+            std::map<std::string, uint64_t> phases;    // microseconds
+            std::map<std::string, uint64_t> changes;
+            std::map<std::string, uint64_t> failures;
+            std::vector<HookRun>            hooks;
+        };
+
+        Collected g_metrics;
+
+        /**
+         * -------------------------------------------------------------------
+         * escapeLabel
+         *
+         * Prometheus label values escape backslash, quote and newline.
+         * -------------------------------------------------------------------
+         */
+        std::string escapeLabel(const std::string& value) {
+            std::string escaped;
+            for (char c : value) {
+                switch (c) {
+                    case '\\': escaped += "\\\\"; break;
+                    case '"':  escaped += "\\\""; break;
+                    case '\n': escaped += "\\n";  break;
+                    default:   escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * writeAtomically
+         *
+         * Writes "<path>.tmp", syncs it and renames it over path. The
+         * textfile collector skips names not ending in ".prom", so it never
+         * sees the temporary file either.
+         * -------------------------------------------------------------------
+         */
+        bool writeAtomically(const std::string& path, const std::string& contents) {
+            std::error_code ec;
+            fs::path parent = fs::path(path).parent_path();
+            if (!parent.empty()) {
+                fs::create_directories(parent, ec);
+            }
+
+            std::string tmpPath = path + ".tmp";
+            int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::cerr << "Error: Cannot write metrics to " << tmpPath << ": "
+                          << strerror(errno) << std::endl;
+                return false;
+            }
+            size_t written = 0;
+            while (written < contents.size()) {
+                ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                written += static_cast<size_t>(n);
+            }
+            bool ok = written == contents.size() && fsync(fd) == 0;
+            ok = close(fd) == 0 && ok;
+            if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+                std::cerr << "Error: Cannot write metrics to " << path << ": "
+                          << strerror(errno) << std::endl;
+                unlink(tmpPath.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        uint64_t peakRssBytes() {
+            struct rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KiB
+        }
+
+        void metric(std::ostringstream& out, const char* name, const char* type,
+                    const char* help) {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " " << type << "\n";
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Metrics::start
+     * ------------------------------------------------------------------------
+     */
+    void Metrics::start(const std::string& command, const std::string& textfilePath,
+                        const std::string& jsonPath) {
+        if (textfilePath.empty() && jsonPath.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        g_metrics.command      = command;
+        g_metrics.textfilePath = textfilePath;
+        g_metrics.jsonPath     = jsonPath;
+        g_metrics.started      = std::chrono::steady_clock::now();
+        s_enabled = true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Metrics::add*
+     * ------------------------------------------------------------------------
+     */
+    void Metrics::addPhase(const char* phase, uint64_t microseconds) {
+        if (!enabled()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        g_metrics.phases[phase] += microseconds;
+    }
+
+    void Metrics::addDownload(uint64_t bytes) {
+        if (enabled()) {
+            g_metrics.downloadBytes += bytes;
+        }
+    }
+
+    void Metrics::addCacheLookup(bool hit) {
+        if (enabled()) {
+            (hit ? g_metrics.cacheHits : g_metrics.cacheMisses)++;
+        }
+    }
+
+    void Metrics::addPackageChange(const char* operation) {
+        if (!enabled()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        g_metrics.changes[operation]++;
+    }
+
+    void Metrics::addHook(const std::string& name, uint64_t microseconds, bool ok) {
+        if (!enabled()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        g_metrics.hooks.push_back({ name, microseconds, ok });
+        if (!ok) {
+            g_metrics.failures["hook"]++;
+        }
+    }
+
+    void Metrics::addFailure(const char* kind) {
+        if (!enabled()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        g_metrics.failures[kind]++;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Metrics::finish
+     *
+     * Renders both formats from one snapshot. Every series carries the
+     * command as a label so dashboards can tell install from update runs.
+     * ------------------------------------------------------------------------
+     */
+    bool Metrics::finish(int exitCode) {
+        if (!enabled()) {
+            return true;
+        }
+        s_enabled = false;
+
+        std::lock_guard<std::mutex> lock(g_metrics.mutex);
+        if (exitCode != 0 && g_metrics.failures.empty()) {
+            g_metrics.failures["exit"]++;
+        }
+        double duration = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - g_metrics.started).count();
+        double finishedAt = std::chrono::duration<double>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t hits   = g_metrics.cacheHits;
+        uint64_t misses = g_metrics.cacheMisses;
+        double hitRatio = (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 1.0;
+        uint64_t failures = 0;
+        for (const auto& [kind, count] : g_metrics.failures) {
+            failures += count;
+        }
+        uint64_t rss = peakRssBytes();
+
+        bool ok = true;
+        std::string cmd = "command=\"" + escapeLabel(g_metrics.command) + "\"";
+
+        if (!g_metrics.textfilePath.empty()) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(6);
+            metric(out, "starpack_transaction_timestamp_seconds", "gauge",
+                   "Unix time the last transaction finished.");
+            out << "starpack_transaction_timestamp_seconds{" << cmd << "} " << finishedAt << "\n";
+            metric(out, "starpack_transaction_duration_seconds", "gauge",
+                   "Wall time of the last transaction.");
+            out << "starpack_transaction_duration_seconds{" << cmd << "} " << duration << "\n";
+            metric(out, "starpack_transaction_success", "gauge",
+                   "1 if the last transaction exited 0 and recorded no failures.");
+            out << "starpack_transaction_success{" << cmd << "} " << (failures == 0) << "\n";
+            metric(out, "starpack_transaction_failures", "gauge",
+                   "Failures in the last transaction by kind.");
+            out << "starpack_transaction_failures{" << cmd << ",kind=\"total\"} " << failures << "\n";
+            for (const auto& [kind, count] : g_metrics.failures) {
+                out << "starpack_transaction_failures{" << cmd << ",kind=\""
+                    << escapeLabel(kind) << "\"} " << count << "\n";
+            }
+            metric(out, "starpack_download_bytes", "gauge",
+                   "Bytes downloaded by the last transaction.");
+            out << "starpack_download_bytes{" << cmd << "} " << g_metrics.downloadBytes << "\n";
+            metric(out, "starpack_cache_hits", "gauge",
+                   "Repository files (packages, signatures, indices) found in the cache.");
+            out << "starpack_cache_hits{" << cmd << "} " << hits << "\n";
+            metric(out, "starpack_cache_misses", "gauge",
+                   "Repository files downloaded by the last transaction.");
+            out << "starpack_cache_misses{" << cmd << "} " << misses << "\n";
+            metric(out, "starpack_cache_hit_ratio", "gauge",
+                   "Cache hits over lookups in the last transaction (1 without lookups).");
+            out << "starpack_cache_hit_ratio{" << cmd << "} " << hitRatio << "\n";
+            metric(out, "starpack_phase_duration_seconds", "gauge",
+                   "Time per phase in the last transaction, summed over threads.");
+            for (const auto& [phase, us] : g_metrics.phases) {
+                out << "starpack_phase_duration_seconds{" << cmd << ",phase=\""
+                    << escapeLabel(phase) << "\"} " << us / 1e6 << "\n";
+            }
+            metric(out, "starpack_packages_changed", "gauge",
+                   "Packages changed by the last transaction by operation.");
+            for (const auto& [operation, count] : g_metrics.changes) {
+                out << "starpack_packages_changed{" << cmd << ",operation=\""
+                    << escapeLabel(operation) << "\"} " << count << "\n";
+            }
+            metric(out, "starpack_hooks_run", "gauge", "Hooks run by the last transaction.");
+            out << "starpack_hooks_run{" << cmd << "} " << g_metrics.hooks.size() << "\n";
+            // A hook runs once per matching package, so runs are summed per
+            // hook: one series per label set, as the textfile collector requires
+            struct HookTotals {
+                uint64_t runs         = 0;
+                uint64_t microseconds = 0;
+                uint64_t failures     = 0;
+            };
+            std::map<std::string, HookTotals> hookTotals;
+            for (const auto& hook : g_metrics.hooks) {
+                HookTotals& totals = hookTotals[hook.name];
+                totals.runs++;
+                totals.microseconds += hook.microseconds;
+                totals.failures     += hook.ok ? 0 : 1;
+            }
+            metric(out, "starpack_hook_runs", "gauge",
+                   "Runs of each hook in the last transaction.");
+            for (const auto& [name, totals] : hookTotals) {
+                out << "starpack_hook_runs{" << cmd << ",hook=\"" << escapeLabel(name)
+                    << "\"} " << totals.runs << "\n";
+            }
+            metric(out, "starpack_hook_duration_seconds", "gauge",
+                   "Time spent in each hook in the last transaction, summed over its runs.");
+            for (const auto& [name, totals] : hookTotals) {
+                out << "starpack_hook_duration_seconds{" << cmd << ",hook=\"" << escapeLabel(name)
+                    << "\"} " << totals.microseconds / 1e6 << "\n";
+            }
+            metric(out, "starpack_hook_failures", "gauge",
+                   "Failed runs of each hook in the last transaction.");
+            for (const auto& [name, totals] : hookTotals) {
+                out << "starpack_hook_failures{" << cmd << ",hook=\"" << escapeLabel(name)
+                    << "\"} " << totals.failures << "\n";
+            }
+            metric(out, "starpack_peak_rss_bytes", "gauge",
+                   "Peak resident set size of the last transaction.");
+            out << "starpack_peak_rss_bytes{" << cmd << "} " << rss << "\n";
+            ok = writeAtomically(g_metrics.textfilePath, out.str()) && ok;
+        }
+
+        if (!g_metrics.jsonPath.empty()) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(6)
+                << "{\"command\":" << Trace::quote(g_metrics.command)
+                << ",\"timestamp\":" << finishedAt
+                << ",\"duration_seconds\":" << duration
+                << ",\"success\":" << (failures == 0 ? "true" : "false")
+                << ",\"failures\":{\"total\":" << failures;
+            for (const auto& [kind, count] : g_metrics.failures) {
+                out << "," << Trace::quote(kind) << ":" << count;
+            }
+            out << "},\"download_bytes\":" << g_metrics.downloadBytes
+                << ",\"cache\":{\"hits\":" << hits << ",\"misses\":" << misses
+                << ",\"hit_ratio\":" << hitRatio << "}"
+                << ",\"phases\":{";
+            bool first = true;
+            for (const auto& [phase, us] : g_metrics.phases) {
+                out << (first ? "" : ",") << Trace::quote(phase) << ":" << us / 1e6;
+                first = false;
+            }
+            out << "},\"packages_changed\":{";
+            first = true;
+            for (const auto& [operation, count] : g_metrics.changes) {
+                out << (first ? "" : ",") << Trace::quote(operation) << ":" << count;
+                first = false;
+            }
+            out << "},\"hooks\":[";
+            for (size_t i = 0; i < g_metrics.hooks.size(); i++) {
+                const HookRun& hook = g_metrics.hooks[i];
+                out << (i ? "," : "") << "{\"name\":" << Trace::quote(hook.name)
+                    << ",\"seconds\":" << hook.microseconds / 1e6
+                    << ",\"ok\":" << (hook.ok ? "true" : "false") << "}";
+            }
+            out << "],\"peak_rss_bytes\":" << rss << "}\n";
+            ok = writeAtomically(g_metrics.jsonPath, out.str()) && ok;
+        }
+        return ok;
+    }
+
+} // namespace Starpack
@@ -0,0 +1,482 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "object_store.hpp"    // Class definition
+#include "low_impact.hpp"      // Write pacing and page-cache hygiene
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // Reading installed.db
+#include <filesystem>          // Directory handling
+#include <sstream>             // Object ID formatting
+#include <vector>              // Temporary name buffer
+#include <cstdlib>             // mkstemp
+#include <iomanip>             // std::hex, std::setw
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <ctime>               // std::time
+#include <fcntl.h>             // open, O_* flags
+#include <unistd.h>            // write, close, link, unlink, fchown
+#include <sys/stat.h>          // stat, fchmod, futimens
+#include <archive.h>           // Libarchive reading
+#include <archive_entry.h>     // Libarchive entry handling
+#include <openssl/evp.h>       // SHA-256
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        // Files up to this size are hashed in memory and only written if new
+        constexpr size_t kInlineLimit = 4 * 1024 * 1024;
+
+        // Times an object removed by a concurrent sweep is published again
+        constexpr int kPublishRetries = 3;
+
+        std::string g_storeDir;
+
+        /**
+         * -------------------------------------------------------------------
+         * writeAll
+         * -------------------------------------------------------------------
+         */
+        bool writeAll(int fd, const char* data, size_t size) {
+            LowImpact::throttleWrite(size);
+            while (size > 0) {
+                ssize_t n = write(fd, data, size);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * createTempObject
+         *
+         * Creates a temporary file in <store>/tmp (same filesystem as the
+         * objects, so it can be linked into place).
+         * -------------------------------------------------------------------
+         */
+        int createTempObject(const std::string& storeDir, std::string& tmpPath) {
+            std::string pattern = storeDir + "/tmp/obj.XXXXXX";
+            std::vector<char> name(pattern.begin(), pattern.end());
+            name.push_back('\0');
+            int fd = mkstemp(name.data());
+            if (fd >= 0) {
+                tmpPath = name.data();
+            } else {
+                std::cerr << "Error: Cannot create temporary object in " << storeDir
+                          << ": " << strerror(errno) << std::endl;
+            }
+            return fd;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * applyObjectMetadata
+         *
+         * Gives a temporary object the entry's owner, mode and mtime. This
+         * also makes its ctime recent, which is what collectGarbage uses to
+         * leave temporary files of running installs alone.
+         * -------------------------------------------------------------------
+         */
+        void applyObjectMetadata(int fd, struct archive_entry* entry, mode_t perm,
+                                 uid_t uid, gid_t gid, const std::string& objectId) {
+            if (geteuid() == 0 && fchown(fd, uid, gid) != 0) {
+                std::cerr << "Warning: fchown failed for object " << objectId
+                          << ": " << strerror(errno) << std::endl;
+            }
+            fchmod(fd, perm);
+            struct timespec times[2];
+            times[0].tv_sec  = archive_entry_mtime(entry);
+            times[0].tv_nsec = archive_entry_mtime_nsec(entry);
+            times[1] = times[0];
+            futimens(fd, times);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * stageTempObject
+         *
+         * Creates a new temporary object holding the entry's data, taken
+         * from memory or copied from the previous temporary file (dataFd,
+         * still open even if its name was swept or renamed away), which it
+         * then replaces.
+         * -------------------------------------------------------------------
+         */
+        bool stageTempObject(int& dataFd, std::string& tmpPath, const std::string& inlineData,
+                             struct archive_entry* entry, mode_t perm, uid_t uid, gid_t gid,
+                             const std::string& objectId) {
+            std::string newPath;
+            int fd = createTempObject(g_storeDir, newPath);
+            if (fd < 0) {
+                return false;
+            }
+            bool ok = true;
+            if (dataFd < 0) {
+                ok = writeAll(fd, inlineData.data(), inlineData.size());
+            } else {
+                char buffer[65536];
+                off_t offset = 0;
+                ssize_t n;
+                while ((n = pread(dataFd, buffer, sizeof(buffer), offset)) > 0) {
+                    if (!writeAll(fd, buffer, static_cast<size_t>(n))) {
+                        ok = false;
+                        break;
+                    }
+                    offset += n;
+                }
+                ok = ok && n == 0;
+            }
+            if (!ok) {
+                std::cerr << "Error: Cannot write temporary object " << newPath << ": "
+                          << strerror(errno) << std::endl;
+                close(fd);
+                unlink(newPath.c_str());
+                return false;
+            }
+            applyObjectMetadata(fd, entry, perm, uid, gid, objectId);
+            if (dataFd >= 0) {
+                close(dataFd);
+            }
+            dataFd = fd;
+            tmpPath = newPath;
+            return true;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::setStoreDir / storeDir
+     * ------------------------------------------------------------------------
+     */
+    void ObjectStore::setStoreDir(const std::string& dir) {
+        g_storeDir = dir;
+        while (g_storeDir.size() > 1 && g_storeDir.back() == '/') {
+            g_storeDir.pop_back();
+        }
+    }
+
+    const std::string& ObjectStore::storeDir() {
+        return g_storeDir;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::objectPath
+     * ------------------------------------------------------------------------
+     */
+    std::string ObjectStore::objectPath(const std::string& storeDir, const std::string& id) {
+        return storeDir + "/" + id.substr(0, 2) + "/" + id;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::usableFor
+     * ------------------------------------------------------------------------
+     */
+    bool ObjectStore::usableFor(const std::string& installDir) {
+        if (g_storeDir.empty()) {
+            return false;
+        }
+
+        std::error_code ec;
+        fs::create_directories(fs::path(g_storeDir) / "tmp", ec);
+        if (ec) {
+            std::cerr << "Warning: Cannot create object store " << g_storeDir
+                      << ": " << ec.message() << ". Deduplication disabled." << std::endl;
+            return false;
+        }
+
+        struct stat storeStat, rootStat;
+        if (stat(g_storeDir.c_str(), &storeStat) != 0 ||
+            stat(installDir.c_str(), &rootStat) != 0) {
+            return false;
+        }
+        if (storeStat.st_dev != rootStat.st_dev) {
+            std::cerr << "Warning: Object store " << g_storeDir << " is on a different "
+                      << "filesystem than " << installDir
+                      << ". Deduplication disabled for this root." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::linkEntry
+     *
+     * Hashes the entry while reading it. Small files stay in memory and are
+     * only written when the object is new; large ones are spooled to a
+     * temporary file in the store, which is kept open until destPath is
+     * linked. New objects are published with link(), so concurrent
+     * installers racing on the same content are safe.
+     * ------------------------------------------------------------------------
+     */
+    bool ObjectStore::linkEntry(struct archive* a, struct archive_entry* entry,
+                                const std::string& destPath, std::string& objectId) {
+
+        EVP_MD_CTX* md = EVP_MD_CTX_new();
+        if (!md || EVP_DigestInit_ex(md, EVP_sha256(), nullptr) != 1) {
+            std::cerr << "Error: SHA-256 initialisation failed." << std::endl;
+            EVP_MD_CTX_free(md);
+            return false;
+        }
+
+        std::string inlineData;
+        std::string tmpPath;
+        int tmpFd = -1;
+        bool ok = true;
+
+        uint64_t dataSize = 0;
+        char buffer[65536];
+        la_ssize_t n;
+        while ((n = archive_read_data(a, buffer, sizeof(buffer))) > 0) {
+            EVP_DigestUpdate(md, buffer, static_cast<size_t>(n));
+            dataSize += static_cast<uint64_t>(n);
+            if (tmpFd < 0 && inlineData.size() + static_cast<size_t>(n) <= kInlineLimit) {
+                inlineData.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (tmpFd < 0) {
+                tmpFd = createTempObject(g_storeDir, tmpPath);
+                if (tmpFd < 0 || !writeAll(tmpFd, inlineData.data(), inlineData.size())) {
+                    ok = false;
+                    break;
+                }
+                inlineData.clear();
+            }
+            if (!writeAll(tmpFd, buffer, static_cast<size_t>(n))) {
+                ok = false;
+                break;
+            }
+        }
+        if (n < 0) {
+            std::cerr << "Error reading data for " << destPath << ": "
+                      << archive_error_string(a) << std::endl;
+            ok = false;
+        }
+
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLen = 0;
+        EVP_DigestFinal_ex(md, digest, &digestLen);
+        EVP_MD_CTX_free(md);
+
+        mode_t perm = archive_entry_perm(entry) & 07777;
+        uid_t uid = geteuid() == 0 ? static_cast<uid_t>(archive_entry_uid(entry)) : geteuid();
+        gid_t gid = geteuid() == 0 ? static_cast<gid_t>(archive_entry_gid(entry)) : getegid();
+
+        std::ostringstream idStream;
+        for (unsigned int i = 0; i < digestLen; ++i) {
+            idStream << std::hex << std::setw(2) << std::setfill('0')
+                     << static_cast<int>(digest[i]);
+        }
+        idStream << "-" << std::oct << perm << std::dec << "-" << uid << "-" << gid;
+        objectId = idStream.str();
+
+        std::string objPath = objectPath(g_storeDir, objectId);
+        struct stat objStat;
+        bool publish = ok && lstat(objPath.c_str(), &objStat) != 0;
+
+        // Objects may be edited in place through any root that links them.
+        // One that no longer has the entry's size is not this content any
+        // more: a fresh copy replaces it in the store (the roots linking the
+        // edited inode keep it)
+        bool replace = ok && !publish && static_cast<uint64_t>(objStat.st_size) != dataSize;
+        if (replace) {
+            std::cerr << "Warning: Object " << objectId << " was modified in place; "
+                      << "replacing it in the store." << std::endl;
+            publish = true;
+        }
+        if (ok && tmpFd >= 0) {
+            applyObjectMetadata(tmpFd, entry, perm, uid, gid, objectId);
+        }
+
+        // releaseObjects and collectGarbage delete objects whose only link is
+        // the store entry. A new object is in that state until destPath links
+        // it, and an existing one can get there after the lstat above, so an
+        // object that vanishes before it is linked is published again (as is
+        // a temporary file swept by a concurrent clean).
+        for (int attempt = 0; ok; attempt++) {
+            if (attempt > kPublishRetries) {
+                std::cerr << "Error: Cannot link " << destPath << " to object " << objectId
+                          << ": it was removed " << attempt << " times." << std::endl;
+                ok = false;
+                break;
+            }
+            if (publish) {
+                if (tmpPath.empty() &&
+                    !stageTempObject(tmpFd, tmpPath, inlineData, entry, perm, uid, gid, objectId)) {
+                    ok = false;
+                    break;
+                }
+                std::error_code ec;
+                fs::create_directories(fs::path(objPath).parent_path(), ec);
+                if (replace) {
+                    if (rename(tmpPath.c_str(), objPath.c_str()) != 0) {
+                        std::cerr << "Error: Cannot replace object " << objPath << ": "
+                                  << strerror(errno) << std::endl;
+                        ok = false;
+                        break;
+                    }
+                    tmpPath.clear(); // Renamed into place; tmpFd still holds the data
+                    replace = false;
+                } else if (link(tmpPath.c_str(), objPath.c_str()) != 0 && errno != EEXIST) {
+                    if (errno == ENOENT) {
+                        tmpPath.clear(); // Swept; stage a new copy
+                        continue;
+                    }
+                    std::cerr << "Error: Cannot add object " << objPath << ": "
+                              << strerror(errno) << std::endl;
+                    ok = false;
+                    break;
+                }
+                LowImpact::dropFromCache(objPath, true);
+            }
+
+            // Replace whatever is at destPath with a link to the object
+            if (unlink(destPath.c_str()) != 0 && errno != ENOENT) {
+                std::cerr << "Error: Cannot replace " << destPath << ": "
+                          << strerror(errno) << std::endl;
+                ok = false;
+                break;
+            }
+            if (link(objPath.c_str(), destPath.c_str()) == 0) {
+                break;
+            }
+            if (errno != ENOENT) {
+                std::cerr << "Error: Cannot link " << destPath << " to object " << objectId
+                          << ": " << strerror(errno) << std::endl;
+                ok = false;
+                break;
+            }
+            publish = true;
+        }
+
+        if (tmpFd >= 0) {
+            close(tmpFd);
+        }
+        if (!tmpPath.empty()) {
+            unlink(tmpPath.c_str());
+        }
+        return ok;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::readPackageObjects
+     * ------------------------------------------------------------------------
+     */
+    std::vector<StoredObject> ObjectStore::readPackageObjects(const std::string& packageName,
+                                                              const std::string& dbPath,
+                                                              std::string& storeDir) {
+        std::vector<StoredObject> objects;
+        storeDir.clear();
+
+        std::ifstream dbFile(dbPath);
+        if (!dbFile.is_open()) {
+            return objects;
+        }
+
+        std::string line;
+        bool inPackageSection = false;
+        bool inObjectsSection = false;
+        while (std::getline(dbFile, line)) {
+            if (!inPackageSection) {
+                inPackageSection = (line == packageName + " /");
+                continue;
+            }
+            if (line == "----------------------------------------") {
+                break;
+            }
+            if (line.rfind("Object-store: ", 0) == 0) {
+                storeDir = line.substr(14);
+            } else if (line == "Objects:") {
+                inObjectsSection = true;
+            } else if (line == "Dependencies:" || line == "Files:") {
+                inObjectsSection = false;
+            } else if (inObjectsSection) {
+                size_t space = line.find(' ');
+                if (space != std::string::npos) {
+                    objects.push_back({ line.substr(0, space), line.substr(space + 1) });
+                }
+            }
+        }
+        return objects;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::releaseObjects
+     *
+     * An object whose only remaining link is the store entry itself is no
+     * longer used by any root. An installer that loses such an object
+     * between publishing and linking it publishes it again (linkEntry).
+     * ------------------------------------------------------------------------
+     */
+    size_t ObjectStore::releaseObjects(const std::string& storeDir,
+                                       const std::vector<StoredObject>& objects) {
+        size_t released = 0;
+        if (storeDir.empty()) {
+            return released;
+        }
+        for (const auto& object : objects) {
+            std::string objPath = objectPath(storeDir, object.id);
+            struct stat st;
+            if (lstat(objPath.c_str(), &st) == 0 && st.st_nlink == 1 &&
+                unlink(objPath.c_str()) == 0) {
+                released++;
+            }
+        }
+        return released;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * ObjectStore::collectGarbage
+     * ------------------------------------------------------------------------
+     */
+    size_t ObjectStore::collectGarbage(const std::string& storeDir) {
+        size_t released = 0;
+        std::error_code ec;
+        if (storeDir.empty() || !fs::is_directory(storeDir, ec)) {
+            return released;
+        }
+
+        std::time_t staleBefore = std::time(nullptr) - 3600;
+        for (const auto& bucket : fs::directory_iterator(storeDir, ec)) {
+            if (!bucket.is_directory(ec)) {
+                continue;
+            }
+            bool isTmp = bucket.path().filename() == "tmp";
+            for (const auto& object : fs::directory_iterator(bucket.path(), ec)) {
+                struct stat st;
+                std::string path = object.path().string();
+                if (lstat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                    continue;
+                }
+                if (isTmp) {
+                    // Leftovers of interrupted installs; recent ones may still be in
+                    // use. Their mtime is the archive entry's, so the age is the ctime
+                    if (st.st_ctime < staleBefore) {
+                        unlink(path.c_str());
+                    }
+                } else if (st.st_nlink == 1 && unlink(path.c_str()) == 0) {
+                    released++;
+                }
+            }
+        }
+        return released;
+    }
+
+} // namespace Starpack
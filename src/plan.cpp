@@ -0,0 +1,285 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "plan.hpp"            // Class definition
+#include "install.hpp"         // fetchPackages
+#include "utils.hpp"           // sha256File
+#include "events.hpp"          // Confirmation by library consumers
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // Writing the plan
+#include <filesystem>          // Paths, hook directories
+#include <algorithm>           // std::transform
+#include <cctype>              // std::tolower
+#include <ctime>               // Creation time
+#include <yaml-cpp/yaml.h>     // Plan serialization
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        // Host-wide hooks, see Hook::runNewStyleHooks
+        const fs::path kUniversalHookDir = "/etc/starpack.d/universal-hooks/";
+
+        /**
+         * -------------------------------------------------------------------
+         * addHooks
+         * -------------------------------------------------------------------
+         */
+        void addHooks(const fs::path& dir, bool recursive,
+                      std::map<std::string, std::string>& hooks) {
+            std::error_code ec;
+            if (!fs::is_directory(dir, ec)) {
+                return;
+            }
+            auto visit = [&](const fs::directory_entry& entry) {
+                if (entry.is_regular_file(ec) && entry.path().extension() == ".hook") {
+                    hooks[entry.path().string()] = sha256File(entry.path().string());
+                }
+            };
+            if (recursive) {
+                for (const auto& entry : fs::recursive_directory_iterator(dir, ec)) {
+                    visit(entry);
+                }
+            } else {
+                for (const auto& entry : fs::directory_iterator(dir, ec)) {
+                    visit(entry);
+                }
+            }
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * PlanFile::databaseGeneration
+     * ------------------------------------------------------------------------
+     */
+    std::string PlanFile::databaseGeneration(const std::string& installDir) {
+        fs::path dbPath = fs::path(installDir) / "var" / "lib" / "starpack" / "installed.db";
+        std::error_code ec;
+        if (!fs::exists(dbPath, ec)) {
+            return "empty";
+        }
+        return sha256File(dbPath.string());
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * PlanFile::hookSet
+     * ------------------------------------------------------------------------
+     */
+    std::map<std::string, std::string> PlanFile::hookSet(const std::string& installDir) {
+        std::map<std::string, std::string> hooks;
+        addHooks(kUniversalHookDir, false, hooks);
+        addHooks(fs::path(installDir) / "etc" / "starpack" / "hooks", true, hooks);
+        return hooks;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * PlanFile::create
+     * ------------------------------------------------------------------------
+     */
+    bool PlanFile::create(const std::vector<ManifestEntry>& entries,
+                          const std::string& installDir,
+                          const std::string& outputPath) {
+        std::cout << "--- Starpack Plan ---" << std::endl;
+        std::cout << "Target directory: " << installDir << std::endl;
+
+        SyncPlan plan;
+        if (!Sync::computePlan(entries, installDir, plan)) {
+            return false;
+        }
+        Sync::printPlan(plan);
+
+        // Steps 5-6: everything apply needs ends up verified in the cache
+        std::vector<ResolvedPackage> fetchPlan;
+        for (const auto& step : plan.steps) {
+            fetchPlan.push_back(step.package);
+        }
+        if (!fetchPlan.empty() && !Installer::fetchPackages(fetchPlan, installDir)) {
+            return false;
+        }
+
+        YAML::Node doc;
+        doc["format"]        = formatVersion;
+        doc["root"]          = fs::absolute(installDir).lexically_normal().string();
+        doc["created"]       = static_cast<long long>(std::time(nullptr));
+        doc["db_generation"] = databaseGeneration(installDir);
+        doc["unchanged"]     = plan.unchanged;
+
+        for (const auto& step : plan.steps) {
+            std::string hash = sha256File(step.package.archivePath);
+            if (hash.empty()) {
+                std::cerr << "Error: Cannot read " << step.package.archivePath << std::endl;
+                return false;
+            }
+            YAML::Node node;
+            node["name"]              = step.package.name;
+            node["installed_version"] = step.installedVersion;
+            node["repo"]              = step.package.repoUrl;
+            node["sha256"]            = hash;
+            node["metadata"]          = step.package.metadata;
+            doc["steps"].push_back(node);
+        }
+        for (const auto& name : plan.removals) {
+            doc["removals"].push_back(name);
+        }
+        for (const auto& hook : hookSet(installDir)) {
+            YAML::Node node;
+            node["path"]   = hook.first;
+            node["sha256"] = hook.second;
+            doc["hooks"].push_back(node);
+        }
+
+        std::string tmpPath = outputPath + ".part";
+        {
+            std::ofstream out(tmpPath, std::ios::trunc);
+            if (!out) {
+                std::cerr << "Error: Unable to write plan to " << tmpPath << std::endl;
+                return false;
+            }
+            YAML::Emitter emitter;
+            emitter << doc;
+            out << emitter.c_str() << "\n";
+            if (!out) {
+                std::cerr << "Error: Failed writing " << tmpPath << std::endl;
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmpPath, outputPath, ec);
+        if (ec) {
+            std::cerr << "Error: Unable to create " << outputPath << ": "
+                      << ec.message() << std::endl;
+            return false;
+        }
+
+        std::cout << "Plan written to " << outputPath << " (" << plan.steps.size()
+                  << " package(s) cached and verified)." << std::endl;
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * PlanFile::apply
+     * ------------------------------------------------------------------------
+     */
+    bool PlanFile::apply(const std::string& planPath, bool confirm) {
+        std::cout << "--- Starpack Apply ---" << std::endl;
+
+        YAML::Node doc;
+        try {
+            doc = YAML::LoadFile(planPath);
+        } catch (const YAML::Exception& e) {
+            std::cerr << "Error: Cannot read plan " << planPath << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        // A malformed field (wrong type, missing key) throws while decoding
+        std::string installDir;
+        SyncPlan plan;
+        try {
+            if (!doc["format"] || doc["format"].as<int>() != formatVersion ||
+                !doc["root"] || !doc["db_generation"]) {
+                std::cerr << "Error: " << planPath << " is not a Starpack plan (format "
+                          << formatVersion << ")." << std::endl;
+                return false;
+            }
+
+            installDir = doc["root"].as<std::string>();
+            std::cout << "Target directory: " << installDir << std::endl;
+
+            // Drift checks: the root must still be in the state the plan was made for
+            if (databaseGeneration(installDir) != doc["db_generation"].as<std::string>()) {
+                std::cerr << "Error: " << installDir << "/var/lib/starpack/installed.db changed "
+                          << "since the plan was created. Create a new plan." << std::endl;
+                return false;
+            }
+
+            std::map<std::string, std::string> plannedHooks;
+            if (doc["hooks"]) {
+                for (const auto& hook : doc["hooks"]) {
+                    plannedHooks[hook["path"].as<std::string>()] = hook["sha256"].as<std::string>();
+                }
+            }
+            if (hookSet(installDir) != plannedHooks) {
+                std::cerr << "Error: The hooks for " << installDir << " changed since the "
+                          << "plan was created. Create a new plan." << std::endl;
+                return false;
+            }
+
+            plan.prefetched = true;
+            plan.unchanged  = doc["unchanged"] ? doc["unchanged"].as<size_t>() : 0;
+            fs::path cacheDir = fs::path(installDir) / "var" / "lib" / "starpack" / "cache";
+            if (doc["steps"]) {
+                for (const auto& node : doc["steps"]) {
+                    SyncStep step;
+                    step.package.name     = node["name"].as<std::string>();
+                    step.package.repoUrl  = node["repo"].as<std::string>();
+                    step.package.metadata = node["metadata"];
+                    step.installedVersion = node["installed_version"].as<std::string>();
+                    if (!step.package.metadata["file_name"]) {
+                        std::cerr << "Error: Plan entry for " << step.package.name
+                                  << " has no file name." << std::endl;
+                        return false;
+                    }
+                    step.package.archivePath =
+                        (cacheDir / step.package.metadata["file_name"].as<std::string>()).string();
+
+                    // The archive must be the exact file that was verified at plan time
+                    if (sha256File(step.package.archivePath) != node["sha256"].as<std::string>()) {
+                        std::cerr << "Error: Cached archive " << step.package.archivePath
+                                  << " is missing or differs from the planned one." << std::endl;
+                        return false;
+                    }
+                    plan.steps.push_back(step);
+                }
+            }
+            if (doc["removals"]) {
+                for (const auto& node : doc["removals"]) {
+                    plan.removals.push_back(node.as<std::string>());
+                }
+            }
+        } catch (const YAML::Exception& e) {
+            std::cerr << "Error: " << planPath << " is an invalid plan: " << e.what() << std::endl;
+            return false;
+        }
+
+        if (plan.empty()) {
+            std::cout << "The plan contains no changes." << std::endl;
+            return true;
+        }
+
+        Sync::printPlan(plan);
+        if (confirm && Events::active()) {
+            std::vector<std::string> packages;
+            for (const auto& step : plan.steps) {
+                packages.push_back(step.package.name);
+            }
+            packages.insert(packages.end(), plan.removals.begin(), plan.removals.end());
+            if (!Events::confirm("apply", packages)) {
+                std::cout << "Aborting apply." << std::endl;
+                return false;
+            }
+        } else if (confirm) {
+            std::cout << "Proceed? [Y/n]: ";
+            std::string response;
+            std::getline(std::cin, response);
+            std::transform(response.begin(), response.end(), response.begin(),
+                           [](unsigned char c){ return std::tolower(c); });
+            if (!response.empty() && response != "y" && response != "yes") {
+                std::cout << "Aborting apply." << std::endl;
+                return false;
+            }
+        }
+
+        return Sync::applyPlan(plan, installDir);
+    }
+
+} // namespace Starpack
@@ -0,0 +1,301 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "progress.hpp"        // Class definition
+#include "events.hpp"          // Library consumers get events instead
+
+#include <iostream>            // Standard I/O (cout)
+#include <sstream>             // Building the status line
+#include <iomanip>             // Fixed-point sizes and rates
+#include <atomic>              // Task counters
+#include <mutex>               // Activity registry
+#include <condition_variable>  // Renderer ticks and stop
+#include <thread>              // Renderer thread
+#include <vector>              // Running activities
+#include <algorithm>           // std::find, std::min
+#include <chrono>              // Refresh intervals, rates
+#include <unistd.h>            // isatty
+#include <sys/ioctl.h>         // Terminal width
+
+using namespace std::chrono;
+
+namespace Starpack {
+
+    struct Progress::State {
+        std::string    label;
+        Progress::Unit unit;
+        uint64_t       expected;
+
+        // Updated by tasks
+        std::atomic<uint64_t> active{0};
+        std::atomic<uint64_t> finished{0};
+        std::atomic<uint64_t> unknown{0};        // running tasks without a total
+        std::atomic<uint64_t> activeDone{0};
+        std::atomic<uint64_t> activeTotal{0};
+        std::atomic<uint64_t> finishedDone{0};
+
+        // Renderer only
+        uint64_t lastDone = 0;
+        double   rate     = 0;                   // smoothed units per second
+    };
+
+    namespace {
+
+        // Terminal redraw and plain-line intervals
+        constexpr auto kRefresh       = milliseconds(100);
+        constexpr auto kPlainInterval = seconds(3);
+        constexpr int  kBarWidth      = 24;
+
+        std::mutex                     g_mutex;
+        std::condition_variable        g_tick;
+        std::vector<Progress::State*>  g_activities;
+        std::thread                    g_renderer;
+        bool                           g_stop = false;
+
+        std::string humanBytes(double bytes) {
+            static const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+            int unit = 0;
+            while (bytes >= 1024 && unit < 4) {
+                bytes /= 1024;
+                unit++;
+            }
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << bytes << " " << units[unit];
+            return out.str();
+        }
+
+        /**
+         * Fraction done, or a negative value while it cannot be known. With
+         * an expected number of tasks, running transfers count by the share
+         * they received; otherwise the running totals decide.
+         */
+        double fractionOf(const Progress::State& state) {
+            uint64_t active      = state.active.load(std::memory_order_relaxed);
+            uint64_t finished    = state.finished.load(std::memory_order_relaxed);
+            uint64_t unknown     = state.unknown.load(std::memory_order_relaxed);
+            uint64_t activeDone  = state.activeDone.load(std::memory_order_relaxed);
+            uint64_t activeTotal = state.activeTotal.load(std::memory_order_relaxed);
+
+            double activeShare = (unknown == 0 && activeTotal > 0)
+                ? std::min(1.0, static_cast<double>(activeDone) / static_cast<double>(activeTotal))
+                : 0.0;
+            if (state.expected > 0) {
+                double steps = static_cast<double>(finished) + activeShare * static_cast<double>(active);
+                return std::min(1.0, steps / static_cast<double>(state.expected));
+            }
+            if (unknown == 0 && activeTotal > 0) {
+                return activeShare;
+            }
+            return -1.0;
+        }
+
+        uint64_t doneOf(const Progress::State& state) {
+            return state.finishedDone.load(std::memory_order_relaxed) +
+                   state.activeDone.load(std::memory_order_relaxed);
+        }
+
+        /** Terminal form: label, steps, bar, percentage, amount and rate. */
+        std::string drawLine(const Progress::State& state) {
+            std::ostringstream out;
+            out << state.label;
+            if (state.expected > 0) {
+                out << " " << state.finished.load(std::memory_order_relaxed) << "/" << state.expected;
+            }
+            double fraction = fractionOf(state);
+            if (fraction >= 0) {
+                int filled = static_cast<int>(fraction * kBarWidth);
+                out << " [";
+                for (int i = 0; i < kBarWidth; i++) {
+                    out << (i < filled ? '=' : (i == filled ? '>' : ' '));
+                }
+                out << "] " << std::setw(3) << static_cast<int>(fraction * 100) << "%";
+            }
+            if (state.unit == Progress::Unit::Bytes) {
+                out << "  " << humanBytes(static_cast<double>(doneOf(state)));
+                if (state.rate > 0) {
+                    out << "  " << humanBytes(state.rate) << "/s";
+                }
+            }
+            return out.str();
+        }
+
+        /** Plain form for logs and pipes. */
+        std::string plainLine(const Progress::State& state) {
+            std::ostringstream out;
+            out << state.label << ":";
+            if (state.expected > 0) {
+                out << " " << state.finished.load(std::memory_order_relaxed) << "/" << state.expected;
+            }
+            double fraction = fractionOf(state);
+            if (fraction >= 0) {
+                out << " (" << static_cast<int>(fraction * 100) << "%)";
+            }
+            if (state.unit == Progress::Unit::Bytes) {
+                out << ", " << humanBytes(static_cast<double>(doneOf(state)));
+                if (state.rate > 0) {
+                    out << " at " << humanBytes(state.rate) << "/s";
+                }
+            }
+            return out.str();
+        }
+
+        /**
+         * Renderer thread: the only writer of the progress view. Runs while
+         * at least one activity exists.
+         */
+        void renderLoop() {
+            const bool tty = isatty(STDOUT_FILENO);
+            size_t width = 80;
+            struct winsize size;
+            if (tty && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+                width = size.ws_col;
+            }
+
+            bool drawn = false;
+            auto last = steady_clock::now();
+            auto nextPlain = last + kPlainInterval;
+
+            std::unique_lock<std::mutex> lock(g_mutex);
+            while (!g_tick.wait_for(lock, kRefresh, [] { return g_stop; })) {
+                auto now = steady_clock::now();
+                double elapsed = duration<double>(now - last).count();
+                last = now;
+
+                std::string view;
+                for (Progress::State* state : g_activities) {
+                    uint64_t done = doneOf(*state);
+                    if (elapsed > 0 && done >= state->lastDone) {
+                        double sample = static_cast<double>(done - state->lastDone) / elapsed;
+                        state->rate = (state->rate <= 0) ? sample : 0.8 * state->rate + 0.2 * sample;
+                    }
+                    state->lastDone = done;
+
+                    if (tty) {
+                        view += (view.empty() ? "" : "  |  ") + drawLine(*state);
+                    } else if (now >= nextPlain) {
+                        view += plainLine(*state) + "\n";
+                    }
+                }
+                if (view.empty()) {
+                    continue;
+                }
+                if (!tty) {
+                    nextPlain = now + kPlainInterval;
+                }
+
+                lock.unlock();
+                if (tty) {
+                    if (view.size() >= width) {
+                        view.resize(width - 1);
+                    }
+                    std::cout << "\r" << view << "\033[K" << std::flush;
+                    drawn = true;
+                } else {
+                    std::cout << view << std::flush;
+                }
+                lock.lock();
+            }
+            lock.unlock();
+
+            if (drawn) {
+                std::cout << "\r\033[K" << std::flush;
+            }
+        }
+
+    } // anonymous namespace
+
+    /** ---- Progress::Activity ---- */
+    Progress::Activity::Activity(const std::string& label, Unit unit, uint64_t expectedTasks)
+        : state_(nullptr) {
+        if (Events::active()) {
+            return;
+        }
+        state_ = new State();
+        state_->label    = label;
+        state_->unit     = unit;
+        state_->expected = expectedTasks;
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_activities.push_back(state_);
+        if (!g_renderer.joinable()) {
+            g_stop = false;
+            g_renderer = std::thread(renderLoop);
+        }
+    }
+
+    Progress::Activity::~Activity() {
+        if (!state_) {
+            return;
+        }
+        std::thread renderer;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_activities.erase(std::find(g_activities.begin(), g_activities.end(), state_));
+            if (g_activities.empty()) {
+                g_stop = true;
+                renderer = std::move(g_renderer);
+            }
+        }
+        if (renderer.joinable()) {
+            g_tick.notify_all();
+            renderer.join();
+        }
+        delete state_;
+    }
+
+    void Progress::Activity::advance(uint64_t steps) {
+        if (state_) {
+            state_->finished.fetch_add(steps, std::memory_order_relaxed);
+        }
+    }
+
+    /** ---- Progress::Task ---- */
+    Progress::Task::Task(Activity& activity, uint64_t total)
+        : state_(activity.state_), total_(total) {
+        if (!state_) {
+            return;
+        }
+        state_->active.fetch_add(1, std::memory_order_relaxed);
+        if (total_ == 0) {
+            state_->unknown.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            state_->activeTotal.fetch_add(total_, std::memory_order_relaxed);
+        }
+    }
+
+    Progress::Task::~Task() {
+        if (!state_) {
+            return;
+        }
+        if (total_ == 0) {
+            state_->unknown.fetch_sub(1, std::memory_order_relaxed);
+        }
+        state_->activeTotal.fetch_sub(total_, std::memory_order_relaxed);
+        state_->activeDone.fetch_sub(done_, std::memory_order_relaxed);
+        state_->finishedDone.fetch_add(done_, std::memory_order_relaxed);
+        state_->finished.fetch_add(1, std::memory_order_relaxed);
+        state_->active.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Progress::Task::update(uint64_t done, uint64_t total) {
+        if (!state_) {
+            return;
+        }
+        if (total != total_) {
+            if (total_ == 0) {
+                state_->unknown.fetch_sub(1, std::memory_order_relaxed);
+            } else if (total == 0) {
+                state_->unknown.fetch_add(1, std::memory_order_relaxed);
+            }
+            // Unsigned wrap-around makes this a signed adjustment
+            state_->activeTotal.fetch_add(total - total_, std::memory_order_relaxed);
+            total_ = total;
+        }
+        if (done != done_) {
+            state_->activeDone.fetch_add(done - done_, std::memory_order_relaxed);
+            done_ = done;
+        }
+    }
+
+} // namespace Starpack
@@ -1,6 +1,12 @@
 #include "remove.hpp"      // Functions definitions
 #include "hook.hpp"
 #include "install.hpp"     // Starpack::Installer::isPackageInstalled
+#include "object_store.hpp" // Starpack::ObjectStore garbage collection
+#include "trace.hpp"       // --trace phase spans
+#include "metrics.hpp"     // Transaction metrics
+#include "log.hpp"         // Per-file detail at debug level
+#include "config.hpp"      // Durability setting
+#include "utils.hpp"       // syncFile
 #include <chroot_util.hpp> // Starpack::ChrootUtil support
 
 #include <iostream>
@@ -277,7 +283,8 @@ std::vector<std::string> getFilesToRemove(const std::string& packageName, const
                 inFilesSection = true;
                 continue;
             }
-            if (line == "Dependencies:" || line == "----------------------------------------") {
+            if (line == "Dependencies:" || line == "Objects:" ||
+                line == "----------------------------------------") {
                 inFilesSection = false;
                 if (line == "----------------------------------------") {
                     inPackageSection = false;
@@ -335,14 +342,14 @@ void removeFiles(const std::vector<std::string>& filesToRemove, const std::strin
                 // Remove empty directories
                 if (fs::is_empty(absPath)) {
                     fs::remove(absPath);
-                    std::cout << "Removed directory: " << absPath.string() << std::endl;
+                    Log::debug("Removed directory: " + absPath.string());
                 } else {
-                    std::cout << "Skipping non-empty directory (may contain other files): "
-                              << absPath.string() << std::endl;
+                    Log::debug("Skipping non-empty directory (may contain other files): " +
+                               absPath.string());
                 }
             } else {
                 fs::remove(absPath);
-                std::cout << "Removed: " << absPath.string() << std::endl;
+                Log::debug("Removed: " + absPath.string());
             }
         } catch (const fs::filesystem_error& e) {
             std::cerr << "Error removing path: " << absPath.string()
@@ -375,8 +382,7 @@ void removeFiles(const std::vector<std::string>& filesToRemove, const std::strin
                 fs::is_empty(absPath))
             {
                 fs::remove(absPath);
-                std::cout << "Removed now-empty directory: "
-                          << absPath.string() << std::endl;
+                Log::debug("Removed now-empty directory: " + absPath.string());
             }
         } catch (const std::exception& e) {
         }
@@ -428,6 +434,19 @@ void updateDatabase(const std::string& packageName, const std::string& dbPath)
 
     dbFile.close();
     tempDbFile.close();
+    if (!tempDbFile) {
+        fs::remove(tempDbFilePath);
+        throw std::runtime_error("Error: Failed writing temporary DB file: " +
+                                 tempDbFilePath.string());
+    }
+
+    // The new DB reaches the disk before it replaces the old one
+    Starpack::Durability durability = Starpack::Config::current().settings.durability;
+    if (durability != Starpack::Durability::None && !Starpack::syncFile(tempDbFilePath.string())) {
+        fs::remove(tempDbFilePath);
+        throw std::runtime_error("Error: Unable to sync temporary DB file: " +
+                                 tempDbFilePath.string());
+    }
 
     // Replace the original DB file with the temp file
     try {
@@ -437,6 +456,10 @@ void updateDatabase(const std::string& packageName, const std::string& dbPath)
         throw std::runtime_error("Error: Failed to update DB file '" +
                                  dbPath + "'. Reason: " + e.what());
     }
+    if (durability == Starpack::Durability::Full &&
+        !Starpack::syncFile(dbFilePath.parent_path().string())) {
+        std::cerr << "Warning: Could not sync " << dbFilePath.parent_path().string() << ".\n";
+    }
     std::cout << "Database " << dbPath << " updated (removed entry for "
               << packageName << ").\n";
 }
@@ -460,6 +483,7 @@ void removePackages(const std::vector<std::string>& packageNames,
         }
         processedPackages.insert(currentPackage);
 
+        Trace::Span removeSpan("remove", "remove", currentPackage);
         std::cout << "--- Processing removal for: " << currentPackage << " ---\n";
 
         // A) Basic checks
@@ -533,6 +557,10 @@ void removePackages(const std::vector<std::string>& packageNames,
             }
         }
 
+        // Objects in the store that this package links to
+        std::string objectStoreDir;
+        auto storedObjects = ObjectStore::readPackageObjects(currentPackage, dbPath, objectStoreDir);
+
         // D) Run PreRemove hooks
         std::cout << "Running PreRemove hooks for " << currentPackage << "...\n";
         Hook::runNewStyleHooks("PreRemove", "Remove", relativePaths, installDir, currentPackage);
@@ -545,14 +573,23 @@ void removePackages(const std::vector<std::string>& packageNames,
         try {
             updateDatabase(currentPackage, dbPath);
             successfullyRemoved.push_back(currentPackage);
+            Metrics::addPackageChange("remove");
             std::cout << "Package '" << currentPackage << "' processing complete.\n";
         } catch (const std::exception& e) {
             std::cerr << "Error updating DB after removing " << currentPackage
                       << ": " << e.what() << "\nDatabase may be inconsistent.\n";
+            Metrics::addFailure("db");
             // Decide whether to proceed
             continue;
         }
 
+        // Drop store objects that no root links to any more
+        if (!storedObjects.empty()) {
+            size_t released = ObjectStore::releaseObjects(objectStoreDir, storedObjects);
+            std::cout << "Released " << released << " unreferenced object(s) from "
+                      << objectStoreDir << ".\n";
+        }
+
         // G) Run PostRemove hooks
         std::cout << "Running PostRemove hooks for " << currentPackage << "...\n";
         Hook::runNewStyleHooks("PostRemove", "Remove", relativePaths, installDir, currentPackage);
@@ -1,5 +1,6 @@
 #include "repository.hpp"
 #include "utils.hpp"
+#include "version.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -17,10 +18,8 @@
 #include <ctime>
 #include <unordered_set>
 #include <future>      // For parallel processing
-#include <mutex> // So output isn't garbled
 
 namespace fs = std::filesystem;
-std::mutex cout_mutex;
 
 namespace Starpack {
 
@@ -145,6 +144,29 @@ std::string getArchiveUpdateTime(const std::string& packagePath)
     }
 }
 
+/**
+ * @brief Build identifier of an archive: the packager's build_epoch from
+ *        metadata.yaml if given, otherwise the archive mtime in seconds
+ *        since the Unix epoch. Rebuilds of a version get larger values.
+ */
+int64_t getArchiveBuildEpoch(const std::string& packagePath, const YAML::Node& metadata)
+{
+    if (metadata["build_epoch"] && metadata["build_epoch"].IsScalar()) {
+        int64_t epoch = metadata["build_epoch"].as<int64_t>(0);
+        if (epoch > 0) {
+            return epoch;
+        }
+    }
+    std::error_code ec;
+    auto ftime = fs::last_write_time(packagePath, ec);
+    if (ec) {
+        std::cerr << "Error getting archive build time: " << ec.message() << "\n";
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::file_clock::to_sys(ftime).time_since_epoch()).count();
+}
+
 /**
  * @brief Extracts a single file (e.g., "metadata.yaml") from the archive
  *        to the specified directory using libarchive.
@@ -276,11 +298,7 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
     YAML::Node pkgNode;
     fs::path fileName = packagePath.filename();
     
-    // Lock for synchronized output.
-    {
-        std::lock_guard<std::mutex> lock(cout_mutex);
-        std::cout << "Processing package: " << packagePath.string() << std::endl;
-    }
+    Log::debug("Processing package: " + packagePath.string());
 
     // Create a unique temporary directory for this package
     fs::path tempDir = baseCacheDir / fileName.stem();
@@ -288,7 +306,6 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
     fs::remove_all(tempDir, ec); // Clean up from previous run
     fs::create_directories(tempDir, ec);
     if (ec) {
-        std::lock_guard<std::mutex> lock(cout_mutex);
         std::cerr << "Error: Failed to create temporary directory "
                   << tempDir << ": " << ec.message() << std::endl;
         return pkgNode;
@@ -296,11 +313,8 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
 
     // Extract metadata.yaml
     if (!extractFileFromArchive(packagePath.string(), "metadata.yaml", tempDir.string())) {
-        {
-            std::lock_guard<std::mutex> lock(cout_mutex);
-            std::cerr << "Error: Failed to extract metadata.yaml from "
-                      << packagePath.string() << std::endl;
-        }
+        std::cerr << "Error: Failed to extract metadata.yaml from "
+                  << packagePath.string() << std::endl;
         fs::remove_all(tempDir, ec);
         return pkgNode;
     }
@@ -309,7 +323,6 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
     fs::path extractedFilesDir = tempDir / "files";
     if (!extractDirectoryFromArchive(packagePath.string(), "files", tempDir.string()))
     {
-        std::lock_guard<std::mutex> lock(cout_mutex);
         std::cerr << "Error: Failed to extract files directory from "
                   << packagePath.string() << std::endl;
         // Continue even if files extraction fails; file list will be empty.
@@ -329,6 +342,7 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
 
         // Version
         pkgNode["version"] = metadata["version"].as<std::string>();
+        pkgNode["version_key"] = Version::indexKey(pkgNode["version"].as<std::string>());
 
         // Description
         pkgNode["description"] = metadata["description"].as<std::string>();
@@ -386,6 +400,13 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
             pkgNode["update_time"] = updateTime;
         }
 
+        // Build identifiers compared by the upgrade planner
+        int64_t buildEpoch = getArchiveBuildEpoch(packagePath.string(), metadata);
+        if (buildEpoch > 0) {
+            pkgNode["build_epoch"] = buildEpoch;
+        }
+        pkgNode["sha256"] = sha256File(packagePath.string());
+
         // update_dirs (optional)
         if (metadata["update_dirs"]) {
             pkgNode["update_dirs"] = metadata["update_dirs"];
@@ -403,7 +424,6 @@ YAML::Node processPackageForIndex(const fs::path& packagePath, const fs::path& b
     // Cleanup temporary directory
     fs::remove_all(tempDir, ec);
     if (ec) {
-        std::lock_guard<std::mutex> lock(cout_mutex);
         std::cerr << "Warning: Failed to remove temporary directory "
                   << tempDir << ": " << ec.message() << std::endl;
     }
@@ -546,6 +566,7 @@ void Repository::addMissingPackagesToIndex(const std::string& location)
                     pkgName = removeSlashAndAfter(pkgName);
                     pkgEntry["name"] = pkgName;
                     pkgEntry["version"] = metadata["version"].as<std::string>();
+                    pkgEntry["version_key"] = Version::indexKey(pkgEntry["version"].as<std::string>());
                     pkgEntry["description"] = metadata["description"].as<std::string>();
                     pkgEntry["file_name"] = fileName;
 
@@ -568,6 +589,12 @@ void Repository::addMissingPackagesToIndex(const std::string& location)
                         pkgEntry["update_time"] = updateTime;
                     }
 
+                    int64_t buildEpoch = getArchiveBuildEpoch(entry.path().string(), metadata);
+                    if (buildEpoch > 0) {
+                        pkgEntry["build_epoch"] = buildEpoch;
+                    }
+                    pkgEntry["sha256"] = sha256File(entry.path().string());
+
                     YAML::Node filesNode(YAML::NodeType::Sequence);
                     std::string filesPath = tempDir + "/files";
                     if (fs::exists(filesPath) && fs::is_directory(filesPath)) {
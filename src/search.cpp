@@ -1,5 +1,6 @@
 #include "search.hpp"
 #include "utils.hpp"
+#include "config.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -17,27 +18,17 @@ namespace Starpack {
 // ============================================================================
 // Helper: loadRepoUrls
 // ============================================================================
-// Reads repository entries from /etc/starpack/repos.conf, ensuring each line
-// ends with a slash, then appending 'repo.db.yaml'.
+// Returns the index URL ('repo.db.yaml') of every repository in configPath,
+// highest priority first.
 std::vector<std::string> loadRepoUrls(const std::string& configPath)
 {
-    std::ifstream configFile(configPath);
-    if (!configFile.is_open()) {
+    if (!fs::exists(configPath)) {
         throw std::runtime_error("Failed to open config file: " + configPath);
     }
 
     std::vector<std::string> repoUrls;
-    std::string line;
-
-    while (std::getline(configFile, line)) {
-        // Skip empty lines and comments
-        if (!line.empty() && line[0] != '#') {
-            if (line.back() != '/') {
-                line += '/';  // Ensure slash at the end
-            }
-            line += "repo.db.yaml";  // Append the repository filename
-            repoUrls.push_back(line);
-        }
+    for (const auto& repo : Config::forReposFile(configPath).byPriority()) {
+        repoUrls.push_back(repo.url + "repo.db.yaml");
     }
     return repoUrls;
 }
@@ -0,0 +1,490 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "serve.hpp"           // Class definition
+#include "config.hpp"          // Default upstream from repos.conf
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <filesystem>          // Cache paths
+#include <map>                 // In-flight fills
+#include <memory>              // std::shared_ptr
+#include <mutex>               // std::mutex, std::lock_guard
+#include <condition_variable>  // Waiting for a coalesced fill
+#include <thread>              // One thread per connection
+#include <chrono>              // Back-off on accept errors
+#include <algorithm>           // std::replace
+#include <cctype>              // std::isalnum, std::tolower
+#include <cstring>             // strerror
+#include <cerrno>              // errno
+#include <csignal>             // Ignoring SIGPIPE
+#include <ctime>               // Index age
+#include <curl/curl.h>         // Upstream fetches
+#include <fcntl.h>             // open
+#include <unistd.h>            // close, read
+#include <sys/stat.h>          // fstat, stat
+#include <sys/socket.h>        // socket, bind, listen, accept, send
+#include <sys/sendfile.h>      // sendfile
+#include <netinet/in.h>        // sockaddr_in
+#include <arpa/inet.h>         // inet_pton, inet_ntop
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        // An idle keep-alive connection is closed after this many seconds
+        constexpr int kIdleTimeout = 30;
+
+        // Largest request head that is accepted
+        constexpr size_t kMaxRequestHead = 16 * 1024;
+
+        /**
+         * -------------------------------------------------------------------
+         * Fill
+         *
+         * One upstream download that any number of requests may wait for.
+         * -------------------------------------------------------------------
+         */
+        struct Fill {
+            std::mutex              mutex;
+            std::condition_variable cv;
+            bool                    done = false;
+            bool                    ok   = false;
+        };
+
+        struct ServerState {
+            std::string upstream;
+            fs::path    cacheDir;
+            std::string indexFile;   // Local name of the upstream's repo.db.yaml
+            int         indexTtl = 60;
+
+            std::mutex                                   fillMutex;
+            std::map<std::string, std::shared_ptr<Fill>> fills;
+            std::mutex                                   logMutex;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * validName
+         *
+         * Only plain file names are served; no directories, no dot files.
+         * -------------------------------------------------------------------
+         */
+        bool validName(const std::string& name) {
+            if (name.empty() || name[0] == '.' || name.size() > 255) {
+                return false;
+            }
+            return std::all_of(name.begin(), name.end(), [](unsigned char c) {
+                return std::isalnum(c) || c == '.' || c == '-' || c == '_' || c == '+' || c == '~';
+            });
+        }
+
+        size_t writeToFd(void* ptr, size_t size, size_t nmemb, void* userdata) {
+            int fd = *static_cast<int*>(userdata);
+            const char* data = static_cast<const char*>(ptr);
+            size_t left = size * nmemb;
+            while (left > 0) {
+                ssize_t n = write(fd, data, left);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return 0;
+                }
+                data += n;
+                left -= static_cast<size_t>(n);
+            }
+            return size * nmemb;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * fetchUpstream
+         *
+         * Downloads url to path via a temporary file, quietly (the server
+         * log has one line per request instead of progress bars).
+         * -------------------------------------------------------------------
+         */
+        bool fetchUpstream(const std::string& url, const fs::path& path, std::string& error) {
+            std::string tmpPath = path.string() + ".serve-part";
+            int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                error = std::string("cannot create ") + tmpPath + ": " + strerror(errno);
+                return false;
+            }
+
+            CURL* curl = curl_easy_init();
+            if (!curl) {
+                close(fd);
+                unlink(tmpPath.c_str());
+                error = "curl_easy_init failed";
+                return false;
+            }
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeToFd);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &fd);
+            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L);
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+            curl_easy_setopt(curl, CURLOPT_USERAGENT, "Starpack/1.0 (serve)");
+
+            CURLcode res = curl_easy_perform(curl);
+            curl_easy_cleanup(curl);
+            bool ok = (res == CURLE_OK) && fsync(fd) == 0;
+            close(fd);
+
+            if (!ok) {
+                error = res != CURLE_OK ? curl_easy_strerror(res) : "write failed";
+                unlink(tmpPath.c_str());
+                return false;
+            }
+            if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+                error = std::string("cannot move ") + tmpPath + " into place: " + strerror(errno);
+                unlink(tmpPath.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * ensureCached
+         *
+         * Makes sure the requested file is in the cache. Returns "hit",
+         * "miss" (this request filled it), "coalesced" (waited for another
+         * request's fill), "stale" (upstream failed, old index served) or
+         * an empty string if the file is not available.
+         * -------------------------------------------------------------------
+         */
+        std::string ensureCached(ServerState& state, const std::string& name,
+                                 const fs::path& localPath, bool isIndex) {
+            bool present = false;
+            auto fresh = [&] {
+                struct stat st;
+                present = stat(localPath.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+                return present && (!isIndex || std::time(nullptr) - st.st_mtime < state.indexTtl);
+            };
+            if (fresh()) {
+                return "hit";
+            }
+
+            std::shared_ptr<Fill> fill;
+            bool owner = false;
+            {
+                std::lock_guard<std::mutex> lock(state.fillMutex);
+                auto it = state.fills.find(name);
+                if (it != state.fills.end()) {
+                    fill = it->second;
+                } else {
+                    fill = std::make_shared<Fill>();
+                    state.fills[name] = fill;
+                    owner = true;
+                }
+            }
+
+            bool filled = false;
+            if (owner) {
+                // A fill may have completed between the check above and now
+                std::string error;
+                filled = fresh();
+                bool ok = filled || fetchUpstream(state.upstream + name, localPath, error);
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(state.logMutex);
+                    std::cerr << "[serve] Upstream fetch of " << state.upstream << name
+                              << " failed: " << error << std::endl;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(state.fillMutex);
+                    state.fills.erase(name);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(fill->mutex);
+                    fill->done = true;
+                    fill->ok   = ok;
+                }
+                fill->cv.notify_all();
+            } else {
+                std::unique_lock<std::mutex> lock(fill->mutex);
+                fill->cv.wait(lock, [&] { return fill->done; });
+            }
+
+            if (fill->ok) {
+                return owner ? (filled ? "hit" : "miss") : "coalesced";
+            }
+            return present ? "stale" : "";
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * sendAll
+         * -------------------------------------------------------------------
+         */
+        bool sendAll(int fd, const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool sendStatus(int fd, int code, const std::string& reason, bool keepAlive) {
+            std::string body = std::to_string(code) + " " + reason + "\n";
+            return sendAll(fd, "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n"
+                               "Content-Type: text/plain\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                               (keepAlive ? "" : "Connection: close\r\n") +
+                               "\r\n" + body);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * sendCachedFile
+         *
+         * Headers go out with send(), the body straight from the page cache
+         * with sendfile().
+         * -------------------------------------------------------------------
+         */
+        bool sendCachedFile(int sock, const fs::path& path, bool headOnly, bool keepAlive,
+                            off_t& bytesSent) {
+            bytesSent = 0;
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return sendStatus(sock, 404, "Not Found", keepAlive);
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                return sendStatus(sock, 500, "Internal Server Error", keepAlive);
+            }
+
+            std::string head = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: application/octet-stream\r\n"
+                               "Content-Length: " + std::to_string(st.st_size) + "\r\n";
+            head += keepAlive ? "" : "Connection: close\r\n";
+            head += "\r\n";
+            bool ok = sendAll(sock, head);
+
+            off_t offset = 0;
+            while (ok && !headOnly && offset < st.st_size) {
+                ssize_t n = sendfile(sock, fd, &offset, static_cast<size_t>(st.st_size - offset));
+                if (n < 0) {
+                    if (errno == EINTR || errno == EAGAIN) {
+                        continue;
+                    }
+                    ok = false;
+                } else if (n == 0) {
+                    ok = false; // File shrank underneath us
+                }
+            }
+            bytesSent = offset;
+            close(fd);
+            return ok;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * handleConnection
+         *
+         * Serves GET and HEAD requests on one connection, keeping it open
+         * between requests unless the client asks otherwise.
+         * -------------------------------------------------------------------
+         */
+        void handleConnection(int sock, std::string peer, ServerState& state) {
+            struct timeval timeout{ kIdleTimeout, 0 };
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            std::string buffer;
+            char chunk[4096];
+            bool keepAlive = true;
+
+            while (keepAlive) {
+                size_t headEnd;
+                while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                    if (buffer.size() > kMaxRequestHead) {
+                        sendStatus(sock, 431, "Request Header Fields Too Large", false);
+                        close(sock);
+                        return;
+                    }
+                    ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+                    if (n <= 0) {
+                        close(sock);
+                        return;
+                    }
+                    buffer.append(chunk, static_cast<size_t>(n));
+                }
+                std::string head = buffer.substr(0, headEnd);
+                buffer.erase(0, headEnd + 4);
+
+                // Request line: METHOD TARGET VERSION
+                size_t lineEnd = head.find("\r\n");
+                std::string requestLine = head.substr(0, lineEnd);
+                size_t sp1 = requestLine.find(' ');
+                size_t sp2 = requestLine.rfind(' ');
+                if (sp1 == std::string::npos || sp2 == sp1) {
+                    sendStatus(sock, 400, "Bad Request", false);
+                    break;
+                }
+                std::string method  = requestLine.substr(0, sp1);
+                std::string target  = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+                std::string version = requestLine.substr(sp2 + 1);
+
+                keepAlive = (version == "HTTP/1.1");
+                std::string lowerHead = head;
+                std::transform(lowerHead.begin(), lowerHead.end(), lowerHead.begin(),
+                               [](unsigned char c){ return std::tolower(c); });
+                if (lowerHead.find("\r\nconnection: close") != std::string::npos) {
+                    keepAlive = false;
+                } else if (lowerHead.find("\r\nconnection: keep-alive") != std::string::npos) {
+                    keepAlive = true;
+                }
+
+                if (method != "GET" && method != "HEAD") {
+                    sendStatus(sock, 405, "Method Not Allowed", false);
+                    break;
+                }
+
+                std::string name = target.substr(0, target.find('?'));
+                if (!name.empty() && name[0] == '/') {
+                    name.erase(0, 1);
+                }
+                if (!validName(name)) {
+                    if (!sendStatus(sock, 404, "Not Found", keepAlive)) {
+                        break;
+                    }
+                    continue;
+                }
+
+                bool isIndex = (name == "repo.db.yaml");
+                fs::path localPath = state.cacheDir / (isIndex ? state.indexFile : name);
+                std::string outcome = ensureCached(state, name, localPath, isIndex);
+
+                off_t bytesSent = 0;
+                bool ok;
+                if (outcome.empty()) {
+                    ok = sendStatus(sock, 404, "Not Found", keepAlive);
+                } else {
+                    ok = sendCachedFile(sock, localPath, method == "HEAD", keepAlive, bytesSent);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(state.logMutex);
+                    std::cout << "[serve] " << peer << " " << method << " /" << name << " "
+                              << (outcome.empty() ? "404" : "200 " + outcome) << " "
+                              << bytesSent << std::endl;
+                }
+                if (!ok) {
+                    break;
+                }
+            }
+            close(sock);
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * CacheServer::run
+     * ------------------------------------------------------------------------
+     */
+    bool CacheServer::run(const ServeOptions& options) {
+        ServerState state;
+        state.indexTtl = options.indexTtl;
+        state.upstream = options.upstream;
+        if (state.upstream.empty()) {
+            std::vector<RepositoryConfig> repositories = Config::current().byPriority();
+            if (repositories.empty()) {
+                std::cerr << "Error: No upstream given and no repositories configured." << std::endl;
+                return false;
+            }
+            state.upstream = repositories.front().url;
+        }
+        if (state.upstream.back() != '/') {
+            state.upstream += '/';
+        }
+
+        // Same cache and index naming as the installer, so the serving host's
+        // own installs and the fleet share one cache
+        state.cacheDir = fs::path(options.installDir) / "var" / "lib" / "starpack" / "cache";
+        std::error_code ec;
+        fs::create_directories(state.cacheDir, ec);
+        if (ec) {
+            std::cerr << "Error: Cannot create cache directory " << state.cacheDir.string()
+                      << ": " << ec.message() << std::endl;
+            return false;
+        }
+        state.indexFile = state.upstream;
+        std::replace(state.indexFile.begin(), state.indexFile.end(), '/', '_');
+        std::replace(state.indexFile.begin(), state.indexFile.end(), ':', '_');
+        state.indexFile += "repo.db.yaml";
+
+        int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            std::cerr << "Error: socket() failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons(static_cast<uint16_t>(options.port));
+        if (inet_pton(AF_INET, options.bindAddress.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "Error: Invalid bind address " << options.bindAddress << std::endl;
+            close(listenFd);
+            return false;
+        }
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 128) != 0) {
+            std::cerr << "Error: Cannot listen on " << options.bindAddress << ":" << options.port
+                      << ": " << strerror(errno) << std::endl;
+            close(listenFd);
+            return false;
+        }
+
+        // Clients that hang up mid-transfer must not kill the server
+        std::signal(SIGPIPE, SIG_IGN);
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+
+        std::cout << "Serving " << state.cacheDir.string() << " on http://"
+                  << options.bindAddress << ":" << options.port << "/ (upstream "
+                  << state.upstream << ", index TTL " << state.indexTtl << "s)" << std::endl;
+
+        while (true) {
+            sockaddr_in peerAddr{};
+            socklen_t   peerLen = sizeof(peerAddr);
+            int sock = accept4(listenFd, reinterpret_cast<sockaddr*>(&peerAddr), &peerLen,
+                               SOCK_CLOEXEC);
+            if (sock < 0) {
+                if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE ||
+                    errno == ENFILE) {
+                    if (errno == EMFILE || errno == ENFILE) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+                    continue;
+                }
+                std::cerr << "Error: accept() failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            char peer[INET_ADDRSTRLEN] = "?";
+            inet_ntop(AF_INET, &peerAddr.sin_addr, peer, sizeof(peer));
+            std::thread(handleConnection, sock, std::string(peer), std::ref(state)).detach();
+        }
+
+        close(listenFd);
+        curl_global_cleanup();
+        return false;
+    }
+
+} // namespace Starpack
@@ -0,0 +1,181 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "starpack.hpp"        // Class definition
+#include "install.hpp"         // Repository index, PackageSourceCache
+
+#include <iostream>            // Standard I/O (cerr)
+#include <filesystem>          // Cache paths
+#include <algorithm>           // std::sort, std::find
+#include <unordered_set>       // Names to remove
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        bool loadSources(const std::string& installDir, PackageSourceCache& sources) {
+            fs::path cacheDir = fs::path(installDir) / "var" / "lib" / "starpack" / "cache";
+            std::error_code ec;
+            fs::create_directories(cacheDir, ec);
+            return Installer::loadRepositoryIndex(cacheDir.string(), sources);
+        }
+
+        PackageSummary summarize(const std::string& repoUrl, const YAML::Node& node) {
+            PackageSummary package;
+            package.repository  = repoUrl;
+            package.name        = node["name"] ? node["name"].as<std::string>() : "";
+            package.version     = node["version"] ? node["version"].as<std::string>() : "";
+            package.description = node["description"] ? node["description"].as<std::string>() : "";
+            if (node["dependencies"] && node["dependencies"].IsSequence()) {
+                for (const auto& dep : node["dependencies"]) {
+                    package.dependencies.push_back(dep.as<std::string>());
+                }
+            }
+            return package;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::setEventHandler
+     * ------------------------------------------------------------------------
+     */
+    void Library::setEventHandler(EventHandler* handler) {
+        Events::setHandler(handler);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::installedPackages
+     * ------------------------------------------------------------------------
+     */
+    std::vector<ManifestEntry> Library::installedPackages(const std::string& installDir) {
+        return Sync::installedEntries(installDir);
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::findPackage
+     * ------------------------------------------------------------------------
+     */
+    bool Library::findPackage(const std::string& name, PackageSummary& package,
+                              const std::string& installDir) {
+        PackageSourceCache sources;
+        if (!loadSources(installDir, sources)) {
+            return false;
+        }
+        auto it = sources.find(name);
+        if (it == sources.end()) {
+            return false;
+        }
+        package = summarize(it->second.first, it->second.second);
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::searchPackages
+     * ------------------------------------------------------------------------
+     */
+    std::vector<PackageSummary> Library::searchPackages(const std::string& text,
+                                                        const std::string& installDir) {
+        std::vector<PackageSummary> matches;
+        PackageSourceCache sources;
+        if (!loadSources(installDir, sources)) {
+            return matches;
+        }
+        for (const auto& [name, source] : sources) {
+            PackageSummary package = summarize(source.first, source.second);
+            if (package.name.find(text)        != std::string::npos ||
+                package.version.find(text)     != std::string::npos ||
+                package.description.find(text) != std::string::npos) {
+                matches.push_back(std::move(package));
+            }
+        }
+        std::sort(matches.begin(), matches.end(),
+                  [](const PackageSummary& a, const PackageSummary& b) { return a.name < b.name; });
+        return matches;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::planSync / planInstall / planRemove
+     * ------------------------------------------------------------------------
+     */
+    bool Library::planSync(const std::vector<ManifestEntry>& entries,
+                           const std::string& installDir, SyncPlan& plan) {
+        if (!Sync::computePlan(entries, installDir, plan)) {
+            Events::error("resolve", "The requested packages cannot be resolved.");
+            return false;
+        }
+        return true;
+    }
+
+    bool Library::planInstall(const std::vector<std::string>& names,
+                              const std::string& installDir, SyncPlan& plan) {
+        // Installed packages stay pinned, so only the new names (and their
+        // missing dependencies) end up in the plan
+        std::vector<ManifestEntry> entries = Sync::installedEntries(installDir);
+        for (const auto& name : names) {
+            bool installed = std::any_of(entries.begin(), entries.end(),
+                                         [&](const ManifestEntry& e) { return e.name == name; });
+            if (!installed) {
+                entries.push_back({ name, "" });
+            }
+        }
+        return planSync(entries, installDir, plan);
+    }
+
+    bool Library::planRemove(const std::vector<std::string>& names,
+                             const std::string& installDir, SyncPlan& plan) {
+        std::unordered_set<std::string> toRemove(names.begin(), names.end());
+        std::vector<ManifestEntry> entries;
+        for (const auto& entry : Sync::installedEntries(installDir)) {
+            if (!toRemove.count(entry.name)) {
+                entries.push_back(entry);
+            }
+        }
+        if (!planSync(entries, installDir, plan)) {
+            return false;
+        }
+
+        // A package that stays in the closure is still needed by something else
+        for (const auto& name : names) {
+            if (std::find(plan.removals.begin(), plan.removals.end(), name) == plan.removals.end()) {
+                std::string message = name + " is not installed or is required by another "
+                                      "installed package.";
+                std::cerr << "Error: " << message << std::endl;
+                Events::error("resolve", message);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Library::apply
+     * ------------------------------------------------------------------------
+     */
+    bool Library::apply(const SyncPlan& plan, const std::string& installDir) {
+        std::vector<std::string> packages;
+        for (const auto& step : plan.steps) {
+            packages.push_back(step.package.name);
+        }
+        packages.insert(packages.end(), plan.removals.begin(), plan.removals.end());
+        if (!plan.empty() && !Events::confirm("apply", packages)) {
+            return false;
+        }
+        bool ok = Sync::applyPlan(plan, installDir);
+        if (!ok) {
+            Events::error("apply", "The transaction did not complete.");
+        }
+        return ok;
+    }
+
+} // namespace Starpack
@@ -0,0 +1,661 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "sync.hpp"            // Class definition
+#include "install.hpp"         // Repository index, resolver, fetch, extraction
+#include "update.hpp"          // Updater::compareVersions, isNewerBuild
+#include "remove.hpp"          // removeFiles
+#include "hook.hpp"            // Pre/Post hooks
+#include "object_store.hpp"    // Releasing replaced objects
+#include "events.hpp"          // Progress events and confirmation
+#include "trace.hpp"           // --trace phase spans
+#include "metrics.hpp"         // Transaction metrics
+#include "config.hpp"          // Durability
+#include "cache.hpp"           // Cache limits after the transaction
+#include "utils.hpp"           // syncFile, syncFileSystem
+
+#include <iostream>            // Standard I/O (cout, cerr)
+#include <fstream>             // Manifest and installed.db
+#include <sstream>             // Line parsing
+#include <filesystem>          // Paths, rename
+#include <unordered_map>       // Installed package lookup
+#include <unordered_set>       // Desired package set
+#include <algorithm>           // std::find, std::transform
+#include <cctype>              // std::tolower
+#include <cstdlib>             // strtoll
+
+// Alias for easier filesystem usage
+namespace fs = std::filesystem;
+
+namespace Starpack {
+
+    namespace {
+
+        const std::string kSeparator = "----------------------------------------";
+
+        /**
+         * @brief One package block of installed.db.
+         */
+        struct InstalledEntry {
+            std::string name;
+            std::string version;
+            int64_t     buildEpoch = 0;        // 0 for entries written before it was recorded
+            std::string sha256;
+            std::string block;                 // Verbatim text, separator included
+            std::string storeDir;
+            std::vector<std::string> files;    // As recorded (leading '/')
+            std::vector<StoredObject> objects;
+        };
+
+        /**
+         * -------------------------------------------------------------------
+         * trim
+         * -------------------------------------------------------------------
+         */
+        std::string trim(const std::string& s) {
+            size_t start = s.find_first_not_of(" \t\r");
+            if (start == std::string::npos) {
+                return "";
+            }
+            size_t end = s.find_last_not_of(" \t\r");
+            return s.substr(start, end - start + 1);
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * readInstalledDatabase
+         *
+         * Loads every block of installed.db, keeping the original text so
+         * untouched packages are written back byte for byte.
+         * -------------------------------------------------------------------
+         */
+        std::vector<InstalledEntry> readInstalledDatabase(const std::string& dbPath) {
+            std::vector<InstalledEntry> entries;
+            std::ifstream dbFile(dbPath);
+            if (!dbFile.is_open()) {
+                return entries;
+            }
+
+            enum class Section { None, Files, Objects, Dependencies };
+            Section section = Section::None;
+            bool inBlock = false;
+            std::string line;
+            while (std::getline(dbFile, line)) {
+                if (!inBlock) {
+                    if (line.size() > 2 && line.compare(line.size() - 2, 2, " /") == 0) {
+                        entries.push_back({});
+                        entries.back().name = line.substr(0, line.size() - 2);
+                        entries.back().block = line + "\n";
+                        section = Section::None;
+                        inBlock = true;
+                    }
+                    continue;
+                }
+
+                InstalledEntry& entry = entries.back();
+                entry.block += line + "\n";
+                if (line == kSeparator) {
+                    inBlock = false;
+                } else if (line.rfind("Version: ", 0) == 0) {
+                    entry.version = line.substr(9);
+                } else if (line.rfind("Build-epoch: ", 0) == 0) {
+                    entry.buildEpoch = std::strtoll(line.c_str() + 13, nullptr, 10);
+                } else if (line.rfind("Sha256: ", 0) == 0) {
+                    entry.sha256 = line.substr(8);
+                } else if (line.rfind("Object-store: ", 0) == 0) {
+                    entry.storeDir = line.substr(14);
+                } else if (line == "Files:") {
+                    section = Section::Files;
+                } else if (line == "Objects:") {
+                    section = Section::Objects;
+                } else if (line == "Dependencies:") {
+                    section = Section::Dependencies;
+                } else if (section == Section::Files && !line.empty()) {
+                    entry.files.push_back(line);
+                } else if (section == Section::Objects) {
+                    size_t space = line.find(' ');
+                    if (space != std::string::npos) {
+                        entry.objects.push_back({ line.substr(0, space), line.substr(space + 1) });
+                    }
+                }
+            }
+
+            // A truncated last block is kept as-is, but terminated
+            if (inBlock) {
+                entries.back().block += kSeparator + "\n";
+            }
+            return entries;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * relativePaths
+         *
+         * DB paths ("/usr/bin/x") as passed to hooks ("usr/bin/x").
+         * -------------------------------------------------------------------
+         */
+        std::vector<std::string> relativePaths(const std::vector<std::string>& files) {
+            std::vector<std::string> paths;
+            paths.reserve(files.size());
+            for (const auto& file : files) {
+                std::string rel = (!file.empty() && file[0] == '/') ? file.substr(1) : file;
+                if (!rel.empty()) {
+                    paths.push_back(rel);
+                }
+            }
+            return paths;
+        }
+
+        /**
+         * -------------------------------------------------------------------
+         * writeDatabase
+         *
+         * Writes the new installed.db next to the old one and renames it over,
+         * so readers see either the old or the new state.
+         * -------------------------------------------------------------------
+         */
+        bool writeDatabase(const fs::path& dbPath, const std::string& contents) {
+            Trace::Span span("db", "write database");
+            span.arg("bytes", static_cast<uint64_t>(contents.size()));
+            fs::path tmpPath = dbPath;
+            tmpPath += ".tmp";
+            {
+                std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+                if (!out) {
+                    std::cerr << "Error: Unable to create temporary DB file: "
+                              << tmpPath << std::endl;
+                    return false;
+                }
+                out << contents;
+                out.flush();
+                if (!out) {
+                    std::cerr << "Error: Failed writing " << tmpPath << std::endl;
+                    return false;
+                }
+            }
+            if (Config::current().settings.durability != Durability::None &&
+                !syncFile(tmpPath.string())) {
+                std::cerr << "Error: Unable to sync " << tmpPath << std::endl;
+                return false;
+            }
+            std::error_code ec;
+            fs::rename(tmpPath, dbPath, ec);
+            if (ec) {
+                std::cerr << "Error: Unable to replace " << dbPath << ": "
+                          << ec.message() << std::endl;
+                return false;
+            }
+            if (Config::current().settings.durability == Durability::Full &&
+                !syncFile(dbPath.parent_path().string())) {
+                std::cerr << "Warning: Could not sync " << dbPath.parent_path() << std::endl;
+            }
+            return true;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::readManifest
+     *
+     * Accepted lines: "name", "name version", "name = version" and
+     * "name==version". Blank lines and '#' comments are ignored.
+     * ------------------------------------------------------------------------
+     */
+    bool Sync::readManifest(const std::string& manifestPath,
+                            std::vector<ManifestEntry>& entries) {
+        std::ifstream manifest(manifestPath);
+        if (!manifest.is_open()) {
+            std::cerr << "Error: Unable to open manifest " << manifestPath << std::endl;
+            return false;
+        }
+
+        std::unordered_set<std::string> seen;
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(manifest, line)) {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            std::replace(line.begin(), line.end(), '=', ' ');
+
+            std::istringstream fields(line);
+            ManifestEntry entry;
+            std::string extra;
+            if (!(fields >> entry.name)) {
+                continue;
+            }
+            fields >> entry.version;
+            if (fields >> extra) {
+                std::cerr << "Error: " << manifestPath << ":" << lineNumber
+                          << ": expected 'name' or 'name = version'." << std::endl;
+                return false;
+            }
+            if (!seen.insert(entry.name).second) {
+                std::cerr << "Error: " << manifestPath << ":" << lineNumber
+                          << ": package '" << entry.name << "' listed twice." << std::endl;
+                return false;
+            }
+            entries.push_back(entry);
+        }
+
+        if (entries.empty()) {
+            std::cerr << "Error: Manifest " << manifestPath << " lists no packages." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::installedEntries
+     * ------------------------------------------------------------------------
+     */
+    std::vector<ManifestEntry> Sync::installedEntries(const std::string& installDir) {
+        std::vector<ManifestEntry> entries;
+        std::string dbPath = (fs::path(installDir) / "var" / "lib" /
+                              "starpack" / "installed.db").string();
+        for (const auto& entry : readInstalledDatabase(dbPath)) {
+            entries.push_back({ entry.name, entry.version });
+        }
+        return entries;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::computePlan
+     * ------------------------------------------------------------------------
+     */
+    bool Sync::computePlan(const std::vector<ManifestEntry>& entries,
+                           const std::string& installDir,
+                           SyncPlan& plan) {
+        Trace::Span span("sync", "compute plan");
+        plan = SyncPlan();
+
+        fs::path cacheDir = fs::path(installDir) / "var" / "lib" / "starpack" / "cache";
+        std::string dbPath = (fs::path(installDir) / "var" / "lib" /
+                              "starpack" / "installed.db").string();
+        std::error_code ec;
+        fs::create_directories(cacheDir, ec);
+
+        // Steps 1-3: repositories, always fresh since the plan is a full diff
+        PackageSourceCache packageSourceCache;
+        if (!Installer::loadRepositoryIndex(cacheDir.string(), packageSourceCache, true)) {
+            return false;
+        }
+
+        std::vector<InstalledEntry> installed = readInstalledDatabase(dbPath);
+        std::unordered_map<std::string, const InstalledEntry*> installedByName;
+        for (const auto& entry : installed) {
+            installedByName[entry.name] = &entry;
+        }
+
+        std::vector<std::string> desired;
+        std::unordered_map<std::string, std::string> pinnedVersions;
+        for (const auto& entry : entries) {
+            desired.push_back(entry.name);
+            if (!entry.version.empty()) {
+                pinnedVersions[entry.name] = entry.version;
+            }
+        }
+
+        // Step 4: one resolver run over the whole manifest
+        std::cout << "[4/8] Resolving dependencies..." << std::endl;
+        Events::phase("resolve");
+        std::vector<std::string> order;
+        auto isProvided = [&](const std::string& name) {
+            return installedByName.count(name) > 0;
+        };
+        if (!Installer::resolveDependencies(desired, packageSourceCache, isProvided, order)) {
+            return false;
+        }
+
+        std::unordered_set<std::string> closure(order.begin(), order.end());
+        for (const auto& name : order) {
+            auto installedIt = installedByName.find(name);
+            std::string installedVersion = installedIt != installedByName.end()
+                                           ? installedIt->second->version : "";
+
+            auto sourceIt = packageSourceCache.find(name);
+            if (sourceIt == packageSourceCache.end()) {
+                // Only installed locally; the resolver already checked that
+                plan.unchanged++;
+                continue;
+            }
+            const YAML::Node& metadata = sourceIt->second.second;
+            std::string repoVersion = metadata["version"] ? metadata["version"].as<std::string>() : "";
+
+            auto pinned = pinnedVersions.find(name);
+            if (pinned != pinnedVersions.end() && pinned->second != repoVersion) {
+                if (installedIt != installedByName.end() && installedVersion == pinned->second) {
+                    plan.unchanged++;
+                    continue;
+                }
+                std::cerr << "Error: Version " << pinned->second << " of '" << name
+                          << "' is not available (repositories offer "
+                          << (repoVersion.empty() ? "no version" : repoVersion) << ")."
+                          << std::endl;
+                return false;
+            }
+
+            int versionCmp = installedIt == installedByName.end()
+                             ? 1 : Updater::compareVersions(repoVersion, installedVersion);
+            bool needed = installedIt == installedByName.end() ||
+                          (pinned != pinnedVersions.end() && installedVersion != repoVersion) ||
+                          versionCmp > 0 ||
+                          (versionCmp == 0 && Updater::isNewerBuild(metadata, installedIt->second->buildEpoch,
+                                                                    installedIt->second->sha256));
+            if (!needed) {
+                plan.unchanged++;
+                continue;
+            }
+
+            if (!metadata["file_name"] || !metadata["file_name"].IsScalar()) {
+                std::cerr << "Error: Missing 'file_name' in metadata for package '"
+                          << name << "'." << std::endl;
+                return false;
+            }
+            SyncStep step;
+            step.package.name        = name;
+            step.package.repoUrl     = sourceIt->second.first;
+            step.package.metadata    = metadata;
+            step.package.archivePath = (cacheDir / metadata["file_name"].as<std::string>()).string();
+            step.installedVersion    = installedVersion;
+            plan.steps.push_back(step);
+        }
+
+        // Whatever is installed but outside the closure goes, most recent first
+        for (auto it = installed.rbegin(); it != installed.rend(); ++it) {
+            if (!closure.count(it->name)) {
+                plan.removals.push_back(it->name);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::printPlan
+     * ------------------------------------------------------------------------
+     */
+    void Sync::printPlan(const SyncPlan& plan) {
+        for (const auto& step : plan.steps) {
+            std::string version = step.package.metadata["version"]
+                                  ? step.package.metadata["version"].as<std::string>() : "?";
+            if (step.installedVersion.empty()) {
+                std::cout << "  install  " << step.package.name << " " << version << "\n";
+            } else {
+                std::cout << "  upgrade  " << step.package.name << " "
+                          << step.installedVersion << " -> " << version << "\n";
+            }
+        }
+        for (const auto& name : plan.removals) {
+            std::cout << "  remove   " << name
+                      << (isCriticalPackage(name) ? "  (critical package!)" : "") << "\n";
+        }
+        std::cout << plan.steps.size() << " to install/upgrade, "
+                  << plan.removals.size() << " to remove, "
+                  << plan.unchanged << " unchanged." << std::endl;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::applyPlan
+     *
+     * Removals go first so files moving between packages end up owned by
+     * the new package. The DB is rewritten once, after all files are in
+     * place; if an extraction fails, the DB still records exactly what was
+     * done before the failure.
+     * ------------------------------------------------------------------------
+     */
+    bool Sync::applyPlan(const SyncPlan& plan, const std::string& installDir) {
+        if (plan.empty()) {
+            std::cout << installDir << " already matches the manifest." << std::endl;
+            return true;
+        }
+
+        Trace::Span span("sync", "apply plan", installDir);
+        fs::path dbDir  = fs::path(installDir) / "var" / "lib" / "starpack";
+        fs::path dbPath = dbDir / "installed.db";
+        std::error_code ec;
+        fs::create_directories(dbDir / "cache", ec);
+
+        // Steps 5-6: one download and verification phase for the whole plan
+        std::vector<ResolvedPackage> fetchPlan;
+        for (const auto& step : plan.steps) {
+            fetchPlan.push_back(step.package);
+        }
+        if (!plan.prefetched && !fetchPlan.empty()) {
+            Events::phase("download");
+            if (!Installer::fetchPackages(fetchPlan, installDir)) {
+                Events::error("download", "Downloading or verifying the packages failed.");
+                return false;
+            }
+        }
+
+        std::vector<InstalledEntry> installed = readInstalledDatabase(dbPath.string());
+        std::unordered_map<std::string, size_t> installedIndex;
+        for (size_t i = 0; i < installed.size(); ++i) {
+            installedIndex[installed[i].name] = i;
+        }
+
+        // Step 7: removals
+        std::cout << "[7/8] Applying changes to " << installDir << "..." << std::endl;
+        std::unordered_set<std::string> removed;
+        if (!plan.removals.empty()) {
+            Events::phase("remove");
+        }
+        for (const auto& name : plan.removals) {
+            auto it = installedIndex.find(name);
+            if (it == installedIndex.end()) {
+                continue;
+            }
+            const InstalledEntry& entry = installed[it->second];
+            Trace::Span removeSpan("remove", "remove", name);
+            std::cout << " -> Removing " << name << "..." << std::endl;
+            Events::progress("remove", name, removed.size(), plan.removals.size());
+            Hook::runNewStyleHooks("PreRemove", "Remove", relativePaths(entry.files),
+                                   installDir, name);
+            removeFiles(entry.files, installDir);
+            removed.insert(name);
+        }
+
+        // Step 7: installs and upgrades, dependencies first
+        bool useObjectStore = ObjectStore::usableFor(installDir);
+        std::unordered_map<std::string, std::string> newBlocks;
+        std::vector<const SyncStep*> applied;
+        bool failed = false;
+        if (!plan.steps.empty()) {
+            Events::phase("extract");
+        }
+        for (size_t i = 0; i < plan.steps.size(); ++i) {
+            const SyncStep& step = plan.steps[i];
+            const std::string& name = step.package.name;
+            auto oldIt = installedIndex.find(name);
+            bool upgrade = oldIt != installedIndex.end();
+            Trace::Span packageSpan("install", upgrade ? "upgrade" : "install", name);
+
+            std::cout << "\n(" << (i + 1) << "/" << plan.steps.size() << ") "
+                      << (upgrade ? "Upgrading " : "Installing ") << name << "..." << std::endl;
+            Events::progress("extract", name, i, plan.steps.size());
+
+            std::vector<std::string> newPaths = Installer::packageFilePaths(step.package.metadata);
+            Hook::runNewStyleHooks(upgrade ? "PreUpdate" : "PreInstall",
+                                   upgrade ? "Update" : "Install",
+                                   upgrade ? newPaths : std::vector<std::string>{},
+                                   installDir, name);
+
+            std::vector<StoredObject> storedObjects;
+            if (!Installer::extractPackage(step.package, installDir, useObjectStore, storedObjects)) {
+                Metrics::addFailure("extract");
+                failed = true;
+                break;
+            }
+
+            // Files the new version no longer ships
+            if (upgrade) {
+                std::unordered_set<std::string> keep(newPaths.begin(), newPaths.end());
+                std::vector<std::string> obsolete;
+                for (const auto& file : installed[oldIt->second].files) {
+                    std::string rel = (!file.empty() && file[0] == '/') ? file.substr(1) : file;
+                    if (!keep.count(rel)) {
+                        obsolete.push_back(file);
+                    }
+                }
+                if (!obsolete.empty()) {
+                    removeFiles(obsolete, installDir);
+                }
+            }
+
+            newBlocks[name] = Installer::formatDatabaseEntry(
+                name, Installer::databaseNode(step.package.metadata, storedObjects));
+            applied.push_back(&step);
+        }
+
+        // With Durability = full the extracted files reach the disk first
+        if (Config::current().settings.durability == Durability::Full &&
+            !syncFileSystem(installDir)) {
+            std::cerr << "Warning: Could not sync " << installDir << std::endl;
+        }
+
+        // One DB commit: untouched blocks verbatim, upgrades in place, new
+        // packages appended in installation order
+        std::cout << "\n -> Committing installation database..." << std::endl;
+        Events::phase("commit");
+        std::string database;
+        for (const auto& entry : installed) {
+            if (removed.count(entry.name)) {
+                continue;
+            }
+            auto replacement = newBlocks.find(entry.name);
+            if (replacement != newBlocks.end()) {
+                database += replacement->second;
+                newBlocks.erase(replacement);
+            } else {
+                database += entry.block;
+            }
+        }
+        for (const SyncStep* step : applied) {
+            auto block = newBlocks.find(step->package.name);
+            if (block != newBlocks.end()) {
+                database += block->second;
+            }
+        }
+        if (!writeDatabase(dbPath, database)) {
+            std::cerr << "Error: Files were changed but " << dbPath
+                      << " could not be updated." << std::endl;
+            Metrics::addFailure("db");
+            return false;
+        }
+        for (const SyncStep* step : applied) {
+            Metrics::addPackageChange(installedIndex.count(step->package.name) ? "upgrade" : "install");
+        }
+        for (size_t n = 0; n < removed.size(); n++) {
+            Metrics::addPackageChange("remove");
+        }
+
+        // Objects of removed or replaced packages that nothing links to now
+        size_t released = 0;
+        for (const auto& entry : installed) {
+            bool replaced = removed.count(entry.name) > 0;
+            for (const SyncStep* step : applied) {
+                replaced = replaced || step->package.name == entry.name;
+            }
+            if (replaced && !entry.objects.empty()) {
+                released += ObjectStore::releaseObjects(entry.storeDir, entry.objects);
+            }
+        }
+        if (released > 0) {
+            std::cout << " -> Released " << released << " unreferenced object(s)." << std::endl;
+        }
+
+        // Step 7.5: Post hooks
+        std::cout << "[7.5/8] Running Post hooks..." << std::endl;
+        Events::phase("hooks");
+        Trace::Span hooksSpan("hook", "Post hooks");
+        for (const auto& name : plan.removals) {
+            if (removed.count(name)) {
+                Hook::runNewStyleHooks("PostRemove", "Remove",
+                                       relativePaths(installed[installedIndex[name]].files),
+                                       installDir, name);
+            }
+        }
+        for (const SyncStep* step : applied) {
+            bool upgrade = installedIndex.count(step->package.name) > 0;
+            Hook::runNewStyleHooks(upgrade ? "PostUpdate" : "PostInstall",
+                                   upgrade ? "Update" : "Install",
+                                   Installer::packageFilePaths(step->package.metadata),
+                                   installDir, step->package.name);
+        }
+
+        std::cout << "[8/8] " << installDir << ": " << applied.size()
+                  << " package(s) installed/upgraded, " << removed.size()
+                  << " removed." << std::endl;
+        Cache::enforceLimits((dbDir / "cache").string());
+        if (failed) {
+            Events::error("extract", "Stopped after " + std::to_string(applied.size()) + " of " +
+                                     std::to_string(plan.steps.size()) + " package(s).");
+            std::cerr << "Error: Sync stopped after " << applied.size() << " of "
+                      << plan.steps.size() << " package(s); run it again to finish."
+                      << std::endl;
+        }
+        return !failed;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Sync::syncRoot
+     * ------------------------------------------------------------------------
+     */
+    bool Sync::syncRoot(const std::string& manifestPath,
+                        const std::string& installDir,
+                        bool confirm) {
+        std::cout << "--- Starpack Sync ---" << std::endl;
+        std::cout << "Target directory: " << installDir << std::endl;
+
+        std::vector<ManifestEntry> entries;
+        if (!readManifest(manifestPath, entries)) {
+            return false;
+        }
+
+        SyncPlan plan;
+        if (!computePlan(entries, installDir, plan)) {
+            return false;
+        }
+        if (plan.empty()) {
+            std::cout << installDir << " already matches " << manifestPath
+                      << " (" << plan.unchanged << " package(s))." << std::endl;
+            return true;
+        }
+
+        printPlan(plan);
+        if (confirm && Events::active()) {
+            std::vector<std::string> packages;
+            for (const auto& step : plan.steps) {
+                packages.push_back(step.package.name);
+            }
+            packages.insert(packages.end(), plan.removals.begin(), plan.removals.end());
+            if (!Events::confirm("sync", packages)) {
+                std::cout << "Aborting sync." << std::endl;
+                return false;
+            }
+        } else if (confirm) {
+            std::cout << "Proceed? [Y/n]: ";
+            std::string response;
+            std::getline(std::cin, response);
+            response = trim(response);
+            std::transform(response.begin(), response.end(), response.begin(),
+                           [](unsigned char c){ return std::tolower(c); });
+            if (!response.empty() && response != "y" && response != "yes") {
+                std::cout << "Aborting sync." << std::endl;
+                return false;
+            }
+        }
+
+        return applyPlan(plan, installDir);
+    }
+
+} // namespace Starpack
@@ -0,0 +1,250 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "trace.hpp"           // Class definition
+#include "metrics.hpp"         // Per-phase totals from outermost spans
+#include "memory_stats.hpp"    // Per-phase RSS and allocations
+
+#include <iostream>            // Standard I/O (cerr)
+#include <fstream>             // Trace file
+#include <chrono>              // Monotonic clock
+#include <mutex>               // Record list
+#include <cstdio>              // snprintf
+#include <cstring>             // strcmp
+#include <algorithm>           // std::none_of
+#include <unistd.h>            // getpid
+
+namespace Starpack {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Record {
+            const char* category;
+            std::string name;
+            uint64_t    start;
+            uint64_t    duration;
+            int         tid;
+            std::vector<std::pair<std::string, std::string>> args;
+            char        phase = 'X';  // 'X' complete event, 'C' counter
+        };
+
+        std::mutex          g_recordMutex;
+        std::vector<Record> g_records;
+        std::string         g_path;
+        Clock::time_point   g_origin = Clock::now();
+        std::atomic<int>    g_nextTid{1};
+
+        // Categories of the spans open on this thread, innermost last
+        thread_local std::vector<const char*> t_openCategories;
+
+        // Small sequential thread ids read better in viewers than pthread ids
+        int threadId() {
+            thread_local int tid = g_nextTid++;
+            return tid;
+        }
+
+        void addRecord(Record record) {
+            std::lock_guard<std::mutex> lock(g_recordMutex);
+            g_records.push_back(std::move(record));
+        }
+
+        // A point of the "memory" counter track, in MiB
+        void addMemoryCounter(uint64_t at, const MemoryStats::Sample& sample) {
+            char rss[32], hwm[32];
+            std::snprintf(rss, sizeof(rss), "%.1f", sample.rss / (1024.0 * 1024.0));
+            std::snprintf(hwm, sizeof(hwm), "%.1f", sample.hwm / (1024.0 * 1024.0));
+            addRecord({ "memory", "memory", at, 0, threadId(),
+                        { { "rss_mib", rss }, { "peak_mib", hwm } }, 'C' });
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Trace::start / finish / now
+     * ------------------------------------------------------------------------
+     */
+    void Trace::start(const std::string& path) {
+        std::lock_guard<std::mutex> lock(g_recordMutex);
+        g_path = path;
+        g_origin = Clock::now();
+        g_records.clear();
+        threadId(); // the caller's thread is tid 1
+        s_enabled = true;
+    }
+
+    bool Trace::finish() {
+        if (!enabled()) {
+            return true;
+        }
+        s_enabled = false;
+
+        std::lock_guard<std::mutex> lock(g_recordMutex);
+        std::ofstream out(g_path, std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Cannot write trace file " << g_path << std::endl;
+            return false;
+        }
+
+        int pid = getpid();
+        out << "{\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":1,\"args\":{\"name\":\"starpack\"}}";
+        for (const auto& record : g_records) {
+            out << ",\n{\"name\":" << quote(record.name)
+                << ",\"cat\":\"" << record.category << "\""
+                << ",\"ph\":\"" << record.phase << "\",\"ts\":" << record.start;
+            if (record.phase == 'X') {
+                out << ",\"dur\":" << record.duration;
+            }
+            out << ",\"pid\":" << pid << ",\"tid\":" << record.tid;
+            if (!record.args.empty()) {
+                out << ",\"args\":{";
+                for (size_t i = 0; i < record.args.size(); i++) {
+                    out << (i ? "," : "") << quote(record.args[i].first) << ":"
+                        << record.args[i].second;
+                }
+                out << "}";
+            }
+            out << "}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        g_records.clear();
+
+        out.flush();
+        if (!out) {
+            std::cerr << "Error: Failed writing trace file " << g_path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t Trace::now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - g_origin).count();
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Trace::complete
+     * ------------------------------------------------------------------------
+     */
+    void Trace::complete(const char* category, const std::string& name,
+                         uint64_t start, uint64_t end,
+                         const std::vector<std::pair<std::string, std::string>>& args) {
+        if (!enabled()) {
+            return;
+        }
+        addRecord({ category, name, start, end > start ? end - start : 0, threadId(), args });
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Trace::quote
+     * ------------------------------------------------------------------------
+     */
+    std::string Trace::quote(const std::string& value) {
+        std::string quoted = "\"";
+        for (char c : value) {
+            switch (c) {
+                case '"':  quoted += "\\\""; break;
+                case '\\': quoted += "\\\\"; break;
+                case '\n': quoted += "\\n";  break;
+                case '\t': quoted += "\\t";  break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        quoted += escaped;
+                    } else {
+                        quoted += c;
+                    }
+            }
+        }
+        quoted += '"';
+        return quoted;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Trace::Span
+     * ------------------------------------------------------------------------
+     */
+    Trace::Span::Span(const char* category, const char* name, const std::string& subject)
+        : active_(enabled() || Metrics::enabled() || MemoryStats::enabled()),
+          tracing_(enabled()), category_(category) {
+        if (!active_) {
+            return;
+        }
+        if (tracing_) {
+            name_ = name;
+            if (!subject.empty()) {
+                name_ += ": ";
+                name_ += subject;
+            }
+        }
+        outermost_ = std::none_of(t_openCategories.begin(), t_openCategories.end(),
+                                  [category](const char* open) {
+                                      return std::strcmp(open, category) == 0;
+                                  });
+        t_openCategories.push_back(category);
+        start_ = now();
+        if (outermost_ && (tracing_ || MemoryStats::enabled())) {
+            MemoryStats::Sample sample = MemoryStats::sample();
+            sampled_  = true;
+            rssStart_ = sample.rss;
+            hwmStart_ = sample.hwm;
+            if (MemoryStats::enabled()) {
+                memoryToken_ = MemoryStats::phaseBegin(category);
+            }
+            if (tracing_) {
+                addMemoryCounter(start_, sample);
+            }
+        }
+    }
+
+    Trace::Span::~Span() {
+        if (!active_) {
+            return;
+        }
+        uint64_t end = now();
+        t_openCategories.pop_back();
+        if (outermost_) {
+            Metrics::addPhase(category_, end - start_);
+        }
+        if (sampled_) {
+            MemoryStats::Sample atStart{ rssStart_, hwmStart_ };
+            MemoryStats::Sample atEnd = MemoryStats::sample();
+            if (memoryToken_ >= 0) {
+                MemoryStats::phaseEnd(memoryToken_, end - start_, atStart, atEnd);
+            }
+            if (tracing_ && enabled()) {
+                args_.emplace_back("rss_start", std::to_string(atStart.rss));
+                args_.emplace_back("rss_end", std::to_string(atEnd.rss));
+                args_.emplace_back("peak_growth",
+                                   std::to_string(atEnd.hwm > atStart.hwm ? atEnd.hwm - atStart.hwm : 0));
+                addMemoryCounter(end, atEnd);
+            }
+        }
+        if (tracing_ && enabled()) {
+            addRecord({ category_, std::move(name_), start_, end - start_, threadId(),
+                        std::move(args_) });
+        }
+    }
+
+    void Trace::Span::arg(const char* key, uint64_t value) {
+        if (tracing_) {
+            args_.emplace_back(key, std::to_string(value));
+        }
+    }
+
+    void Trace::Span::arg(const char* key, const std::string& value) {
+        if (tracing_) {
+            args_.emplace_back(key, quote(value));
+        }
+    }
+
+} // namespace Starpack
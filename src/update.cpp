@@ -1,6 +1,16 @@
 #include "update.hpp"
 #include "install.hpp"  // Provides Installer::verifyGPGSignature(...)
 #include "hook.hpp"     // Provides Hook::runNewStyleHooks(...)
+#include "download.hpp" // Provides downloadMultipleFilesMulti(...)
+#include "utils.hpp"    // Provides parallelFor(...)
+#include "low_impact.hpp" // Write pacing and page-cache hygiene
+#include "events.hpp"     // Confirmation by library consumers
+#include "trace.hpp"      // --trace phase spans
+#include "metrics.hpp"    // Transaction metrics
+#include "config.hpp"     // Repositories, Jobs, Durability, NoExtract
+#include "cache.hpp"      // Cache limits after the transaction
+#include "version.hpp"    // Version sort keys
+#include "object_store.hpp" // Deduplicated upgrades
 
 #include <iostream>        // For standard I/O
 #include <fstream>         // For file stream operations
@@ -69,7 +79,7 @@ void removeObsoleteFiles(const std::string& packageName,
     bool inFilesSection   = false;
 
     while (std::getline(dbFile, line)) {
-        if (!inPackageSection && line.rfind(packageName, 0) == 0) {
+        if (!inPackageSection && line == packageName + " /") {
             // Found the package header
             inPackageSection = true;
             continue;
@@ -246,6 +256,11 @@ int extract_archive_section(const std::string& archivePath,
             archive_read_data_skip(a);
             continue;
         }
+        if (sectionPrefix == "files/" &&
+            Starpack::Config::current().settings.excludedFromExtraction(finalRelativePath.string())) {
+            archive_read_data_skip(a);
+            continue;
+        }
 
         fs::path fullDestPath = fs::path(destDir) / finalRelativePath;
         archive_entry_set_pathname(entry, fullDestPath.string().c_str());
@@ -262,6 +277,7 @@ int extract_archive_section(const std::string& archivePath,
             int64_t offset;
 
             while ((r = archive_read_data_block(a, &buff, &size, &offset)) == ARCHIVE_OK) {
+                Starpack::LowImpact::throttleWrite(size);
                 if (archive_write_data_block(ext, buff, size, offset) < ARCHIVE_OK) {
                     std::cerr << "Error writing data for "
                               << fullDestPath.string() << ": "
@@ -281,6 +297,8 @@ int extract_archive_section(const std::string& archivePath,
             std::cerr << "Error finishing entry "
                       << fullDestPath.string() << ": "
                       << archive_error_string(ext) << std::endl;
+        } else if (archive_entry_filetype(entry) == AE_IFREG) {
+            Starpack::LowImpact::dropFromCache(fullDestPath.string(), true);
         }
     }
 
@@ -337,6 +355,38 @@ bool isUrl(const std::string& url)
             url.rfind("https://", 0) == 0);
 }
 
+// ---------------------------------------------------------------------------
+// versionKeyOf
+//
+// The index record's precomputed version_key, or one computed from its
+// version for indices written before keys were stored.
+std::string versionKeyOf(const YAML::Node& node)
+{
+    if (node["version_key"] && node["version_key"].IsScalar()) {
+        std::string key = node["version_key"].as<std::string>();
+        if (Starpack::Version::isIndexKey(key)) {
+            return key;
+        }
+    }
+    return Starpack::Version::indexKey(node["version"].as<std::string>());
+}
+
+// ---------------------------------------------------------------------------
+// buildEpochOf / sha256Of
+//
+// Build identifiers of an index record (0 / empty when the index predates them).
+int64_t buildEpochOf(const YAML::Node& node)
+{
+    const YAML::Node epoch = node["build_epoch"];
+    return epoch && epoch.IsScalar() ? epoch.as<int64_t>(0) : 0;
+}
+
+std::string sha256Of(const YAML::Node& node)
+{
+    const YAML::Node sha = node["sha256"];
+    return sha && sha.IsScalar() ? sha.as<std::string>() : "";
+}
+
 } // end anonymous namespace
 
 namespace Starpack {
@@ -367,14 +417,23 @@ bool Updater::downloadFile(const std::string& url, const std::string& destPath)
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, nullptr);
     curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    if (downloadRateLimit() > 0) {
+        curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE,
+                         static_cast<curl_off_t>(downloadRateLimit()));
+    }
 
     CURLcode res = curl_easy_perform(curl);
     fclose(fp);
 
+    curl_off_t bytes = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+    Starpack::Metrics::addDownload(static_cast<uint64_t>(bytes));
+
     bool success = (res == CURLE_OK);
     if (!success) {
         std::cerr << "Error: Failed to download " << url << ": "
                   << curl_easy_strerror(res) << std::endl;
+        Starpack::Metrics::addFailure("download");
         std::error_code ec;
         fs::remove(destPath, ec); // remove partial file
     }
@@ -386,81 +445,45 @@ bool Updater::downloadFile(const std::string& url, const std::string& destPath)
 // ============================================================================
 // Updater::compareVersions
 //
-// Compares two dot-separated numeric version strings (e.g., "1.2.3").
+// Thin wrapper kept for callers of the public API; see Version.
 int Updater::compareVersions(const std::string& v1, const std::string& v2)
 {
-    std::istringstream iss1(v1), iss2(v2);
-    std::string token1, token2;
-    int num1 = 0, num2 = 0;
-    char delim = '.';
-
-    while (true) {
-        bool got1 = bool(std::getline(iss1, token1, delim));
-        bool got2 = bool(std::getline(iss2, token2, delim));
-
-        try { num1 = got1 ? std::stoi(token1) : 0; }
-        catch (...) { num1 = 0; }
-        try { num2 = got2 ? std::stoi(token2) : 0; }
-        catch (...) { num2 = 0; }
-
-        if (num1 > num2) return 1;
-        if (num1 < num2) return -1;
-
-        if (!got1 && !got2) {
-            break; // same length and all equal
-        }
-        if (got1 && !got2 && num1 > 0) {
-            return 1;
-        }
-        if (!got1 && got2 && num2 > 0) {
-            return -1;
-        }
-        if (!got1 && !got2) {
-            break;
-        }
-    }
-    return 0;
+    return Version::compare(v1, v2);
 }
 
 // ============================================================================
-// Updater::compareDates
+// Updater::isNewerBuild
 //
-// Compares two "DD/MM/YYYY" date strings.
-int Updater::compareDates(const std::string& d1, const std::string& d2)
+// Same version, newer build: one integer compare, with the archive hash
+// ruling out re-indexed copies of the installed archive.
+bool Updater::isNewerBuild(const YAML::Node& repoPackage, int64_t installedEpoch,
+                           const std::string& installedSha256)
 {
-    std::tm tm1 = {}, tm2 = {};
-    char format[] = "%d/%m/%Y";
-
-    if (strptime(d1.c_str(), format, &tm1) == nullptr ||
-        strptime(d2.c_str(), format, &tm2) == nullptr) {
-        std::cerr << "Warning: Could not parse date '" << d1
-                  << "' or '" << d2 << "' with DD/MM/YYYY.\n";
-        return 0;
+    int64_t repoEpoch = buildEpochOf(repoPackage);
+    if (repoEpoch <= 0 || installedEpoch <= 0 || repoEpoch <= installedEpoch) {
+        return false;
     }
-
-    if (tm1.tm_year != tm2.tm_year) return (tm1.tm_year > tm2.tm_year) ? 1 : -1;
-    if (tm1.tm_mon != tm2.tm_mon)   return (tm1.tm_mon > tm2.tm_mon)   ? 1 : -1;
-    if (tm1.tm_mday != tm2.tm_mday) return (tm1.tm_mday > tm2.tm_mday) ? 1 : -1;
-
-    return 0;
+    return installedSha256.empty() || sha256Of(repoPackage) != installedSha256;
 }
 
 // ============================================================================
-// Updater::getInstalledVersion
+// Updater::getInstalledBuild
 //
-// Fetches the "Version:" line from the installed.db for a given package.
-std::string Updater::getInstalledVersion(const std::string& packageName,
-                                         const std::string& dbPath)
+// Fetches the "Version:", "Build-epoch:" and "Sha256:" lines from the
+// installed.db for a given package.
+Updater::InstalledBuild Updater::getInstalledBuild(const std::string& packageName,
+                                                   const std::string& dbPath)
 {
+    InstalledBuild build;
     std::ifstream dbFile(dbPath);
     if (!dbFile.is_open()) {
-        return "";
+        return build;
     }
 
     std::string line;
     bool inPackageSection = false;
     while (std::getline(dbFile, line)) {
-        if (!inPackageSection && line.rfind(packageName, 0) == 0) {
+        if (!inPackageSection && line == packageName + " /") {
             inPackageSection = true;
             continue;
         }
@@ -468,90 +491,100 @@ std::string Updater::getInstalledVersion(const std::string& packageName,
             continue;
         }
 
+        std::istringstream iss(line);
+        std::string label, value;
         if (line.rfind("Version:", 0) == 0) {
-            std::istringstream iss(line);
-            std::string label, version;
-            if (iss >> label >> version) {
-                return version;
-            }
-        }
-        if (line == "----------------------------------------") {
-            break;
-        }
-    }
-    return "";
-}
-
-// ============================================================================
-// Updater::getInstalledUpdateDate
-//
-// Fetches the "Update-time:" line from the installed.db for a given package.
-std::string Updater::getInstalledUpdateDate(const std::string& packageName,
-                                            const std::string& dbPath)
-{
-    std::ifstream dbFile(dbPath);
-    if (!dbFile.is_open()) {
-        return "";
-    }
-
-    std::string line;
-    bool inPackageSection = false;
-    while (std::getline(dbFile, line)) {
-        if (!inPackageSection && line.rfind(packageName, 0) == 0) {
-            inPackageSection = true;
-            continue;
-        }
-        if (!inPackageSection) {
-            continue;
-        }
-
-        if (line.rfind("Update-time:", 0) == 0) {
-            std::istringstream iss(line);
-            std::string label, timeStr;
-            if (iss >> label >> timeStr) {
-                return timeStr;
+            iss >> label >> build.version;
+        } else if (line.rfind("Build-epoch:", 0) == 0) {
+            if (iss >> label >> value) {
+                build.buildEpoch = std::strtoll(value.c_str(), nullptr, 10);
             }
-        }
-        if (line == "----------------------------------------") {
+        } else if (line.rfind("Sha256:", 0) == 0) {
+            iss >> label >> build.sha256;
+        } else if (line == "Files:" || line == "----------------------------------------") {
             break;
         }
     }
-    return "";
+    return build;
 }
 
 // ============================================================================
 // Updater::updateDatabaseVersion
 //
-// Updates the Version and Update-time lines for a specific package in the DB.
-void Updater::updateDatabaseVersion(const std::string& packageName,
+// Rewrites the Version and Update-time lines of a package in the DB,
+// records its Build-epoch and Sha256 right after the version and replaces
+// its Object-store and Objects lines with the new objects.
+bool Updater::updateDatabaseVersion(const std::string& packageName,
                                     const std::string& dbPath,
-                                    const std::string& newVersion,
-                                    const std::string& newUpdateDate)
+                                    const UpdateCandidate& cand,
+                                    const std::vector<StoredObject>& storedObjects)
 {
     std::ifstream dbFile(dbPath);
     if (!dbFile.is_open()) {
         std::cerr << "Error: Cannot open DB file " << dbPath
                   << " for updating.\n";
-        return;
+        return false;
     }
 
     std::ostringstream updated;
     std::string line;
     bool inTargetPkg = false;
     bool versionUpdated = false;
-    bool dateUpdated    = false;
+    bool inObjects = false;
+    bool storeWritten = storedObjects.empty();
+    bool objectsWritten = storedObjects.empty();
+    auto writeObjects = [&]() {
+        if (!storeWritten) {
+            updated << "Object-store: " << ObjectStore::storeDir() << "\n";
+            storeWritten = true;
+        }
+        if (!objectsWritten) {
+            updated << "Objects:\n";
+            for (const auto& object : storedObjects) {
+                updated << object.id << " " << object.path << "\n";
+            }
+            objectsWritten = true;
+        }
+    };
 
     while (std::getline(dbFile, line)) {
-        if (!inTargetPkg && line.rfind(packageName, 0) == 0) {
+        if (!inTargetPkg && line == packageName + " /") {
             inTargetPkg = true;
             updated << line << "\n";
         } else if (inTargetPkg) {
-            if (line.rfind("Version:", 0) == 0) {
-                updated << "Version: " << newVersion << "\n";
+            // The old object list is dropped; the new one follows the files
+            if (line == "Objects:") {
+                inObjects = true;
+                continue;
+            }
+            if (inObjects) {
+                if (line != "Dependencies:" && line != "----------------------------------------") {
+                    continue;
+                }
+                inObjects = false;
+            }
+            if (line == "Files:" && !storeWritten) {
+                updated << "Object-store: " << ObjectStore::storeDir() << "\n";
+                storeWritten = true;
+            }
+            if (line == "Dependencies:" || line == "----------------------------------------") {
+                writeObjects();
+            }
+            if (line.rfind("Object-store:", 0) == 0) {
+                // Superseded by the store of the new objects, if any
+            } else if (line.rfind("Version:", 0) == 0) {
+                updated << "Version: " << cand.candidateVersion << "\n";
+                if (cand.candidateBuildEpoch > 0) {
+                    updated << "Build-epoch: " << cand.candidateBuildEpoch << "\n";
+                }
+                if (!cand.candidateSha256.empty()) {
+                    updated << "Sha256: " << cand.candidateSha256 << "\n";
+                }
                 versionUpdated = true;
-            } else if (line.rfind("Update-time:", 0) == 0) {
-                updated << "Update-time: " << newUpdateDate << "\n";
-                dateUpdated = true;
+            } else if (line.rfind("Build-epoch:", 0) == 0 || line.rfind("Sha256:", 0) == 0) {
+                // Superseded by the lines written after Version
+            } else if (line.rfind("Update-time:", 0) == 0 && !cand.candidateUpdateTime.empty()) {
+                updated << "Update-time: " << cand.candidateUpdateTime << "\n";
             } else {
                 updated << line << "\n";
             }
@@ -564,21 +597,50 @@ void Updater::updateDatabaseVersion(const std::string& packageName,
     }
 
     dbFile.close();
-    if (!versionUpdated || !dateUpdated) {
+    if (!versionUpdated) {
         std::cerr << "Warning: Could not find '" << packageName
-                  << "' or its Version/Update-time in " << dbPath
+                  << "' or its Version in " << dbPath
                   << ". Not updated.\n";
-        return;
+        return false;
     }
 
-    std::ofstream outFile(dbPath, std::ios::trunc);
-    if (outFile.is_open()) {
+    // Written next to the DB and renamed over it, so a crash leaves either
+    // the old or the new DB
+    std::string tmpPath = dbPath + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream outFile(tmpPath, std::ios::trunc);
+        if (!outFile.is_open()) {
+            std::cerr << "Error: Failed to open " << tmpPath
+                      << " for writing updates.\n";
+            return false;
+        }
         outFile << updated.str();
-        outFile.close();
-    } else {
-        std::cerr << "Error: Failed to open DB " << dbPath
-                  << " for writing updates.\n";
+        outFile.flush();
+        if (!outFile) {
+            std::cerr << "Error: Failed writing " << tmpPath << ".\n";
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    Durability durability = Config::current().settings.durability;
+    if (durability != Durability::None && !syncFile(tmpPath)) {
+        std::cerr << "Error: Could not sync " << tmpPath << ". " << dbPath
+                  << " was not updated.\n";
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    fs::rename(tmpPath, dbPath, ec);
+    if (ec) {
+        std::cerr << "Error: Unable to replace " << dbPath << ": " << ec.message() << "\n";
+        fs::remove(tmpPath, ec);
+        return false;
     }
+    if (durability == Durability::Full &&
+        !syncFile(fs::path(dbPath).parent_path().string())) {
+        std::cerr << "Warning: Could not sync the directory of " << dbPath << ".\n";
+    }
+    return true;
 }
 
 // ============================================================================
@@ -587,6 +649,9 @@ void Updater::updateDatabaseVersion(const std::string& packageName,
 // Prompts user for Y/n confirmation about a set of packages to be updated.
 bool Updater::getConfirmation(const std::vector<std::string>& packages)
 {
+    if (Starpack::Events::active()) {
+        return Starpack::Events::confirm("update", packages);
+    }
     std::cout << "The following packages will be updated:\n";
     for (const auto& pkg : packages) {
         std::cout << "  - " << pkg << "\n";
@@ -716,124 +781,304 @@ finish:
 }
 
 // ============================================================================
-// Updater::updatePackage
+// Updater::updatePackage (single root)
 //
-// The main function that orchestrates package updates: checking repos,
-// comparing versions, downloading, verifying, hooking, extracting, database
-// updates, etc.
+// Thin wrapper around the multi-root variant.
 void Updater::updatePackage(const std::vector<std::string>& packageNames,
                             const std::string& installDir)
 {
-    // ===============================================================
-    // FIX for "use of undeclared identifier 'installedDbPath'":
-    //
-    // We declare this variable at the start of the function so it
-    // remains in scope for the entire update process.  
-    // ===============================================================
+    updatePackage(packageNames, std::vector<std::string>{installDir});
+}
+
+// ============================================================================
+// Updater::applyUpdate
+//
+// Applies one downloaded and verified package update to a single root:
+// hooks, staged extraction, DB update and obsolete file removal. Staging
+// happens below the root's own cache directory so the final renames never
+// cross filesystems. With an object store the files are linked from the
+// store in place instead, as sync does, and the replaced objects released.
+bool Updater::applyUpdate(const UpdateCandidate& cand,
+                          const YAML::Node& packageMetadata,
+                          const std::string& installDir)
+{
+    Trace::Span span("install", "upgrade", cand.packageName);
     std::string installedDbPath = installDir + "/var/lib/starpack/installed.db";
 
-    // --- Step 1: Load Repository Configuration ---
-    std::cout << "[1/N] Loading repository configuration...\n";
-    std::ifstream repoConf("/etc/starpack/repos.conf");
-    if (!repoConf.is_open()) {
-        std::cerr << "Error: Unable to open /etc/starpack/repos.conf.\n";
-        return;
+    // (D) Gather changed file paths for Hook usage
+    std::vector<std::string> changedPaths;
+    for (const auto& fNode : packageMetadata["files"]) {
+        if (!fNode.IsScalar()) {
+            continue;
+        }
+        std::string path = fNode.as<std::string>();
+        Hook::trim(path);
+        if (!path.empty() && path.front() == '/') {
+            path.erase(0, 1);
+        }
+        if (!path.empty()) {
+            changedPaths.push_back(path);
+        }
     }
 
-    std::vector<std::string> repoUrls;
-    std::string repoUrlLine;
-    while (std::getline(repoConf, repoUrlLine)) {
-        Hook::trim(repoUrlLine);
-        if (repoUrlLine.empty() || repoUrlLine[0] == '#') {
-            continue;
+    // (E) PreUpdate Hooks
+    std::cout << "  [" << installDir << "] Running PreUpdate hooks for "
+              << cand.packageName << "...\n";
+    auto preHookCount = Hook::runNewStyleHooks("PreUpdate", "Update",
+                                               changedPaths,
+                                               installDir,
+                                               cand.packageName);
+    if (preHookCount > 0) {
+        std::cout << "    (" << preHookCount
+                  << " PreUpdate hooks executed)\n";
+    }
+
+    // (F) Extract updated files to staging
+    int stripComponents = 0;
+    if (packageMetadata["strip_components"] &&
+        packageMetadata["strip_components"].IsScalar()) {
+        try {
+            stripComponents = packageMetadata["strip_components"].as<int>();
+        } catch (...) {
+            stripComponents = 0;
         }
-        if (repoUrlLine.back() != '/') {
-            repoUrlLine += '/';
+    }
+    std::string oldStoreDir;
+    std::vector<StoredObject> oldObjects =
+        ObjectStore::readPackageObjects(cand.packageName, installedDbPath, oldStoreDir);
+    std::vector<StoredObject> storedObjects;
+    bool applyOk = true;
+    if (ObjectStore::usableFor(installDir)) {
+        // Linked from the store in place; staging would turn them into copies
+        ResolvedPackage package{ cand.packageName, "", cand.archivePath, packageMetadata };
+        applyOk = Installer::extractPackage(package, installDir, true, storedObjects);
+        LowImpact::dropFromCache(cand.archivePath, false);
+    } else {
+        std::vector<std::string> updateDirs; // If partial updates were required
+        fs::path stagingDir = fs::path(installDir) / "var/lib/starpack/cache" /
+                              ("starpack_update_" + cand.packageName);
+        std::error_code ec;
+        fs::remove_all(stagingDir, ec);
+        if (!extractUpdatedFiles(cand.archivePath, stagingDir.string(), updateDirs, stripComponents)) {
+            std::cerr << "  [" << installDir << "] Warning: Some extraction issues occurred for "
+                      << cand.packageName << ".\n";
         }
-        repoUrls.push_back(repoUrlLine);
+        LowImpact::dropFromCache(cand.archivePath, false);
+
+        // (G) Move staged files to final
+        try {
+            for (const auto& de : fs::recursive_directory_iterator(stagingDir)) {
+                fs::path srcPath = de.path();
+                fs::path relPath = fs::relative(srcPath, stagingDir);
+                fs::path dstPath = fs::path(installDir) / relPath;
+
+                std::error_code ec;
+                if (fs::is_directory(srcPath)) {
+                    fs::create_directories(dstPath, ec);
+                } else {
+                    fs::create_directories(dstPath.parent_path(), ec);
+                    if (fs::exists(dstPath, ec) || fs::is_symlink(dstPath, ec)) {
+                        fs::remove(dstPath, ec);
+                    }
+                    fs::rename(srcPath, dstPath, ec);
+                    if (ec) {
+                        throw fs::filesystem_error("Failed to rename staging item",
+                                                   srcPath, dstPath, ec);
+                    }
+                }
+            }
+        } catch (const fs::filesystem_error &ex) {
+            std::cerr << "  [" << installDir << "] Error applying file updates for "
+                      << cand.packageName << ": " << ex.what() << std::endl;
+            applyOk = false;
+        }
+        fs::remove_all(stagingDir, ec); // Remove staging dir
+    }
+
+    if (!applyOk) {
+        std::cerr << "  [" << installDir << "] Error: Update failed mid-application for "
+                  << cand.packageName << ".\n";
+        Metrics::addFailure("update");
+        return false;
+    }
+
+    // (H) Update DB, after the new files reached the disk with Durability = full
+    if (Config::current().settings.durability == Durability::Full && !syncFileSystem(installDir)) {
+        std::cerr << "  [" << installDir << "] Warning: Could not sync the root.\n";
+    }
+    bool dbUpdated = updateDatabaseVersion(cand.packageName, installedDbPath, cand, storedObjects);
+
+    // (I) Remove obsolete files if no partial subdirectories
+    if (!packageMetadata["update_dirs"] || !packageMetadata["update_dirs"].IsSequence()) {
+        removeObsoleteFiles(cand.packageName, installDir,
+                            packageMetadata["files"]);
     }
-    repoConf.close();
 
-    if (repoUrls.empty()) {
-        std::cerr << "Error: No valid repository URLs found.\n";
+    // Objects of the old version that no root links to any more. They stay
+    // if the DB still lists them, for clean to sweep
+    if (dbUpdated && !oldObjects.empty()) {
+        size_t released = ObjectStore::releaseObjects(oldStoreDir, oldObjects);
+        if (released > 0) {
+            std::cout << "  [" << installDir << "] Released " << released
+                      << " unreferenced object(s) from " << oldStoreDir << "\n";
+        }
+    }
+
+    // (J) PostUpdate Hooks
+    auto postHookCount = Hook::runNewStyleHooks("PostUpdate", "Update",
+                                                changedPaths,
+                                                installDir,
+                                                cand.packageName);
+    if (postHookCount > 0) {
+        std::cout << "    (" << postHookCount
+                  << " PostUpdate hooks executed)\n";
+    }
+
+    std::cout << "  [" << installDir << "] Package updated successfully: "
+              << cand.packageName << " (" << cand.candidateVersion << ")\n";
+    Metrics::addPackageChange("upgrade");
+    return true;
+}
+
+// ============================================================================
+// Updater::updatePackage (multiple roots)
+//
+// The main function that orchestrates package updates: checking repos,
+// comparing versions, downloading, verifying, hooking, extracting, database
+// updates, etc. Repository indices are fetched once, and each update is
+// downloaded, verified and unpacked once before being applied to every root
+// that needs it. Roots are updated in parallel.
+void Updater::updatePackage(const std::vector<std::string>& packageNames,
+                            const std::vector<std::string>& installDirs,
+                            bool downloadOnly)
+{
+    if (installDirs.empty()) {
+        std::cerr << "Error: No installation root given.\n";
+        return;
+    }
+
+    // Archives, signatures and the keyring come from the first root.
+    const std::string& cacheRoot = installDirs.front();
+    std::string cacheDir = cacheRoot + "/var/lib/starpack/cache";
+
+    // --- Step 1: Load Repository Configuration ---
+    std::cout << "[1/N] Loading repository configuration...\n";
+    const Config& config = Config::current();
+    std::vector<RepositoryConfig> repositories = config.byPriority();
+    if (repositories.empty()) {
+        std::cerr << "Error: No valid repository URLs found in " << Config::defaultPath << ".\n";
+        Metrics::addFailure("index");
+        return;
+    }
+    std::cout << "Found " << repositories.size() << " repository URL(s).\n";
+
+    std::error_code ec;
+    fs::create_directories(cacheDir, ec);
+    if (ec) {
+        std::cerr << "Error: Could not create cache directory " << cacheDir
+                  << ": " << ec.message() << "\n";
+        Metrics::addFailure("cache");
         return;
     }
-    std::cout << "Found " << repoUrls.size() << " repository URL(s).\n";
-
-    // Prepare a structure for potential updates
-    struct UpdateCandidate {
-        std::string packageName;
-        std::string candidateVersion;
-        std::string candidateUpdateTime; // e.g., "DD/MM/YYYY"
-        std::string packageFileUrl;
-        YAML::Node  metadata;
-    };
-    std::vector<UpdateCandidate> candidates;
 
     // --- Step 2: Check Repositories for Updates ---
+    // Each repository index is downloaded once and reused for every package.
     std::cout << "[2/N] Checking repositories for updates...\n";
-    std::string tempRepoDbPath = "/tmp/starpack_repo_cache.db.yaml";
+    struct RepoIndex {
+        std::string url;
+        int         priority;
+        YAML::Node  packages;
+    };
+    std::vector<RepoIndex> repoIndices;
+    std::string tempRepoDbPath = cacheDir + "/starpack_update_repo.db.yaml";
+
+    for (const auto &repo : repositories) {
+        const std::string& url = repo.url;
+        Trace::Span indexSpan("index", "load repository", url);
+        std::string repoIndexUrl = url + "repo.db.yaml";
+        std::cout << "    Checking repo: " << repoIndexUrl << std::endl;
+
+        // The mirrors are only asked when the repository itself fails
+        bool fetched = false;
+        for (const auto &base : repo.bases()) {
+            if (downloadFile(base + "repo.db.yaml", tempRepoDbPath)) {
+                fetched = true;
+                break;
+            }
+            std::cerr << "    Warning: Could not download " << base << "repo.db.yaml\n";
+        }
+        if (!fetched) {
+            continue;
+        }
 
+        YAML::Node repoIndex;
+        try {
+            repoIndex = YAML::LoadFile(tempRepoDbPath);
+        } catch (const std::exception &e) {
+            std::cerr << "    Warning: Failed to parse "
+                      << repoIndexUrl << ": " << e.what() << "\n";
+            fs::remove(tempRepoDbPath, ec);
+            continue;
+        }
+        // Remove the temp file after parsing
+        fs::remove(tempRepoDbPath, ec);
+
+        if (!repoIndex["packages"] || !repoIndex["packages"].IsSequence()) {
+            std::cerr << "    Warning: Invalid 'packages' in " << repoIndexUrl << "\n";
+            continue;
+        }
+        repoIndices.push_back({url, repo.priority, repoIndex["packages"]});
+    }
+    if (repoIndices.empty()) {
+        std::cerr << "Error: No repository index could be read. Nothing was updated.\n";
+        Metrics::addFailure("index");
+        return;
+    }
+
+    std::vector<UpdateCandidate> candidates;
     for (const auto &pkgName : packageNames) {
         std::cout << " -> Checking updates for: " << pkgName << std::endl;
         bool foundCandidate = false;
+        int bestPriority = 0;
         UpdateCandidate best;
 
-        // For each repository, download the index and look for pkgName
-        for (const auto &url : repoUrls) {
-            std::string repoIndexUrl = url + "repo.db.yaml";
-            std::cout << "    Checking repo: " << repoIndexUrl << std::endl;
-
-            if (!downloadFile(repoIndexUrl, tempRepoDbPath)) {
-                std::cerr << "    Warning: Could not download " << repoIndexUrl << "\n";
-                continue;
-            }
-
-            YAML::Node repoIndex;
-            try {
-                repoIndex = YAML::LoadFile(tempRepoDbPath);
-            } catch (const std::exception &e) {
-                std::cerr << "    Warning: Failed to parse "
-                          << repoIndexUrl << ": " << e.what() << "\n";
-                std::error_code ec; fs::remove(tempRepoDbPath, ec);
-                continue;
-            }
-            // Remove the temp file after parsing
-            std::error_code ec; fs::remove(tempRepoDbPath, ec);
-
-            if (!repoIndex["packages"] || !repoIndex["packages"].IsSequence()) {
-                std::cerr << "    Warning: Invalid 'packages' in " << repoIndexUrl << "\n";
-                continue;
+        // Search for our package in every repository of the highest
+        // priority that has it; the newest version among those wins
+        for (const auto &[url, priority, packages] : repoIndices) {
+            if (foundCandidate && priority < bestPriority) {
+                break;
             }
-
-            // Search for our package in this repo
-            for (const auto &node : repoIndex["packages"]) {
+            for (const auto &node : packages) {
                 if (!node["name"] || !node["version"] || !node["file_name"]) {
                     // Skip invalid nodes
                     continue;
                 }
-                if (node["name"].as<std::string>() == pkgName) {
-                    std::string repoVersion = node["version"].as<std::string>();
+                if (node["name"].as<std::string>() != pkgName) {
+                    continue;
+                }
+                std::string repoVersion = node["version"].as<std::string>();
+                std::string repoVersionKey = versionKeyOf(node);
+                int64_t repoBuildEpoch = buildEpochOf(node);
+
+                // Compare with the best found so far: sort keys compare
+                // bytewise, rebuilds of one version by build epoch
+                int keyCmp = foundCandidate ? repoVersionKey.compare(best.candidateVersionKey) : 1;
+                if (keyCmp > 0 || (keyCmp == 0 && repoBuildEpoch > best.candidateBuildEpoch)) {
                     std::string repoUpdateTime;
                     if (node["update_time"] && node["update_time"].IsScalar()) {
                         repoUpdateTime = node["update_time"].as<std::string>();
                     }
-
-                    // Compare with the best found so far
-                    if (!foundCandidate ||
-                        compareVersions(repoVersion, best.candidateVersion) > 0 ||
-                       (compareVersions(repoVersion, best.candidateVersion) == 0 &&
-                        !repoUpdateTime.empty() &&
-                        (best.candidateUpdateTime.empty() ||
-                         compareDates(repoUpdateTime, best.candidateUpdateTime) > 0)))
-                    {
-                        best.packageName         = pkgName;
-                        best.candidateVersion    = repoVersion;
-                        best.candidateUpdateTime = repoUpdateTime;
-                        best.packageFileUrl      = url + node["file_name"].as<std::string>();
-                        best.metadata            = YAML::Clone(node);
-                        foundCandidate = true;
-                    }
+                    best.packageName         = pkgName;
+                    best.candidateVersion    = repoVersion;
+                    best.candidateVersionKey = repoVersionKey;
+                    best.candidateUpdateTime = repoUpdateTime;
+                    best.candidateBuildEpoch = repoBuildEpoch;
+                    best.candidateSha256     = sha256Of(node);
+                    best.packageFileUrl      = url + node["file_name"].as<std::string>();
+                    best.archivePath         = cacheDir + "/" + node["file_name"].as<std::string>();
+                    best.metadata            = YAML::Clone(node);
+                    bestPriority   = priority;
+                    foundCandidate = true;
                 }
             }
         }
@@ -842,36 +1087,45 @@ void Updater::updatePackage(const std::vector<std::string>& packageNames,
             continue;
         }
 
-        // Compare the best candidate version/date with the installed version/date
-        std::string installedVersion = getInstalledVersion(pkgName, installedDbPath);
-        std::string installedDate    = getInstalledUpdateDate(pkgName, installedDbPath);
-
-        bool upToDate = false;
-        if (!installedVersion.empty()) {
-            int verCmp = compareVersions(installedVersion, best.candidateVersion);
-            if (verCmp > 0) {
-                upToDate = true;
-            } else if (verCmp == 0) {
-                if (!installedDate.empty() && !best.candidateUpdateTime.empty()) {
-                    if (compareDates(installedDate, best.candidateUpdateTime) >= 0) {
-                        upToDate = true;
-                    }
-                } else if (best.candidateUpdateTime.empty()) {
-                    // No date info in candidate => treat as up-to-date
-                    upToDate = true;
+        // Compare the best candidate version/build with each root's installed version/build
+        for (size_t r = 0; r < installDirs.size(); ++r) {
+            std::string installedDbPath = installDirs[r] + "/var/lib/starpack/installed.db";
+            InstalledBuild installed = getInstalledBuild(pkgName, installedDbPath);
+            const std::string& installedVersion = installed.version;
+
+            bool upToDate = false;
+            bool rebuild  = false;
+            if (!installedVersion.empty()) {
+                int verCmp = Version::indexKey(installedVersion).compare(best.candidateVersionKey);
+                if (verCmp == 0) {
+                    rebuild  = isNewerBuild(best.metadata, installed.buildEpoch, installed.sha256);
+                    upToDate = !rebuild;
+                } else {
+                    upToDate = verCmp > 0;
                 }
             }
-        }
 
-        if (upToDate) {
-            std::cout << "Info: '" << pkgName << "' is already up-to-date.\n";
-            continue;
+            std::string rootLabel = installDirs.size() > 1 ? " in " + installDirs[r] : "";
+            if (installDirs.size() > 1 && installedVersion.empty()) {
+                // Never pull a package into a root that does not have it.
+                std::cout << "Info: '" << pkgName << "' is not installed" << rootLabel << ".\n";
+                continue;
+            }
+            if (upToDate) {
+                std::cout << "Info: '" << pkgName << "' is already up-to-date" << rootLabel << ".\n";
+                continue;
+            }
+
+            std::cout << "Info: Update found for '" << pkgName << "'" << rootLabel << " (Installed: "
+                      << (installedVersion.empty() ? "None" : installedVersion)
+                      << ", Available: " << best.candidateVersion
+                      << (rebuild ? ", rebuilt" : "") << ")\n";
+            best.roots.push_back(r);
         }
 
-        std::cout << "Info: Update found for '" << pkgName << "' (Installed: "
-                  << (installedVersion.empty() ? "None" : installedVersion)
-                  << ", Available: " << best.candidateVersion << ")\n";
-        candidates.push_back(best);
+        if (!best.roots.empty()) {
+            candidates.push_back(best);
+        }
     }
 
     if (candidates.empty()) {
@@ -879,8 +1133,12 @@ void Updater::updatePackage(const std::vector<std::string>& packageNames,
         return;
     }
 
-    // --- Step 3: Confirmation ---
+    // --- Step 3: Confirmation (nothing is changed when only downloading) ---
     std::cout << "[3/N] Confirming updates...\n";
+    if (downloadOnly) {
+        std::cout << "Download only: " << candidates.size()
+                  << " pending update(s) will be fetched into the cache.\n";
+    }
     bool foundCritical = false;
     for (auto &cand : candidates) {
         if (isCriticalPackage(cand.packageName)) {
@@ -894,199 +1152,161 @@ void Updater::updatePackage(const std::vector<std::string>& packageNames,
     // Collect for user prompt
     std::vector<std::string> pkgsToConfirm;
     for (auto &c : candidates) {
-        pkgsToConfirm.push_back(c.packageName + " (" + c.candidateVersion + ")");
+        std::string entry = c.packageName + " (" + c.candidateVersion + ")";
+        if (installDirs.size() > 1) {
+            entry += " [" + std::to_string(c.roots.size()) + " root(s)]";
+        }
+        pkgsToConfirm.push_back(entry);
     }
-    if (!getConfirmation(pkgsToConfirm)) {
+    if (!downloadOnly && !getConfirmation(pkgsToConfirm)) {
         std::cout << "Update canceled by user.\n";
         return;
     }
 
-    // --- Step 4: Download, Verify, and Apply Updates ---
-    std::cout << "[4/N] Applying updates...\n";
-    size_t idx = 0;
-    for (auto &cand : candidates) {
-        idx++;
-        std::cout << "\n(" << idx << "/" << candidates.size()
-                  << ") Updating: " << cand.packageName << "\n"
-                  << "  Version: " << cand.candidateVersion
-                  << (cand.candidateUpdateTime.empty() ? "" : " (Update Time: " + cand.candidateUpdateTime + ")") << "\n"
-                  << "  Source: " << cand.packageFileUrl << std::endl;
-
-        // (A) Download
-        fs::path tempDir = "/tmp/starpack_update_" + cand.packageName;
-        fs::create_directories(tempDir);
-        std::string tempPkgPath = (tempDir / (cand.packageName + ".starpack")).string();
-        std::string tempSigPath = tempPkgPath + ".sig";
-
-        std::cout << "  Downloading package..." << std::flush;
-        if (!downloadFile(cand.packageFileUrl, tempPkgPath)) {
-            std::cerr << "\nError: Package download failed.\n";
-            fs::remove_all(tempDir);
-            continue;
+    // --- Step 4: Download and Verify (once for all roots) ---
+    std::cout << "[4/N] Downloading updates...\n";
+    // A cached archive is reused only if it is the indexed build (see
+    // Installer::fetchPackages)
+    parallelFor(candidates.size(), config.settings.workersFor(candidates.size()), [&](size_t i) {
+        Cache::discardIfStale(candidates[i].archivePath, candidates[i].candidateSha256);
+    });
+    std::vector<std::pair<std::string, std::string>> filesToDownload;
+    for (const auto &cand : candidates) {
+        filesToDownload.emplace_back(cand.packageFileUrl, cand.archivePath);
+        filesToDownload.emplace_back(cand.packageFileUrl + ".sig", cand.archivePath + ".sig");
+    }
+    {
+        Trace::Span downloadSpan("download", "fetch packages");
+        if (!downloadWithMirrors(filesToDownload)) {
+            std::cerr << "Warning: Some downloads failed. Affected packages will be skipped.\n";
         }
-        std::cout << " Done.\n";
+    }
 
-        std::cout << "  Downloading signature..." << std::flush;
-        if (!downloadFile(cand.packageFileUrl + ".sig", tempSigPath)) {
-            std::cerr << "\nError: Signature download failed.\n";
-            fs::remove_all(tempDir);
-            continue;
+    // Verification and metadata extraction run up to Jobs at a time
+    std::vector<YAML::Node> packageMetadata(candidates.size());
+    std::vector<char> ready(candidates.size(), 0);
+    parallelFor(candidates.size(), config.settings.workersFor(candidates.size()), [&](size_t i) {
+        const auto &cand = candidates[i];
+        std::error_code ec;
+
+        if (!fs::exists(cand.archivePath) || !fs::exists(cand.archivePath + ".sig")) {
+            std::cerr << "Error: Package or signature missing for " << cand.packageName
+                      << ". Skipping update.\n";
+            return;
         }
-        std::cout << " Done.\n";
 
         // (B) Verify GPG signature
-        std::cout << "  Verifying signature..." << std::flush;
-        if (!Installer::verifyGPGSignature(tempPkgPath, tempSigPath, installDir)) {
-            std::cerr << "\nError: GPG signature verification failed.\n";
-            fs::remove_all(tempDir);
-            continue;
+        Trace::Span verifySpan("verify", "verify signature", cand.packageName);
+        if (!Installer::verifyGPGSignature(cand.archivePath, cand.archivePath + ".sig", cacheRoot)) {
+            std::cerr << "Error: GPG signature verification failed for "
+                      << cand.packageName << ".\n";
+            Metrics::addFailure("verify");
+            fs::remove(cand.archivePath, ec);
+            fs::remove(cand.archivePath + ".sig", ec);
+            fs::remove(cand.archivePath + Cache::digestSuffix, ec);
+            return;
         }
-        std::cout << " OK.\n";
+        Cache::recordDigest(cand.archivePath);
+        std::cout << "  Verifying signature for " << cand.packageName << "... OK.\n";
 
         // (C) Extract metadata.yaml from inside the package
-        std::string tempMetaDir = (tempDir / "meta_extract").string();
-        YAML::Node packageMetadata;
-        if (extractFileFromArchive(tempPkgPath, "metadata.yaml", tempMetaDir)) {
+        std::string tempMetaDir = cacheDir + "/starpack_meta_" + cand.packageName;
+        if (extractFileFromArchive(cand.archivePath, "metadata.yaml", tempMetaDir)) {
             try {
-                packageMetadata = YAML::LoadFile(tempMetaDir + "/metadata.yaml");
+                packageMetadata[i] = YAML::LoadFile(tempMetaDir + "/metadata.yaml");
             } catch (const std::exception& e) {
                 std::cerr << "  Warning: Could not parse metadata.yaml: "
                           << e.what() << " (Using repo metadata fallback)\n";
-                packageMetadata = cand.metadata;
+                packageMetadata[i] = cand.metadata;
             }
         } else {
             std::cerr << "  Warning: Could not extract metadata.yaml. Using repo metadata fallback.\n";
-            packageMetadata = cand.metadata;
+            packageMetadata[i] = cand.metadata;
         }
-        fs::remove_all(tempMetaDir);
+        fs::remove_all(tempMetaDir, ec);
 
-        if (!packageMetadata || !packageMetadata["files"] || !packageMetadata["files"].IsSequence()) {
+        if (!packageMetadata[i] || !packageMetadata[i]["files"] ||
+            !packageMetadata[i]["files"].IsSequence()) {
             std::cerr << "Error: Invalid metadata for " << cand.packageName << ". Skipping update.\n";
-            fs::remove_all(tempDir);
-            continue;
+            Metrics::addFailure("metadata");
+            return;
         }
+        ready[i] = 1;
+    });
 
-        // (D) Gather changed file paths for Hook usage
-        std::vector<std::string> changedPaths;
-        for (const auto& fNode : packageMetadata["files"]) {
-            if (!fNode.IsScalar()) {
-                continue;
-            }
-            std::string path = fNode.as<std::string>();
-            Hook::trim(path);
-            if (!path.empty() && path.front() == '/') {
-                path.erase(0, 1);
-            }
-            if (!path.empty()) {
-                changedPaths.push_back(path);
-            }
-        }
-
-        // (E) PreUpdate Hooks
-        std::cout << "  Running PreUpdate hooks...\n";
-        auto preHookCount = Hook::runNewStyleHooks("PreUpdate", "Update",
-                                                   changedPaths,
-                                                   installDir,
-                                                   cand.packageName);
-        if (preHookCount > 0) {
-            std::cout << "    (" << preHookCount
-                      << " PreUpdate hooks executed)\n";
-        }
+    if (downloadOnly) {
+        size_t cached = std::count(ready.begin(), ready.end(), 1);
+        std::cout << "\n--- " << cached << " of " << candidates.size()
+                  << " update(s) downloaded and verified into " << cacheDir << ". ---\n";
+        return;
+    }
 
-        // (F) Extract updated files to staging
-        std::cout << "  Extracting updated files..." << std::flush;
-        int stripComponents = 0;
-        if (packageMetadata["strip_components"] &&
-            packageMetadata["strip_components"].IsScalar()) {
-            try {
-                stripComponents = packageMetadata["strip_components"].as<int>();
-            } catch (...) {
-                stripComponents = 0;
-            }
+    // --- Step 5: Apply Updates (one worker per root) ---
+    std::cout << "[5/N] Applying updates"
+              << (installDirs.size() > 1 ? " to " + std::to_string(installDirs.size()) + " roots" : "")
+              << "...\n";
+    std::vector<std::vector<size_t>> rootPlans(installDirs.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (!ready[i]) {
+            continue;
         }
-        std::vector<std::string> updateDirs; // If partial updates were required
-        std::string stagingDir = (tempDir / "staging").string();
-        if (!extractUpdatedFiles(tempPkgPath, stagingDir, updateDirs, stripComponents)) {
-            std::cerr << "\n  Warning: Some extraction issues occurred.\n";
-        } else {
-            std::cout << " Done.\n";
+        for (size_t r : candidates[i].roots) {
+            rootPlans[r].push_back(i);
         }
+    }
 
-        // (G) Move staged files to final
-        std::cout << "  Applying file updates..." << std::flush;
-        bool applyOk = true;
-        try {
-            for (const auto& de : fs::recursive_directory_iterator(stagingDir)) {
-                fs::path srcPath = de.path();
-                fs::path relPath = fs::relative(srcPath, stagingDir);
-                fs::path dstPath = fs::path(installDir) / relPath;
-
-                std::error_code ec;
-                if (fs::is_directory(srcPath)) {
-                    fs::create_directories(dstPath, ec);
-                } else {
-                    fs::create_directories(dstPath.parent_path(), ec);
-                    if (fs::exists(dstPath, ec) || fs::is_symlink(dstPath, ec)) {
-                        fs::remove(dstPath, ec);
-                    }
-                    fs::rename(srcPath, dstPath, ec);
-                    if (ec) {
-                        throw fs::filesystem_error("Failed to rename staging item",
-                                                   srcPath, dstPath, ec);
-                    }
+    // Deduplicated packages stay deduplicated: without --dedup or --store the
+    // store recorded for them in the installed DB is used
+    if (ObjectStore::storeDir().empty()) {
+        for (size_t r = 0; r < installDirs.size() && ObjectStore::storeDir().empty(); ++r) {
+            std::string dbPath = installDirs[r] + "/var/lib/starpack/installed.db";
+            for (size_t i : rootPlans[r]) {
+                std::string recordedStore;
+                ObjectStore::readPackageObjects(candidates[i].packageName, dbPath, recordedStore);
+                if (!recordedStore.empty()) {
+                    ObjectStore::setStoreDir(recordedStore);
+                    std::cout << "Using object store " << recordedStore << "\n";
+                    break;
                 }
             }
-        } catch (const fs::filesystem_error &ex) {
-            std::cerr << "\nError applying file updates for "
-                      << cand.packageName << ": " << ex.what() << std::endl;
-            applyOk = false;
         }
-        fs::remove_all(stagingDir); // Remove staging dir
+    }
 
-        if (!applyOk) {
-            std::cerr << "Error: Update failed mid-application for "
-                      << cand.packageName << ".\n";
-            fs::remove_all(tempDir);
-            continue;
-        }
-        std::cout << " Done.\n";
-
-        // (H) Update DB
-        std::cout << "  Updating installation database..." << std::flush;
-        updateDatabaseVersion(cand.packageName,
-                              installedDbPath,
-                              cand.candidateVersion,
-                              cand.candidateUpdateTime);
-        std::cout << " Done.\n";
-
-        // (I) Remove obsolete files if no partial subdirectories
-        if (!packageMetadata["update_dirs"] || !packageMetadata["update_dirs"].IsSequence()) {
-            std::cout << "  Removing obsolete files...\n";
-            removeObsoleteFiles(cand.packageName, installDir,
-                                packageMetadata["files"]);
-            std::cout << "  Obsolete file check complete.\n";
+    // A root whose updates throw is abandoned (and counted as failed); the
+    // other roots finish
+    std::vector<size_t> failures(installDirs.size(), 0);
+    std::vector<char> finished(installDirs.size(), 0);
+    parallelFor(installDirs.size(), config.settings.workersFor(installDirs.size()), [&](size_t r) {
+        for (size_t i : rootPlans[r]) {
+            if (!applyUpdate(candidates[i], packageMetadata[i], installDirs[r])) {
+                failures[r]++;
+            }
         }
-
-        // (J) PostUpdate Hooks
-        std::cout << "  Running PostUpdate hooks...\n";
-        auto postHookCount = Hook::runNewStyleHooks("PostUpdate", "Update",
-                                                    changedPaths,
-                                                    installDir,
-                                                    cand.packageName);
-        if (postHookCount > 0) {
-            std::cout << "    (" << postHookCount
-                      << " PostUpdate hooks executed)\n";
+        finished[r] = 1;
+    });
+    for (size_t r = 0; r < installDirs.size(); ++r) {
+        if (!finished[r]) {
+            std::cerr << "Error: Updating " << installDirs[r] << " was aborted.\n";
+            failures[r]++;
         }
+    }
 
-        // (K) Final Cleanup
-        std::cout << "Package updated successfully: " << cand.packageName << "\n";
+    for (const auto &cand : candidates) {
         if (isCriticalPackage(cand.packageName)) {
             std::cout << "NOTICE: '" << cand.packageName
                       << "' is critical. A reboot is recommended.\n";
         }
-        fs::remove_all(tempDir); // Clean up
-    } // end for(candidates)
+    }
+    if (installDirs.size() > 1) {
+        for (size_t r = 0; r < installDirs.size(); ++r) {
+            if (failures[r] > 0) {
+                std::cerr << "Error: " << failures[r] << " update(s) failed in "
+                          << installDirs[r] << ".\n";
+            }
+        }
+    }
 
+    Cache::enforceLimits(cacheDir);
     std::cout << "\n--- Update process finished. ---\n";
 }
 
@@ -2,6 +2,16 @@
 #include <curl/curl.h>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <openssl/evp.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace Starpack {
 
@@ -79,4 +89,118 @@ std::string removeSlashAndAfter(const std::string& input)
     return input;
 }
 
+/**
+ * @brief Hands out indices from a shared counter to up to maxWorkers threads
+ *        (bounded by the hardware concurrency) until all items are done.
+ *        An exception ends only the item that threw it.
+ */
+size_t parallelFor(size_t count, size_t maxWorkers, const std::function<void(size_t)>& fn)
+{
+    size_t hw      = std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t workers = std::min({count, std::max<size_t>(1, maxWorkers), hw});
+
+    std::atomic<size_t> failed{0};
+    auto runItem = [&](size_t i) {
+        try {
+            fn(i);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            failed++;
+        } catch (...) {
+            std::cerr << "Error: Unknown exception in a worker." << std::endl;
+            failed++;
+        }
+    };
+
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            runItem(i);
+        }
+        return failed;
+    }
+
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                runItem(i);
+            }
+        });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    return failed;
+}
+
+/**
+ * @brief Streams the file through SHA-256 in 64 KiB chunks.
+ */
+std::string sha256File(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return "";
+    }
+
+    EVP_MD_CTX* md = EVP_MD_CTX_new();
+    if (!md || EVP_DigestInit_ex(md, EVP_sha256(), nullptr) != 1) {
+        EVP_MD_CTX_free(md);
+        return "";
+    }
+
+    std::vector<char> buffer(65536);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (file.gcount() > 0) {
+            EVP_DigestUpdate(md, buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+    }
+    bool ok = file.eof();
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    EVP_DigestFinal_ex(md, digest, &digestLen);
+    EVP_MD_CTX_free(md);
+    if (!ok) {
+        return "";
+    }
+
+    std::ostringstream hex;
+    for (unsigned int i = 0; i < digestLen; ++i) {
+        hex << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(digest[i]);
+    }
+    return hex.str();
+}
+
+/**
+ * @brief fsync() on a read-only descriptor, which is enough on Linux.
+ */
+bool syncFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief syncfs() through a descriptor of path.
+ */
+bool syncFileSystem(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = syncfs(fd) == 0;
+    close(fd);
+    return ok;
+}
+
 } // namespace Starpack
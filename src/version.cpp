@@ -0,0 +1,200 @@
+//============================================================================
+// Includes
+//============================================================================
+
+#include "version.hpp"         // Class definition
+
+#include <iostream>            // Standard I/O (cerr)
+#include <cstring>             // memcmp
+#include <algorithm>           // std::min
+
+namespace Starpack {
+
+    namespace {
+
+        // Run tags, in the order the runs sort against each other
+        constexpr unsigned char kEnd          = 0x00;  // terminates a letter run
+        constexpr unsigned char kPreRelease   = 0x01;  // letters glued to the previous run
+        constexpr unsigned char kEndOfPart    = 0x02;  // end of upstream or release
+        constexpr unsigned char kLetters      = 0x03;  // letters after a separator
+        constexpr unsigned char kNumber       = 0x04;
+
+        // Bounded writer that keeps counting past the end of the buffer
+        struct KeyWriter {
+            unsigned char* out;
+            size_t         capacity;
+            size_t         length = 0;
+
+            void put(unsigned char byte) {
+                if (length < capacity) {
+                    out[length] = byte;
+                }
+                length++;
+            }
+        };
+
+        bool isDigit(unsigned char c)  { return c >= '0' && c <= '9'; }
+        bool isLetter(unsigned char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+        }
+
+        // Digits without leading zeros, prefixed by their count, so that a
+        // longer number sorts after a shorter one
+        void putNumber(KeyWriter& key, std::string_view digits) {
+            size_t first = 0;
+            while (first < digits.size() && digits[first] == '0') {
+                first++;
+            }
+            size_t count = std::min<size_t>(digits.size() - first, 0xff);
+            key.put(static_cast<unsigned char>(count));
+            for (size_t i = 0; i < count; i++) {
+                key.put(static_cast<unsigned char>(digits[first + i]));
+            }
+        }
+
+        void putPart(KeyWriter& key, std::string_view part) {
+            size_t i = 0;
+            bool separated = false;
+            while (i < part.size()) {
+                unsigned char c = static_cast<unsigned char>(part[i]);
+                size_t start = i;
+                if (isDigit(c)) {
+                    while (i < part.size() && isDigit(static_cast<unsigned char>(part[i]))) {
+                        i++;
+                    }
+                    key.put(kNumber);
+                    putNumber(key, part.substr(start, i - start));
+                } else if (isLetter(c)) {
+                    while (i < part.size() && isLetter(static_cast<unsigned char>(part[i]))) {
+                        i++;
+                    }
+                    key.put(separated || start == 0 ? kLetters : kPreRelease);
+                    for (size_t j = start; j < i; j++) {
+                        key.put(static_cast<unsigned char>(part[j]));
+                    }
+                    key.put(kEnd);
+                } else {
+                    i++;
+                    separated = true;
+                    continue;
+                }
+                separated = false;
+            }
+            key.put(kEndOfPart);
+        }
+
+        constexpr char kHex[] = "0123456789abcdef";
+
+        int hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        }
+
+    } // end anonymous namespace
+
+    /**
+     * ------------------------------------------------------------------------
+     * Version::encode
+     * ------------------------------------------------------------------------
+     */
+    size_t Version::encode(std::string_view version, unsigned char* out, size_t capacity) {
+        KeyWriter key{out, capacity};
+        key.put(keyFormat);
+
+        // Epoch: leading digits followed by ':'
+        std::string_view epoch;
+        size_t colon = version.find(':');
+        if (colon != std::string_view::npos && colon > 0 &&
+            std::all_of(version.begin(), version.begin() + colon,
+                        [](char c) { return isDigit(static_cast<unsigned char>(c)); })) {
+            epoch   = version.substr(0, colon);
+            version = version.substr(colon + 1);
+        }
+        putNumber(key, epoch);
+
+        size_t dash = version.rfind('-');
+        putPart(key, version.substr(0, dash));
+        if (dash != std::string_view::npos) {
+            putPart(key, version.substr(dash + 1));
+        }
+        return key.length;
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Version::key / indexKey / isIndexKey
+     * ------------------------------------------------------------------------
+     */
+    std::string Version::key(std::string_view version) {
+        unsigned char buffer[256];
+        size_t length = encode(version, buffer, sizeof(buffer));
+        if (length <= sizeof(buffer)) {
+            return std::string(reinterpret_cast<const char*>(buffer), length);
+        }
+        std::string result(length, '\0');
+        encode(version, reinterpret_cast<unsigned char*>(result.data()), length);
+        return result;
+    }
+
+    std::string Version::indexKey(std::string_view version) {
+        std::string raw = key(version);
+        std::string hex;
+        hex.reserve(raw.size() * 2);
+        for (unsigned char byte : raw) {
+            hex += kHex[byte >> 4];
+            hex += kHex[byte & 0x0f];
+        }
+        return hex;
+    }
+
+    bool Version::isIndexKey(std::string_view text) {
+        if (text.size() < 4 || text.size() % 2 != 0) {
+            return false;
+        }
+        if (hexValue(text[0]) * 16 + hexValue(text[1]) != keyFormat) {
+            return false;
+        }
+        return std::all_of(text.begin(), text.end(), [](char c) { return hexValue(c) >= 0; });
+    }
+
+    /**
+     * ------------------------------------------------------------------------
+     * Version::compare / satisfies
+     * ------------------------------------------------------------------------
+     */
+    int Version::compare(std::string_view a, std::string_view b) {
+        unsigned char keyA[256];
+        unsigned char keyB[256];
+        size_t lengthA = encode(a, keyA, sizeof(keyA));
+        size_t lengthB = encode(b, keyB, sizeof(keyB));
+
+        int result;
+        if (lengthA <= sizeof(keyA) && lengthB <= sizeof(keyB)) {
+            result = std::memcmp(keyA, keyB, std::min(lengthA, lengthB));
+            if (result == 0) {
+                result = lengthA < lengthB ? -1 : (lengthA > lengthB ? 1 : 0);
+            }
+        } else {
+            result = key(a).compare(key(b));
+        }
+        return (result > 0) - (result < 0);
+    }
+
+    bool Version::satisfies(std::string_view available, std::string_view op,
+                            std::string_view required) {
+        int result = compare(available, required);
+
+        if      (op == ">")                return result > 0;
+        else if (op == ">=")               return result >= 0;
+        else if (op == "<")                return result < 0;
+        else if (op == "<=")               return result <= 0;
+        else if (op == "==" || op == "=")  return result == 0;
+        else if (op == "!=")               return result != 0;
+
+        std::cerr << "Warning: Unknown version comparison operator: '"
+                  << op << "'\n";
+        return false;
+    }
+
+} // namespace Starpack